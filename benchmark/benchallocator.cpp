@@ -0,0 +1,239 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "allocator.h"
+#include "benchmark.h"
+#include "cpu.h"
+#include "datareader.h"
+#include "net.h"
+
+class DataReaderFromEmpty : public ncnn::DataReader
+{
+public:
+    virtual int scan(const char* format, void* p) const { return 0; }
+    virtual int read(void* buf, int size) const { memset(buf, 0, size); return size; }
+};
+
+struct WorkerArgs
+{
+    ncnn::Net* net;
+    const ncnn::Mat* in;
+    ncnn::Allocator* blob_allocator;
+    ncnn::Allocator* workspace_allocator;
+    int loop_count;
+};
+
+static void* worker(void* args)
+{
+    WorkerArgs* wa = (WorkerArgs*)args;
+
+    for (int i=0; i<wa->loop_count; i++)
+    {
+        ncnn::Extractor ex = wa->net->create_extractor();
+        ex.set_num_threads(1);
+        ex.set_blob_allocator(wa->blob_allocator);
+        ex.set_workspace_allocator(wa->workspace_allocator);
+        ex.input("data", *wa->in);
+
+        ncnn::Mat out;
+        ex.extract("output", out);
+    }
+
+    return 0;
+}
+
+// average milliseconds per inference with num_workers extractors in parallel
+static double run(ncnn::Net& net, const ncnn::Mat& in, ncnn::Allocator* blob_allocator, ncnn::Allocator* workspace_allocator, int num_workers, int loop_count)
+{
+    // warm up the pools
+    WorkerArgs warmup = { &net, &in, blob_allocator, workspace_allocator, 2 };
+    worker(&warmup);
+
+    std::vector<WorkerArgs> args(num_workers);
+    std::vector<ncnn::Thread*> threads(num_workers);
+
+    double start = ncnn::get_current_time();
+
+    for (int i=0; i<num_workers; i++)
+    {
+        WorkerArgs wa = { &net, &in, blob_allocator, workspace_allocator, loop_count };
+        args[i] = wa;
+        threads[i] = new ncnn::Thread(worker, &args[i]);
+    }
+
+    for (int i=0; i<num_workers; i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    double end = ncnn::get_current_time();
+
+    return (end - start) / (num_workers * loop_count);
+}
+
+struct FreeArgs
+{
+    ncnn::Allocator* allocator;
+    std::vector<void*>* blocks;
+};
+
+static void* free_worker(void* args)
+{
+    FreeArgs* fa = (FreeArgs*)args;
+
+    for (size_t i=0; i<fa->blocks->size(); i++)
+    {
+        fa->allocator->fastFree((*fa->blocks)[i]);
+    }
+
+    return 0;
+}
+
+// this thread allocates and another thread frees, as with blobs handed from an extractor to its caller
+// returns the number of blocks allocated after the first round, which is 0 when freed blocks are reused
+static int cross_thread_new_blocks(ncnn::Allocator* allocator, int loop_count)
+{
+    const int block_count = 64;
+
+    std::vector<void*> first_blocks;
+    int new_blocks = 0;
+
+    for (int i=0; i<loop_count; i++)
+    {
+        std::vector<void*> blocks(block_count);
+        for (int j=0; j<block_count; j++)
+        {
+            blocks[j] = allocator->fastMalloc((j % 8 + 1) * 64 * 1024);
+        }
+
+        if (i == 0)
+        {
+            first_blocks = blocks;
+        }
+        else
+        {
+            for (int j=0; j<block_count; j++)
+            {
+                if (std::find(first_blocks.begin(), first_blocks.end(), blocks[j]) == first_blocks.end())
+                    new_blocks++;
+            }
+        }
+
+        FreeArgs fa = { allocator, &blocks };
+        ncnn::Thread thread(free_worker, &fa);
+        thread.join();
+    }
+
+    return new_blocks;
+}
+
+static void benchmark_cross_thread(int loop_count)
+{
+    int new_pool = 0;
+    {
+        ncnn::PoolAllocator allocator;
+        new_pool = cross_thread_new_blocks(&allocator, loop_count);
+    }
+
+    int new_bucket = 0;
+    {
+        ncnn::BucketPoolAllocator allocator;
+        new_bucket = cross_thread_new_blocks(&allocator, loop_count);
+    }
+
+    fprintf(stderr, "%40s  pool = %8d  bucket = %8d new blocks\n", "cross thread free", new_pool, new_bucket);
+}
+
+static void benchmark(const char* parampath, int w, int h, int c, int num_workers, int loop_count)
+{
+    ncnn::Net net;
+    net.opt.num_threads = 1;
+
+    if (net.load_param(parampath) != 0)
+    {
+        fprintf(stderr, "load_param %s failed\n", parampath);
+        return;
+    }
+
+    DataReaderFromEmpty dr;
+    net.load_model(dr);
+
+    ncnn::Mat in(w, h, c);
+    in.fill(0.01f);
+
+    double t_unlocked = 0;
+    if (num_workers == 1)
+    {
+        // unlocked pool only serves one extractor at a time
+        ncnn::UnlockedPoolAllocator blob_allocator;
+        ncnn::PoolAllocator workspace_allocator;
+        t_unlocked = run(net, in, &blob_allocator, &workspace_allocator, num_workers, loop_count);
+    }
+
+    double t_pool = 0;
+    {
+        ncnn::PoolAllocator blob_allocator;
+        ncnn::PoolAllocator workspace_allocator;
+        t_pool = run(net, in, &blob_allocator, &workspace_allocator, num_workers, loop_count);
+    }
+
+    double t_bucket = 0;
+    {
+        ncnn::BucketPoolAllocator blob_allocator;
+        ncnn::BucketPoolAllocator workspace_allocator;
+        t_bucket = run(net, in, &blob_allocator, &workspace_allocator, num_workers, loop_count);
+    }
+
+    if (num_workers == 1)
+        fprintf(stderr, "%40s  unlocked = %8.3f  pool = %8.3f  bucket = %8.3f ms\n", parampath, t_unlocked, t_pool, t_bucket);
+    else
+        fprintf(stderr, "%40s  pool = %8.3f  bucket = %8.3f ms\n", parampath, t_pool, t_bucket);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 6)
+    {
+        fprintf(stderr, "Usage: %s [w] [h] [c] [num workers] [loop count] [param]...\n", argv[0]);
+        return -1;
+    }
+
+    int w = atoi(argv[1]);
+    int h = atoi(argv[2]);
+    int c = atoi(argv[3]);
+    int num_workers = atoi(argv[4]);
+    int loop_count = atoi(argv[5]);
+
+    ncnn::set_omp_dynamic(0);
+    ncnn::set_omp_num_threads(1);
+
+    fprintf(stderr, "num_workers = %d\n", num_workers);
+    fprintf(stderr, "loop_count = %d\n", loop_count);
+
+    benchmark_cross_thread(loop_count);
+
+    for (int i=6; i<argc; i++)
+    {
+        benchmark(argv[i], w, h, c, num_workers, loop_count);
+    }
+
+    return 0;
+}
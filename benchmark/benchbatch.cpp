@@ -0,0 +1,111 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "benchmark.h"
+#include "cpu.h"
+#include "datareader.h"
+#include "net.h"
+
+class DataReaderFromEmpty : public ncnn::DataReader
+{
+public:
+    virtual int scan(const char* format, void* p) const { return 0; }
+    virtual int read(void* buf, int size) const { memset(buf, 0, size); return size; }
+};
+
+// milliseconds for loop_count batched extractions
+static double run(ncnn::Net& net, const std::vector<ncnn::Mat>& in, int loop_count, int& failed)
+{
+    double start = ncnn::get_current_time();
+
+    for (int i=0; i<loop_count; i++)
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", in);
+
+        std::vector<ncnn::Mat> out;
+        if (ex.extract("output", out) != 0)
+            failed++;
+    }
+
+    double end = ncnn::get_current_time();
+
+    return end - start;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 5)
+    {
+        fprintf(stderr, "Usage: %s [param] [w] [h] [c] [max batch] [loop count] [num threads]\n", argv[0]);
+        return -1;
+    }
+
+    const char* parampath = argv[1];
+    int w = atoi(argv[2]);
+    int h = atoi(argv[3]);
+    int c = atoi(argv[4]);
+    int max_batch = argc >= 6 ? atoi(argv[5]) : 16;
+    int loop_count = argc >= 7 ? atoi(argv[6]) : 20;
+    int num_threads = argc >= 8 ? atoi(argv[7]) : ncnn::get_cpu_count();
+
+    ncnn::Net net;
+    net.opt.num_threads = num_threads;
+    net.opt.use_local_pool_allocator = true;
+
+    if (net.load_param(parampath) != 0)
+    {
+        fprintf(stderr, "load_param %s failed\n", parampath);
+        return -1;
+    }
+
+    DataReaderFromEmpty dr;
+    net.load_model(dr);
+
+    fprintf(stderr, "loop_count = %d\n", loop_count);
+    fprintf(stderr, "num_threads = %d\n", num_threads);
+
+    double base_throughput = 0;
+
+    for (int n=1; n<=max_batch; n*=2)
+    {
+        std::vector<ncnn::Mat> in(n);
+        for (int i=0; i<n; i++)
+        {
+            in[i].create(w, h, c);
+            in[i].fill(0.01f);
+        }
+
+        // warm up
+        int failed = 0;
+        run(net, in, 1, failed);
+
+        failed = 0;
+        double time = run(net, in, loop_count, failed);
+
+        double throughput = n * loop_count * 1000.0 / time;
+        if (n == 1)
+            base_throughput = throughput;
+
+        fprintf(stderr, "batch = %3d  time = %8.2f ms  throughput = %8.2f /s  scaling = %5.2f  failed = %d\n",
+                n, time / loop_count, throughput, throughput / base_throughput, failed);
+    }
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "benchmark.h"
+#include "cpu.h"
+#include "datareader.h"
+#include "net.h"
+
+class DataReaderFromEmpty : public ncnn::DataReader
+{
+public:
+    virtual int scan(const char* format, void* p) const { return 0; }
+    virtual int read(void* buf, int size) const { memset(buf, 0, size); return size; }
+};
+
+struct WorkerArgs
+{
+    ncnn::Net* net;
+    const ncnn::Mat* in;
+    int loop_count;
+    int failed;
+};
+
+static void* worker(void* args)
+{
+    WorkerArgs* wa = (WorkerArgs*)args;
+
+    for (int i=0; i<wa->loop_count; i++)
+    {
+        ncnn::Extractor ex = wa->net->create_extractor();
+        ex.set_num_threads(1);
+        ex.input("data", *wa->in);
+
+        ncnn::Mat out;
+        if (ex.extract("output", out) != 0)
+            wa->failed++;
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 5)
+    {
+        fprintf(stderr, "Usage: %s [param] [w] [h] [c] [max extractors] [loop count]\n", argv[0]);
+        return -1;
+    }
+
+    const char* parampath = argv[1];
+    int w = atoi(argv[2]);
+    int h = atoi(argv[3]);
+    int c = atoi(argv[4]);
+    int max_extractors = argc >= 6 ? atoi(argv[5]) : ncnn::get_cpu_count();
+    int loop_count = argc >= 7 ? atoi(argv[6]) : 100;
+
+    ncnn::set_omp_dynamic(0);
+    ncnn::set_omp_num_threads(1);
+
+    // one net shared by every extractor
+    // each extractor scratches in its own workspace pool
+    ncnn::Net net;
+    net.opt.num_threads = 1;
+    net.opt.use_local_pool_allocator = true;
+
+    if (net.load_param(parampath) != 0)
+    {
+        fprintf(stderr, "load_param %s failed\n", parampath);
+        return -1;
+    }
+
+    DataReaderFromEmpty dr;
+    net.load_model(dr);
+
+    ncnn::Mat in(w, h, c);
+    in.fill(0.01f);
+
+    fprintf(stderr, "loop_count = %d\n", loop_count);
+    fprintf(stderr, "max_extractors = %d\n", max_extractors);
+
+    // warm up
+    {
+        WorkerArgs wa = { &net, &in, 10, 0 };
+        worker(&wa);
+    }
+
+    double base_throughput = 0;
+
+    for (int n=1; n<=max_extractors; n*=2)
+    {
+        std::vector<WorkerArgs> args(n);
+        std::vector<ncnn::Thread*> threads(n);
+
+        double start = ncnn::get_current_time();
+
+        for (int i=0; i<n; i++)
+        {
+            args[i].net = &net;
+            args[i].in = &in;
+            args[i].loop_count = loop_count;
+            args[i].failed = 0;
+            threads[i] = new ncnn::Thread(worker, &args[i]);
+        }
+
+        int failed = 0;
+        for (int i=0; i<n; i++)
+        {
+            threads[i]->join();
+            delete threads[i];
+            failed += args[i].failed;
+        }
+
+        double end = ncnn::get_current_time();
+
+        double throughput = n * loop_count * 1000.0 / (end - start);
+        if (n == 1)
+            base_throughput = throughput;
+
+        fprintf(stderr, "extractors = %3d  time = %8.2f ms  throughput = %8.2f /s  scaling = %5.2f  failed = %d\n",
+                n, end - start, throughput, throughput / base_throughput, failed);
+    }
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "allocator.h"
+#include "benchmark.h"
+#include "cpu.h"
+#include "layer.h"
+#include "mat.h"
+#include "modelbin.h"
+#include "option.h"
+#include "paramdict.h"
+
+// a layer running as one sgemm, M = outch, K = inch * kernel * kernel, N = output size
+struct GemmShape
+{
+    const char* type;
+    int w;
+    int h;
+    int inch;
+    int outch;
+    int kernel;
+    int stride;
+};
+
+static const GemmShape g_shapes[] = {
+    // 1x1 convolution reads the input as B in place
+    { "Convolution",  56,  56,   64,   64, 1, 1 },
+    { "Convolution",  56,  56,   64,  256, 1, 1 },
+    { "Convolution",  28,  28,  512,  128, 1, 1 },
+    { "Convolution",  14,  14, 1024,  256, 1, 1 },
+    { "Convolution",   7,   7, 2048,  512, 1, 1 },
+    // im2col convolution
+    { "Convolution", 224, 224,    3,   32, 3, 2 },
+    { "Convolution",  56,  56,   64,  128, 3, 2 },
+    { "Convolution",  28,  28,  256,  256, 3, 2 },
+    { "Convolution",  56,  56,   64,   64, 5, 1 },
+    // innerproduct is N = 1
+    { "InnerProduct",  1,   1,  512, 1000, 1, 1 },
+    { "InnerProduct",  1,   1, 2048, 1000, 1, 1 },
+    { "InnerProduct",  1,   1, 4096, 4096, 1, 1 },
+};
+
+// average milliseconds per forward
+static double run(const GemmShape& s, int num_threads, int loop_count, int& M, int& N, int& K)
+{
+    ncnn::PoolAllocator workspace_allocator;
+
+    ncnn::Option opt;
+    opt.num_threads = num_threads;
+    opt.workspace_allocator = &workspace_allocator;
+    // 3x3 stride 1 would go winograd
+    opt.use_winograd_convolution = false;
+
+    const int weight_data_size = s.outch * s.inch * s.kernel * s.kernel;
+
+    ncnn::Layer* op = ncnn::create_layer(s.type);
+
+    ncnn::ParamDict pd;
+    if (s.type[0] == 'C')
+    {
+        pd.set(0, s.outch);// num_output
+        pd.set(1, s.kernel);// kernel_w
+        pd.set(3, s.stride);// stride_w
+        pd.set(5, 1);// bias_term
+        pd.set(6, weight_data_size);
+    }
+    else
+    {
+        pd.set(0, s.outch);// num_output
+        pd.set(1, 1);// bias_term
+        pd.set(2, weight_data_size);
+    }
+    op->load_param(pd);
+
+    ncnn::Mat weights[2];
+    weights[0] = ncnn::Mat(weight_data_size);
+    weights[1] = ncnn::Mat(s.outch);
+    weights[0].fill(0.01f);
+    weights[1].fill(0.1f);
+    op->load_model(ncnn::ModelBinFromMatArray(weights));
+
+    op->create_pipeline(opt);
+
+    ncnn::Mat bottom_blob(s.w, s.h, s.inch);
+    bottom_blob.fill(0.5f);
+
+    ncnn::Mat top_blob;
+
+    // warm up the pool
+    op->forward(bottom_blob, top_blob, opt);
+
+    M = s.outch;
+    N = top_blob.dims == 1 ? 1 : top_blob.w * top_blob.h;
+    K = s.inch * s.kernel * s.kernel;
+
+    double start = ncnn::get_current_time();
+
+    for (int i=0; i<loop_count; i++)
+    {
+        op->forward(bottom_blob, top_blob, opt);
+    }
+
+    double end = ncnn::get_current_time();
+
+    op->destroy_pipeline(opt);
+    delete op;
+
+    return (end - start) / loop_count;
+}
+
+int main(int argc, char** argv)
+{
+    int loop_count = 10;
+    int num_threads = ncnn::get_cpu_count();
+    int isa = -1;
+
+    if (argc >= 2)
+        loop_count = atoi(argv[1]);
+    if (argc >= 3)
+        num_threads = atoi(argv[2]);
+    if (argc >= 4)
+        isa = atoi(argv[3]);
+
+    if (isa >= 0)
+        ncnn::set_cpu_x86_isa(isa);
+
+    fprintf(stderr, "loop_count = %d\n", loop_count);
+    fprintf(stderr, "num_threads = %d\n", num_threads);
+    fprintf(stderr, "x86_isa = %d\n", ncnn::get_cpu_x86_isa());
+
+    const int shape_count = sizeof(g_shapes) / sizeof(g_shapes[0]);
+    for (int i=0; i<shape_count; i++)
+    {
+        const GemmShape& s = g_shapes[i];
+
+        int M = 0;
+        int N = 0;
+        int K = 0;
+        double t = run(s, num_threads, loop_count, M, N, K);
+
+        double gflops = 2.0 * M * N * K / (t * 1e6);
+
+        fprintf(stderr, "%14s %dx%d/%d  M = %4d  N = %5d  K = %5d  %9.3f ms  %7.2f GFLOPS\n", s.type, s.kernel, s.kernel, s.stride, M, N, K, t, gflops);
+    }
+
+    return 0;
+}
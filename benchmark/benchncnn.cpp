@@ -48,6 +48,48 @@ public:
     virtual int read(void* buf, int size) const { memset(buf, 0, size); return size; }
 };
 
+// workspace allocator keeping the peak of the bytes in use
+class PeakAllocator : public ncnn::Allocator
+{
+public:
+    PeakAllocator() : used(0), peak(0) {}
+
+    virtual void* fastMalloc(size_t size)
+    {
+        // the size sits in front of the aligned block
+        unsigned char* ptr = (unsigned char*)ncnn::fastMalloc(size + MALLOC_ALIGN);
+        if (!ptr)
+            return 0;
+        *(size_t*)ptr = size;
+
+        lock.lock();
+        used += size;
+        if (used > peak)
+            peak = used;
+        lock.unlock();
+
+        return ptr + MALLOC_ALIGN;
+    }
+
+    virtual void fastFree(void* ptr)
+    {
+        unsigned char* p = (unsigned char*)ptr - MALLOC_ALIGN;
+
+        lock.lock();
+        used -= *(size_t*)p;
+        lock.unlock();
+
+        ncnn::fastFree(p);
+    }
+
+public:
+    size_t used;
+    size_t peak;
+
+private:
+    ncnn::Mutex lock;
+};
+
 static int g_warmup_loop_count = 800; // BISONAI
 static int g_loop_count = 4;
 
@@ -134,6 +176,17 @@ void benchmark(const char* comment, const ncnn::Mat& _in, const ncnn::Option& op
     for(const auto & t : times)
         printf("%f ", t);
     printf("\n");
+
+    // one more inference for the workspace peak, the pool above never gives memory back
+    PeakAllocator workspace_peak_allocator;
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ex.set_workspace_allocator(&workspace_peak_allocator);
+        ex.input("data", in);
+        ex.extract("output", out);
+    }
+
+    fprintf(stderr, "%20s  workspace peak = %.2f MB\n", comment, workspace_peak_allocator.peak / 1024.0 / 1024.0);
 }
 
 int main(int argc, char** argv)
@@ -143,6 +196,8 @@ int main(int argc, char** argv)
     int powersave = 0;
     int gpu_device = -1;
     int experiment_type = 7;
+    int implicit_gemm = 0;
+    int packing = 0;
 
     if (argc >= 2)
     {
@@ -158,6 +213,14 @@ int main(int argc, char** argv)
     {
         loop_count = atoi(argv[2]);
     }
+    if (argc >= 4)
+    {
+        implicit_gemm = atoi(argv[3]);
+    }
+    if (argc >= 5)
+    {
+        packing = atoi(argv[4]);
+    }
 
     bool use_vulkan_compute = gpu_device != -1;
 
@@ -191,6 +254,7 @@ int main(int argc, char** argv)
 #endif // NCNN_VULKAN
     opt.use_winograd_convolution = true;
     opt.use_sgemm_convolution = true;
+    opt.use_implicit_gemm_convolution = implicit_gemm != 0;
     opt.use_int8_inference = true;
     opt.use_vulkan_compute = use_vulkan_compute;
     opt.use_fp16_packed = true;
@@ -199,7 +263,7 @@ int main(int argc, char** argv)
     opt.use_int8_storage = true;
     opt.use_int8_arithmetic = true;
     // BISONAI: Convolution using packing on arm64 seems to be significantly slower.
-    opt.use_packing_layout = false;
+    opt.use_packing_layout = packing != 0;
 
     ncnn::set_cpu_powersave(powersave);
 
@@ -210,6 +274,8 @@ int main(int argc, char** argv)
     fprintf(stderr, "num_threads = %d\n", num_threads);
     fprintf(stderr, "powersave = %d\n", ncnn::get_cpu_powersave());
     fprintf(stderr, "gpu_device = %d\n", gpu_device);
+    fprintf(stderr, "implicit_gemm = %d\n", implicit_gemm);
+    fprintf(stderr, "packing = %d\n", packing);
 
     if (experiment_type == 7)
     {
@@ -0,0 +1,372 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "allocator.h"
+#include "benchmark.h"
+#include "cpu.h"
+#include "layer.h"
+#include "mat.h"
+#include "modelbin.h"
+#include "option.h"
+#include "paramdict.h"
+
+static void fill_random(ncnn::Mat& m, unsigned int seed)
+{
+    for (int q=0; q<m.c; q++)
+    {
+        float* ptr = m.channel(q);
+        for (int i=0; i<m.w * m.h; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            ptr[i] = ((seed >> 16) & 0x7fff) / 32768.f - 0.5f;
+        }
+    }
+}
+
+static ncnn::Mat random_mat(int w, unsigned int seed)
+{
+    ncnn::Mat m(w);
+    fill_random(m, seed);
+    return m;
+}
+
+struct LayerCase
+{
+    const char* name;
+    const char* type;
+    int w;
+    int h;
+    int c;
+    int bottom_count;
+    void (*setup)(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& weights);
+    // the second bottom holds one value per channel
+    int per_channel;
+};
+
+static void setup_conv3x3(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& weights)
+{
+    pd.set(0, 64);// num_output
+    pd.set(1, 3);// kernel_w
+    pd.set(4, 1);// pad_w
+    pd.set(5, 1);// bias_term
+    pd.set(6, 64 * 64 * 9);// weight_data_size
+    pd.set(9, 1);// relu
+    weights.push_back(random_mat(64 * 64 * 9, 11));
+    weights.push_back(random_mat(64, 12));
+}
+
+static void setup_conv3x3s2(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& weights)
+{
+    pd.set(0, 128);
+    pd.set(1, 3);
+    pd.set(3, 2);// stride_w
+    pd.set(4, 1);
+    pd.set(5, 1);
+    pd.set(6, 128 * 64 * 9);
+    weights.push_back(random_mat(128 * 64 * 9, 13));
+    weights.push_back(random_mat(128, 14));
+}
+
+static void setup_conv1x1(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& weights)
+{
+    pd.set(0, 256);
+    pd.set(1, 1);
+    pd.set(5, 1);
+    pd.set(6, 256 * 128);
+    pd.set(9, 1);
+    weights.push_back(random_mat(256 * 128, 15));
+    weights.push_back(random_mat(256, 16));
+}
+
+static void setup_convdw3x3(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& weights)
+{
+    pd.set(0, 64);
+    pd.set(1, 3);
+    pd.set(4, 1);
+    pd.set(5, 1);
+    pd.set(6, 64 * 9);
+    pd.set(7, 64);// group
+    pd.set(9, 1);
+    weights.push_back(random_mat(64 * 9, 17));
+    weights.push_back(random_mat(64, 18));
+}
+
+static void setup_convdw3x3s2(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& weights)
+{
+    pd.set(0, 64);
+    pd.set(1, 3);
+    pd.set(3, 2);
+    pd.set(4, 1);
+    pd.set(5, 1);
+    pd.set(6, 64 * 9);
+    pd.set(7, 64);
+    weights.push_back(random_mat(64 * 9, 21));
+    weights.push_back(random_mat(64, 22));
+}
+
+static void setup_convdw5x5(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& weights)
+{
+    pd.set(0, 64);
+    pd.set(1, 5);
+    pd.set(4, 2);
+    pd.set(5, 1);
+    pd.set(6, 64 * 25);
+    pd.set(7, 64);
+    pd.set(9, 1);
+    weights.push_back(random_mat(64 * 25, 23));
+    weights.push_back(random_mat(64, 24));
+}
+
+static void setup_innerproduct(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& weights)
+{
+    pd.set(0, 256);
+    pd.set(1, 1);
+    pd.set(2, 256 * 256 * 7 * 7);
+    weights.push_back(random_mat(256 * 256 * 7 * 7, 19));
+    weights.push_back(random_mat(256, 20));
+}
+
+static void setup_maxpool(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& /*weights*/)
+{
+    pd.set(0, 0);// max
+    pd.set(1, 3);// kernel_w
+    pd.set(2, 2);// stride_w
+    pd.set(3, 1);// pad_w
+}
+
+static void setup_avgpool(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& /*weights*/)
+{
+    pd.set(0, 1);// avg
+    pd.set(1, 2);
+    pd.set(2, 2);
+}
+
+static void setup_globalpool(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& /*weights*/)
+{
+    pd.set(0, 1);
+    pd.set(4, 1);// global_pooling
+}
+
+static void setup_padding(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& /*weights*/)
+{
+    pd.set(0, 1);// top
+    pd.set(1, 2);// bottom
+    pd.set(2, 1);// left
+    pd.set(3, 2);// right
+    pd.set(5, 0.5f);// value
+}
+
+static void setup_relu(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& /*weights*/)
+{
+    pd.set(0, 0.1f);// slope
+}
+
+static void setup_eltwise(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& /*weights*/)
+{
+    pd.set(0, 1);// sum
+}
+
+static void setup_binaryop(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& /*weights*/)
+{
+    pd.set(0, 2);// mul
+}
+
+static void setup_binaryop_scalar(ncnn::ParamDict& pd, std::vector<ncnn::Mat>& /*weights*/)
+{
+    pd.set(0, 0);// add
+    pd.set(1, 1);// with_scalar
+    pd.set(2, 0.25f);
+}
+
+// the layers with x86 packed kernels
+static const LayerCase g_cases[] = {
+    { "conv3x3 relu", "Convolution", 56, 56, 64, 1, setup_conv3x3 },
+    { "conv3x3 s2", "Convolution", 56, 56, 64, 1, setup_conv3x3s2 },
+    { "conv1x1 relu", "Convolution", 28, 28, 128, 1, setup_conv1x1 },
+    { "convdw3x3 relu", "ConvolutionDepthWise", 56, 56, 64, 1, setup_convdw3x3 },
+    { "convdw3x3 s2", "ConvolutionDepthWise", 56, 56, 64, 1, setup_convdw3x3s2 },
+    { "convdw5x5 relu", "ConvolutionDepthWise", 56, 56, 64, 1, setup_convdw5x5 },
+    { "innerproduct", "InnerProduct", 7, 7, 256, 1, setup_innerproduct },
+    { "maxpool3x3 s2", "Pooling", 56, 56, 64, 1, setup_maxpool },
+    { "avgpool2x2 s2", "Pooling", 56, 56, 64, 1, setup_avgpool },
+    { "globalavgpool", "Pooling", 7, 7, 512, 1, setup_globalpool },
+    { "padding", "Padding", 56, 56, 64, 1, setup_padding },
+    { "leakyrelu", "ReLU", 56, 56, 64, 1, setup_relu },
+    { "eltwise sum", "Eltwise", 56, 56, 64, 2, setup_eltwise },
+    { "binaryop mul", "BinaryOp", 56, 56, 64, 2, setup_binaryop },
+    { "binaryop mul c", "BinaryOp", 56, 56, 64, 2, setup_binaryop, 1 },
+    { "binaryop scalar", "BinaryOp", 56, 56, 64, 1, setup_binaryop_scalar },
+};
+
+// average milliseconds per forward, the output of the last run is kept in top_blob
+// packed is cleared when the layer keeps pack1 under use_packing_layout
+static double run(const LayerCase& lc, const std::vector<ncnn::Mat>& bottom_blobs, int elempack, ncnn::Mat& top_blob, bool& packed, int num_threads, int loop_count)
+{
+    ncnn::PoolAllocator workspace_allocator;
+
+    ncnn::Option opt;
+    opt.num_threads = num_threads;
+    opt.workspace_allocator = &workspace_allocator;
+    opt.use_packing_layout = elempack > 1;
+
+    ncnn::Layer* op = ncnn::create_layer(lc.type);
+
+    ncnn::ParamDict pd;
+    std::vector<ncnn::Mat> weights;
+    lc.setup(pd, weights);
+    op->load_param(pd);
+
+    if (!weights.empty())
+        op->load_model(ncnn::ModelBinFromMatArray(&weights[0]));
+
+    op->create_pipeline(opt);
+
+    // the net feeds pack1 blobs to layers that decline packing
+    packed = op->support_packing;
+    if (!packed)
+        elempack = 1;
+
+    std::vector<ncnn::Mat> bottom_blobs_packed(bottom_blobs.size());
+    for (size_t i=0; i<bottom_blobs.size(); i++)
+    {
+        ncnn::convert_packing(bottom_blobs[i], bottom_blobs_packed[i], elempack, opt);
+    }
+
+    std::vector<ncnn::Mat> top_blobs(1);
+
+    double start = 0;
+    int ret = 0;
+    for (int i=0; i<=loop_count && ret == 0; i++)
+    {
+        // the first run warms up the pools
+        if (i == 1)
+            start = ncnn::get_current_time();
+
+        if (op->one_blob_only)
+            ret = op->forward(bottom_blobs_packed[0], top_blobs[0], opt);
+        else
+            ret = op->forward(bottom_blobs_packed, top_blobs, opt);
+    }
+
+    double end = ncnn::get_current_time();
+
+    op->destroy_pipeline(opt);
+    delete op;
+
+    if (ret != 0)
+        return -1;
+
+    ncnn::convert_packing(top_blobs[0], top_blob, 1, opt);
+
+    return (end - start) / loop_count;
+}
+
+static void benchmark(const LayerCase& lc, const std::vector<int>& elempacks, int num_threads, int loop_count)
+{
+    // layers left out of the build
+    ncnn::Layer* probe = ncnn::create_layer(lc.type);
+    if (!probe)
+    {
+        fprintf(stderr, "  %-18s %s not built\n", lc.name, lc.type);
+        return;
+    }
+    delete probe;
+
+    std::vector<ncnn::Mat> bottom_blobs(lc.bottom_count);
+    for (int i=0; i<lc.bottom_count; i++)
+    {
+        if (i == 1 && lc.per_channel)
+            bottom_blobs[i].create(1, 1, lc.c);
+        else
+            bottom_blobs[i].create(lc.w, lc.h, lc.c);
+        fill_random(bottom_blobs[i], i + 1);
+    }
+
+    ncnn::Mat top_ref;
+    bool packed = false;
+    double t_ref = run(lc, bottom_blobs, 1, top_ref, packed, num_threads, loop_count);
+
+    for (size_t k=0; k<elempacks.size(); k++)
+    {
+        ncnn::Mat top_blob;
+        double t = run(lc, bottom_blobs, elempacks[k], top_blob, packed, num_threads, loop_count);
+        if (!packed)
+        {
+            fprintf(stderr, "  %-18s keeps pack1\n", lc.name);
+            break;
+        }
+
+        if (t < 0 || top_blob.w != top_ref.w || top_blob.h != top_ref.h || top_blob.c != top_ref.c)
+        {
+            fprintf(stderr, "  %-18s pack%d failed\n", lc.name, elempacks[k]);
+            continue;
+        }
+
+        // channel gaps are left uninitialized
+        float maxdiff = 0.f;
+        for (int q=0; q<top_blob.c; q++)
+        {
+            const float* ptr = top_blob.channel(q);
+            const float* ref = top_ref.channel(q);
+            for (int j=0; j<top_blob.w * top_blob.h; j++)
+            {
+                float d = fabs(ptr[j] - ref[j]);
+                if (d > maxdiff)
+                    maxdiff = d;
+            }
+        }
+
+        fprintf(stderr, "  %-18s pack1 %9.3f ms  pack%d %9.3f ms  maxdiff = %g\n", lc.name, t_ref, elempacks[k], t, maxdiff);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int loop_count = 10;
+    int num_threads = ncnn::get_cpu_count();
+
+    if (argc >= 2)
+        loop_count = atoi(argv[1]);
+    if (argc >= 3)
+        num_threads = atoi(argv[2]);
+
+    fprintf(stderr, "loop_count = %d\n", loop_count);
+    fprintf(stderr, "num_threads = %d\n", num_threads);
+
+    // sse2 layers take pack4, the avx ones pack8 and pack4 for channel counts not divisible by 8
+    const int max_isa = ncnn::get_cpu_x86_isa();
+    const int case_count = sizeof(g_cases) / sizeof(g_cases[0]);
+    for (int isa=0; isa<=max_isa; isa++)
+    {
+        ncnn::set_cpu_x86_isa(isa);
+        fprintf(stderr, "x86_isa = %d\n", ncnn::get_cpu_x86_isa());
+
+        std::vector<int> elempacks;
+        elempacks.push_back(4);
+        if (isa >= 1)
+            elempacks.push_back(8);
+
+        for (int i=0; i<case_count; i++)
+        {
+            benchmark(g_cases[i], elempacks, num_threads, loop_count);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "benchmark.h"
+#include "net.h"
+
+// whole file in 32-bit aligned memory, zero terminated for the text parser
+static int read_file(const char* path, std::vector<int>& data, long& size)
+{
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", path);
+        return -1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    data.assign(size / sizeof(int) + 1, 0);
+    size_t nread = fread(data.data(), 1, size, fp);
+    fclose(fp);
+
+    return nread == (size_t)size ? 0 : -1;
+}
+
+// average milliseconds to parse the structure of one net, 0 = text, 1 = bin, 2 = graph
+static double bench_load(int format, const std::vector<int>& data, int loop_count)
+{
+    double start = ncnn::get_current_time();
+
+    for (int i=0; i<loop_count; i++)
+    {
+        ncnn::Net net;
+
+        int ret = -1;
+        if (format == 0)
+            ret = net.load_param_mem((const char*)data.data());
+        else if (format == 1)
+            ret = net.load_param((const unsigned char*)data.data()) > 0 ? 0 : -1;
+        else
+            ret = net.load_param_graph((const unsigned char*)data.data()) > 0 ? 0 : -1;
+
+        if (ret != 0)
+        {
+            fprintf(stderr, "load format %d failed\n", format);
+            return -1;
+        }
+    }
+
+    double end = ncnn::get_current_time();
+
+    return (end - start) / loop_count;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        fprintf(stderr, "Usage: %s [param] [param bin] [param graph] [loop count]\n", argv[0]);
+        return -1;
+    }
+
+    int loop_count = argc >= 5 ? atoi(argv[4]) : 100;
+
+    static const char* const format_names[3] = { "text", "bin", "graph" };
+
+    fprintf(stderr, "loop_count = %d\n", loop_count);
+
+    for (int i=0; i<3; i++)
+    {
+        std::vector<int> data;
+        long size = 0;
+        if (read_file(argv[1 + i], data, size) != 0)
+            return -1;
+
+        double time = bench_load(i, data, loop_count);
+        if (time < 0)
+            return -1;
+
+        fprintf(stderr, "%8s %10ld bytes  %8.3f ms\n", format_names[i], size, time);
+    }
+
+    return 0;
+}
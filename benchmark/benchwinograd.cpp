@@ -0,0 +1,190 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "allocator.h"
+#include "benchmark.h"
+#include "cpu.h"
+#include "layer.h"
+#include "mat.h"
+#include "modelbin.h"
+#include "option.h"
+#include "paramdict.h"
+
+struct ConvShape
+{
+    int w;
+    int h;
+    int inch;
+    int outch;
+};
+
+// 3x3 stride 1 layers of resnet18 and vgg16 at 224x224
+static const ConvShape g_shapes[] = {
+    { 224, 224,  64,  64 },
+    { 112, 112, 128, 128 },
+    {  56,  56,  64,  64 },
+    {  56,  56, 256, 256 },
+    {  28,  28, 128, 128 },
+    {  28,  28, 512, 512 },
+    {  14,  14, 256, 256 },
+    {  14,  14, 512, 512 },
+    {   7,   7, 512, 512 },
+};
+
+struct ConvConfig
+{
+    const char* name;
+    bool use_winograd_convolution;
+    bool use_winograd43_convolution;
+    bool use_winograd63_convolution;
+};
+
+// sgemm is the reference the winograd outputs are compared against
+static const ConvConfig g_configs[] = {
+    { "sgemm", false, false, false },
+    { "F(2,3)", true, false, false },
+    { "F(4,3)", true, true, false },
+    { "F(6,3)", true, false, true },
+    { "auto", true, true, true },
+};
+
+static void fill_random(ncnn::Mat& m, unsigned int seed)
+{
+    float* ptr = m;
+    for (size_t i=0; i<m.total(); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        ptr[i] = ((seed >> 16) & 0x7fff) / 32768.f - 0.5f;
+    }
+}
+
+// average milliseconds per forward, the output of the last run is kept in top_blob
+static double run(const ConvShape& s, const ConvConfig& c, const ncnn::Mat& bottom_blob, const ncnn::Mat& weight_data, const ncnn::Mat& bias_data, ncnn::Mat& top_blob, int num_threads, int loop_count)
+{
+    // top_blob outlives this run, only the workspace comes from a pool
+    ncnn::PoolAllocator workspace_allocator;
+
+    ncnn::Option opt;
+    opt.num_threads = num_threads;
+    opt.workspace_allocator = &workspace_allocator;
+    opt.use_winograd_convolution = c.use_winograd_convolution;
+    opt.use_winograd43_convolution = c.use_winograd43_convolution;
+    opt.use_winograd63_convolution = c.use_winograd63_convolution;
+
+    ncnn::Layer* op = ncnn::create_layer("Convolution");
+
+    ncnn::ParamDict pd;
+    pd.set(0, s.outch);// num_output
+    pd.set(1, 3);// kernel_w
+    pd.set(3, 1);// stride_w
+    pd.set(4, 1);// pad_w
+    pd.set(5, 1);// bias_term
+    pd.set(6, s.outch * s.inch * 9);// weight_data_size
+    op->load_param(pd);
+
+    ncnn::Mat weights[2];
+    weights[0] = weight_data;
+    weights[1] = bias_data;
+    op->load_model(ncnn::ModelBinFromMatArray(weights));
+
+    op->create_pipeline(opt);
+
+    // warm up the pools
+    op->forward(bottom_blob, top_blob, opt);
+
+    double start = ncnn::get_current_time();
+
+    for (int i=0; i<loop_count; i++)
+    {
+        op->forward(bottom_blob, top_blob, opt);
+    }
+
+    double end = ncnn::get_current_time();
+
+    op->destroy_pipeline(opt);
+    delete op;
+
+    return (end - start) / loop_count;
+}
+
+static void benchmark(const ConvShape& s, int num_threads, int loop_count)
+{
+    ncnn::Mat bottom_blob(s.w, s.h, s.inch);
+    ncnn::Mat weight_data(s.outch * s.inch * 9);
+    ncnn::Mat bias_data(s.outch);
+    fill_random(bottom_blob, 1);
+    fill_random(weight_data, 2);
+    fill_random(bias_data, 3);
+
+    ncnn::Mat top_ref;
+
+    const int config_count = sizeof(g_configs) / sizeof(g_configs[0]);
+    for (int i=0; i<config_count; i++)
+    {
+        ncnn::Mat top_blob;
+        double t = run(s, g_configs[i], bottom_blob, weight_data, bias_data, top_blob, num_threads, loop_count);
+
+        if (i == 0)
+            top_ref = top_blob.clone();
+
+        // channel gaps are left uninitialized
+        float maxdiff = 0.f;
+        for (int q=0; q<top_blob.c; q++)
+        {
+            const float* ptr = top_blob.channel(q);
+            const float* ref = top_ref.channel(q);
+            for (int j=0; j<top_blob.w * top_blob.h; j++)
+            {
+                float d = fabs(ptr[j] - ref[j]);
+                if (d > maxdiff)
+                    maxdiff = d;
+            }
+        }
+
+        fprintf(stderr, "  %4d x %-4d %4d -> %-4d  %-8s %9.3f ms  maxdiff = %g\n", s.w, s.h, s.inch, s.outch, g_configs[i].name, t, maxdiff);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int loop_count = 10;
+    int num_threads = ncnn::get_cpu_count();
+    int isa = -1;
+
+    if (argc >= 2)
+        loop_count = atoi(argv[1]);
+    if (argc >= 3)
+        num_threads = atoi(argv[2]);
+    if (argc >= 4)
+        isa = atoi(argv[3]);
+
+    if (isa >= 0)
+        ncnn::set_cpu_x86_isa(isa);
+
+    fprintf(stderr, "loop_count = %d\n", loop_count);
+    fprintf(stderr, "num_threads = %d\n", num_threads);
+    fprintf(stderr, "x86_isa = %d\n", ncnn::get_cpu_x86_isa());
+
+    const int shape_count = sizeof(g_shapes) / sizeof(g_shapes[0]);
+    for (int i=0; i<shape_count; i++)
+    {
+        benchmark(g_shapes[i], num_threads, loop_count);
+    }
+
+    return 0;
+}
@@ -241,6 +241,232 @@ void UnlockedPoolAllocator::fastFree(void* ptr)
     ncnn::fastFree(ptr);
 }
 
+// multiplicative hash keeping the top bits, the low bits of block addresses are mostly alignment
+static int shard_index(size_t key)
+{
+    unsigned long long h = (unsigned long long)key * 0x9E3779B97F4A7C15ull;
+    return (int)(h >> 60) & (BucketPoolAllocator::SHARD_COUNT - 1);
+}
+
+// threads take the free list shards round robin on their first allocation
+static int current_thread_shard()
+{
+    static int next_shard = 0;
+    static thread_local int shard = -1;
+
+    if (shard == -1)
+        shard = NCNN_XADD(&next_shard, 1) & (BucketPoolAllocator::SHARD_COUNT - 1);
+
+    return shard;
+}
+
+BucketPoolAllocator::BucketPoolAllocator()
+{
+}
+
+BucketPoolAllocator::~BucketPoolAllocator()
+{
+    clear();
+
+    for (int i=0; i<SHARD_COUNT; i++)
+    {
+        SizeMapShard& shard = size_map_shards[i];
+        if (!shard.blocks.empty())
+        {
+            fprintf(stderr, "FATAL ERROR! bucket pool allocator destroyed too early\n");
+            std::unordered_map<void*, BlockInfo>::iterator it = shard.blocks.begin();
+            for (; it != shard.blocks.end(); it++)
+            {
+                fprintf(stderr, "%p still in use\n", it->first);
+            }
+        }
+    }
+}
+
+void BucketPoolAllocator::clear()
+{
+    for (int i=0; i<SHARD_COUNT; i++)
+    {
+        FreeListShard& shard = free_list_shards[i];
+
+        MutexLockGuard lock(shard.lock);
+
+        for (int j=0; j<CLASS_COUNT; j++)
+        {
+            std::vector<void*>& free_list = shard.free_lists[j];
+            for (size_t k=0; k<free_list.size(); k++)
+            {
+                void* ptr = free_list[k];
+
+                SizeMapShard& size_map_shard = size_map_shards[shard_index((size_t)ptr)];
+                size_map_shard.lock.lock();
+                size_map_shard.blocks.erase(ptr);
+                size_map_shard.lock.unlock();
+
+                ncnn::fastFree(ptr);
+            }
+            free_list.clear();
+        }
+    }
+}
+
+int BucketPoolAllocator::size_class(size_t size, size_t* class_size)
+{
+    if (size <= 64)
+    {
+        int index = size == 0 ? 0 : (int)((size - 1) / 16);
+        *class_size = (index + 1) * 16;
+        return index;
+    }
+
+    // 2^b < size <= 2^(b+1) is split into four classes of 2^(b-2) each
+    size_t n = size - 1;
+#if defined __GNUC__
+    int b = (int)sizeof(unsigned long long) * 8 - 1 - __builtin_clzll((unsigned long long)n);
+#else
+    int b = 6;
+    while (b + 1 < (int)sizeof(size_t) * 8 && (n >> (b + 1)))
+        b++;
+#endif
+
+    int sub = (int)((n >> (b - 2)) & 3);
+    *class_size = ((size_t)1 << b) + ((size_t)(sub + 1) << (b - 2));
+    return 4 + (b - 6) * 4 + sub;
+}
+
+void* BucketPoolAllocator::fastMalloc(size_t size)
+{
+    size_t class_size;
+    int index = size_class(size, &class_size);
+
+    int owner = current_thread_shard();
+    FreeListShard& shard = free_list_shards[owner];
+
+    shard.lock.lock();
+
+    std::vector<void*>& free_list = shard.free_lists[index];
+    if (!free_list.empty())
+    {
+        void* ptr = free_list.back();
+        free_list.pop_back();
+
+        shard.lock.unlock();
+
+        return ptr;
+    }
+
+    shard.lock.unlock();
+
+    // new block
+    void* ptr = ncnn::fastMalloc(class_size);
+    if (!ptr)
+        return 0;
+
+    BlockInfo info;
+    info.size_class = index;
+    info.owner = owner;
+
+    SizeMapShard& size_map_shard = size_map_shards[shard_index((size_t)ptr)];
+    size_map_shard.lock.lock();
+    size_map_shard.blocks[ptr] = info;
+    size_map_shard.lock.unlock();
+
+    return ptr;
+}
+
+void BucketPoolAllocator::fastFree(void* ptr)
+{
+    SizeMapShard& size_map_shard = size_map_shards[shard_index((size_t)ptr)];
+
+    size_map_shard.lock.lock();
+
+    std::unordered_map<void*, BlockInfo>::iterator it = size_map_shard.blocks.find(ptr);
+    if (it == size_map_shard.blocks.end())
+    {
+        size_map_shard.lock.unlock();
+
+        fprintf(stderr, "FATAL ERROR! bucket pool allocator get wild %p\n", ptr);
+        ncnn::fastFree(ptr);
+        return;
+    }
+
+    BlockInfo info = it->second;
+
+    size_map_shard.lock.unlock();
+
+    // the block goes back to the thread that allocated it
+    // so a block freed on another thread is still reused by its producer
+    FreeListShard& shard = free_list_shards[info.owner];
+
+    shard.lock.lock();
+    shard.free_lists[info.size_class].push_back(ptr);
+    shard.lock.unlock();
+}
+
+ArenaAllocator::ArenaAllocator(Allocator* _fallback) : fallback(_fallback)
+{
+    arena = 0;
+    arena_size = 0;
+}
+
+ArenaAllocator::~ArenaAllocator()
+{
+    if (!arena)
+        return;
+
+    if (fallback)
+        fallback->fastFree(arena);
+    else
+        ncnn::fastFree(arena);
+}
+
+int ArenaAllocator::reserve(size_t size)
+{
+    if (size <= arena_size)
+        return 0;
+
+    if (fallback)
+    {
+        if (arena)
+            fallback->fastFree(arena);
+        arena = (unsigned char*)fallback->fastMalloc(size);
+    }
+    else
+    {
+        ncnn::fastFree(arena);
+        arena = (unsigned char*)ncnn::fastMalloc(size);
+    }
+
+    if (!arena)
+    {
+        arena_size = 0;
+        return -100;
+    }
+
+    arena_size = size;
+    return 0;
+}
+
+void* ArenaAllocator::fastMalloc(size_t size)
+{
+    if (fallback)
+        return fallback->fastMalloc(size);
+
+    return ncnn::fastMalloc(size);
+}
+
+void ArenaAllocator::fastFree(void* ptr)
+{
+    // arena memory is released as a whole
+    if (contains(ptr))
+        return;
+
+    if (fallback)
+        fallback->fastFree(ptr);
+    else
+        ncnn::fastFree(ptr);
+}
+
 #if NCNN_VULKAN
 VkAllocator::VkAllocator(const VulkanDevice* _vkdev) : vkdev(_vkdev)
 {
@@ -24,6 +24,7 @@
 
 #include <stdlib.h>
 #include <list>
+#include <unordered_map>
 #include <vector>
 #include "platform.h"
 
@@ -173,6 +174,84 @@ private:
     std::list< std::pair<size_t, void*> > payouts;
 };
 
+// pool allocator with size class free lists
+// requests are rounded up to one of four classes per power of two
+// so fastMalloc and fastFree never scan the cached blocks
+// block sizes live in a pointer keyed hash map instead of a header before the block
+// free lists are sharded by calling thread to keep concurrent extractors off the same lock
+// a freed block goes back to the shard of the thread that allocated it
+class BucketPoolAllocator : public Allocator
+{
+public:
+    BucketPoolAllocator();
+    ~BucketPoolAllocator();
+
+    // release all cached blocks immediately
+    void clear();
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+public:
+    // size class of a request
+    // class_size receives the rounded block size
+    static int size_class(size_t size, size_t* class_size);
+
+    enum { CLASS_COUNT = 4 + ((int)sizeof(size_t) * 8 - 6) * 4 };
+    enum { SHARD_COUNT = 16 };
+
+private:
+    struct FreeListShard
+    {
+        Mutex lock;
+        std::vector<void*> free_lists[CLASS_COUNT];
+    };
+
+    struct BlockInfo
+    {
+        int size_class;
+        // free list shard the block returns to
+        int owner;
+    };
+
+    struct SizeMapShard
+    {
+        Mutex lock;
+        std::unordered_map<void*, BlockInfo> blocks;
+    };
+
+    FreeListShard free_list_shards[SHARD_COUNT];
+    SizeMapShard size_map_shards[SHARD_COUNT];
+};
+
+// carve blobs out of one preallocated arena
+// the arena offset of each blob is decided by the memory planner in Net
+// fastMalloc requests outside the plan are forwarded to the fallback allocator
+// and fastFree on arena memory is no-op
+class ArenaAllocator : public Allocator
+{
+public:
+    ArenaAllocator(Allocator* fallback = 0);
+    ~ArenaAllocator();
+
+    // grow the arena to at least size bytes
+    // return 0 if success
+    int reserve(size_t size);
+
+    // return the arena memory at offset
+    unsigned char* at(size_t offset) const { return arena + offset; }
+    // return true if ptr points into the arena
+    bool contains(const void* ptr) const { return (const unsigned char*)ptr >= arena && (const unsigned char*)ptr < arena + arena_size; }
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+private:
+    Allocator* fallback;
+    unsigned char* arena;
+    size_t arena_size;
+};
+
 #if NCNN_VULKAN
 
 class VkBufferMemory
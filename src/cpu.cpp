@@ -14,6 +14,8 @@
 
 #include "cpu.h"
 
+#include "platform.h"
+
 #include <stdio.h>
 #include <string.h>
 #include <vector>
@@ -28,6 +30,16 @@
 #include <stdint.h>
 #endif
 
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define NCNN_CPU_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
 #if __APPLE__
 #include "TargetConditionals.h"
 #if TARGET_OS_IPHONE
@@ -191,6 +203,170 @@ int cpu_support_arm_asimdhp()
 #endif
 }
 
+#if NCNN_CPU_X86
+static void x86_cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+#ifdef _MSC_VER
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)subleaf);
+    regs[0] = r[0];
+    regs[1] = r[1];
+    regs[2] = r[2];
+    regs[3] = r[3];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// register state the os saves on context switch
+static unsigned int x86_xgetbv()
+{
+#ifdef _MSC_VER
+    return (unsigned int)_xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+#endif
+}
+
+// bit 0 avx, 1 fma, 2 avx2, 3 avx512f, 4 avx512 vnni
+static unsigned int get_x86_features()
+{
+    unsigned int regs[4];
+    x86_cpuid(0, 0, regs);
+    const unsigned int max_leaf = regs[0];
+    if (max_leaf < 1)
+        return 0;
+
+    x86_cpuid(1, 0, regs);
+    const unsigned int ecx1 = regs[2];
+
+    // avx needs the os to save xmm and ymm state
+    const bool osxsave = ecx1 & (1u << 27);
+    const unsigned int xcr0 = osxsave ? x86_xgetbv() : 0;
+    const bool avx = (ecx1 & (1u << 28)) && (xcr0 & 0x06) == 0x06;
+    if (!avx)
+        return 0;
+
+    unsigned int features = 1;
+    if (ecx1 & (1u << 12))
+        features |= 2;
+
+    if (max_leaf >= 7)
+    {
+        x86_cpuid(7, 0, regs);
+        const unsigned int ebx7 = regs[1];
+        const unsigned int ecx7 = regs[2];
+        if (ebx7 & (1u << 5))
+            features |= 4;
+
+        // avx512 needs opmask and zmm state too
+        if ((ebx7 & (1u << 16)) && (xcr0 & 0xe6) == 0xe6)
+        {
+            features |= 8;
+
+            // vnni kernels use the byte and 256-bit forms as well
+            if ((ebx7 & (1u << 30)) && (ebx7 & (1u << 31)) && (ecx7 & (1u << 11)))
+                features |= 16;
+        }
+    }
+
+    return features;
+}
+
+static unsigned int g_x86_features = get_x86_features();
+#endif // NCNN_CPU_X86
+
+int cpu_support_x86_avx()
+{
+#if NCNN_CPU_X86
+    return g_x86_features & 1 ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
+int cpu_support_x86_fma()
+{
+#if NCNN_CPU_X86
+    return g_x86_features & 2 ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
+int cpu_support_x86_avx2()
+{
+#if NCNN_CPU_X86
+    return g_x86_features & 4 ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
+int cpu_support_x86_avx512f()
+{
+#if NCNN_CPU_X86
+    return g_x86_features & 8 ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
+int cpu_support_x86_avx512vnni()
+{
+#if NCNN_CPU_X86
+    return g_x86_features & 16 ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
+// best x86 layer variant both this cpu and the build have
+static int get_max_x86_isa()
+{
+    int isa = 0;
+#if NCNN_RUNTIME_CPU_AVX
+    if (cpu_support_x86_avx())
+        isa = 1;
+#endif
+#if NCNN_RUNTIME_CPU_AVX2
+    if (cpu_support_x86_avx2() && cpu_support_x86_fma())
+        isa = 2;
+#endif
+#if NCNN_RUNTIME_CPU_AVX512
+    if (cpu_support_x86_avx512f() && cpu_support_x86_avx2() && cpu_support_x86_fma())
+        isa = 3;
+#endif
+#if NCNN_RUNTIME_CPU_AVX512VNNI
+    if (cpu_support_x86_avx512vnni() && cpu_support_x86_avx2() && cpu_support_x86_fma())
+        isa = 4;
+#endif
+    return isa;
+}
+
+static int g_x86_isa = get_max_x86_isa();
+
+int get_cpu_x86_isa()
+{
+    return g_x86_isa;
+}
+
+int set_cpu_x86_isa(int isa)
+{
+    if (isa < 0)
+    {
+        fprintf(stderr, "invalid x86 isa %d\n", isa);
+        return -1;
+    }
+
+    const int max_isa = get_max_x86_isa();
+    g_x86_isa = isa < max_isa ? isa : max_isa;
+
+    return 0;
+}
+
 static int get_cpucount()
 {
 #ifdef __ANDROID__
@@ -546,4 +722,13 @@ void set_omp_dynamic(int dynamic)
 #endif
 }
 
+int get_omp_thread_num()
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
 } // namespace ncnn
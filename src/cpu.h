@@ -24,6 +24,29 @@ int cpu_support_arm_neon();
 int cpu_support_arm_vfpv4();
 // asimdhp = aarch64 asimd half precision
 int cpu_support_arm_asimdhp();
+// avx = x86 avx with os saved ymm state
+int cpu_support_x86_avx();
+// fma = x86 fma3
+int cpu_support_x86_fma();
+// avx2 = x86 avx2
+int cpu_support_x86_avx2();
+// avx512f = x86 avx512 foundation with os saved zmm state
+int cpu_support_x86_avx512f();
+// avx512vnni = x86 avx512 vnni with avx512bw and avx512vl
+int cpu_support_x86_avx512vnni();
+
+// instruction set create_layer picks the x86 layer variant for
+// variants are built when NCNN_RUNTIME_CPU is enabled
+// 0 = compiled baseline
+// 1 = avx
+// 2 = avx2 + fma
+// 3 = avx512f
+// 4 = avx512f + vnni
+// defaults to the best one this cpu and build support
+// the setter clamps to that, layers created before keep their variant
+// return 0 if success for setter function
+int get_cpu_x86_isa();
+int set_cpu_x86_isa(int isa);
 
 // cpu info
 int get_cpu_count();
@@ -46,6 +69,8 @@ void set_omp_num_threads(int num_threads);
 int get_omp_dynamic();
 void set_omp_dynamic(int dynamic);
 
+int get_omp_thread_num();
+
 } // namespace ncnn
 
 #endif // NCNN_CPU_H
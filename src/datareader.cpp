@@ -31,6 +31,11 @@ int DataReader::read(void* /*buf*/, int /*size*/) const
     return 0;
 }
 
+int DataReader::reference(int /*size*/, const void** /*buf*/) const
+{
+    return 0;
+}
+
 #if NCNN_STDIO
 DataReaderFromStdio::DataReaderFromStdio(FILE* _fp) : fp(_fp)
 {
@@ -74,6 +79,37 @@ int DataReaderFromMemory::read(void* buf, int size) const
     return size;
 }
 
+int DataReaderFromMemory::reference(int size, const void** buf) const
+{
+    *buf = mem;
+    mem += size;
+    return size;
+}
+
+DataReaderFromMapping::DataReaderFromMapping(const unsigned char* _mem, size_t size) : mem(_mem), end(_mem + size)
+{
+}
+
+int DataReaderFromMapping::read(void* buf, int size) const
+{
+    if (size > end - mem)
+        size = end - mem;
+
+    memcpy(buf, mem, size);
+    mem += size;
+    return size;
+}
+
+int DataReaderFromMapping::reference(int size, const void** buf) const
+{
+    if (size > end - mem)
+        return 0;
+
+    *buf = mem;
+    mem += size;
+    return size;
+}
+
 #if __ANDROID_API__ >= 9
 DataReaderFromAndroidAsset::DataReaderFromAndroidAsset(AAsset* _asset) : asset(_asset), mem(0)
 {
@@ -37,6 +37,11 @@ public:
     // read binary param and model data
     // return bytes read
     virtual int read(void* buf, int size) const;
+
+    // reference size bytes of model data in place and advance
+    // the referenced memory must outlive the loaded weights
+    // return bytes referenced, 0 if the reader can not reference
+    virtual int reference(int size, const void** buf) const;
 };
 
 #if NCNN_STDIO
@@ -60,11 +65,26 @@ public:
 
     virtual int scan(const char* format, void* p) const;
     virtual int read(void* buf, int size) const;
+    virtual int reference(int size, const void** buf) const;
 
 protected:
     const unsigned char*& mem;
 };
 
+// read and reference model data from a mapped file of known size
+class DataReaderFromMapping : public DataReader
+{
+public:
+    DataReaderFromMapping(const unsigned char* mem, size_t size);
+
+    virtual int read(void* buf, int size) const;
+    virtual int reference(int size, const void** buf) const;
+
+protected:
+    mutable const unsigned char* mem;
+    const unsigned char* end;
+};
+
 #if __ANDROID_API__ >= 9
 class DataReaderFromAndroidAsset : public DataReader
 {
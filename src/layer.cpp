@@ -20,6 +20,13 @@
 #include <algorithm>
 #include "cpu.h"
 
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+#if __AVX__
+#include <immintrin.h>
+#endif
+
 #ifdef __clang__
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Woverloaded-virtual"
@@ -38,6 +45,9 @@ Layer::Layer()
     support_vulkan = false;
     support_packing = false;
 
+    pipeline_weights_restored = false;
+    support_batch = false;
+
 #if NCNN_VULKAN
     vkdev = 0;
 #endif // NCNN_VULKAN
@@ -67,7 +77,13 @@ int Layer::destroy_pipeline(const Option& /*opt*/)
     return 0;
 }
 
-int Layer::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+int Layer::pipeline_weights(std::vector<Mat*>& weights)
+{
+    weights.clear();
+    return 0;
+}
+
+int Layer::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
     if (!support_inplace)
         return -1;
@@ -83,7 +99,7 @@ int Layer::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_b
     return forward_inplace(top_blobs, opt);
 }
 
-int Layer::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+int Layer::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     if (!support_inplace)
         return -1;
@@ -95,60 +111,174 @@ int Layer::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
     return forward_inplace(top_blob, opt);
 }
 
-int Layer::forward_inplace(std::vector<Mat>& /*bottom_top_blobs*/, const Option& /*opt*/)
+int Layer::select_kernel(const Mat& /*bottom_blob*/, const Option& /*opt*/) const
+{
+    return -1;
+}
+
+int Layer::candidate_kernels(const Mat& /*bottom_blob*/, std::vector<int>& kernels, const Option& /*opt*/) const
+{
+    kernels.clear();
+    return 0;
+}
+
+int Layer::forward_with_kernel(const Mat& bottom_blob, Mat& top_blob, int /*kernel*/, const Option& opt) const
+{
+    return forward(bottom_blob, top_blob, opt);
+}
+
+int Layer::forward_batch(const std::vector< std::vector<Mat> >& bottom_batch, std::vector< std::vector<Mat> >& top_batch, const Option& opt) const
+{
+    top_batch.resize(bottom_batch.size());
+    for (size_t i=0; i<bottom_batch.size(); i++)
+    {
+        top_batch[i].resize(tops.size());
+
+        int ret = forward(bottom_batch[i], top_batch[i], opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+int Layer::forward_batch(const std::vector<Mat>& bottom_batch, std::vector<Mat>& top_batch, const Option& opt) const
+{
+    top_batch.resize(bottom_batch.size());
+    for (size_t i=0; i<bottom_batch.size(); i++)
+    {
+        int ret = forward(bottom_batch[i], top_batch[i], opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+int Layer::forward_inplace(std::vector<Mat>& /*bottom_top_blobs*/, const Option& /*opt*/) const
 {
     return -1;
 }
 
-int Layer::forward_inplace(Mat& /*bottom_top_blob*/, const Option& /*opt*/)
+int Layer::forward_inplace(Mat& /*bottom_top_blob*/, const Option& /*opt*/) const
 {
     return -1;
 }
 
-int Layer::sum_channels_vec_indices_arm(const Mat& bottom_blob, Mat& top_blob, const std::vector<std::vector<int>>& indexes, const Option& opt)
+int Layer::sum_channels_vec_indices_arm(const Mat& bottom_blob, Mat& top_blob, const std::vector<std::vector<int>>& indexes, const Option& opt) const
 {
     #if BISONAI_DEBUG
     printf("Layer::sum_channels_vec_indices_arm\n");
     #endif
-    const auto w = bottom_blob.w;
-    const auto h = bottom_blob.h;
-    const auto size = w*h;
-
+    const int size = bottom_blob.w * bottom_blob.h;
     const int top_blob_channels = indexes.size();
 
-    auto top_idx = 0;
-
-    for (const auto & vec_idx : indexes)
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<top_blob_channels; q++)
     {
-        if (vec_idx.size() == 0) continue;
+        const std::vector<int>& vec_idx = indexes[q];
+        const int n = vec_idx.size();
+
+        float* outptr = top_blob.channel(q);
 
-        for (const auto j : vec_idx)
+        if (n == 0)
         {
-            const float* ptr = bottom_blob.channel(j);
-            float* outptr = top_blob.channel(top_idx);
+            memset(outptr, 0, size * sizeof(float));
+            continue;
+        }
 
-            int k = 0;
-            for (; k<size / 4; k++)
-            {
-                float32x4_t _p = vld1q_f32(outptr);
-                float32x4_t _p1 = vld1q_f32(ptr);
-                _p = vaddq_f32(_p, _p1);
-                vst1q_f32(outptr, _p);
+        std::vector<const float*> ptrs(n);
+        for (int j=0; j<n; j++)
+        {
+            ptrs[j] = bottom_blob.channel(vec_idx[j]);
+        }
 
-                ptr += 4;
-                outptr += 4;
+        int i = 0;
+#if __ARM_NEON
+        for (; i+3<size; i+=4)
+        {
+            float32x4_t _sum = vld1q_f32(ptrs[0] + i);
+            for (int j=1; j<n; j++)
+            {
+                _sum = vaddq_f32(_sum, vld1q_f32(ptrs[j] + i));
             }
-
-            k = 0;
-            for (; k < size % 4; k++)
+            vst1q_f32(outptr + i, _sum);
+        }
+#endif // __ARM_NEON
+        for (; i<size; i++)
+        {
+            float sum = ptrs[0][i];
+            for (int j=1; j<n; j++)
             {
-                *outptr += *ptr;
-                ptr += 1;
-                outptr += 1;
+                sum += ptrs[j][i];
             }
+            outptr[i] = sum;
         }
+    }
 
-        top_idx++;
+    return 0;
+}
+
+int Layer::sum_channels_vec_indices_x86(const Mat& bottom_blob, Mat& top_blob, const std::vector<std::vector<int>>& indexes, const Option& opt) const
+{
+    #if BISONAI_DEBUG
+    printf("Layer::sum_channels_vec_indices_x86\n");
+    #endif
+    const int size = bottom_blob.w * bottom_blob.h;
+    const int top_blob_channels = indexes.size();
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<top_blob_channels; q++)
+    {
+        const std::vector<int>& vec_idx = indexes[q];
+        const int n = vec_idx.size();
+
+        float* outptr = top_blob.channel(q);
+
+        if (n == 0)
+        {
+            memset(outptr, 0, size * sizeof(float));
+            continue;
+        }
+
+        std::vector<const float*> ptrs(n);
+        for (int j=0; j<n; j++)
+        {
+            ptrs[j] = bottom_blob.channel(vec_idx[j]);
+        }
+
+        int i = 0;
+#if __AVX__
+        for (; i+7<size; i+=8)
+        {
+            __m256 _sum = _mm256_loadu_ps(ptrs[0] + i);
+            for (int j=1; j<n; j++)
+            {
+                _sum = _mm256_add_ps(_sum, _mm256_loadu_ps(ptrs[j] + i));
+            }
+            _mm256_storeu_ps(outptr + i, _sum);
+        }
+#endif // __AVX__
+#if __SSE2__
+        for (; i+3<size; i+=4)
+        {
+            __m128 _sum = _mm_loadu_ps(ptrs[0] + i);
+            for (int j=1; j<n; j++)
+            {
+                _sum = _mm_add_ps(_sum, _mm_loadu_ps(ptrs[j] + i));
+            }
+            _mm_storeu_ps(outptr + i, _sum);
+        }
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            float sum = ptrs[0][i];
+            for (int j=1; j<n; j++)
+            {
+                sum += ptrs[j][i];
+            }
+            outptr[i] = sum;
+        }
     }
 
     return 0;
@@ -160,7 +290,7 @@ int Layer::upload_model(VkTransfer& /*cmd*/, const Option& /*opt*/)
     return 0;
 }
 
-int Layer::forward(const std::vector<VkMat>& bottom_blobs, std::vector<VkMat>& top_blobs, VkCompute& cmd, const Option& opt)
+int Layer::forward(const std::vector<VkMat>& bottom_blobs, std::vector<VkMat>& top_blobs, VkCompute& cmd, const Option& opt) const
 {
     if (!support_inplace)
         return -1;
@@ -178,7 +308,7 @@ int Layer::forward(const std::vector<VkMat>& bottom_blobs, std::vector<VkMat>& t
     return forward_inplace(top_blobs, cmd, opt);
 }
 
-int Layer::forward(const VkMat& bottom_blob, VkMat& top_blob, VkCompute& cmd, const Option& opt)
+int Layer::forward(const VkMat& bottom_blob, VkMat& top_blob, VkCompute& cmd, const Option& opt) const
 {
     if (!support_inplace)
         return -1;
@@ -192,12 +322,12 @@ int Layer::forward(const VkMat& bottom_blob, VkMat& top_blob, VkCompute& cmd, co
     return forward_inplace(top_blob, cmd, opt);
 }
 
-int Layer::forward_inplace(std::vector<VkMat>& /*bottom_top_blobs*/, VkCompute& /*cmd*/, const Option& /*opt*/)
+int Layer::forward_inplace(std::vector<VkMat>& /*bottom_top_blobs*/, VkCompute& /*cmd*/, const Option& /*opt*/) const
 {
     return -1;
 }
 
-int Layer::forward_inplace(VkMat& /*bottom_top_blob*/, VkCompute& /*cmd*/, const Option& /*opt*/)
+int Layer::forward_inplace(VkMat& /*bottom_top_blob*/, VkCompute& /*cmd*/, const Option& /*opt*/) const
 {
     return -1;
 }
@@ -210,16 +340,123 @@ static const layer_registry_entry layer_registry[] =
 
 static const int layer_registry_entry_count = sizeof(layer_registry) / sizeof(layer_registry_entry);
 
+// x86 layers built for wider instruction sets, same order as layer_registry
+#if NCNN_RUNTIME_CPU_AVX
+static const layer_registry_entry layer_registry_avx[] =
+{
+#include "layer_registry_avx.h"
+};
+#endif // NCNN_RUNTIME_CPU_AVX
+
+#if NCNN_RUNTIME_CPU_AVX2
+static const layer_registry_entry layer_registry_avx2[] =
+{
+#include "layer_registry_avx2.h"
+};
+#endif // NCNN_RUNTIME_CPU_AVX2
+
+#if NCNN_RUNTIME_CPU_AVX512
+static const layer_registry_entry layer_registry_avx512[] =
+{
+#include "layer_registry_avx512.h"
+};
+#endif // NCNN_RUNTIME_CPU_AVX512
+
+#if NCNN_RUNTIME_CPU_AVX512VNNI
+static const layer_registry_entry layer_registry_avx512vnni[] =
+{
+#include "layer_registry_avx512vnni.h"
+};
+#endif // NCNN_RUNTIME_CPU_AVX512VNNI
+
+static const layer_registry_entry* layer_registry_for_cpu()
+{
+    int isa = get_cpu_x86_isa();
+    (void)isa;
+
+#if NCNN_RUNTIME_CPU_AVX512VNNI
+    if (isa >= 4)
+        return layer_registry_avx512vnni;
+#endif
+#if NCNN_RUNTIME_CPU_AVX512
+    if (isa >= 3)
+        return layer_registry_avx512;
+#endif
+#if NCNN_RUNTIME_CPU_AVX2
+    if (isa >= 2)
+        return layer_registry_avx2;
+#endif
+#if NCNN_RUNTIME_CPU_AVX
+    if (isa >= 1)
+        return layer_registry_avx;
+#endif
+
+    return layer_registry;
+}
+
 #if NCNN_STRING
-int layer_to_index(const char* type)
+static unsigned int layer_type_hash(const char* type)
 {
-    for (int i=0; i<layer_registry_entry_count; i++)
+    // fnv-1a
+    unsigned int hash = 2166136261u;
+    for (; *type; type++)
     {
-        if (strcmp(type, layer_registry[i].name) == 0)
-            return i;
+        hash ^= (unsigned char)*type;
+        hash *= 16777619u;
     }
 
-    return -1;
+    return hash;
+}
+
+// open addressing table from layer type name to registry index
+class LayerTypeTable
+{
+public:
+    LayerTypeTable()
+    {
+        int size = 1;
+        while (size < layer_registry_entry_count * 2)
+            size *= 2;
+
+        mask = size - 1;
+        slots.resize(size, -1);
+
+        // inserted in registry order, so the first of duplicated names is found first
+        for (int i=0; i<layer_registry_entry_count; i++)
+        {
+            unsigned int j = layer_type_hash(layer_registry[i].name) & mask;
+            while (slots[j] != -1)
+                j = (j + 1) & mask;
+
+            slots[j] = i;
+        }
+    }
+
+    int find(const char* type) const
+    {
+        unsigned int j = layer_type_hash(type) & mask;
+        while (slots[j] != -1)
+        {
+            if (strcmp(type, layer_registry[slots[j]].name) == 0)
+                return slots[j];
+
+            j = (j + 1) & mask;
+        }
+
+        return -1;
+    }
+
+private:
+    std::vector<int> slots;
+    unsigned int mask;
+};
+
+int layer_to_index(const char* type)
+{
+    // built on first lookup
+    static const LayerTypeTable table;
+
+    return table.find(type);
 }
 
 Layer* create_layer(const char* type)
@@ -237,7 +474,7 @@ Layer* create_layer(int index)
     if (index < 0 || index >= layer_registry_entry_count)
         return 0;
 
-    layer_creator_func layer_creator = layer_registry[index].creator;
+    layer_creator_func layer_creator = layer_registry_for_cpu()[index].creator;
     if (!layer_creator)
         return 0;
 
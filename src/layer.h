@@ -57,6 +57,12 @@ public:
     // return 0 if success
     virtual int destroy_pipeline(const Option& opt = Option());
 
+    // transformed weight data created by create_pipeline
+    // the weight cache stores them after create_pipeline
+    // and fills them in before create_pipeline on later loads
+    // return 0 if success
+    virtual int pipeline_weights(std::vector<Mat*>& weights);
+
 public:
     // one input and one output blob
     bool one_blob_only;
@@ -70,18 +76,52 @@ public:
     // accept input blob with packed storage
     bool support_packing;
 
+    // pipeline_weights were filled in from the weight cache
+    // create_pipeline skips the transforms producing them
+    bool pipeline_weights_restored;
+
+    // forward_batch runs the samples of a batch together
+    // otherwise the net forwards a batch one sample at a time
+    bool support_batch;
+
 public:
     // implement inference
     // return 0 if success
-    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt = Option());
-    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt = Option());
+    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt = Option()) const;
+    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt = Option()) const;
 
     // implement inplace inference
     // return 0 if success
-    virtual int forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt = Option());
-    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt = Option());
+    virtual int forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt = Option()) const;
+    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt = Option()) const;
+
+    // kernel forward runs for this bottom blob when several fit the shape
+    // return -1 if the layer has a single kernel
+    virtual int select_kernel(const Mat& bottom_blob, const Option& opt = Option()) const;
+
+    // kernels forward_with_kernel can run for this bottom blob
+    // left empty if the layer has a single kernel
+    // return 0 if success
+    virtual int candidate_kernels(const Mat& bottom_blob, std::vector<int>& kernels, const Option& opt = Option()) const;
+
+    // forward running the given kernel instead of the one select_kernel picks
+    // -1 or a kernel not available falls back to select_kernel
+    // the default ignores kernel and runs forward
+    // return 0 if success
+    virtual int forward_with_kernel(const Mat& bottom_blob, Mat& top_blob, int kernel, const Option& opt = Option()) const;
 
-    int sum_channels_vec_indices_arm(const Mat& bottom_blob, Mat& top_blob, const std::vector<std::vector<int>>& indexes, const Option& opt);
+    // implement batched inference, one entry per sample
+    // bottom_batch[i] of multi-blob layers holds the bottom blobs of sample i
+    // the default runs forward on every sample
+    // return 0 if success
+    virtual int forward_batch(const std::vector< std::vector<Mat> >& bottom_batch, std::vector< std::vector<Mat> >& top_batch, const Option& opt = Option()) const;
+    virtual int forward_batch(const std::vector<Mat>& bottom_batch, std::vector<Mat>& top_batch, const Option& opt = Option()) const;
+
+    // gather-sum channels, top channel i is the sum of bottom channels indexes[i]
+    // every top channel is written once, an empty index list gives zeros
+    // return 0 if success
+    int sum_channels_vec_indices_arm(const Mat& bottom_blob, Mat& top_blob, const std::vector<std::vector<int>>& indexes, const Option& opt) const;
+    int sum_channels_vec_indices_x86(const Mat& bottom_blob, Mat& top_blob, const std::vector<std::vector<int>>& indexes, const Option& opt) const;
 
 #if NCNN_VULKAN
 public:
@@ -91,13 +131,13 @@ public:
 public:
     // implement inference
     // return 0 if success
-    virtual int forward(const std::vector<VkMat>& bottom_blobs, std::vector<VkMat>& top_blobs, VkCompute& cmd, const Option& opt = Option());
-    virtual int forward(const VkMat& bottom_blob, VkMat& top_blob, VkCompute& cmd, const Option& opt = Option());
+    virtual int forward(const std::vector<VkMat>& bottom_blobs, std::vector<VkMat>& top_blobs, VkCompute& cmd, const Option& opt = Option()) const;
+    virtual int forward(const VkMat& bottom_blob, VkMat& top_blob, VkCompute& cmd, const Option& opt = Option()) const;
 
     // implement inplace inference
     // return 0 if success
-    virtual int forward_inplace(std::vector<VkMat>& bottom_top_blobs, VkCompute& cmd, const Option& opt = Option());
-    virtual int forward_inplace(VkMat& bottom_top_blob, VkCompute& cmd, const Option& opt = Option());
+    virtual int forward_inplace(std::vector<VkMat>& bottom_top_blobs, VkCompute& cmd, const Option& opt = Option()) const;
+    virtual int forward_inplace(VkMat& bottom_top_blob, VkCompute& cmd, const Option& opt = Option()) const;
 
 public:
     // assigned immediately after creating this layer
@@ -24,7 +24,7 @@ class AbsVal : public Layer
 public:
     AbsVal();
 
-    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt);
+    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
 };
 
 } // namespace ncnn
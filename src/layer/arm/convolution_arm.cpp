@@ -103,6 +103,14 @@ int Convolution_arm::create_pipeline(const Option& opt)
         activation->create_pipeline(opt);
     }
 
+    // product-quantized weight runs the lookup table forward of Convolution
+    if (!weight_codebook.empty())
+    {
+        use_fp32_packing_inference = false;
+        support_packing = false;
+        return 0;
+    }
+
     const int maxk = kernel_w * kernel_h;
     int num_input = weight_data_size / maxk / num_output;
 
@@ -116,12 +124,24 @@ int Convolution_arm::create_pipeline(const Option& opt)
         support_packing = false;
     }
 
+    #if BISONAI_KILL_THE_BITS
+    // channel groups index unpacked input channels
+    if (use_channel_reduction)
+    {
+        use_fp32_packing_inference = false;
+        support_packing = false;
+    }
+    #endif
+
     if (use_fp32_packing_inference)
     {
 
     // pack4
     if (num_input % 4 == 0 && num_output % 4 == 0)
     {
+        if (pipeline_weights_restored)
+            return 0;
+
         if (kernel_w == 1 && kernel_h == 1 && stride_w == 1 && stride_h == 1 && dilation_w == 1 && dilation_h == 1)
         {
             conv1x1s1_sgemm_transform_kernel_pack4_neon(weight_data, weight_data_pack4, num_input, num_output);
@@ -209,6 +229,9 @@ int Convolution_arm::create_pipeline(const Option& opt)
     // pack1to4
     if (num_input % 4 != 0 && num_output % 4 == 0)
     {
+        if (pipeline_weights_restored)
+            return 0;
+
         // src = kw-kh-inch-outch
         // dst = 4b-kw-kh-inch-outch/4b
         {
@@ -253,6 +276,9 @@ int Convolution_arm::create_pipeline(const Option& opt)
     // pack4to1
     if (num_input % 4 == 0 && num_output % 4 != 0)
     {
+        if (pipeline_weights_restored)
+            return 0;
+
         if (kernel_w == 1 && kernel_h == 1 && stride_w == 1 && stride_h == 1 && dilation_w == 1 && dilation_h == 1)
         {
             conv1x1s1_sgemm_transform_kernel_pack4to1_neon(weight_data, weight_data_pack4to1, num_input, num_output);
@@ -336,16 +362,19 @@ int Convolution_arm::create_pipeline(const Option& opt)
 
         if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
         {
-            conv3x3s2_transform_kernel_int8_neon(weight_data, weight_3x3s2_int8_data, num_input, num_output);
+            if (!pipeline_weights_restored)
+                conv3x3s2_transform_kernel_int8_neon(weight_data, weight_3x3s2_int8_data, num_input, num_output);
         }
         else if (kernel_w == 1 && kernel_h == 1 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
         {
-            conv1x1s1_sgemm_transform_kernel_int8_neon(weight_data, weight_1x1s1_sgemm_int8_data, num_input, num_output);
+            if (!pipeline_weights_restored)
+                conv1x1s1_sgemm_transform_kernel_int8_neon(weight_data, weight_1x1s1_sgemm_int8_data, num_input, num_output);
             use_sgemm1x1 = true;
         }
         else
         {
-            conv_im2col_sgemm_transform_kernel_int8_neon(weight_data, weight_sgemm_int8_data, num_input, num_output, maxk);
+            if (!pipeline_weights_restored)
+                conv_im2col_sgemm_transform_kernel_int8_neon(weight_data, weight_sgemm_int8_data, num_input, num_output, maxk);
         }
 
         return 0;
@@ -353,6 +382,9 @@ int Convolution_arm::create_pipeline(const Option& opt)
 
     if (impl_type > 0)
     {
+        if (pipeline_weights_restored)
+            return 0;
+
         switch(impl_type)
         {
             case 1:
@@ -380,36 +412,27 @@ int Convolution_arm::create_pipeline(const Option& opt)
         return 0;
     }
 
-    if (use_winograd3x3)
+    if (use_winograd3x3 && !pipeline_weights_restored)
     {
 //         conv3x3s1_winograd64_transform_kernel_neon(weight_data, weight_3x3_winograd64_data, num_input, num_output);
         conv3x3s1_winograd64_transform_kernel_neon5(weight_data, weight_3x3_winograd64_data, num_input, num_output);
     }
 
-    if (use_sgemm1x1)
+    if (use_sgemm1x1 && !pipeline_weights_restored)
     {
         conv1x1s1_sgemm_transform_kernel_neon(weight_data, weight_1x1_sgemm_data, num_input, num_output);
     }
 
-    if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
+    if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2 && !pipeline_weights_restored)
     {
         conv3x3s2_transform_kernel_neon(weight_data, weight_3x3s2_data, num_input, num_output);
     }
 
+    if (!pipeline_weights_restored)
     {
         conv_im2col_sgemm_transform_kernel_neon(weight_data, weight_sgemm_data, num_input, num_output, maxk);
     }
 
-    #if BISONAI_KILL_THE_BITS
-    // Reduce number of channels in `weight_data`
-    const int input_channel_reduced = reduced_input_channels;
-    weight_data_reduced.create(kernel_w*kernel_h*input_channel_reduced*num_output, 1, 1, 4u, opt.blob_allocator);
-
-    // Preallocate bottom_blob
-    bottom_blob_bordered_reduced.create(input_feature_size, input_feature_size, reduced_input_channels, 4u, opt.blob_allocator);
-    bottom_blob_bordered_reduced.fill(0.0f);
-    #endif
-
     #if BISONAI_DEBUG
     printf("End of Convolution_arm::create_pipeline\n");
     #endif
@@ -428,6 +451,23 @@ int Convolution_arm::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+int Convolution_arm::pipeline_weights(std::vector<Mat*>& weights)
+{
+    weights.clear();
+    weights.push_back(&weight_3x3_winograd64_data);
+    weights.push_back(&weight_1x1_sgemm_data);
+    weights.push_back(&weight_3x3s2_data);
+    weights.push_back(&weight_3x3s2_int8_data);
+    weights.push_back(&weight_1x1s1_sgemm_int8_data);
+    weights.push_back(&weight_sgemm_int8_data);
+    weights.push_back(&weight_sgemm_data);
+    weights.push_back(&weight_data_pack4);
+    weights.push_back(&weight_data_pack1to4);
+    weights.push_back(&weight_data_pack4to1);
+
+    return 0;
+}
+
 int Convolution_arm::forwardDilation(const Mat& bottom_blob, Mat& top_blob, conv_func conv, const Option& opt) const
 {
     int w = bottom_blob.w;
@@ -552,7 +592,7 @@ int Convolution_arm::forwardDilation(const Mat& bottom_blob, Mat& top_blob, conv
     return 0;
 }
 
-int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     #if BISONAI_DEBUG
     printf("Convolution_arm::forward\n");
@@ -561,6 +601,23 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     // convolv with NxN kernel
     // value = value + bias
 
+    #if BISONAI_KILL_THE_BITS
+    if (use_channel_reduction && bottom_blob.dims == 3 && bottom_blob.c == original_input_channels)
+    {
+        Mat bottom_blob_reduced;
+        int ret = reduce_input_channels(bottom_blob, bottom_blob_reduced, opt);
+        if (ret != 0)
+            return ret;
+
+        return forward(bottom_blob_reduced, top_blob, opt);
+    }
+    #endif // BISONAI_KILL_THE_BITS
+
+    if (!weight_codebook.empty())
+    {
+        return Convolution::forward(bottom_blob, top_blob, opt);
+    }
+
 #if __ARM_NEON
     if (use_fp32_packing_inference)
     {
@@ -1127,12 +1184,15 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         bottom_blob_unbordered = bottom_blob_int8;
     }
 
+    // the int8 bottom blob pads with the quantized pad value
+    const float border_value = bottom_blob_unbordered.elemsize == 1 ? pad_value * bottom_blob_int8_scale + bottom_blob_int8_zero_point : pad_value;
+
     Mat bottom_blob_bordered = bottom_blob_unbordered;
     if (pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0)
     {
         Option opt_b = opt;
         opt_b.blob_allocator = opt.workspace_allocator;
-        copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, pad_value, opt_b);
+        copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, border_value, opt_b);
     }
     else if (pad_left == -233 && pad_right == -233 && pad_top == -233 && pad_bottom == -233)
     {
@@ -1142,7 +1202,7 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         {
             Option opt_b = opt;
             opt_b.blob_allocator = opt.workspace_allocator;
-            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
+            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, border_value, opt_b);
         }
     }
     else if (pad_left == -234 && pad_right == -234 && pad_top == -234 && pad_bottom == -234)
@@ -1153,7 +1213,7 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         {
             Option opt_b = opt;
             opt_b.blob_allocator = opt.workspace_allocator;
-            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad - hpad / 2, hpad / 2, wpad - wpad / 2, wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
+            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad - hpad / 2, hpad / 2, wpad - wpad / 2, wpad / 2, BORDER_CONSTANT, border_value, opt_b);
         }
     }
     if (bottom_blob_bordered.empty())
@@ -1323,40 +1383,7 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         }
         else
         {
-            #if BISONAI_KILL_THE_BITS
-            for (auto idx = 0; idx < num_output; ++idx)
-            {
-                #if BISONAI_DEBUG
-                printf("Channel-wise reduction idx: %d\n", idx);
-                #endif
-
-                this->sum_channels_vec_indices_arm(bottom_blob_bordered, bottom_blob_bordered_reduced, assignments, opt);
-            }
-
-            #if BISONAI_DEBUG
-            printf("bottom_blob_bordered w=%d\n", bottom_blob_bordered.w);
-            printf("bottom_blob_bordered h=%d\n", bottom_blob_bordered.h);
-            printf("bottom_blob_bordered c=%d\n", bottom_blob_bordered.c);
-            printf("bottom_blob_bordered elemsize=%d\n", bottom_blob_bordered.elemsize);
-            printf("bottom_blob_bordered elempack=%d\n", bottom_blob_bordered.elempack);
-
-            printf("bottom_blob_reduced w=%d\n", bottom_blob_bordered_reduced.w);
-            printf("bottom_blob_reduced h=%d\n", bottom_blob_bordered_reduced.h);
-            printf("bottom_blob_reduced c=%d\n", bottom_blob_bordered_reduced.c);
-            printf("bottom_blob_reduced elemsize=%d\n", bottom_blob_bordered_reduced.elemsize);
-            printf("bottom_blob_reduced elempack=%d\n", bottom_blob_bordered_reduced.elempack);
-
-            printf("kernel w=%d\n", weight_data_reduced.w);
-            printf("kernel h=%d\n", weight_data_reduced.h);
-            printf("kernel c=%d\n", weight_data_reduced.c);
-            printf("kernel elemsize=%d\n", weight_data_reduced.elemsize);
-            printf("kernel elempack=%d\n", weight_data_reduced.elempack);
-            #endif
-
-            conv(bottom_blob_bordered_reduced, top_blob, weight_data_reduced, bias_data, opt);
-            #else
             conv(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
-            #endif
         }
     }
 
@@ -24,7 +24,7 @@ class Flatten_arm : virtual public Flatten
 public:
     Flatten_arm();
 
-    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt);
+    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 };
 
 } // namespace ncnn
@@ -38,6 +38,14 @@ InnerProduct_arm::InnerProduct_arm()
 
 int InnerProduct_arm::create_pipeline(const Option& opt)
 {
+    // product-quantized weight runs the lookup table forward of InnerProduct
+    if (!weight_codebook.empty())
+    {
+        use_fp32_packing_inference = false;
+        support_packing = false;
+        return 0;
+    }
+
 #if __ARM_NEON
     bool weight_data_is_float32 = (weight_data.elemsize == (size_t)4u);
 
@@ -79,8 +87,13 @@ int InnerProduct_arm::destroy_pipeline(const Option& opt)
     return 0;
 }
 
-int InnerProduct_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+int InnerProduct_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
+    if (!weight_codebook.empty())
+    {
+        return InnerProduct::forward(bottom_blob, top_blob, opt);
+    }
+
     if (use_int8_inference)
     {
         // TODO
@@ -34,6 +34,10 @@ static inline signed char float2int8(float v)
 
 int Requantize_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 { 
+    // per channel scales and zero point run the plain forward
+    if (scale_out_data_size > 1 || zero_point != 0)
+        return Requantize::forward(bottom_blob, top_blob, opt);
+
     int dims = bottom_blob.dims;
 
     if (dims == 1)
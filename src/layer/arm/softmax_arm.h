@@ -24,7 +24,7 @@ class Softmax_arm : virtual public Softmax
 public:
     Softmax_arm();
 
-    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt);
+    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
 };
 
 } // namespace ncnn
@@ -14,7 +14,7 @@
 
 #include "convolution.h"
 #include <algorithm>
-#include <random>
+#include "cpu.h"
 #include "layer_type.h"
 
 namespace ncnn {
@@ -28,6 +28,10 @@ Convolution::Convolution()
     use_int8_requantize = false;
 
     quantize = 0;
+
+    #if BISONAI_KILL_THE_BITS
+    use_channel_reduction = false;
+    #endif
 }
 
 int Convolution::load_param(const ParamDict& pd)
@@ -53,11 +57,13 @@ int Convolution::load_param(const ParamDict& pd)
     activation_type = pd.get(9, 0);
     activation_params = pd.get(10, Mat());
     impl_type = pd.get(17, 0);
+    bottom_blob_int8_zero_point = pd.get(23, 0);
 
     #if BISONAI_KILL_THE_BITS
     original_input_channels = pd.get(19, 0);
     reduced_input_channels = pd.get(20, 0);
     input_feature_size = pd.get(21, 0);
+    Mat channel_group = pd.get(22, Mat());
 
     #if BISONAI_DEBUG
     printf("original_input_channels=%d\n", original_input_channels);
@@ -65,65 +71,89 @@ int Convolution::load_param(const ParamDict& pd)
     printf("input_feature_size=%d\n", input_feature_size);
     #endif
 
-    auto rng = std::default_random_engine {};
-
-    std::vector<int> indexes;
-    for (auto i = 0; i < original_input_channels; ++i)
-        indexes.push_back(i);
-
-    const int channel_reduction_factor = floor(original_input_channels / reduced_input_channels);
-    const int reg_channel_reduction = (reduced_input_channels - 1) * channel_reduction_factor;
-    const int last_channel_reduction_factor = (original_input_channels - reg_channel_reduction);
+    use_channel_reduction = original_input_channels > 0 && reduced_input_channels > 0 && reduced_input_channels < original_input_channels;
 
-    #if BISONAI_DEBUG
-    printf("channel_reduction_factor %d\n", channel_reduction_factor);
-    printf("reg_channel_reduction %d\n", reg_channel_reduction);
-    printf("last_channel_reduction_factor %d\n", last_channel_reduction_factor);
-    printf("sum %d\n", reg_channel_reduction+last_channel_reduction_factor);
-    #endif
-
-    for (auto i = 0; i < reduced_input_channels-1; ++i)
+    assignments.clear();
+    if (use_channel_reduction)
     {
-        std::vector<int> channel_combinations;
-        std::shuffle(std::begin(indexes), std::end(indexes), rng);
+        assignments.resize(reduced_input_channels);
 
-        for (auto j = 0; j < channel_reduction_factor; ++j)
+        if (channel_group.empty())
         {
-            channel_combinations.push_back(indexes.at(j));
+            // contiguous groups, the last one takes the remainder
+            const int channel_reduction_factor = original_input_channels / reduced_input_channels;
+            for (int i=0; i<original_input_channels; i++)
+            {
+                assignments[std::min(i / channel_reduction_factor, reduced_input_channels - 1)].push_back(i);
+            }
         }
+        else
+        {
+            if (channel_group.w != original_input_channels)
+            {
+                fprintf(stderr, "channel group size %d mismatch original_input_channels %d\n", channel_group.w, original_input_channels);
+                return -1;
+            }
 
-        assignments.push_back(channel_combinations);
-    }
+            // group index of each input channel, -1 drops the channel
+            const int* group_ptr = channel_group;
+            for (int i=0; i<original_input_channels; i++)
+            {
+                int g = group_ptr[i];
+                if (g < -1 || g >= reduced_input_channels)
+                {
+                    fprintf(stderr, "invalid channel group %d for input channel %d\n", g, i);
+                    return -1;
+                }
 
-    std::vector<int> channel_combinations;
-    for (auto i = 0; i < last_channel_reduction_factor; ++i)
-    {
-        channel_combinations.push_back(indexes.at(i));
+                if (g >= 0)
+                    assignments[g].push_back(i);
+            }
+        }
     }
-    assignments.push_back(channel_combinations);
-
-    #if BISONAI_DEBUG
-    printf("assignments size %d\n", assignments.size());
-    #endif
-
-    int assignments_sum = 0;
-    for (const auto a : assignments)
-        assignments_sum += a.size();
-    #if BISONAI_DEBUG
-    printf("assignments_sum %d\n", assignments_sum);
-    #endif # BISONAI_DBUG
-
-    #endif # BISONAI_KILL_THE_BITS
+    #endif // BISONAI_KILL_THE_BITS
 
     return 0;
 }
 
 int Convolution::load_model(const ModelBin& mb)
 {
-    weight_data = mb.load(weight_data_size, 0);
+    weight_data = mb.load_pq(weight_data_size, 0, weight_codebook);
     if (weight_data.empty())
         return -100;
 
+    if (!weight_codebook.empty())
+    {
+        // lookup table forward works on whole kernels in float32
+        // create_pipeline decodes the codes unless use_pq_lookup_table is set
+        bool use_lut = weight_codebook.w == kernel_w * kernel_h && !int8_scale_term;
+        #if BISONAI_KILL_THE_BITS
+        use_lut = use_lut && !use_channel_reduction;
+        #endif
+
+        if (use_lut)
+        {
+            weight_codes = weight_data;
+            weight_data.release();
+        }
+        else
+        {
+            weight_data = pq_decode(weight_codebook, weight_data);
+            weight_codebook.release();
+            if (weight_data.empty())
+                return -100;
+        }
+    }
+
+    #if BISONAI_KILL_THE_BITS
+    if (use_channel_reduction)
+    {
+        int ret = reduce_weight_data();
+        if (ret != 0)
+            return ret;
+    }
+    #endif // BISONAI_KILL_THE_BITS
+
     if (bias_term)
     {
         bias_data = mb.load(num_output, 1);
@@ -131,7 +161,15 @@ int Convolution::load_model(const ModelBin& mb)
             return -100;
     }
 
-    if (int8_scale_term)
+    if (int8_scale_term == 3)
+    {
+        const int num_input = weight_data_size / (kernel_w * kernel_h) / num_output;
+
+        weight_data_int8_scales = mb.load(num_output, 1);
+        bottom_blob_int8_scales = mb.load(num_input, 1);
+        bottom_blob_int8_scale = 1.f;
+    }
+    else if (int8_scale_term)
     {
         weight_data_int8_scales = mb.load(num_output, 1);
         bottom_blob_int8_scale = mb.load(1, 1)[0];
@@ -140,8 +178,93 @@ int Convolution::load_model(const ModelBin& mb)
     return 0;
 }
 
+#if BISONAI_KILL_THE_BITS
+int Convolution::reduce_weight_data()
+{
+    const int maxk = kernel_w * kernel_h;
+
+    // weights already reduced offline
+    if (weight_data_size == maxk * reduced_input_channels * num_output)
+        return 0;
+
+    if (weight_data_size != maxk * original_input_channels * num_output)
+    {
+        fprintf(stderr, "weight_data_size %d mismatch original_input_channels %d and reduced_input_channels %d\n", weight_data_size, original_input_channels, reduced_input_channels);
+        return -1;
+    }
+
+    if (weight_data.elemsize != (size_t)4u)
+    {
+        fprintf(stderr, "channel reduction needs float32 weight_data\n");
+        return -1;
+    }
+
+    // summed channels share one kernel, the mean of their kernels
+    Mat weight_data_reduced(maxk * reduced_input_channels * num_output);
+    if (weight_data_reduced.empty())
+        return -100;
+
+    for (int p=0; p<num_output; p++)
+    {
+        const float* kptr = (const float*)weight_data + maxk * original_input_channels * p;
+
+        for (int g=0; g<reduced_input_channels; g++)
+        {
+            float* outptr = (float*)weight_data_reduced + maxk * (reduced_input_channels * p + g);
+
+            const std::vector<int>& group = assignments[g];
+            const float scale = group.empty() ? 0.f : 1.f / group.size();
+
+            for (int k=0; k<maxk; k++)
+            {
+                float sum = 0.f;
+                for (size_t j=0; j<group.size(); j++)
+                {
+                    sum += kptr[maxk * group[j] + k];
+                }
+                outptr[k] = sum * scale;
+            }
+        }
+    }
+
+    weight_data = weight_data_reduced;
+    weight_data_size = maxk * reduced_input_channels * num_output;
+
+    return 0;
+}
+
+int Convolution::reduce_input_channels(const Mat& bottom_blob, Mat& bottom_blob_reduced, const Option& opt) const
+{
+    if (bottom_blob.elemsize != (size_t)4u || bottom_blob.elempack != 1)
+    {
+        fprintf(stderr, "channel reduction needs unpacked float32 input\n");
+        return -1;
+    }
+
+    bottom_blob_reduced.create(bottom_blob.w, bottom_blob.h, reduced_input_channels, (size_t)4u, opt.workspace_allocator);
+    if (bottom_blob_reduced.empty())
+        return -100;
+
+#if __ARM_NEON
+    return sum_channels_vec_indices_arm(bottom_blob, bottom_blob_reduced, assignments, opt);
+#else
+    return sum_channels_vec_indices_x86(bottom_blob, bottom_blob_reduced, assignments, opt);
+#endif // __ARM_NEON
+}
+#endif // BISONAI_KILL_THE_BITS
+
 int Convolution::create_pipeline(const Option& opt)
 {
+    if (!weight_codebook.empty() && !opt.use_pq_lookup_table)
+    {
+        weight_data = pq_decode(weight_codebook, weight_codes);
+        if (weight_data.empty())
+            return -100;
+
+        weight_codebook.release();
+        weight_codes.release();
+    }
+
     bool weight_data_is_int8 = (weight_data.elemsize == (size_t)1u);
     bool weight_data_is_float32 = (weight_data.elemsize == (size_t)4u);
 
@@ -153,6 +276,12 @@ int Convolution::create_pipeline(const Option& opt)
 
     use_int8_inference = opt.use_int8_inference && (weight_data_is_int8 || (weight_data_is_float32 && int8_scale_term));
 
+    if (weight_data_is_float32 && use_int8_inference && int8_scale_term == 3)
+    {
+        fprintf(stderr, "per channel int8 scales need the int8 weight folded by ncnn2int8\n");
+        return -1;
+    }
+
     // runtime quantize the weight data
     if (weight_data_is_float32 && use_int8_inference)
     {
@@ -187,49 +316,38 @@ int Convolution::create_pipeline(const Option& opt)
         weight_data = int8_weight_data;
     }
 
-    // initial the quantize,dequantize op layer
-    if (use_int8_inference)
+    // the int8 bottom blob is offset by the zero point, take its product with the weight off the bias
+    if (use_int8_inference && bottom_blob_int8_zero_point != 0)
     {
-        quantize = ncnn::create_layer(ncnn::LayerType::Quantize);
-        {
-            ncnn::ParamDict pd;
-            pd.set(0, bottom_blob_int8_scale);// scale
-
-            quantize->load_param(pd);
+        Mat bias_data_corrected(num_output);
+        if (bias_data_corrected.empty())
+            return -100;
 
-            quantize->create_pipeline(opt);
-        }
+        const int weight_data_size_output = weight_data_size / num_output;
 
-        dequantize_ops.resize(num_output);
         for (int n=0; n<num_output; n++)
         {
-            dequantize_ops[n] = ncnn::create_layer(ncnn::LayerType::Dequantize);
-
-            float top_rescale = 1.f;
-
-            if (weight_data_int8_scales[n] == 0)
-                top_rescale = 0;
-            else
-                top_rescale = 1.f / (bottom_blob_int8_scale * weight_data_int8_scales[n]);
-
-            ncnn::ParamDict pd;
-            pd.set(0, top_rescale);// scale
-            pd.set(1, bias_term);  // bias_term
-            pd.set(2, 1);          // bias_data_size
+            const signed char* kptr = (const signed char*)weight_data + weight_data_size_output * n;
 
-            dequantize_ops[n]->load_param(pd);
+            int sum = 0;
+            for (int i=0; i<weight_data_size_output; i++)
+                sum += kptr[i];
 
-            dequantize_ops[n]->create_pipeline(opt);
+            float bias = bias_term ? bias_data[n] : 0.f;
+            if (weight_data_int8_scales[n] != 0)
+                bias -= bottom_blob_int8_zero_point * sum / (bottom_blob_int8_scale * weight_data_int8_scales[n]);
 
-            ncnn::Mat weights[1];
-            weights[0] = bias_data.range(n, 1);
-
-            dequantize_ops[n]->load_model(ModelBinFromMatArray(weights));
-
-            dequantize_scales.push_back(top_rescale);
+            bias_data_corrected[n] = bias;
         }
+
+        bias_data = bias_data_corrected;
+        bias_term = 1;
     }
 
+    // initial the quantize,dequantize op layer
+    if (use_int8_inference)
+        create_dequantize_op();
+
     return 0;
 }
 
@@ -262,6 +380,70 @@ int Convolution::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+int Convolution::create_dequantize_op(void)
+{
+    if (!use_int8_inference)
+    {
+        fprintf(stderr, "dequantized op set but use_int8_inference disabled\n");
+        return -1;
+    }
+
+    // the ops of a former bottom_blob_int8_scale
+    if (quantize)
+    {
+        delete quantize;
+        quantize = 0;
+    }
+    for (int i=0; i<(int)dequantize_ops.size(); i++)
+        delete dequantize_ops[i];
+    dequantize_ops.clear();
+    dequantize_scales.clear();
+
+    quantize = ncnn::create_layer(ncnn::LayerType::Quantize);
+    {
+        ncnn::ParamDict pd;
+        pd.set(0, bottom_blob_int8_scale);// scale
+        pd.set(1, int8_scale_term == 3 ? bottom_blob_int8_scales.w : 1);// scale_data_size
+        pd.set(2, bottom_blob_int8_zero_point);// zero_point
+
+        quantize->load_param(pd);
+
+        ncnn::Mat weights[1];
+        weights[0] = bottom_blob_int8_scales;
+
+        quantize->load_model(ModelBinFromMatArray(weights));
+    }
+
+    dequantize_ops.resize(num_output);
+    for (int n=0; n<num_output; n++)
+    {
+        dequantize_ops[n] = ncnn::create_layer(ncnn::LayerType::Dequantize);
+
+        float top_rescale = 1.f;
+
+        if (weight_data_int8_scales[n] == 0)
+            top_rescale = 0;
+        else
+            top_rescale = 1.f / (bottom_blob_int8_scale * weight_data_int8_scales[n]);
+
+        ncnn::ParamDict pd;
+        pd.set(0, top_rescale);// scale
+        pd.set(1, bias_term);  // bias_term
+        pd.set(2, 1);          // bias_data_size
+
+        dequantize_ops[n]->load_param(pd);
+
+        ncnn::Mat weights[1];
+        weights[0] = bias_data.range(n, 1);
+
+        dequantize_ops[n]->load_model(ModelBinFromMatArray(weights));
+
+        dequantize_scales.push_back(top_rescale);
+    }
+
+    return 0;
+}
+
 int Convolution::create_requantize_op(void)
 {
     if (!use_int8_requantize)
@@ -270,6 +452,12 @@ int Convolution::create_requantize_op(void)
         return -1;
     }
 
+    // the ops of a former top_blob_int8_scale
+    for (int i=0; i<(int)requantize_ops.size(); i++)
+        delete requantize_ops[i];
+    requantize_ops.clear();
+    requantize_scales.clear();
+
     requantize_ops.resize(num_output);
     for (int n=0; n<num_output; n++)
     {
@@ -309,7 +497,7 @@ int Convolution::create_requantize_op(void)
     return 0;
 }
 
-int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     #if BISONAI_DEBUG
     printf("Convolution::forward\n");
@@ -317,6 +505,18 @@ int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
     // convolv with NxN kernel
     // value = value + bias
 
+    #if BISONAI_KILL_THE_BITS
+    if (use_channel_reduction && bottom_blob.dims == 3 && bottom_blob.c == original_input_channels)
+    {
+        Mat bottom_blob_reduced;
+        int ret = reduce_input_channels(bottom_blob, bottom_blob_reduced, opt);
+        if (ret != 0)
+            return ret;
+
+        return forward(bottom_blob_reduced, top_blob, opt);
+    }
+    #endif // BISONAI_KILL_THE_BITS
+
     // flattened blob, implement as InnerProduct
     if (bottom_blob.dims == 1 && kernel_w == 1 && kernel_h == 1)
     {
@@ -337,7 +537,7 @@ int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
 
             // set weights
             ncnn::Mat weights[4];
-            weights[0] = weight_data;
+            weights[0] = weight_codebook.empty() ? weight_data : pq_decode(weight_codebook, weight_codes);
             weights[1] = bias_data;
 
             if (int8_scale_term)
@@ -388,12 +588,15 @@ int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
         bottom_blob_unbordered = bottom_blob_int8;
     }
 
+    // the int8 bottom blob pads with the quantized pad value
+    const float border_value = bottom_blob_unbordered.elemsize == 1 ? pad_value * bottom_blob_int8_scale + bottom_blob_int8_zero_point : pad_value;
+
     Mat bottom_blob_bordered = bottom_blob_unbordered;
     if (pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0)
     {
         Option opt_b = opt;
         opt_b.blob_allocator = opt.workspace_allocator;
-        copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, pad_value, opt_b);
+        copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, border_value, opt_b);
     }
     else if (pad_left == -233 && pad_right == -233 && pad_top == -233 && pad_bottom == -233)
     {
@@ -404,7 +607,7 @@ int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
         {
             Option opt_b = opt;
             opt_b.blob_allocator = opt.workspace_allocator;
-            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
+            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, border_value, opt_b);
         }
     }
     else if (pad_left == -234 && pad_right == -234 && pad_top == -234 && pad_bottom == -234)
@@ -416,7 +619,7 @@ int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
         {
             Option opt_b = opt;
             opt_b.blob_allocator = opt.workspace_allocator;
-            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad - hpad / 2, hpad / 2, wpad - wpad / 2, wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
+            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad - hpad / 2, hpad / 2, wpad - wpad / 2, wpad / 2, BORDER_CONSTANT, border_value, opt_b);
         }
     }
     if (bottom_blob_bordered.empty())
@@ -449,6 +652,11 @@ int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
         }
     }
 
+    if (!weight_codebook.empty())
+    {
+        return forward_lut(bottom_blob_bordered, top_blob, outw, outh, space_ofs, opt);
+    }
+
     // int8
     if (use_int8_inference)
     {
@@ -662,4 +870,173 @@ int Convolution::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
     return 0;
 }
 
+int Convolution::forward_lut(const Mat& bottom_blob_bordered, Mat& top_blob, int outw, int outh, const int* space_ofs, const Option& opt) const
+{
+    const int w = bottom_blob_bordered.w;
+    const int channels = bottom_blob_bordered.c;
+    const int outsize = outw * outh;
+    const int maxk = kernel_w * kernel_h;
+    const int num_codeword = weight_codebook.h;
+
+    if (bottom_blob_bordered.elemsize != (size_t)4u || weight_codes.w != num_output * channels)
+    {
+        fprintf(stderr, "Convolution lookup table forward needs float32 input of %d channels\n", weight_codes.w / num_output);
+        return -1;
+    }
+
+    const unsigned char* codes = weight_codes;
+
+    top_blob.create(outw, outh, num_output, (size_t)4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // codewords each input channel refers to, the others need no partial products
+    std::vector<unsigned char> codeword_used(channels * num_codeword, 0);
+    for (int p=0; p<num_output; p++)
+    {
+        for (int q=0; q<channels; q++)
+        {
+            codeword_used[q * num_codeword + codes[p * channels + q]] = 1;
+        }
+    }
+
+    // input offset of each output position
+    std::vector<int> _in_ofs(outsize);
+    int* in_ofs = &_in_ofs[0];
+    for (int i = 0; i < outh; i++)
+    {
+        for (int j = 0; j < outw; j++)
+        {
+            in_ofs[i * outw + j] = i * stride_h * w + j * stride_w;
+        }
+    }
+
+    // output tiles keep im2col, partial products and accumulators in cache
+    const int tile = 64;
+    const int num_tile = (outsize + tile - 1) / tile;
+
+    // one im2col and partial product buffer per thread
+    Mat col_buffers(tile * maxk, opt.num_threads, (size_t)4u, opt.workspace_allocator);
+    Mat lut_buffers(tile * num_codeword, opt.num_threads, (size_t)4u, opt.workspace_allocator);
+    if (col_buffers.empty() || lut_buffers.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t=0; t<num_tile; t++)
+    {
+        const int i0 = t * tile;
+        const int n = std::min(tile, outsize - i0);
+
+        Mat col(tile, maxk, col_buffers.row(get_omp_thread_num()), (size_t)4u);
+        Mat lut(tile, num_codeword, lut_buffers.row(get_omp_thread_num()), (size_t)4u);
+
+        for (int p=0; p<num_output; p++)
+        {
+            float* outptr = (float*)top_blob.channel(p) + i0;
+
+            const float bias = bias_term ? bias_data[p] : 0.f;
+
+            for (int i = 0; i < n; i++)
+            {
+                outptr[i] = bias;
+            }
+        }
+
+        for (int q=0; q<channels; q++)
+        {
+            const float* sptr = bottom_blob_bordered.channel(q);
+
+            for (int l = 0; l < maxk; l++)
+            {
+                const float* sptr_l = sptr + space_ofs[l];
+                float* cptr = col.row(l);
+
+                for (int i = 0; i < n; i++)
+                {
+                    cptr[i] = sptr_l[ in_ofs[i0 + i] ];
+                }
+            }
+
+            // partial products of each codeword with this input channel
+            const unsigned char* used = &codeword_used[q * num_codeword];
+            for (int k=0; k<num_codeword; k++)
+            {
+                if (!used[k])
+                    continue;
+
+                const float* kptr = weight_codebook.row(k);
+                float* lptr = lut.row(k);
+
+                for (int i = 0; i < n; i++)
+                {
+                    lptr[i] = 0.f;
+                }
+
+                for (int l = 0; l < maxk; l++)
+                {
+                    const float wk = kptr[l];
+                    const float* cptr = col.row(l);
+
+                    for (int i = 0; i < n; i++)
+                    {
+                        lptr[i] += cptr[i] * wk;
+                    }
+                }
+            }
+
+            // gather the partial products of every kernel by its code
+            for (int p=0; p<num_output; p++)
+            {
+                const float* lptr = lut.row( codes[p * channels + q] );
+                float* outptr = (float*)top_blob.channel(p) + i0;
+
+                for (int i = 0; i < n; i++)
+                {
+                    outptr[i] += lptr[i];
+                }
+            }
+        }
+
+        if (activation_type == 0)
+            continue;
+
+        for (int p=0; p<num_output; p++)
+        {
+            float* outptr = (float*)top_blob.channel(p) + i0;
+
+            for (int i = 0; i < n; i++)
+            {
+                float sum = outptr[i];
+
+                if (activation_type == 1)
+                {
+                    sum = std::max(sum, 0.f);
+                }
+                else if (activation_type == 2)
+                {
+                    float slope = activation_params[0];
+                    sum = sum > 0.f ? sum : sum * slope;
+                }
+                else if (activation_type == 3)
+                {
+                    float min = activation_params[0];
+                    float max = activation_params[1];
+                    if (sum < min)
+                        sum = min;
+                    if (sum > max)
+                        sum = max;
+                }
+                else if (activation_type == 4)
+                {
+                    sum = 1.f / (1.f + exp(-sum));
+                }
+
+                outptr[i] = sum;
+            }
+        }
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -31,9 +31,24 @@ public:
     virtual int create_pipeline(const Option& opt);
     virtual int destroy_pipeline(const Option& opt);
 
+    // (re)build the de/requantize ops from the current int8 scales
+    virtual int create_dequantize_op(void);
     virtual int create_requantize_op(void);
 
-    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt);
+    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
+    // product-quantized weight, convolve input with each codeword once
+    // and gather the partial products of every kernel by its code
+    int forward_lut(const Mat& bottom_blob_bordered, Mat& top_blob, int outw, int outh, const int* space_ofs, const Option& opt) const;
+
+    #if BISONAI_KILL_THE_BITS
+    // replace weight_data of original input channels by the mean kernel of each channel group
+    // return 0 if success
+    int reduce_weight_data();
+    // sum input channels of each channel group in one pass
+    // return 0 if success
+    int reduce_input_channels(const Mat& bottom_blob, Mat& bottom_blob_reduced, const Option& opt) const;
+    #endif
 
 public:
     // param
@@ -53,8 +68,12 @@ public:
 
     int weight_data_size;
 
+    // 1,2=per tensor bottom blob scale 3=per input channel bottom blob scales
     int int8_scale_term;
 
+    // int8 value of zero of the asymmetric quantized bottom blob
+    int bottom_blob_int8_zero_point;
+
     // 0=none 1=relu 2=leakyrelu 3=clip 4=sigmoid
     int activation_type;
     Mat activation_params;
@@ -63,8 +82,15 @@ public:
     Mat weight_data;
     Mat bias_data;
 
+    // product-quantized weight, weight_data stays empty when used
+    // codebook is num_codeword x maxk, one code per kernel in num_output x channels order
+    Mat weight_codebook;
+    Mat weight_codes;
+
     Mat weight_data_int8_scales;
     float bottom_blob_int8_scale;
+    // int8_scale_term 3, the int8 weight has the scales folded in and bottom_blob_int8_scale is 1
+    Mat bottom_blob_int8_scales;
     float top_blob_int8_scale;
 
     bool use_int8_inference;
@@ -82,10 +108,13 @@ public:
     int impl_type;
 
     #if BISONAI_KILL_THE_BITS
+    // input channels summed into each reduced input channel
+    // from the channel group param, contiguous groups by default
     std::vector<std::vector<int>> assignments;
     int original_input_channels;
     int reduced_input_channels;
     int input_feature_size;
+    bool use_channel_reduction;
     #endif
 };
 
@@ -94,6 +94,12 @@ int ConvolutionDepthWise::load_model(const ModelBin& mb)
         bottom_blob_int8_scales = Mat(group);
         bottom_blob_int8_scales.fill(bottom_blob_int8_scale);
     }
+    else if (int8_scale_term == 3)
+    {
+        // per channel bottom blob scales
+        weight_data_int8_scales = mb.load(group, 1);
+        bottom_blob_int8_scales = mb.load(group, 1);
+    }
 
     return 0;
 }
@@ -145,49 +151,7 @@ int ConvolutionDepthWise::create_pipeline(const Option& opt)
     }
 
     if (use_int8_inference)
-    {
-        quantize_ops.resize(group);
-        dequantize_ops.resize(group);
-
-        for (int g=0; g<group; g++)
-        {
-            quantize_ops[g] = ncnn::create_layer(ncnn::LayerType::Quantize);
-
-            ncnn::ParamDict pd;
-            pd.set(0, bottom_blob_int8_scales[g]);// scale
-
-            quantize_ops[g]->load_param(pd);
-
-            quantize_ops[g]->create_pipeline(opt);
-        }
-
-        for (int g=0; g<group; g++)
-        {
-            dequantize_ops[g] = ncnn::create_layer(ncnn::LayerType::Dequantize);
-
-            float top_rescale = 1.f;
-            if (weight_data_int8_scales[g] == 0)
-                top_rescale = 0;
-            else
-                top_rescale = 1.f / (bottom_blob_int8_scales[g] * weight_data_int8_scales[g]);
-
-            ncnn::ParamDict pd;
-            pd.set(0, top_rescale);// scale
-            pd.set(1, bias_term);// bias_term
-            pd.set(2, 1);// bias_data_size
-
-            dequantize_ops[g]->load_param(pd);
-
-            ncnn::Mat weights[1];
-            weights[0] = bias_data.range(g, 1);
-
-            dequantize_ops[g]->load_model(ModelBinFromMatArray(weights));
-
-            dequantize_ops[g]->create_pipeline(opt);
-
-            dequantize_scales.push_back(top_rescale);
-        }
-    }
+        create_dequantize_op();
 
     return 0;
 }
@@ -221,6 +185,64 @@ int ConvolutionDepthWise::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+int ConvolutionDepthWise::create_dequantize_op(void)
+{
+    if (!use_int8_inference)
+    {
+        fprintf(stderr, "dequantized op set but use_int8_inference disabled\n");
+        return -1;
+    }
+
+    // the ops of former bottom_blob_int8_scales
+    for (int i=0; i<(int)quantize_ops.size(); i++)
+        delete quantize_ops[i];
+    quantize_ops.clear();
+    for (int i=0; i<(int)dequantize_ops.size(); i++)
+        delete dequantize_ops[i];
+    dequantize_ops.clear();
+    dequantize_scales.clear();
+
+    quantize_ops.resize(group);
+    dequantize_ops.resize(group);
+
+    for (int g=0; g<group; g++)
+    {
+        quantize_ops[g] = ncnn::create_layer(ncnn::LayerType::Quantize);
+
+        ncnn::ParamDict pd;
+        pd.set(0, bottom_blob_int8_scales[g]);// scale
+
+        quantize_ops[g]->load_param(pd);
+    }
+
+    for (int g=0; g<group; g++)
+    {
+        dequantize_ops[g] = ncnn::create_layer(ncnn::LayerType::Dequantize);
+
+        float top_rescale = 1.f;
+        if (weight_data_int8_scales[g] == 0)
+            top_rescale = 0;
+        else
+            top_rescale = 1.f / (bottom_blob_int8_scales[g] * weight_data_int8_scales[g]);
+
+        ncnn::ParamDict pd;
+        pd.set(0, top_rescale);// scale
+        pd.set(1, bias_term);// bias_term
+        pd.set(2, 1);// bias_data_size
+
+        dequantize_ops[g]->load_param(pd);
+
+        ncnn::Mat weights[1];
+        weights[0] = bias_data.range(g, 1);
+
+        dequantize_ops[g]->load_model(ModelBinFromMatArray(weights));
+
+        dequantize_scales.push_back(top_rescale);
+    }
+
+    return 0;
+}
+
 int ConvolutionDepthWise::create_requantize_op(void)
 {
     if (!use_int8_requantize)
@@ -229,6 +251,12 @@ int ConvolutionDepthWise::create_requantize_op(void)
         return -1;
     }
 
+    // the ops of a former top_blob_int8_scale
+    for (int i=0; i<(int)requantize_ops.size(); i++)
+        delete requantize_ops[i];
+    requantize_ops.clear();
+    requantize_scales.clear();
+
     requantize_ops.resize(group);
     for (int g=0; g<group; g++)
     {
@@ -268,7 +296,7 @@ int ConvolutionDepthWise::create_requantize_op(void)
     return 0;
 }
 
-int ConvolutionDepthWise::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+int ConvolutionDepthWise::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     // convolv with NxN kernel
     // value = value + bias
@@ -31,9 +31,11 @@ public:
     virtual int create_pipeline(const Option& opt);
     virtual int destroy_pipeline(const Option& opt);
 
+    // (re)build the de/requantize ops from the current int8 scales
+    virtual int create_dequantize_op(void);
     virtual int create_requantize_op(void);
 
-    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt);
+    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
 public:
     // param
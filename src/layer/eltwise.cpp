@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include "eltwise.h"
+#include <math.h>
 #include <algorithm>
 
 namespace ncnn {
@@ -23,6 +24,8 @@ Eltwise::Eltwise()
 {
     one_blob_only = false;
     support_inplace = false;// TODO inplace reduction
+
+    top_blob_int8_scale = 1.f;
 }
 
 int Eltwise::load_param(const ParamDict& pd)
@@ -33,8 +36,11 @@ int Eltwise::load_param(const ParamDict& pd)
     return 0;
 }
 
-int Eltwise::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+int Eltwise::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    if (bottom_blobs[0].elemsize == 1u)
+        return Eltwise::forward_int8(bottom_blobs, top_blobs, opt);
+
     const Mat& bottom_blob = bottom_blobs[0];
     int w = bottom_blob.w;
     int h = bottom_blob.h;
@@ -189,4 +195,98 @@ int Eltwise::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top
     return 0;
 }
 
+static inline signed char float2int8(float v)
+{
+    int int32 = round(v);
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
+}
+
+static inline float eltwise_op(int op_type, float a, float b)
+{
+    if (op_type == Eltwise::Operation_PROD)
+        return a * b;
+    if (op_type == Eltwise::Operation_SUM)
+        return a + b;
+    return std::max(a, b);
+}
+
+int Eltwise::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    int size = w * h;
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(w, h, channels, (size_t)1u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // each bottom blob dequantized with its own scale, coeffs only apply to sum
+    std::vector<float> scales(bottom_blobs.size());
+    for (size_t b=0; b<bottom_blobs.size(); b++)
+    {
+        float coeff = op_type == Operation_SUM && coeffs.w != 0 ? coeffs[b] : 1.f;
+        scales[b] = coeff / bottom_blob_int8_scales[b];
+    }
+
+    // more than two bottom blobs are reduced in fp32 before the requantize
+    Mat top_blob_fp32;
+    if (bottom_blobs.size() > 2)
+    {
+        top_blob_fp32.create(w, h, channels, (size_t)4u, opt.workspace_allocator);
+        if (top_blob_fp32.empty())
+            return -100;
+    }
+
+    const Mat& bottom_blob1 = bottom_blobs[1];
+    const float scale0 = scales[0];
+    const float scale1 = scales[1];
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const signed char* ptr = bottom_blob.channel(q);
+        const signed char* ptr1 = bottom_blob1.channel(q);
+        signed char* outptr = top_blob.channel(q);
+
+        if (top_blob_fp32.empty())
+        {
+            for (int i=0; i<size; i++)
+            {
+                outptr[i] = float2int8(eltwise_op(op_type, ptr[i] * scale0, ptr1[i] * scale1) * top_blob_int8_scale);
+            }
+
+            continue;
+        }
+
+        float* sumptr = top_blob_fp32.channel(q);
+
+        for (int i=0; i<size; i++)
+        {
+            sumptr[i] = eltwise_op(op_type, ptr[i] * scale0, ptr1[i] * scale1);
+        }
+
+        for (size_t b=2; b<bottom_blobs.size(); b++)
+        {
+            const signed char* ptrb = bottom_blobs[b].channel(q);
+            const float scale = scales[b];
+
+            for (int i=0; i<size; i++)
+            {
+                sumptr[i] = eltwise_op(op_type, sumptr[i], ptrb[i] * scale);
+            }
+        }
+
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] = float2int8(sumptr[i] * top_blob_int8_scale);
+        }
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
@@ -26,7 +26,9 @@ public:
 
     virtual int load_param(const ParamDict& pd);
 
-    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
+    virtual int forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 
     enum { Operation_PROD = 0, Operation_SUM = 1, Operation_MAX = 2 };
 
@@ -34,6 +36,10 @@ public:
     // param
     int op_type;
     Mat coeffs;
+
+    // int8 bottom blobs are requantized to the top blob scale, set by the int8 graph fusion
+    std::vector<float> bottom_blob_int8_scales;
+    float top_blob_int8_scale;
 };
 
 } // namespace ncnn
@@ -34,7 +34,7 @@ int ExpandDims::load_param(const ParamDict& pd)
     return 0;
 }
 
-int ExpandDims::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+int ExpandDims::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     int w = bottom_blob.w;
     int h = bottom_blob.h;
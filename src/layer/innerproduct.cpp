@@ -42,10 +42,31 @@ int InnerProduct::load_param(const ParamDict& pd)
 
 int InnerProduct::load_model(const ModelBin& mb)
 {
-    weight_data = mb.load(weight_data_size, 0);
+    weight_data = mb.load_pq(weight_data_size, 0, weight_codebook);
     if (weight_data.empty())
         return -100;
 
+    if (!weight_codebook.empty())
+    {
+        // lookup table forward needs subvectors that do not straddle outputs
+        // create_pipeline decodes the codes unless use_pq_lookup_table is set
+        const int num_input = weight_data_size / num_output;
+        bool use_lut = num_input % weight_codebook.w == 0 && !int8_scale_term;
+
+        if (use_lut)
+        {
+            weight_codes = weight_data;
+            weight_data.release();
+        }
+        else
+        {
+            weight_data = pq_decode(weight_codebook, weight_data);
+            weight_codebook.release();
+            if (weight_data.empty())
+                return -100;
+        }
+    }
+
     if (bias_term)
     {
         bias_data = mb.load(num_output, 1);
@@ -64,6 +85,16 @@ int InnerProduct::load_model(const ModelBin& mb)
 
 int InnerProduct::create_pipeline(const Option& opt)
 {
+    if (!weight_codebook.empty() && !opt.use_pq_lookup_table)
+    {
+        weight_data = pq_decode(weight_codebook, weight_codes);
+        if (weight_data.empty())
+            return -100;
+
+        weight_codebook.release();
+        weight_codes.release();
+    }
+
     bool weight_data_is_int8 = (weight_data.elemsize == (size_t)1u);
     bool weight_data_is_float32 = (weight_data.elemsize == (size_t)4u);
 
@@ -88,11 +119,10 @@ int InnerProduct::create_pipeline(const Option& opt)
             quantize->create_pipeline(opt);
         }
 
-        dequantize_ops.resize(num_output);
+        // dequantize scales, applied with bias and activation as each output is stored
+        dequantize_scales.resize(num_output);
         for (int n=0; n<num_output; n++)
         {
-            dequantize_ops[n] = ncnn::create_layer(ncnn::LayerType::Dequantize);
-
             float top_rescale = 1.f;
 
             if (weight_data_int8_scales[n] == 0)
@@ -100,19 +130,7 @@ int InnerProduct::create_pipeline(const Option& opt)
             else
                 top_rescale = 1.f / (bottom_blob_int8_scale * weight_data_int8_scales[n]);
 
-            ncnn::ParamDict pd;
-            pd.set(0, top_rescale);// scale
-            pd.set(1, bias_term);  // bias_term
-            pd.set(2, 1);          // bias_data_size
-
-            dequantize_ops[n]->load_param(pd);
-
-            ncnn::Mat weights[1];
-            weights[0] = bias_data.range(n, 1);
-
-            dequantize_ops[n]->load_model(ModelBinFromMatArray(weights));
-
-            dequantize_ops[n]->create_pipeline(opt);
+            dequantize_scales[n] = top_rescale;
         }
     }
 
@@ -162,17 +180,12 @@ int InnerProduct::destroy_pipeline(const Option& opt)
         quantize = 0;
     }
 
-    for (int i=0; i<(int)dequantize_ops.size(); i++)
-    {
-        dequantize_ops[i]->destroy_pipeline(opt);
-        delete dequantize_ops[i];
-    }
-    dequantize_ops.clear();
+    dequantize_scales.clear();
 
     return 0;
 }
 
-int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     int w = bottom_blob.w;
     int h = bottom_blob.h;
@@ -180,7 +193,13 @@ int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& o
     size_t elemsize = bottom_blob.elemsize;
     int size = w * h;
 
-    top_blob.create(num_output, elemsize, opt.blob_allocator);
+    if (!weight_codebook.empty())
+    {
+        return forward_lut(bottom_blob, top_blob, opt);
+    }
+
+    // float32 output, also when the input arrives as int8
+    top_blob.create(num_output, (size_t)4u, opt.blob_allocator);
     if (top_blob.empty())
         return -100;
 
@@ -205,12 +224,11 @@ int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& o
             bottom_blob_tm = bottom_blob_int8;
         }
 
-        // num_output
+        // int32 output never hits memory, dequantize and activate in place
         #pragma omp parallel for num_threads(opt.num_threads)
         for (int p=0; p<num_output; p++)
         {
             int sum = 0;
-            int* out = top_blob;
 
             // channels
             for (int q=0; q<channels; q++)
@@ -224,29 +242,35 @@ int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& o
                 }
             }
 
-            out[p] = sum;
-        }
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int p=0; p<num_output; p++)
-        {
-            int* out_s32 = top_blob;
-            float* out_f32 = top_blob;
-            float top_rescale = 1.f;
-            if (weight_data_int8_scales[p] == 0)
-                top_rescale = 0;
-            else
-                top_rescale = 1.f / (bottom_blob_int8_scale * weight_data_int8_scales[p]);
+            float sumf = sum * dequantize_scales[p];
 
             if (bias_term)
-                out_f32[p] = out_s32[p] * top_rescale + bias_data[p];
-            else
-                out_f32[p] = out_s32[p] * top_rescale;
+                sumf += bias_data[p];
 
             if (activation_type == 1)
             {
-                out_f32[p] = std::max(out_f32[p], 0.f);
+                sumf = std::max(sumf, 0.f);
+            }
+            else if (activation_type == 2)
+            {
+                float slope = activation_params[0];
+                sumf = sumf > 0.f ? sumf : sumf * slope;
+            }
+            else if (activation_type == 3)
+            {
+                float min = activation_params[0];
+                float max = activation_params[1];
+                if (sumf < min)
+                    sumf = min;
+                if (sumf > max)
+                    sumf = max;
             }
+            else if (activation_type == 4)
+            {
+                sumf = 1.f / (1.f + exp(-sumf));
+            }
+
+            top_blob[p] = sumf;
         }
 
         return 0;
@@ -302,4 +326,115 @@ int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& o
     return 0;
 }
 
+int InnerProduct::forward_lut(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int size = bottom_blob.w * bottom_blob.h;
+    const int channels = bottom_blob.c;
+    const int num_input = weight_data_size / num_output;
+    const int d = weight_codebook.w;
+    const int num_codeword = weight_codebook.h;
+    const int num_block = num_input / d;
+
+    if (bottom_blob.elemsize != (size_t)4u || size * channels != num_input)
+    {
+        fprintf(stderr, "InnerProduct lookup table forward needs float32 input of size %d\n", num_input);
+        return -1;
+    }
+
+    // subvectors may cross channels, gather input contiguously
+    Mat bottom_blob_flattened = bottom_blob;
+    if (channels > 1 && (int)bottom_blob.cstep != size)
+    {
+        bottom_blob_flattened.create(num_input, (size_t)4u, opt.workspace_allocator);
+        if (bottom_blob_flattened.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const float* ptr = bottom_blob.channel(q);
+            float* outptr = (float*)bottom_blob_flattened + size * q;
+
+            for (int i = 0; i < size; i++)
+            {
+                outptr[i] = ptr[i];
+            }
+        }
+    }
+
+    const float* x = bottom_blob_flattened;
+
+    // partial products of each input subvector with each codeword
+    Mat lut(num_codeword, num_block, (size_t)4u, opt.workspace_allocator);
+    if (lut.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int b=0; b<num_block; b++)
+    {
+        const float* xptr = x + b * d;
+        float* lptr = lut.row(b);
+
+        for (int k=0; k<num_codeword; k++)
+        {
+            const float* kptr = weight_codebook.row(k);
+
+            float sum = 0.f;
+            for (int i = 0; i < d; i++)
+            {
+                sum += xptr[i] * kptr[i];
+            }
+
+            lptr[k] = sum;
+        }
+    }
+
+    top_blob.create(num_output, (size_t)4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<num_output; p++)
+    {
+        float sum = 0.f;
+
+        if (bias_term)
+            sum = bias_data[p];
+
+        const unsigned char* codes = (const unsigned char*)weight_codes + num_block * p;
+
+        for (int b=0; b<num_block; b++)
+        {
+            sum += lut.row(b)[ codes[b] ];
+        }
+
+        if (activation_type == 1)
+        {
+            sum = std::max(sum, 0.f);
+        }
+        else if (activation_type == 2)
+        {
+            float slope = activation_params[0];
+            sum = sum > 0.f ? sum : sum * slope;
+        }
+        else if (activation_type == 3)
+        {
+            float min = activation_params[0];
+            float max = activation_params[1];
+            if (sum < min)
+                sum = min;
+            if (sum > max)
+                sum = max;
+        }
+        else if (activation_type == 4)
+        {
+            sum = 1.f / (1.f + exp(-sum));
+        }
+
+        top_blob[p] = sum;
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
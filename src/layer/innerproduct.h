@@ -31,7 +31,11 @@ public:
     virtual int create_pipeline(const Option& opt);
     virtual int destroy_pipeline(const Option& opt);
 
-    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt);
+    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
+    // product-quantized weight, dot input subvectors with each codeword once
+    // and sum the partial products of every output by its codes
+    int forward_lut(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
 public:
     // param
@@ -50,13 +54,18 @@ public:
     Mat weight_data;
     Mat bias_data;
 
+    // product-quantized weight, weight_data stays empty when used
+    // codebook is num_codeword x subvector size, codes in num_output x num_input order
+    Mat weight_codebook;
+    Mat weight_codes;
+
     Mat weight_data_int8_scales;
     float bottom_blob_int8_scale;
 
     bool use_int8_inference;
 
     ncnn::Layer* quantize;
-    std::vector<ncnn::Layer*> dequantize_ops;
+    std::vector<float> dequantize_scales;
 };
 
 } // namespace ncnn
@@ -23,6 +23,7 @@ LSTM::LSTM()
 {
     one_blob_only = false;
     support_inplace = false;
+    support_batch = true;
 }
 
 int LSTM::load_param(const ParamDict& pd)
@@ -181,4 +182,144 @@ int LSTM::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
     return 0;
 }
 
+int LSTM::forward_batch(const std::vector< std::vector<Mat> >& bottom_batch, std::vector< std::vector<Mat> >& top_batch, const Option& opt) const
+{
+    const int batch = bottom_batch.size();
+
+    const Mat& input_blob = bottom_batch[0][0];
+
+    int T = input_blob.h;
+    int size = input_blob.w;
+
+    bool batched = batch > 1;
+    for (int b=0; b<batch && batched; b++)
+    {
+        batched = bottom_batch[b][0].w == size && bottom_batch[b][0].h == T;
+    }
+
+    if (!batched)
+        return Layer::forward_batch(bottom_batch, top_batch, opt);
+
+    size_t elemsize = input_blob.elemsize;
+
+    // hidden and cell state of sample b in row b
+    Mat hidden(num_output, batch, 4u, opt.workspace_allocator);
+    if (hidden.empty())
+        return -100;
+    hidden.fill(0.f);
+
+    Mat cell(num_output, batch, 4u, opt.workspace_allocator);
+    if (cell.empty())
+        return -100;
+
+    // gates of output q in row q, I F O G of each sample
+    Mat gates(4 * batch, num_output, 4u, opt.workspace_allocator);
+    if (gates.empty())
+        return -100;
+
+    top_batch.resize(batch);
+    for (int b=0; b<batch; b++)
+    {
+        top_batch[b].resize(1);
+
+        Mat& top_blob = top_batch[b][0];
+        top_blob.create(num_output, T, elemsize, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+    }
+
+    std::vector<int> conts(batch);
+    std::vector<const float*> xs(batch);
+
+    // unroll
+    for (int t=0; t<T; t++)
+    {
+        for (int b=0; b<batch; b++)
+        {
+            conts[b] = ((const int*)bottom_batch[b][1])[t];
+            xs[b] = bottom_batch[b][0].row(t);
+        }
+
+        // gate_input_t := W_hc * h_conted_{t-1} + W_xc * x_t + b_c for every sample
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<num_output; q++)
+        {
+            const float* weight_hc_data_I = (const float*)weight_hc_data + weight_hc_data.w * q;
+            const float* weight_xc_data_I = (const float*)weight_xc_data + weight_xc_data.w * q;
+            const float* weight_hc_data_F = (const float*)weight_hc_data + weight_hc_data.w * q + num_output * num_output;
+            const float* weight_xc_data_F = (const float*)weight_xc_data + weight_xc_data.w * q + num_output * size;
+            const float* weight_hc_data_O = (const float*)weight_hc_data + weight_hc_data.w * q + num_output * num_output * 2;
+            const float* weight_xc_data_O = (const float*)weight_xc_data + weight_xc_data.w * q + num_output * size * 2;
+            const float* weight_hc_data_G = (const float*)weight_hc_data + weight_hc_data.w * q + num_output * num_output * 3;
+            const float* weight_xc_data_G = (const float*)weight_xc_data + weight_xc_data.w * q + num_output * size * 3;
+
+            float* gates_data = gates.row(q);
+
+            for (int b=0; b<batch; b++)
+            {
+                float I = ((const float*)bias_c_data)[q];
+                float F = ((const float*)bias_c_data)[num_output + q];
+                float O = ((const float*)bias_c_data)[2 * num_output + q];
+                float G = ((const float*)bias_c_data)[3 * num_output + q];
+
+                const float* x = xs[b];
+                for (int i=0; i<size; i++)
+                {
+                    I += weight_xc_data_I[i] * x[i];
+                    F += weight_xc_data_F[i] * x[i];
+                    O += weight_xc_data_O[i] * x[i];
+                    G += weight_xc_data_G[i] * x[i];
+                }
+
+                if (conts[b])
+                {
+                    const float* h_ptr = hidden.row(b);
+                    for (int i=0; i<num_output; i++)
+                    {
+                        float h = h_ptr[i];
+                        I += weight_hc_data_I[i] * h;
+                        F += weight_hc_data_F[i] * h;
+                        O += weight_hc_data_O[i] * h;
+                        G += weight_hc_data_G[i] * h;
+                    }
+                }
+
+                gates_data[4 * b] = I;
+                gates_data[4 * b + 1] = F;
+                gates_data[4 * b + 2] = O;
+                gates_data[4 * b + 3] = G;
+            }
+        }
+
+        // lstm unit, hidden is read above and written below only
+        for (int q=0; q<num_output; q++)
+        {
+            const float* gates_data = gates.row(q);
+
+            for (int b=0; b<batch; b++)
+            {
+                const int cont = conts[b];
+
+                float I = gates_data[4 * b];
+                float F = gates_data[4 * b + 1];
+                float O = gates_data[4 * b + 2];
+                float G = gates_data[4 * b + 3];
+
+                I = 1.f / (1.f + exp(-I));
+                F = cont ? 1.f / (1.f + exp(-F)) : 0.f;
+                O = 1.f / (1.f + exp(-O));
+                G = tanh(G);
+
+                float cell2 = cont ? F * cell.row(b)[q] + I * G : I * G;
+                float H = O * tanh(cell2);
+                cell.row(b)[q] = cell2;
+                hidden.row(b)[q] = H;
+                top_batch[b][0].row(t)[q] = H;
+            }
+        }
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
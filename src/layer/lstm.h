@@ -30,6 +30,9 @@ public:
 
     virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 
+    // samples of one length step together, every weight row is read once per step
+    virtual int forward_batch(const std::vector< std::vector<Mat> >& bottom_batch, std::vector< std::vector<Mat> >& top_batch, const Option& opt) const;
+
 public:
     // param
     int num_output;
@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include "padding.h"
+#include <math.h>
 
 namespace ncnn {
 
@@ -22,6 +23,8 @@ Padding::Padding()
 {
     one_blob_only = true;
     support_inplace = false;
+
+    bottom_blob_int8_scale = 1.f;
 }
 
 int Padding::load_param(const ParamDict& pd)
@@ -41,6 +44,14 @@ int Padding::load_param(const ParamDict& pd)
     return 0;
 }
 
+static inline signed char float2int8(float v)
+{
+    int int32 = round(v);
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
+}
+
 template<typename T>
 static void copy_make_border_image(const Mat& src, Mat& dst, int top, int left, int type, T v)
 {
@@ -275,7 +286,7 @@ static void copy_make_border_image(const Mat& src, Mat& dst, int top, int left,
 
 }
 
-int Padding::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+int Padding::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     if (top == 0 && bottom == 0 && left == 0 && right == 0)
     {
@@ -289,6 +300,9 @@ int Padding::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
     int dims = bottom_blob.dims;
     size_t elemsize = bottom_blob.elemsize;
 
+    // the constant border in the scale of an int8 blob
+    const signed char value_int8 = float2int8(value * bottom_blob_int8_scale);
+
     int outw = w + left + right;
 
     if (dims == 1)
@@ -298,7 +312,7 @@ int Padding::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
             return -100;
 
         if (elemsize == 1)
-            copy_make_border_image<signed char>(bottom_blob, top_blob, 0, left, type, value);
+            copy_make_border_image<signed char>(bottom_blob, top_blob, 0, left, type, value_int8);
         else if (elemsize == 4)
             copy_make_border_image<float>(bottom_blob, top_blob, 0, left, type, value);
 
@@ -314,7 +328,7 @@ int Padding::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
             return -100;
 
         if (elemsize == 1)
-            copy_make_border_image<signed char>(bottom_blob, top_blob, top, left, type, value);
+            copy_make_border_image<signed char>(bottom_blob, top_blob, top, left, type, value_int8);
         else if (elemsize == 4)
             copy_make_border_image<float>(bottom_blob, top_blob, top, left, type, value);
 
@@ -334,7 +348,7 @@ int Padding::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
             Mat borderm = top_blob.channel(q);
 
             if (elemsize == 1)
-                copy_make_border_image<signed char>(m, borderm, top, left, type, value);
+                copy_make_border_image<signed char>(m, borderm, top, left, type, value_int8);
             else if (elemsize == 4)
                 copy_make_border_image<float>(m, borderm, top, left, type, value);
         }
@@ -345,7 +359,7 @@ int Padding::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
     return 0;
 }
 
-int Padding::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+int Padding::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
     const Mat& bottom_blob = bottom_blobs[0];
     const Mat& reference_blob = bottom_blobs[1];
@@ -377,6 +391,9 @@ int Padding::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top
     int dims = bottom_blob.dims;
     size_t elemsize = bottom_blob.elemsize;
 
+    // the constant border in the scale of an int8 blob
+    const signed char value_int8 = float2int8(value * bottom_blob_int8_scale);
+
     int outw = w + _left + _right;
 
     if (dims == 1)
@@ -386,7 +403,7 @@ int Padding::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top
             return -100;
 
         if (elemsize == 1)
-            copy_make_border_image<signed char>(bottom_blob, top_blob, 0, _left, type, value);
+            copy_make_border_image<signed char>(bottom_blob, top_blob, 0, _left, type, value_int8);
         else if (elemsize == 4)
             copy_make_border_image<float>(bottom_blob, top_blob, 0, _left, type, value);
 
@@ -402,7 +419,7 @@ int Padding::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top
             return -100;
 
         if (elemsize == 1)
-            copy_make_border_image<signed char>(bottom_blob, top_blob, _top, _left, type, value);
+            copy_make_border_image<signed char>(bottom_blob, top_blob, _top, _left, type, value_int8);
         else if (elemsize == 4)
             copy_make_border_image<float>(bottom_blob, top_blob, _top, _left, type, value);
 
@@ -422,7 +439,7 @@ int Padding::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top
             Mat borderm = top_blob.channel(q);
 
             if (elemsize == 1)
-                copy_make_border_image<signed char>(m, borderm, _top, _left, type, value);
+                copy_make_border_image<signed char>(m, borderm, _top, _left, type, value_int8);
             else if (elemsize == 4)
                 copy_make_border_image<float>(m, borderm, _top, _left, type, value);
         }
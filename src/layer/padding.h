@@ -26,9 +26,9 @@ public:
 
     virtual int load_param(const ParamDict& pd);
 
-    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt);
+    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
-    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 
 public:
     // -233 = dynamic offset from reference blob
@@ -38,6 +38,9 @@ public:
     int right;
     int type;// 0=CONSTANT 1=REPLICATE 2=REFLECT
     float value;
+
+    // scale of an int8 bottom blob, set by the int8 graph fusion
+    float bottom_blob_int8_scale;
 };
 
 } // namespace ncnn
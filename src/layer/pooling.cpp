@@ -14,6 +14,7 @@
 
 #include "pooling.h"
 #include <float.h>
+#include <math.h>
 #include <algorithm>
 #include "layer_type.h"
 
@@ -21,6 +22,14 @@ namespace ncnn {
 
 DEFINE_LAYER_CREATOR(Pooling)
 
+static inline signed char float2int8(float v)
+{
+    int int32 = round(v);
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
+}
+
 Pooling::Pooling()
 {
     one_blob_only = true;
@@ -45,7 +54,7 @@ int Pooling::load_param(const ParamDict& pd)
     return 0;
 }
 
-int Pooling::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+int Pooling::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     // max value in NxN window
     // avg value in NxN window
@@ -64,6 +73,41 @@ int Pooling::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
 
         int size = w * h;
 
+        if (elemsize == 1)
+        {
+            // int8 keeps the scale of the bottom blob
+            signed char* outptr = top_blob;
+
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const signed char* ptr = bottom_blob.channel(q);
+
+                if (pooling_type == PoolMethod_MAX)
+                {
+                    signed char max = ptr[0];
+                    for (int i=0; i<size; i++)
+                    {
+                        max = std::max(max, ptr[i]);
+                    }
+
+                    outptr[q] = max;
+                }
+                else if (pooling_type == PoolMethod_AVE)
+                {
+                    int sum = 0;
+                    for (int i=0; i<size; i++)
+                    {
+                        sum += ptr[i];
+                    }
+
+                    outptr[q] = float2int8((float)sum / size);
+                }
+            }
+
+            return 0;
+        }
+
         if (pooling_type == PoolMethod_MAX)
         {
             #pragma omp parallel for num_threads(opt.num_threads)
@@ -105,7 +149,8 @@ int Pooling::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
     float pad_value = 0.f;
     if (pooling_type == PoolMethod_MAX)
     {
-        pad_value = -FLT_MAX;
+        // int8 values are clamped to -127
+        pad_value = elemsize == 1 ? -127.f : -FLT_MAX;
     }
     else if (pooling_type == PoolMethod_AVE)
     {
@@ -206,6 +251,70 @@ int Pooling::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
         }
     }
 
+    if (elemsize == 1)
+    {
+        // int8 keeps the scale of the bottom blob, the average is rounded once
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const Mat m = bottom_blob_bordered.channel(q);
+            signed char* outptr = top_blob.channel(q);
+
+            for (int i = 0; i < outh; i++)
+            {
+                // same pad fix as the fp32 average below
+                float hscale = 1.f;
+                if (pooling_type == PoolMethod_AVE && avgpool_count_include_pad == 0)
+                {
+                    if (i == 0 && pad_top != 0)
+                        hscale *= (float)kernel_h / (kernel_h - pad_top);
+                    if (i == outh - 1 && pad_bottom + htailpad != 0)
+                        hscale *= (float)kernel_h / (kernel_h - pad_bottom - htailpad);
+                }
+
+                for (int j = 0; j < outw; j++)
+                {
+                    const signed char* sptr = m.row<signed char>(i*stride_h) + j*stride_w;
+
+                    if (pooling_type == PoolMethod_MAX)
+                    {
+                        signed char max = sptr[0];
+
+                        for (int k = 0; k < maxk; k++)
+                        {
+                            max = std::max(max, sptr[ space_ofs[k] ]);
+                        }
+
+                        outptr[j] = max;
+                        continue;
+                    }
+
+                    float scale = hscale / maxk;
+                    if (avgpool_count_include_pad == 0)
+                    {
+                        if (j == 0 && pad_left != 0)
+                            scale *= (float)kernel_w / (kernel_w - pad_left);
+                        if (j == outw - 1 && pad_right + wtailpad != 0)
+                            scale *= (float)kernel_w / (kernel_w - pad_right - wtailpad);
+                    }
+
+                    int sum = 0;
+
+                    for (int k = 0; k < maxk; k++)
+                    {
+                        sum += sptr[ space_ofs[k] ];
+                    }
+
+                    outptr[j] = float2int8(sum * scale);
+                }
+
+                outptr += outw;
+            }
+        }
+
+        return 0;
+    }
+
     if (pooling_type == PoolMethod_MAX)
     {
         #pragma omp parallel for num_threads(opt.num_threads)
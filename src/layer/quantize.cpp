@@ -29,6 +29,20 @@ Quantize::Quantize()
 int Quantize::load_param(const ParamDict& pd)
 {
     scale = pd.get(0, 1.f);
+    scale_data_size = pd.get(1, 1);
+    zero_point = pd.get(2, 0);
+
+    return 0;
+}
+
+int Quantize::load_model(const ModelBin& mb)
+{
+    if (scale_data_size > 1)
+    {
+        scale_data = mb.load(scale_data_size, 1);
+        if (scale_data.empty())
+            return -100;
+    }
 
     return 0;
 }
@@ -45,6 +59,10 @@ int Quantize::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
 {
     int dims = bottom_blob.dims;
 
+    // per-channel scales index w of 1d, h of 2d and c of 3d blobs
+    if (scale_data_size > 1 && scale_data_size != (dims == 1 ? bottom_blob.w : dims == 2 ? bottom_blob.h : bottom_blob.c))
+        return -100;
+
     if (dims == 1)
     {
         int w = bottom_blob.w;
@@ -59,7 +77,8 @@ int Quantize::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
         #pragma omp parallel for num_threads(opt.num_threads)
         for (int i=0; i<w; i++)
         {
-            outptr[i] = float2int8(ptr[i] * scale);
+            const float s = scale_data_size > 1 ? scale_data[i] : scale;
+            outptr[i] = float2int8(ptr[i] * s + zero_point);
         }
     }
 
@@ -67,19 +86,23 @@ int Quantize::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
     {
         int w = bottom_blob.w;
         int h = bottom_blob.h;
-        int size = w * h;
 
         top_blob.create(w, h, (size_t)1u, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
 
-        const float* ptr = bottom_blob;
-        signed char* outptr = top_blob;
-
         #pragma omp parallel for num_threads(opt.num_threads)
-        for (int i=0; i<size; i++)
+        for (int i=0; i<h; i++)
         {
-            outptr[i] = float2int8(ptr[i] * scale);
+            const float* ptr = bottom_blob.row(i);
+            signed char* outptr = top_blob.row<signed char>(i);
+
+            const float s = scale_data_size > 1 ? scale_data[i] : scale;
+
+            for (int j=0; j<w; j++)
+            {
+                outptr[j] = float2int8(ptr[j] * s + zero_point);
+            }
         }
     }
 
@@ -100,9 +123,11 @@ int Quantize::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt)
             const float* ptr = bottom_blob.channel(q);
             signed char* outptr = top_blob.channel(q);
 
+            const float s = scale_data_size > 1 ? scale_data[q] : scale;
+
             for (int i=0; i<size; i++)
             {
-                outptr[i] = float2int8(ptr[i] * scale);
+                outptr[i] = float2int8(ptr[i] * s + zero_point);
             }
         }
     }
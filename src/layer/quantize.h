@@ -26,10 +26,18 @@ public:
 
     virtual int load_param(const ParamDict& pd);
 
+    virtual int load_model(const ModelBin& mb);
+
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
 public:
     float scale;
+
+    // per channel scales replace scale when scale_data_size > 1
+    int scale_data_size;
+    int zero_point;
+
+    Mat scale_data;
 };
 
 } // namespace ncnn
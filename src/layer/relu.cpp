@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include "relu.h"
+#include <math.h>
 #include <algorithm>
 
 namespace ncnn {
@@ -32,7 +33,15 @@ int ReLU::load_param(const ParamDict& pd)
     return 0;
 }
 
-int ReLU::forward_inplace_int8(Mat& bottom_top_blob, const Option& opt)
+static inline signed char float2int8(float v)
+{
+    int int32 = round(v);
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
+}
+
+int ReLU::forward_inplace_int8(Mat& bottom_top_blob, const Option& opt) const
 {
     int w = bottom_top_blob.w;
     int h = bottom_top_blob.h;
@@ -55,24 +64,24 @@ int ReLU::forward_inplace_int8(Mat& bottom_top_blob, const Option& opt)
     }
     else
     {
-        // TODO
-        // #pragma omp parallel for num_threads(opt.num_threads)
-        // for (int q=0; q<channels; q++)
-        // {
-        //     float* ptr = bottom_top_blob.channel(q);
-
-        //     for (int i=0; i<size; i++)
-        //     {
-        //         if (ptr[i] < 0)
-        //             ptr[i] *= slope;
-        //     }
-        // }
+        // the slope keeps the int8 scale, only the negative side is rounded
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            signed char* ptr = bottom_top_blob.channel(q);
+
+            for (int i=0; i<size; i++)
+            {
+                if (ptr[i] < 0)
+                    ptr[i] = float2int8(ptr[i] * slope);
+            }
+        }
     }
 
     return 0;
 }
 
-int ReLU::forward_inplace(Mat& bottom_top_blob, const Option& opt)
+int ReLU::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
 {
     if (bottom_top_blob.elemsize == 1u)
         return ReLU::forward_inplace_int8(bottom_top_blob, opt);
@@ -42,6 +42,8 @@ int Requantize::load_param(const ParamDict& pd)
     bias_term = pd.get(2, 0);
     bias_data_size = pd.get(3, 0);
     fusion_relu = pd.get(4, 0);
+    scale_out_data_size = pd.get(5, 1);
+    zero_point = pd.get(6, 0);
 
     return 0;
 }
@@ -55,6 +57,13 @@ int Requantize::load_model(const ModelBin& mb)
             return -100;
     }
 
+    if (scale_out_data_size > 1)
+    {
+        scale_out_data = mb.load(scale_out_data_size, 1);
+        if (scale_out_data.empty())
+            return -100;
+    }
+
     return 0;
 }
 
@@ -62,6 +71,13 @@ int Requantize::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt
 { 
     int dims = bottom_blob.dims;
 
+    // per-channel scales index w of 1d, h of 2d and c of 3d blobs
+    if (scale_out_data_size > 1 && scale_out_data_size != (dims == 1 ? bottom_blob.w : dims == 2 ? bottom_blob.h : bottom_blob.c))
+        return -100;
+
+    // relu clamps at the int8 value of zero
+    const signed char relu_min = zero_point;
+
     if (dims == 1)
     {
         int w = bottom_blob.w;
@@ -69,39 +85,15 @@ int Requantize::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt
         const int* intptr = bottom_blob;
         signed char * ptr = top_blob;
 
-        if (bias_term)
-        {
-            if (bias_data_size > 1)
-            {
-                #pragma omp parallel for num_threads(opt.num_threads)
-                for (int i=0; i<w; i++)
-                {
-                    ptr[i] = float2int8(((intptr[i] * scale_in) + bias_data[i]) * scale_out);
-                    if (fusion_relu && ptr[i] < 0)
-                        ptr[i] = 0;
-                }
-            }
-            else
-            {
-                float bias = bias_data[0];
-                #pragma omp parallel for num_threads(opt.num_threads)
-                for (int i=0; i<w; i++)
-                {
-                    ptr[i] = float2int8(((intptr[i] * scale_in) + bias) * scale_out);
-                    if (fusion_relu && ptr[i] < 0)
-                        ptr[i] = 0;
-                }
-            }
-        }
-        else
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i=0; i<w; i++)
         {
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int i=0; i<w; i++)
-            {
-                ptr[i] = float2int8(intptr[i] * scale_in * scale_out);
-                if (fusion_relu && ptr[i] < 0)
-                    ptr[i] = 0;
-            }
+            float bias = bias_term ? (bias_data_size > 1 ? bias_data[i] : bias_data[0]) : 0.f;
+            float scale = scale_out_data_size > 1 ? scale_out_data[i] : scale_out;
+
+            ptr[i] = float2int8(((intptr[i] * scale_in) + bias) * scale + zero_point);
+            if (fusion_relu && ptr[i] < relu_min)
+                ptr[i] = relu_min;
         }
     }
 
@@ -110,38 +102,20 @@ int Requantize::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt
         int w = bottom_blob.w;
         int h = bottom_blob.h;
 
-        if (bias_term)
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i=0; i<h; i++)
         {
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int i=0; i<h; i++)
-            {
-                const int* intptr = bottom_blob.row<const int>(i);
-                signed char* ptr = top_blob.row<signed char>(i);
+            const int* intptr = bottom_blob.row<const int>(i);
+            signed char* ptr = top_blob.row<signed char>(i);
 
-                float bias = bias_data_size > 1 ? bias_data[i] : bias_data[0];
+            float bias = bias_term ? (bias_data_size > 1 ? bias_data[i] : bias_data[0]) : 0.f;
+            float scale = scale_out_data_size > 1 ? scale_out_data[i] : scale_out;
 
-                for (int j=0; j<w; j++)
-                {
-                    ptr[j] = float2int8(((intptr[j] * scale_in) + bias) * scale_out);
-                    if (fusion_relu && ptr[j] < 0)
-                        ptr[j] = 0;
-                }
-            }
-        }
-        else
-        {
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int i=0; i<h; i++)
+            for (int j=0; j<w; j++)
             {
-                const int* intptr = bottom_blob.row<const int>(i);
-                signed char* ptr = top_blob.row<signed char>(i);
-
-                for (int j=0; j<w; j++)
-                {
-                    ptr[j] = float2int8(intptr[j] * scale_in * scale_out);
-                    if (fusion_relu && ptr[j] < 0)
-                        ptr[j] = 0;
-                }
+                ptr[j] = float2int8(((intptr[j] * scale_in) + bias) * scale + zero_point);
+                if (fusion_relu && ptr[j] < relu_min)
+                    ptr[j] = relu_min;
             }
         }
     }
@@ -153,43 +127,25 @@ int Requantize::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt
         int channels = bottom_blob.c;
         int size = w * h;      
 
-        if (bias_term)
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
         {
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int q=0; q<channels; q++)
-            {
-                const int* intptr = bottom_blob.channel(q);
-                signed char* ptr = top_blob.channel(q);
+            const int* intptr = bottom_blob.channel(q);
+            signed char* ptr = top_blob.channel(q);
 
-                float bias = bias_data_size > 1 ? bias_data[q] : bias_data[0];
+            float bias = bias_term ? (bias_data_size > 1 ? bias_data[q] : bias_data[0]) : 0.f;
+            float scale = scale_out_data_size > 1 ? scale_out_data[q] : scale_out;
 
-                for (int i=0; i<size; i++)
-                {
-                    ptr[i] = float2int8(((intptr[i] * scale_in) + bias) * scale_out);
-                    if (fusion_relu && ptr[i] < 0)
-                        ptr[i] = 0;
-                }
-            }
-        }
-        else
-        {
-            #pragma omp parallel for num_threads(opt.num_threads)
-            for (int q=0; q<channels; q++)
+            for (int i=0; i<size; i++)
             {
-                const int* intptr = bottom_blob.channel(q);
-                signed char* ptr = top_blob.channel(q);
-
-                for (int i=0; i<size; i++)
-                {
-                    ptr[i] = float2int8(intptr[i] * scale_in * scale_out);
-                    if (fusion_relu && ptr[i] < 0)
-                        ptr[i] = 0;
-                }
+                ptr[i] = float2int8(((intptr[i] * scale_in) + bias) * scale + zero_point);
+                if (fusion_relu && ptr[i] < relu_min)
+                    ptr[i] = relu_min;
             }
-        }    
+        }
     }
 
     return 0;
 }
 
-} // namespace ncnn
\ No newline at end of file
+} // namespace ncnn
@@ -38,7 +38,12 @@ public:
 
     bool fusion_relu;
 
+    // per channel top_blob_scale replace scale_out when scale_out_data_size > 1
+    int scale_out_data_size;
+    int zero_point;
+
     Mat bias_data;
+    Mat scale_out_data;
 };
 
 } // namespace ncnn
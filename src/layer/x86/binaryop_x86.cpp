@@ -0,0 +1,280 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "binaryop_x86.h"
+
+#include <algorithm>
+
+#include "x86_usability.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(BinaryOp_x86)
+
+BinaryOp_x86::BinaryOp_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+#if __SSE2__
+template<typename V>
+struct binary_op_add_pack {
+    typename V::vec operator() (typename V::vec x, typename V::vec y) const { return V::add(x, y); }
+    float operator() (float x, float y) const { return x + y; }
+};
+
+template<typename V>
+struct binary_op_sub_pack {
+    typename V::vec operator() (typename V::vec x, typename V::vec y) const { return V::sub(x, y); }
+    float operator() (float x, float y) const { return x - y; }
+};
+
+template<typename V>
+struct binary_op_mul_pack {
+    typename V::vec operator() (typename V::vec x, typename V::vec y) const { return V::mul(x, y); }
+    float operator() (float x, float y) const { return x * y; }
+};
+
+template<typename V>
+struct binary_op_div_pack {
+    typename V::vec operator() (typename V::vec x, typename V::vec y) const { return V::div(x, y); }
+    float operator() (float x, float y) const { return x / y; }
+};
+
+template<typename V>
+struct binary_op_max_pack {
+    typename V::vec operator() (typename V::vec x, typename V::vec y) const { return V::max(x, y); }
+    float operator() (float x, float y) const { return std::max(x, y); }
+};
+
+template<typename V>
+struct binary_op_min_pack {
+    typename V::vec operator() (typename V::vec x, typename V::vec y) const { return V::min(x, y); }
+    float operator() (float x, float y) const { return std::min(x, y); }
+};
+
+template<typename V>
+struct binary_op_rsub_pack {
+    typename V::vec operator() (typename V::vec x, typename V::vec y) const { return V::sub(y, x); }
+    float operator() (float x, float y) const { return y - x; }
+};
+
+template<typename V>
+struct binary_op_rdiv_pack {
+    typename V::vec operator() (typename V::vec x, typename V::vec y) const { return V::div(y, x); }
+    float operator() (float x, float y) const { return y / x; }
+};
+
+// a and b share the packed layout, b is either the same shape or one element per channel
+template<typename V, typename Op>
+static int binary_op_pack(const Mat& a, const Mat& b, Mat& c, const Option& opt)
+{
+    Op op;
+
+    const int L = V::lanes;
+    const int channels = a.c;
+    const int size = a.w * a.h;
+
+    c.create(a.w, a.h, channels, a.elemsize, a.elempack, opt.blob_allocator);
+    if (c.empty())
+        return -100;
+
+    // per-channel b holds one packed element per output channel
+    const bool per_channel = b.dims == 1 || (b.w == 1 && b.h == 1);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const float* ptr = a.channel(q);
+        float* outptr = c.channel(q);
+
+        if (per_channel)
+        {
+            const float* b0 = b.dims == 1 ? (const float*)b + q * L : (const float*)b.channel(q);
+            typename V::vec _b = V::load(b0);
+            for (int i=0; i<size; i++)
+            {
+                V::store(outptr + i * L, op(V::load(ptr + i * L), _b));
+            }
+        }
+        else
+        {
+            const float* ptr1 = b.channel(q);
+            for (int i=0; i<size; i++)
+            {
+                V::store(outptr + i * L, op(V::load(ptr + i * L), V::load(ptr1 + i * L)));
+            }
+        }
+    }
+
+    return 0;
+}
+
+template<typename V>
+static int binary_op_pack(int op_type, const Mat& a, const Mat& b, Mat& c, const Option& opt)
+{
+    if (op_type == BinaryOp::Operation_ADD)
+        return binary_op_pack< V, binary_op_add_pack<V> >(a, b, c, opt);
+
+    if (op_type == BinaryOp::Operation_SUB)
+        return binary_op_pack< V, binary_op_sub_pack<V> >(a, b, c, opt);
+
+    if (op_type == BinaryOp::Operation_MUL)
+        return binary_op_pack< V, binary_op_mul_pack<V> >(a, b, c, opt);
+
+    if (op_type == BinaryOp::Operation_DIV)
+        return binary_op_pack< V, binary_op_div_pack<V> >(a, b, c, opt);
+
+    if (op_type == BinaryOp::Operation_MAX)
+        return binary_op_pack< V, binary_op_max_pack<V> >(a, b, c, opt);
+
+    if (op_type == BinaryOp::Operation_MIN)
+        return binary_op_pack< V, binary_op_min_pack<V> >(a, b, c, opt);
+
+    if (op_type == BinaryOp::Operation_RSUB)
+        return binary_op_pack< V, binary_op_rsub_pack<V> >(a, b, c, opt);
+
+    if (op_type == BinaryOp::Operation_RDIV)
+        return binary_op_pack< V, binary_op_rdiv_pack<V> >(a, b, c, opt);
+
+    return 0;
+}
+
+// lanes of a packed element are independent, so the scalar operand runs at full vector width
+template<typename Op>
+static int binary_op_scalar_inplace_pack(Mat& a, float b, const Option& opt)
+{
+#if __AVX__
+    typedef pack8_avx V;
+#else
+    typedef pack4_sse V;
+#endif
+    Op op;
+
+    const int channels = a.c;
+    const int size = a.w * a.h * a.elempack;
+
+    typename V::vec _b = V::set1(b);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = a.channel(q);
+
+        int i = 0;
+        for (; i+V::lanes-1<size; i+=V::lanes)
+        {
+            V::store(ptr + i, op(V::load(ptr + i), _b));
+        }
+        for (; i<size; i++)
+        {
+            ptr[i] = op(ptr[i], b);
+        }
+    }
+
+    return 0;
+}
+#endif // __SSE2__
+
+int BinaryOp_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    const Mat& bottom_blob1 = bottom_blobs[1];
+
+    Mat& top_blob = top_blobs[0];
+
+    const int elempack = bottom_blob.elempack;
+
+    // packed shapes that keep their layout, everything else is broadcast on unpacked blobs
+    bool packed_ok = elempack != 1 && x86_elempack_supported(elempack) && bottom_blob.dims == 3 && op_type != Operation_POW;
+    packed_ok = packed_ok && bottom_blob.elemsize == 4u * elempack && bottom_blob1.elempack == elempack;
+    if (packed_ok)
+    {
+        const Mat& b = bottom_blob1;
+        bool same_shape = b.dims == 3 && b.w == bottom_blob.w && b.h == bottom_blob.h && b.c == bottom_blob.c;
+        bool per_channel = (b.dims == 3 && b.w == 1 && b.h == 1 && b.c == bottom_blob.c) || (b.dims == 1 && b.w == bottom_blob.c);
+        packed_ok = same_shape || per_channel;
+    }
+
+    if (!packed_ok)
+    {
+        if (bottom_blob.elempack == 1 && bottom_blob1.elempack == 1)
+            return BinaryOp::forward(bottom_blobs, top_blobs, opt);
+
+        std::vector<Mat> bottom_blobs_unpacked(2);
+        convert_packing(bottom_blob, bottom_blobs_unpacked[0], 1, opt);
+        convert_packing(bottom_blob1, bottom_blobs_unpacked[1], 1, opt);
+        return BinaryOp::forward(bottom_blobs_unpacked, top_blobs, opt);
+    }
+
+#if __SSE2__
+#if __AVX__
+    if (elempack == 8)
+        return binary_op_pack<pack8_avx>(op_type, bottom_blob, bottom_blob1, top_blob, opt);
+#endif // __AVX__
+    return binary_op_pack<pack4_sse>(op_type, bottom_blob, bottom_blob1, top_blob, opt);
+#else
+    return 0;
+#endif // __SSE2__
+}
+
+int BinaryOp_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+#if __SSE2__
+#if __AVX__
+    typedef pack8_avx V;
+#else
+    typedef pack4_sse V;
+#endif
+    if (op_type == Operation_ADD)
+        return binary_op_scalar_inplace_pack< binary_op_add_pack<V> >(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_SUB)
+        return binary_op_scalar_inplace_pack< binary_op_sub_pack<V> >(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_MUL)
+        return binary_op_scalar_inplace_pack< binary_op_mul_pack<V> >(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_DIV)
+        return binary_op_scalar_inplace_pack< binary_op_div_pack<V> >(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_MAX)
+        return binary_op_scalar_inplace_pack< binary_op_max_pack<V> >(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_MIN)
+        return binary_op_scalar_inplace_pack< binary_op_min_pack<V> >(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_RSUB)
+        return binary_op_scalar_inplace_pack< binary_op_rsub_pack<V> >(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_RDIV)
+        return binary_op_scalar_inplace_pack< binary_op_rdiv_pack<V> >(bottom_top_blob, b, opt);
+#endif // __SSE2__
+
+    if (bottom_top_blob.elempack == 1)
+        return BinaryOp::forward_inplace(bottom_top_blob, opt);
+
+    // pow works on the flat lanes as well, the base kernel only needs to see them unpacked
+    Mat bottom_top_blob_flattened = bottom_top_blob;
+    bottom_top_blob_flattened.w = bottom_top_blob.w * bottom_top_blob.h * bottom_top_blob.elempack;
+    bottom_top_blob_flattened.h = 1;
+    bottom_top_blob_flattened.elemsize = 4u;
+    bottom_top_blob_flattened.elempack = 1;
+    bottom_top_blob_flattened.cstep = bottom_top_blob.cstep * bottom_top_blob.elempack;
+    return BinaryOp::forward_inplace(bottom_top_blob_flattened, opt);
+}
+
+} // namespace ncnn
@@ -511,13 +511,15 @@ static void conv3x3s1_winograd43_transform_kernel_int8_sse(const Mat& kernel, Ma
     //     { 1.0f/24, -1.0f/12,  1.0f/6},
     //     {    0.0f,     0.0f,    1.0f}
     // };
+    // the last row is taken at 1/4 and the output transform scales it back by 4,
+    // 24 * 24 * 127 would overflow the short kernel_tm
     const short ktm[6][3] = {
         {  6,    0,    0},
         { -4,   -4,   -4},
         { -4,    4,   -4},
         {  1,    2,    4},
         {  1,   -2,    4},
-        {  0,    0,   24}
+        {  0,    0,    6}
     };    
 
     #pragma omp parallel for
@@ -556,12 +558,90 @@ static void conv3x3s1_winograd43_transform_kernel_int8_sse(const Mat& kernel, Ma
     }
 }
 
-static void conv3x3s1_winograd43_int8_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Option& opt)
+// per-channel stores applied while the output tiles are still in registers
+// int32 sums of int8 x int8, through scale and bias to float32 and activation
+struct conv_int8_dequant_epilogue
+{
+    typedef float out_type;
+
+    const float* scales;
+    const float* bias;
+    int activation_type;
+    const float* activation_params;
+
+    float scale;
+    float bias0;
+
+    void channel(int p)
+    {
+        scale = scales[p];
+        bias0 = bias ? bias[p] : 0.f;
+    }
+
+    float operator()(int v) const
+    {
+        float f = v * scale + bias0;
+
+        if (activation_type == 1)
+        {
+            f = std::max(f, 0.f);
+        }
+        else if (activation_type == 2)
+        {
+            f = f > 0.f ? f : f * activation_params[0];
+        }
+        else if (activation_type == 3)
+        {
+            f = std::min(std::max(f, activation_params[0]), activation_params[1]);
+        }
+        else if (activation_type == 4)
+        {
+            f = 1.f / (1.f + exp(-f));
+        }
+
+        return f;
+    }
+};
+
+// int32 sums of int8 x int8, through scale_in, bias and scale_out back to int8
+struct conv_int8_requant_epilogue
+{
+    typedef signed char out_type;
+
+    const float* scales;
+    const float* bias;
+    bool fusion_relu;
+
+    float scale_in;
+    float scale_out;
+    float bias0;
+
+    void channel(int p)
+    {
+        scale_in = scales[2*p];
+        scale_out = scales[2*p+1];
+        bias0 = bias ? bias[p] : 0.f;
+    }
+
+    signed char operator()(int v) const
+    {
+        signed char c = float2int8((v * scale_in + bias0) * scale_out);
+        return fusion_relu && c < 0 ? 0 : c;
+    }
+};
+
+// winograd F(4,3) over int8, the output transform stores every tile through epilogue
+// no int32 output blob is kept between the dot and the store
+template<typename Epilogue>
+static void conv3x3s1_winograd43_int8_epilogue_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Epilogue& epilogue, const Option& opt)
 {
     int w = bottom_blob.w;
     int h = bottom_blob.h;
     int inch = bottom_blob.c;
 
+    const int top_w = top_blob.w;
+    const int top_h = top_blob.h;
+
     int outw = top_blob.w;
     int outh = top_blob.h;
     int outch = top_blob.c;
@@ -693,55 +773,7 @@ static void conv3x3s1_winograd43_int8_sse(const Mat& bottom_blob, Mat& top_blob,
     }
     bottom_blob_bordered = Mat();
 
-    // BEGIN dot
-    Mat top_blob_tm;
-    {
-        int w_tm = outw / 4 * 6;
-        int h_tm = outh / 4 * 6;
-
-        int nColBlocks = h_tm/6; // may be the block num in Feathercnn
-        int nRowBlocks = w_tm/6;
-
-        const int tiles = nColBlocks * nRowBlocks; 
-
-        top_blob_tm.create(36, tiles, outch, 4u, opt.workspace_allocator);
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int p=0; p<outch; p++)
-        {
-            Mat out0_tm = top_blob_tm.channel(p);
-            const Mat kernel0_tm = kernel_tm.channel(p);
-
-            for (int i=0; i<tiles; i++)
-            {
-                int* output0_tm = out0_tm.row<int>(i);
-
-                int sum0[36] = {0};
-
-                for (int q=0; q<inch; q++)
-                {
-                    const short* r0 = bottom_blob_tm.channel(q).row<short>(i);
-                    const short* k0 = kernel0_tm.row<short>(q);
-
-                    for (int n=0; n<36; n++)
-                    {
-                        sum0[n] += (int)r0[n] * k0[n];
-                    }
-                }
-
-                for (int n=0; n<36; n++)
-                {
-                    output0_tm[n] = sum0[n];
-                }
-            }
-        }
-    }
-    bottom_blob_tm = Mat();
-    // END dot
-
-    // BEGIN transform output
-    Mat top_blob_bordered;
-    top_blob_bordered.create(outw, outh, outch, 4u, opt.workspace_allocator);
+    // BEGIN dot and transform output
     {
         // AT
         // const float itm[4][6] = {
@@ -754,8 +786,7 @@ static void conv3x3s1_winograd43_int8_sse(const Mat& bottom_blob, Mat& top_blob,
         // 0 =	r00 + r01 + r02 + r03 +	r04
         // 1 =		  r01 - r02 + 2 * (r03 - r04)
         // 2 =		  r01 + r02 + 4 * (r03 + r04)
-        // 3 =		  r01 - r02 + 8 * (r03 - r04)  + r05
-        
+        // 3 =		  r01 - r02 + 8 * (r03 - r04)  + 4 * r05
 
         int w_tm = outw / 4 * 6;
         int h_tm = outh / 4 * 6;
@@ -766,80 +797,170 @@ static void conv3x3s1_winograd43_int8_sse(const Mat& bottom_blob, Mat& top_blob,
         #pragma omp parallel for num_threads(opt.num_threads)
         for (int p=0; p<outch; p++)
         {
-            Mat out_tm = top_blob_tm.channel(p);
-            Mat out = top_blob_bordered.channel(p);
+            Epilogue ep = epilogue;
+            ep.channel(p);
+
+            const Mat kernel0_tm = kernel_tm.channel(p);
+            Mat out = top_blob.channel(p);
 
             for (int j=0; j<nColBlocks; j++)
             {
-                int* outRow0 = out.row<int>(j*4);
-                int* outRow1 = out.row<int>(j*4+1);
-                int* outRow2 = out.row<int>(j*4+2);
-                int* outRow3 = out.row<int>(j*4+3);                
-
-                for(int i=0; i<nRowBlocks; i++)
+                for (int i=0; i<nRowBlocks; i++)
                 {
-                    int* out_tile = out_tm.row<int>(j*nRowBlocks + i);
+                    const int tile = j*nRowBlocks + i;
 
-                    int s0[6],s1[6],s2[6],s3[6],s4[6],s5[6];
-                    int w0[6],w1[6],w2[6],w3[6];
-                    int d0[4],d1[4],d2[4],d3[4],d4[4],d5[4];
-                    int o0[4],o1[4],o2[4],o3[4];
-                    // load
-                    for (int n = 0; n < 6; n++)
+                    int s[36] = {0};
+
+                    int q = 0;
+#if __SSE2__
+                    // two input channels per pmaddwd, int16 products summed pairwise into int32
                     {
-                        s0[n] = out_tile[n];
-                        s1[n] = out_tile[n+ 6];
-                        s2[n] = out_tile[n+12];
-                        s3[n] = out_tile[n+18];
-                        s4[n] = out_tile[n+24];
-                        s5[n] = out_tile[n+30];
+#if __AVX2__
+                        __m256i _s0 = _mm256_setzero_si256();
+                        __m256i _s1 = _mm256_setzero_si256();
+                        __m256i _s2 = _mm256_setzero_si256();
+                        __m256i _s3 = _mm256_setzero_si256();
+#else
+                        __m128i _s[8];
+                        for (int n=0; n<8; n++)
+                            _s[n] = _mm_setzero_si128();
+#endif // __AVX2__
+                        __m128i _s8 = _mm_setzero_si128();
+
+                        for (; q+1<inch; q+=2)
+                        {
+                            const short* r0 = bottom_blob_tm.channel(q).row<const short>(tile);
+                            const short* r1 = bottom_blob_tm.channel(q+1).row<const short>(tile);
+                            const short* k0 = kernel0_tm.row<const short>(q);
+                            const short* k1 = kernel0_tm.row<const short>(q+1);
+
+#if __AVX2__
+                            for (int n=0; n<2; n++)
+                            {
+                                __m256i _r0 = _mm256_loadu_si256((const __m256i*)(r0 + n*16));
+                                __m256i _r1 = _mm256_loadu_si256((const __m256i*)(r1 + n*16));
+                                __m256i _k0 = _mm256_loadu_si256((const __m256i*)(k0 + n*16));
+                                __m256i _k1 = _mm256_loadu_si256((const __m256i*)(k1 + n*16));
+
+                                // positions 0-3 8-11 and 4-7 12-15 of this half
+                                __m256i _lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(_r0, _r1), _mm256_unpacklo_epi16(_k0, _k1));
+                                __m256i _hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(_r0, _r1), _mm256_unpackhi_epi16(_k0, _k1));
+                                if (n == 0)
+                                {
+                                    _s0 = _mm256_add_epi32(_s0, _lo);
+                                    _s1 = _mm256_add_epi32(_s1, _hi);
+                                }
+                                else
+                                {
+                                    _s2 = _mm256_add_epi32(_s2, _lo);
+                                    _s3 = _mm256_add_epi32(_s3, _hi);
+                                }
+                            }
+#else
+                            for (int n=0; n<4; n++)
+                            {
+                                __m128i _r0 = _mm_loadu_si128((const __m128i*)(r0 + n*8));
+                                __m128i _r1 = _mm_loadu_si128((const __m128i*)(r1 + n*8));
+                                __m128i _k0 = _mm_loadu_si128((const __m128i*)(k0 + n*8));
+                                __m128i _k1 = _mm_loadu_si128((const __m128i*)(k1 + n*8));
+
+                                _s[n*2] = _mm_add_epi32(_s[n*2], _mm_madd_epi16(_mm_unpacklo_epi16(_r0, _r1), _mm_unpacklo_epi16(_k0, _k1)));
+                                _s[n*2+1] = _mm_add_epi32(_s[n*2+1], _mm_madd_epi16(_mm_unpackhi_epi16(_r0, _r1), _mm_unpackhi_epi16(_k0, _k1)));
+                            }
+#endif // __AVX2__
+                            {
+                                __m128i _r0 = _mm_loadl_epi64((const __m128i*)(r0 + 32));
+                                __m128i _r1 = _mm_loadl_epi64((const __m128i*)(r1 + 32));
+                                __m128i _k0 = _mm_loadl_epi64((const __m128i*)(k0 + 32));
+                                __m128i _k1 = _mm_loadl_epi64((const __m128i*)(k1 + 32));
+
+                                _s8 = _mm_add_epi32(_s8, _mm_madd_epi16(_mm_unpacklo_epi16(_r0, _r1), _mm_unpacklo_epi16(_k0, _k1)));
+                            }
+                        }
+
+#if __AVX2__
+                        _mm256_storeu_si256((__m256i*)(s + 0), _mm256_permute2x128_si256(_s0, _s1, 0x20));
+                        _mm256_storeu_si256((__m256i*)(s + 8), _mm256_permute2x128_si256(_s0, _s1, 0x31));
+                        _mm256_storeu_si256((__m256i*)(s + 16), _mm256_permute2x128_si256(_s2, _s3, 0x20));
+                        _mm256_storeu_si256((__m256i*)(s + 24), _mm256_permute2x128_si256(_s2, _s3, 0x31));
+#else
+                        for (int n=0; n<8; n++)
+                            _mm_storeu_si128((__m128i*)(s + n*4), _s[n]);
+#endif // __AVX2__
+                        _mm_storeu_si128((__m128i*)(s + 32), _s8);
                     }
-                    // w = A_T * W
-                    for (int n = 0; n < 6; n++)
+#endif // __SSE2__
+                    for (; q<inch; q++)
                     {
-                        w0[n] = s0[n] + s1[n] + s2[n] +   s3[n] +   s4[n];
-                        w1[n] =         s1[n] - s2[n] + 2*s3[n] - 2*s4[n];
-                        w2[n] =         s1[n] + s2[n] + 4*s3[n] + 4*s4[n];
-                        w3[n] =         s1[n] - s2[n] + 8*s3[n] - 8*s4[n] + s5[n];
+                        const short* r0 = bottom_blob_tm.channel(q).row<const short>(tile);
+                        const short* k0 = kernel0_tm.row<const short>(q);
+
+                        for (int n=0; n<36; n++)
+                        {
+                            s[n] += (int)r0[n] * k0[n];
+                        }
                     }
-                    // transpose w to w_t
+
+                    int w0[6],w1[6],w2[6],w3[6];
+                    int o[4][4];
+
+                    // w = A_T * W
+                    for (int n = 0; n < 6; n++)
                     {
-                        d0[0] = w0[0]; d0[1] = w1[0]; d0[2] = w2[0]; d0[3] = w3[0];
-                        d1[0] = w0[1]; d1[1] = w1[1]; d1[2] = w2[1]; d1[3] = w3[1];
-                        d2[0] = w0[2]; d2[1] = w1[2]; d2[2] = w2[2]; d2[3] = w3[2];
-                        d3[0] = w0[3]; d3[1] = w1[3]; d3[2] = w2[3]; d3[3] = w3[3];
-                        d4[0] = w0[4]; d4[1] = w1[4]; d4[2] = w2[4]; d4[3] = w3[4];
-                        d5[0] = w0[5]; d5[1] = w1[5]; d5[2] = w2[5]; d5[3] = w3[5];
+                        w0[n] = s[n] + s[n+6] + s[n+12] +   s[n+18] +   s[n+24];
+                        w1[n] =        s[n+6] - s[n+12] + 2*s[n+18] - 2*s[n+24];
+                        w2[n] =        s[n+6] + s[n+12] + 4*s[n+18] + 4*s[n+24];
+                        w3[n] =        s[n+6] - s[n+12] + 8*s[n+18] - 8*s[n+24] + 4*s[n+30];
                     }
-                    // Y = A_T * w_t
-                    for (int n = 0; n < 4; n++)
+                    // Y = A_T * w_t, o[x][y] holds column x of row y
+                    for (int m = 0; m < 4; m++)
                     {
-                        o0[n] = d0[n] + d1[n] + d2[n] +   d3[n] +   d4[n];
-                        o1[n] =         d1[n] - d2[n] + 2*d3[n] - 2*d4[n];
-                        o2[n] =         d1[n] + d2[n] + 4*d3[n] + 4*d4[n];
-                        o3[n] =         d1[n] - d2[n] + 8*d3[n] - 8*d4[n] + d5[n];
+                        const int* d = m == 0 ? w0 : m == 1 ? w1 : m == 2 ? w2 : w3;
+
+                        o[m][0] = d[0] + d[1] + d[2] +   d[3] +   d[4];
+                        o[m][1] =        d[1] - d[2] + 2*d[3] - 2*d[4];
+                        o[m][2] =        d[1] + d[2] + 4*d[3] + 4*d[4];
+                        o[m][3] =        d[1] - d[2] + 8*d[3] - 8*d[4] + 4*d[5];
                     }
-                    // save to top blob tm
-                    for (int n = 0; n < 4; n++)
+
+                    // store the part of the tile inside the output
+                    const int ymax = std::min(4, top_h - j*4);
+                    const int xmax = std::min(4, top_w - i*4);
+                    for (int y = 0; y < ymax; y++)
                     {
-                        outRow0[n] = o0[n] / 576;
-                        outRow1[n] = o1[n] / 576;
-                        outRow2[n] = o2[n] / 576;
-                        outRow3[n] = o3[n] / 576;
-                    }
+                        typename Epilogue::out_type* outptr = out.row<typename Epilogue::out_type>(j*4 + y) + i*4;
 
-                    outRow0 += 4;
-                    outRow1 += 4;
-                    outRow2 += 4;
-                    outRow3 += 4;
+                        for (int x = 0; x < xmax; x++)
+                        {
+                            outptr[x] = ep(o[x][y] / 576);
+                        }
+                    }
                 }
             }
         }
     }
-    // END transform output 
+    // END dot and transform output
+}
 
-    // cut result pad
-    copy_cut_border(top_blob_bordered, top_blob, 0, top_blob_bordered.h - top_blob.h, 0, top_blob_bordered.w - top_blob.w, opt);
+static void conv3x3s1_winograd43_int8_dequant_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, const std::vector<float>& scales_dequant, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    conv_int8_dequant_epilogue epilogue;
+    epilogue.scales = scales_dequant.data();
+    epilogue.bias = _bias;
+    epilogue.activation_type = activation_type;
+    epilogue.activation_params = activation_params;
+
+    conv3x3s1_winograd43_int8_epilogue_sse(bottom_blob, top_blob, kernel_tm, epilogue, opt);
+}
+
+static void conv3x3s1_winograd43_int8_requant_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, const std::vector<float>& scales_requant, bool fusion_relu, const Option& opt)
+{
+    conv_int8_requant_epilogue epilogue;
+    epilogue.scales = scales_requant.data();
+    epilogue.bias = _bias;
+    epilogue.fusion_relu = fusion_relu;
+
+    conv3x3s1_winograd43_int8_epilogue_sse(bottom_blob, top_blob, kernel_tm, epilogue, opt);
 }
 
 static void conv3x3s2_int8_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, const Option& opt)
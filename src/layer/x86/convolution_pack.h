@@ -0,0 +1,178 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// weight_data_pack holds one output pack per channel
+// with the in lanes x out lanes block of every input pack and kernel tap contiguous
+static void conv_transform_kernel_pack_sse(const Mat& weight_data, Mat& weight_data_pack, int num_input, int num_output, int maxk, int in_elempack, int out_elempack)
+{
+    weight_data_pack.create(maxk * in_elempack * out_elempack, num_input / in_elempack, num_output / out_elempack);
+
+    for (int p=0; p<num_output / out_elempack; p++)
+    {
+        float* kptr = weight_data_pack.channel(p);
+
+        for (int q=0; q<num_input / in_elempack; q++)
+        {
+            for (int k=0; k<maxk; k++)
+            {
+                for (int l=0; l<in_elempack; l++)
+                {
+                    for (int o=0; o<out_elempack; o++)
+                    {
+                        const float* ptr = (const float*)weight_data + ((p * out_elempack + o) * num_input + q * in_elempack + l) * maxk;
+                        kptr[o] = ptr[k];
+                    }
+                    kptr += out_elempack;
+                }
+            }
+        }
+    }
+}
+
+// direct convolution between packed blobs, IN lanes per input element and V::lanes per output element
+// every broadcast input value feeds two output packs and every weight load feeds four output pixels,
+// pixels are tiled over the flattened output so narrow maps keep full tiles
+template<typename V, int IN>
+static void conv_pack_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data_pack, const Mat& bias_data, int stride_w, int stride_h, const int* space_ofs, int maxk, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    typedef typename V::vec vec;
+    const int OUT = V::lanes;
+
+    const int w = bottom_blob.w;
+    const int inch = bottom_blob.c;
+    const size_t in_cstep = bottom_blob.cstep * IN;
+
+    const int outw = top_blob.w;
+    const int outsize = top_blob.w * top_blob.h;
+    const int outch = top_blob.c;
+
+    const int nn_outch = outch / 2;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_outch + outch % 2; pp++)
+    {
+        // the odd output pack left over runs with both halves of the pair on itself
+        const int p0 = pp < nn_outch ? pp * 2 : outch - 1;
+        const int p1 = pp < nn_outch ? pp * 2 + 1 : outch - 1;
+
+        float* outptr0 = top_blob.channel(p0);
+        float* outptr1 = top_blob.channel(p1);
+
+        vec _bias0 = bias_data.empty() ? V::zero() : V::load((const float*)bias_data + p0 * OUT);
+        vec _bias1 = bias_data.empty() ? V::zero() : V::load((const float*)bias_data + p1 * OUT);
+
+        int n = 0;
+        for (; n+3<outsize; n+=4)
+        {
+            // input offset of each output pixel in the tile
+            int ofs[4];
+            for (int t=0; t<4; t++)
+            {
+                ofs[t] = ((n + t) / outw * stride_h * w + (n + t) % outw * stride_w) * IN;
+            }
+
+            vec _sum00 = _bias0;
+            vec _sum01 = _bias0;
+            vec _sum02 = _bias0;
+            vec _sum03 = _bias0;
+            vec _sum10 = _bias1;
+            vec _sum11 = _bias1;
+            vec _sum12 = _bias1;
+            vec _sum13 = _bias1;
+
+            const float* kptr0 = weight_data_pack.channel(p0);
+            const float* kptr1 = weight_data_pack.channel(p1);
+            const float* sptr = bottom_blob;
+
+            for (int q=0; q<inch; q++)
+            {
+                const float* r0 = sptr + ofs[0];
+                const float* r1 = sptr + ofs[1];
+                const float* r2 = sptr + ofs[2];
+                const float* r3 = sptr + ofs[3];
+
+                for (int k=0; k<maxk; k++)
+                {
+                    const int sk = space_ofs[k] * IN;
+
+                    for (int l=0; l<IN; l++)
+                    {
+                        vec _w0 = V::load(kptr0);
+                        vec _w1 = V::load(kptr1);
+
+                        vec _v = V::set1(r0[sk + l]);
+                        _sum00 = V::fmadd(_v, _w0, _sum00);
+                        _sum10 = V::fmadd(_v, _w1, _sum10);
+                        _v = V::set1(r1[sk + l]);
+                        _sum01 = V::fmadd(_v, _w0, _sum01);
+                        _sum11 = V::fmadd(_v, _w1, _sum11);
+                        _v = V::set1(r2[sk + l]);
+                        _sum02 = V::fmadd(_v, _w0, _sum02);
+                        _sum12 = V::fmadd(_v, _w1, _sum12);
+                        _v = V::set1(r3[sk + l]);
+                        _sum03 = V::fmadd(_v, _w0, _sum03);
+                        _sum13 = V::fmadd(_v, _w1, _sum13);
+
+                        kptr0 += OUT;
+                        kptr1 += OUT;
+                    }
+                }
+
+                sptr += in_cstep;
+            }
+
+            V::store(outptr0 + n * OUT, activation_pack<V>(_sum00, activation_type, activation_params));
+            V::store(outptr0 + (n + 1) * OUT, activation_pack<V>(_sum01, activation_type, activation_params));
+            V::store(outptr0 + (n + 2) * OUT, activation_pack<V>(_sum02, activation_type, activation_params));
+            V::store(outptr0 + (n + 3) * OUT, activation_pack<V>(_sum03, activation_type, activation_params));
+            V::store(outptr1 + n * OUT, activation_pack<V>(_sum10, activation_type, activation_params));
+            V::store(outptr1 + (n + 1) * OUT, activation_pack<V>(_sum11, activation_type, activation_params));
+            V::store(outptr1 + (n + 2) * OUT, activation_pack<V>(_sum12, activation_type, activation_params));
+            V::store(outptr1 + (n + 3) * OUT, activation_pack<V>(_sum13, activation_type, activation_params));
+        }
+        for (; n<outsize; n++)
+        {
+            const int ofs = (n / outw * stride_h * w + n % outw * stride_w) * IN;
+
+            vec _sum0 = _bias0;
+            vec _sum1 = _bias1;
+
+            const float* kptr0 = weight_data_pack.channel(p0);
+            const float* kptr1 = weight_data_pack.channel(p1);
+            const float* sptr = (const float*)bottom_blob + ofs;
+
+            for (int q=0; q<inch; q++)
+            {
+                for (int k=0; k<maxk; k++)
+                {
+                    const float* slocal = sptr + space_ofs[k] * IN;
+
+                    for (int l=0; l<IN; l++)
+                    {
+                        vec _v = V::set1(slocal[l]);
+                        _sum0 = V::fmadd(_v, V::load(kptr0), _sum0);
+                        _sum1 = V::fmadd(_v, V::load(kptr1), _sum1);
+                        kptr0 += OUT;
+                        kptr1 += OUT;
+                    }
+                }
+
+                sptr += in_cstep;
+            }
+
+            V::store(outptr0 + n * OUT, activation_pack<V>(_sum0, activation_type, activation_params));
+            V::store(outptr1 + n * OUT, activation_pack<V>(_sum1, activation_type, activation_params));
+        }
+    }
+}
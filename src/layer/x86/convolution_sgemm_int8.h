@@ -20,1341 +20,230 @@ static inline signed char float2int8(float v)
     return (signed char)int32;
 }
 
-static void conv_im2col_sgemm_int8_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, \
-            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const Option& opt)
+// kernel packed 8 output channels by k quads for int8_gemm_8x16, with the vnni offset compensation
+static void conv_im2col_sgemm_transform_kernel_int8_sse(const Mat& _kernel, Mat& kernel_tm, int inch, int outch, int kernel_size)
+{
+    int8_gemm_transform_kernel(_kernel, kernel_tm, inch * kernel_size, outch);
+}
+
+// im2col and pack 16 output pixels by k quads for int8_gemm_8x16
+// 1x1 stride 1 packs the channels in place
+static void conv_im2col_pack_int8_sse(const Mat& bottom_blob, Mat& bottom_tm, int kernel_w, int kernel_h, int stride_w, int stride_h, int outw, int outh, const Option& opt)
 {
     int w = bottom_blob.w;
     int inch = bottom_blob.c;
 
-    int outw = top_blob.w;
-    int outh = top_blob.h;
-    int outch = top_blob.c;
-
-    const signed char *kernel = _kernel;
-
-    // im2row
-    Mat bottom_im2row(kernel_h*kernel_w*inch, outw*outh, 1UL, opt.workspace_allocator);
-    {
-        signed char* ret = (signed char*)bottom_im2row;
-        int retID = 0;
-    
-        for (int i=0; i<outh; i++)
-        {
-            for (int j=0; j<outw; j++)
-            {
-                for (int p=0; p<inch; p++)
-                {
-                    const signed char* input = bottom_blob.channel(p);
-                    for (int u=0; u<kernel_h; u++)
-                    {
-                        for (int v=0; v<kernel_w; v++)
-                        {    
-                            int row = u + i * stride_h;
-                            int col = v + j * stride_w;
-                            int index = row * w + col;
-                            ret[retID] = input[index];
-                            retID++;
-                        }
-                    }                
-                }
-            }
-        }
-    }    
-
-    int kernel_size = kernel_w * kernel_h;
-    int out_size = outw * outh;
+    int maxk = kernel_w * kernel_h;
+    int N = outw * outh;
+    int K = inch * maxk;
 
-    // int M = outch;  // outch
-    int N = outw * outh; // outsize or out stride
-    int K = kernel_w * kernel_h * inch; // ksize * inch
-
-    // bottom_im2row memory packed 4 x 4
-    Mat bottom_tm(4*kernel_size, inch, out_size/4 + out_size%4, (size_t)1u, opt.workspace_allocator);
+    if (maxk == 1 && stride_w == 1 && stride_h == 1 && w == outw && bottom_blob.h == outh)
     {
-        int nn_size = out_size >> 2;
-        int remain_size_start = nn_size << 2;
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int ii=0; ii<nn_size; ii++)
-        {
-            int i = ii * 4;
-
-            const signed char* img0 = bottom_im2row.row<signed char>(i);
-            const signed char* img1 = bottom_im2row.row<signed char>(i+1);
-            const signed char* img2 = bottom_im2row.row<signed char>(i+2);
-            const signed char* img3 = bottom_im2row.row<signed char>(i+3);
-
-            signed char* tmpptr = bottom_tm.channel(i/4);
-
-            int q = 0;
-            for (; q+1<inch*kernel_size; q=q+2)
-            {
-                tmpptr[0] = img0[0];
-                tmpptr[1] = img0[1];
-                tmpptr[2] = img1[0];
-                tmpptr[3] = img1[1];
-                tmpptr[4] = img2[0];
-                tmpptr[5] = img2[1];
-                tmpptr[6] = img3[0];
-                tmpptr[7] = img3[1];
-
-                tmpptr += 8;
-                img0 += 2;
-                img1 += 2;
-                img2 += 2;
-                img3 += 2;
-            }
-
-            for (; q<inch*kernel_size; q++)
-            {
-                tmpptr[0] = img0[0];
-                tmpptr[1] = img1[0];
-                tmpptr[2] = img2[0];
-                tmpptr[3] = img3[0];
-
-                tmpptr += 4;
-                img0 += 1;
-                img1 += 1;
-                img2 += 1;
-                img3 += 1;                
-            }
-        }
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int i=remain_size_start; i<out_size; i++)
-        {
-            const signed char* img0 = bottom_im2row.row<signed char>(i);
-
-            signed char* tmpptr = bottom_tm.channel(i/4 + i%4);
-
-            int q=0;
-            for (; q+1<inch*kernel_size; q=q+2)
-            {
-                tmpptr[0] = img0[0];
-                tmpptr[1] = img0[1];
-
-                tmpptr += 2;
-                img0 += 2;
-            }
-
-            for (; q<inch*kernel_size; q++)
-            {
-                tmpptr[0] = img0[0];
-
-                tmpptr += 1;
-                img0 += 1;
-            }
-        }       
+        int8_gemm_pack_input(bottom_blob, bottom_tm, K, N, opt);
+        return;
     }
 
-    // kernel memory packed 4 x 4
-    Mat kernel_tm(4*kernel_size, inch, outch/4 + outch%4, (size_t)1u, opt.workspace_allocator);
-    {
-        int nn_outch = 0;
-        int remain_outch_start = 0;
-
-        nn_outch = outch >> 2;
-        remain_outch_start = nn_outch << 2;
-        
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int pp=0; pp<nn_outch; pp++)
-        {
-            int p = pp * 4;
+    // one row of output pixels per kernel tap
+    Mat bottom_im2col(N, 1, K, (size_t)1u, opt.workspace_allocator);
 
-            const signed char* k0 = kernel + (p+0)*inch*kernel_size;
-            const signed char* k1 = kernel + (p+1)*inch*kernel_size;
-            const signed char* k2 = kernel + (p+2)*inch*kernel_size;
-            const signed char* k3 = kernel + (p+3)*inch*kernel_size;
-
-            signed char* ktmp = kernel_tm.channel(p/4);
-
-            int q=0;
-            for (; q+1<inch*kernel_size; q+=2)
-            {
-                ktmp[0] = k0[0];
-                ktmp[1] = k0[1];
-                ktmp[2] = k1[0];
-                ktmp[3] = k1[1];
-                ktmp[4] = k2[0];
-                ktmp[5] = k2[1];
-                ktmp[6] = k3[0];
-                ktmp[7] = k3[1];
-
-                ktmp += 8;
-
-                k0 += 2;
-                k1 += 2;
-                k2 += 2;
-                k3 += 2;
-            }
-
-            for (; q<inch*kernel_size; q++)
-            { 
-                ktmp[0] = k0[0];
-                ktmp[1] = k1[0];
-                ktmp[2] = k2[0];
-                ktmp[3] = k3[0];
-                ktmp += 4;
-
-                k0 += 1;
-                k1 += 1;
-                k2 += 1;
-                k3 += 1;
-            }           
-        }
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int p=remain_outch_start; p<outch; p++)
-        {
-            const signed char* k0 = kernel + (p+0)*inch*kernel_size;
-
-            signed char* ktmp = kernel_tm.channel(p/4 + p%4);
-
-            int q=0;
-            for (; q+1<inch*kernel_size; q=q+2)
-            {
-                ktmp[0] = k0[0];
-                ktmp[1] = k0[1];
-                ktmp += 2;
-                k0 += 2;
-            }
-
-            for (; q<inch*kernel_size; q++)
-            {
-                ktmp[0] = k0[0];
-                ktmp++;
-                k0++;
-            }
-        }
-    }    
-
-    // 4x4
-    // sgemm(int M, int N, int K, float* A, float* B, float* C)
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<inch; p++)
     {
-        // int M = outch;  // outch
-        // int N = outw * outh; // outsize or out stride
-        // int L = kernel_w * kernel_h * inch; // ksize * inch
-
-        int nn_outch = 0;
-        int remain_outch_start = 0;
+        const signed char* img = bottom_blob.channel(p);
 
-        nn_outch = outch >> 2;
-        remain_outch_start = nn_outch << 2;
-        
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int pp=0; pp<nn_outch; pp++)
+        for (int u=0; u<kernel_h; u++)
         {
-            int i = pp * 4;
-
-            int* output0 = top_blob.channel(i);
-            int* output1 = top_blob.channel(i+1);
-            int* output2 = top_blob.channel(i+2);
-            int* output3 = top_blob.channel(i+3);
-
-            int j=0;
-            for (; j+3<N; j=j+4)
+            for (int v=0; v<kernel_w; v++)
             {
-                signed char* vb = bottom_tm.channel(j/4);
-                signed char* va = kernel_tm.channel(i/4);
-                
-                int sum0[4] = {0};
-                int sum1[4] = {0};
-                int sum2[4] = {0};
-                int sum3[4] = {0};
-               
-                int k=0;
+                signed char* ptr = bottom_im2col.channel(p * maxk + u * kernel_w + v);
 
-                for (; k+1<K; k=k+2)
+                for (int i=0; i<outh; i++)
                 {
-                    for (int n=0; n<4; n++)
-                    {
-                        sum0[n] += (int)va[0] * vb[2*n];   // k0
-                        sum0[n] += (int)va[1] * vb[2*n+1];
-
-                        sum1[n] += (int)va[2] * vb[2*n];   // k1
-                        sum1[n] += (int)va[3] * vb[2*n+1];
-
-                        sum2[n] += (int)va[4] * vb[2*n];   // k2
-                        sum2[n] += (int)va[5] * vb[2*n+1];
-
-                        sum3[n] += (int)va[6] * vb[2*n];   // k3
-                        sum3[n] += (int)va[7] * vb[2*n+1];
-                    }
+                    const signed char* sptr = img + (i * stride_h + u) * w + v;
 
-                    va += 8;
-                    vb += 8;
-                }
-
-                for (; k<K; k++)
-                {
-                    for (int n=0; n<4; n++)
+                    if (stride_w == 1)
                     {
-                        sum0[n] += (int)va[0] * vb[n];
-                        sum1[n] += (int)va[1] * vb[n];
-                        sum2[n] += (int)va[2] * vb[n];
-                        sum3[n] += (int)va[3] * vb[n];
+                        memcpy(ptr, sptr, outw);
                     }
-                    
-                    va += 4;
-                    vb += 4;
-                }
-
-                for (int n=0; n<4; n++)
-                {
-                    output0[n] = sum0[n];
-                    output1[n] = sum1[n];
-                    output2[n] = sum2[n];
-                    output3[n] = sum3[n];
-                }
-                output0 += 4;
-                output1 += 4;
-                output2 += 4;
-                output3 += 4;
-            }
-
-            for (; j<N; j++)
-            {                
-                int sum0 = 0;
-                int sum1 = 0;
-                int sum2 = 0;
-                int sum3 = 0;
-
-                signed char* vb = bottom_tm.channel(j/4 + j%4);
-                signed char* va = kernel_tm.channel(i/4);
-
-                int k=0;
-
-                for (; k+1<K; k=k+2)
-                {
-                    sum0 += (int)va[0] * vb[0];
-                    sum0 += (int)va[1] * vb[1];
-
-                    sum1 += (int)va[2] * vb[0];
-                    sum1 += (int)va[3] * vb[1];
-
-                    sum2 += (int)va[4] * vb[0];
-                    sum2 += (int)va[5] * vb[1];
-
-                    sum3 += (int)va[6] * vb[0];
-                    sum3 += (int)va[7] * vb[1];
-
-                    va += 8;
-                    vb += 2;
-                }
-
-                for (; k<K; k++)
-                {
-                    sum0 += (int)va[0] * vb[0];
-                    sum1 += (int)va[1] * vb[0];
-                    sum2 += (int)va[2] * vb[0];
-                    sum3 += (int)va[3] * vb[0];
-
-                    va += 4;
-                    vb += 1;
-                }
-                
-                output0[0] = sum0;
-                output1[0] = sum1;
-                output2[0] = sum2;
-                output3[0] = sum3;
-
-                output0++;
-                output1++;
-                output2++;
-                output3++;
-            }
-        }
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int i=remain_outch_start; i<outch; i++)
-        {
-            int* output = top_blob.channel(i);
-
-            int j=0;
-            for (; j+3<N; j=j+4)
-            {
-                signed char* vb = bottom_tm.channel(j/4);
-                signed char* va = kernel_tm.channel(i/4 + i%4);
-                int sum[4] = {0};
-
-                int k=0;
-                for (; k+1<K; k=k+2)
-                {
-                    for (int n=0; n<4; n++)
+                    else
                     {
-                        sum[n] += (int)va[0] * vb[2*n];
-                        sum[n] += (int)va[1] * vb[2*n+1];
+                        for (int j=0; j<outw; j++)
+                        {
+                            ptr[j] = sptr[j * stride_w];
+                        }
                     }
-                    va += 2;
-                    vb += 8;
-                }
 
-                for (; k<K; k++)
-                {
-                    for (int n=0; n<4; n++)
-                    {
-                        sum[n] += (int)va[0] * vb[n];
-                    }
-                    va += 1;
-                    vb += 4;
+                    ptr += outw;
                 }
-
-                for (int n=0; n<4; n++)
-                {
-                    output[n] = sum[n];
-                }
-                output += 4;
-            }
-
-            for (; j<N; j++)
-            {
-                int sum = 0;
-
-                signed char* vb = bottom_tm.channel(j/4 + j%4);
-                signed char* va = kernel_tm.channel(i/4 + i%4);
-
-                for (int k=0; k<K; k++)
-                {
-                    sum += (int)va[0] * vb[0];
-
-                    va += 1;
-                    vb += 1;
-                }
-                output[0] = sum;
-
-                output++;
             }
         }
     }
 
-    // // sgemm(int M, int N, int K, float* A, float* B, float* C)
-    // {
-    //     for (int i=0; i<M; i++)
-    //     {
-    //         int* output = top_blob.channel(i);
-
-    //         for (int j=0; j<N; j++)
-    //         {
-    //             int sum = 0;
-
-    //             signed char* vb = (signed char*)bottom_im2row + K * j;
-    //             const signed char* va = kernel + K * i;
-
-    //             for (int k=0; k<K; k++)
-    //             {
-    //                 sum += (int)va[0] * vb[0];
-
-    //                 va += 1;
-    //                 vb += 1;
-    //             }
-    //             output[0] = sum;
-
-    //             output++;
-    //         }
-    //     }
-    // }
+    int8_gemm_pack_input(bottom_im2col, bottom_tm, K, N, opt);
 }
 
-static void conv_im2col_sgemm_int8_dequant_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, \
-            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const Mat &_bias, std::vector<float> scale_dequant, const Option& opt)
+// the int32 sums of one output channel stored as is
+struct conv_int8_store
 {
-    int w = bottom_blob.w;
-    int inch = bottom_blob.c;
+    conv_int8_store(Mat& _top_blob) : top_blob(_top_blob) {}
 
-    int outw = top_blob.w;
-    int outh = top_blob.h;
-    int outch = top_blob.c;
-
-    const signed char *kernel = _kernel;
-    const float* bias = _bias;
-
-    // im2row
-    Mat bottom_im2row(kernel_h*kernel_w*inch, outw*outh, 1UL, opt.workspace_allocator);
+    void operator()(int p, int j, int n, const int* sum)
     {
-        signed char* ret = (signed char*)bottom_im2row;
-        int retID = 0;
-    
-        for (int i=0; i<outh; i++)
+        int* outptr = (int*)top_blob.channel(p) + j;
+        for (int x=0; x<n; x++)
         {
-            for (int j=0; j<outw; j++)
-            {
-                for (int p=0; p<inch; p++)
-                {
-                    const signed char* input = bottom_blob.channel(p);
-                    for (int u=0; u<kernel_h; u++)
-                    {
-                        for (int v=0; v<kernel_w; v++)
-                        {    
-                            int row = u + i * stride_h;
-                            int col = v + j * stride_w;
-                            int index = row * w + col;
-                            ret[retID] = input[index];
-                            retID++;
-                        }
-                    }                
-                }
-            }
+            outptr[x] = sum[x];
         }
-    }    
+    }
 
-    int kernel_size = kernel_w * kernel_h;
-    int out_size = outw * outh;
+    Mat& top_blob;
+};
 
-    // int M = outch;  // outch
-    int N = outw * outh; // outsize or out stride
-    int K = kernel_w * kernel_h * inch; // ksize * inch
+struct conv_int8_store_dequant
+{
+    conv_int8_store_dequant(Mat& _top_blob, const float* _bias, const std::vector<float>& _scale_dequant)
+        : top_blob(_top_blob), bias(_bias), scale_dequant(_scale_dequant) {}
 
-    // bottom_im2row memory packed 4 x 4
-    Mat bottom_tm(4*kernel_size, inch, out_size/4 + out_size%4, (size_t)1u, opt.workspace_allocator);
+    void operator()(int p, int j, int n, const int* sum)
     {
-        int nn_size = out_size >> 2;
-        int remain_size_start = nn_size << 2;
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int ii=0; ii<nn_size; ii++)
+        float* outptr = (float*)top_blob.channel(p) + j;
+        const float bias0 = bias ? bias[p] : 0.f;
+        const float scale_dequant0 = scale_dequant[p];
+        int x = 0;
+#if __SSE2__
+        __m128 _scale = _mm_set1_ps(scale_dequant0);
+        __m128 _bias = _mm_set1_ps(bias0);
+        for (; x+3<n; x+=4)
         {
-            int i = ii * 4;
-
-            const signed char* img0 = bottom_im2row.row<signed char>(i);
-            const signed char* img1 = bottom_im2row.row<signed char>(i+1);
-            const signed char* img2 = bottom_im2row.row<signed char>(i+2);
-            const signed char* img3 = bottom_im2row.row<signed char>(i+3);
-
-            signed char* tmpptr = bottom_tm.channel(i/4);
-
-            int q = 0;
-            for (; q+1<inch*kernel_size; q=q+2)
-            {
-                tmpptr[0] = img0[0];
-                tmpptr[1] = img0[1];
-                tmpptr[2] = img1[0];
-                tmpptr[3] = img1[1];
-                tmpptr[4] = img2[0];
-                tmpptr[5] = img2[1];
-                tmpptr[6] = img3[0];
-                tmpptr[7] = img3[1];
-
-                tmpptr += 8;
-                img0 += 2;
-                img1 += 2;
-                img2 += 2;
-                img3 += 2;
-            }
-
-            for (; q<inch*kernel_size; q++)
-            {
-                tmpptr[0] = img0[0];
-                tmpptr[1] = img1[0];
-                tmpptr[2] = img2[0];
-                tmpptr[3] = img3[0];
-
-                tmpptr += 4;
-                img0 += 1;
-                img1 += 1;
-                img2 += 1;
-                img3 += 1;                
-            }
+            __m128 _v = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(sum + x)));
+            _mm_storeu_ps(outptr + x, _mm_add_ps(_mm_mul_ps(_v, _scale), _bias));
         }
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int i=remain_size_start; i<out_size; i++)
+#endif // __SSE2__
+        for (; x<n; x++)
         {
-            const signed char* img0 = bottom_im2row.row<signed char>(i);
-
-            signed char* tmpptr = bottom_tm.channel(i/4 + i%4);
-
-            int q=0;
-            for (; q+1<inch*kernel_size; q=q+2)
-            {
-                tmpptr[0] = img0[0];
-                tmpptr[1] = img0[1];
-
-                tmpptr += 2;
-                img0 += 2;
-            }
-
-            for (; q<inch*kernel_size; q++)
-            {
-                tmpptr[0] = img0[0];
-
-                tmpptr += 1;
-                img0 += 1;
-            }
-        }       
-    }
-
-    // kernel memory packed 4 x 4
-    Mat kernel_tm(4*kernel_size, inch, outch/4 + outch%4, (size_t)1u, opt.workspace_allocator);
-    {
-        int nn_outch = 0;
-        int remain_outch_start = 0;
-
-        nn_outch = outch >> 2;
-        remain_outch_start = nn_outch << 2;
-        
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int pp=0; pp<nn_outch; pp++)
-        {
-            int p = pp * 4;
-
-            const signed char* k0 = kernel + (p+0)*inch*kernel_size;
-            const signed char* k1 = kernel + (p+1)*inch*kernel_size;
-            const signed char* k2 = kernel + (p+2)*inch*kernel_size;
-            const signed char* k3 = kernel + (p+3)*inch*kernel_size;
-
-            signed char* ktmp = kernel_tm.channel(p/4);
-
-            int q=0;
-            for (; q+1<inch*kernel_size; q+=2)
-            {
-                ktmp[0] = k0[0];
-                ktmp[1] = k0[1];
-                ktmp[2] = k1[0];
-                ktmp[3] = k1[1];
-                ktmp[4] = k2[0];
-                ktmp[5] = k2[1];
-                ktmp[6] = k3[0];
-                ktmp[7] = k3[1];
-
-                ktmp += 8;
-
-                k0 += 2;
-                k1 += 2;
-                k2 += 2;
-                k3 += 2;
-            }
-
-            for (; q<inch*kernel_size; q++)
-            { 
-                ktmp[0] = k0[0];
-                ktmp[1] = k1[0];
-                ktmp[2] = k2[0];
-                ktmp[3] = k3[0];
-                ktmp += 4;
-
-                k0 += 1;
-                k1 += 1;
-                k2 += 1;
-                k3 += 1;
-            }           
+            outptr[x] = (float)sum[x] * scale_dequant0 + bias0;
         }
+    }
 
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int p=remain_outch_start; p<outch; p++)
-        {
-            const signed char* k0 = kernel + (p+0)*inch*kernel_size;
-
-            signed char* ktmp = kernel_tm.channel(p/4 + p%4);
-
-            int q=0;
-            for (; q+1<inch*kernel_size; q=q+2)
-            {
-                ktmp[0] = k0[0];
-                ktmp[1] = k0[1];
-                ktmp += 2;
-                k0 += 2;
-            }
+    Mat& top_blob;
+    const float* bias;
+    const std::vector<float>& scale_dequant;
+};
 
-            for (; q<inch*kernel_size; q++)
-            {
-                ktmp[0] = k0[0];
-                ktmp++;
-                k0++;
-            }
-        }
-    }    
+struct conv_int8_store_requant
+{
+    conv_int8_store_requant(Mat& _top_blob, const float* _bias, const std::vector<float>& _scale_requant)
+        : top_blob(_top_blob), bias(_bias), scale_requant(_scale_requant) {}
 
-    // 4x4
-    // sgemm(int M, int N, int K, float* A, float* B, float* C)
+    void operator()(int p, int j, int n, const int* sum)
     {
-        // int M = outch;  // outch
-        // int N = outw * outh; // outsize or out stride
-        // int L = kernel_w * kernel_h * inch; // ksize * inch
-
-        int nn_outch = 0;
-        int remain_outch_start = 0;
-
-        nn_outch = outch >> 2;
-        remain_outch_start = nn_outch << 2;
-        
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int pp=0; pp<nn_outch; pp++)
-        {
-            int i = pp * 4;
-
-            const float bias0 = bias ? bias[i] : 0.f;
-            const float bias1 = bias ? bias[i+1] : 0.f;
-            const float bias2 = bias ? bias[i+2] : 0.f;
-            const float bias3 = bias ? bias[i+3] : 0.f;
-
-            const float scale_dequant0 = scale_dequant[i];
-            const float scale_dequant1 = scale_dequant[i+1];
-            const float scale_dequant2 = scale_dequant[i+2];
-            const float scale_dequant3 = scale_dequant[i+3];
-
-            float* output0 = top_blob.channel(i);
-            float* output1 = top_blob.channel(i+1);
-            float* output2 = top_blob.channel(i+2);
-            float* output3 = top_blob.channel(i+3);
-
-            int j=0;
-            for (; j+3<N; j=j+4)
-            {
-                signed char* vb = bottom_tm.channel(j/4);
-                signed char* va = kernel_tm.channel(i/4);
-                
-                int sum0[4] = {0};
-                int sum1[4] = {0};
-                int sum2[4] = {0};
-                int sum3[4] = {0};
-               
-                int k=0;
-
-                for (; k+1<K; k=k+2)
-                {
-                    for (int n=0; n<4; n++)
-                    {
-                        sum0[n] += (int)va[0] * vb[2*n];   // k0
-                        sum0[n] += (int)va[1] * vb[2*n+1];
-
-                        sum1[n] += (int)va[2] * vb[2*n];   // k1
-                        sum1[n] += (int)va[3] * vb[2*n+1];
-
-                        sum2[n] += (int)va[4] * vb[2*n];   // k2
-                        sum2[n] += (int)va[5] * vb[2*n+1];
-
-                        sum3[n] += (int)va[6] * vb[2*n];   // k3
-                        sum3[n] += (int)va[7] * vb[2*n+1];
-                    }
-
-                    va += 8;
-                    vb += 8;
-                }
-
-                for (; k<K; k++)
-                {
-                    for (int n=0; n<4; n++)
-                    {
-                        sum0[n] += (int)va[0] * vb[n];
-                        sum1[n] += (int)va[1] * vb[n];
-                        sum2[n] += (int)va[2] * vb[n];
-                        sum3[n] += (int)va[3] * vb[n];
-                    }
-                    
-                    va += 4;
-                    vb += 4;
-                }
-
-                for (int n=0; n<4; n++)
-                {
-                    output0[n] = (float)sum0[n] * scale_dequant0 + bias0;
-                    output1[n] = (float)sum1[n] * scale_dequant1 + bias1;
-                    output2[n] = (float)sum2[n] * scale_dequant2 + bias2;
-                    output3[n] = (float)sum3[n] * scale_dequant3 + bias3;
-                }
-                output0 += 4;
-                output1 += 4;
-                output2 += 4;
-                output3 += 4;
-            }
-
-            for (; j<N; j++)
-            {                
-                int sum0 = 0;
-                int sum1 = 0;
-                int sum2 = 0;
-                int sum3 = 0;
-
-                signed char* vb = bottom_tm.channel(j/4 + j%4);
-                signed char* va = kernel_tm.channel(i/4);
-
-                int k=0;
-
-                for (; k+1<K; k=k+2)
-                {
-                    sum0 += (int)va[0] * vb[0];
-                    sum0 += (int)va[1] * vb[1];
-
-                    sum1 += (int)va[2] * vb[0];
-                    sum1 += (int)va[3] * vb[1];
-
-                    sum2 += (int)va[4] * vb[0];
-                    sum2 += (int)va[5] * vb[1];
-
-                    sum3 += (int)va[6] * vb[0];
-                    sum3 += (int)va[7] * vb[1];
-
-                    va += 8;
-                    vb += 2;
-                }
-
-                for (; k<K; k++)
-                {
-                    sum0 += (int)va[0] * vb[0];
-                    sum1 += (int)va[1] * vb[0];
-                    sum2 += (int)va[2] * vb[0];
-                    sum3 += (int)va[3] * vb[0];
-
-                    va += 4;
-                    vb += 1;
-                }
-                
-                output0[0] = (float)sum0 * scale_dequant0 + bias0;
-                output1[0] = (float)sum1 * scale_dequant1 + bias1;
-                output2[0] = (float)sum2 * scale_dequant2 + bias2;
-                output3[0] = (float)sum3 * scale_dequant3 + bias3;
-
-                output0++;
-                output1++;
-                output2++;
-                output3++;
-            }
-        }
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int i=remain_outch_start; i<outch; i++)
-        {
-            float* output = top_blob.channel(i);
-
-            const float bias0 = bias ? bias[i] : 0.f;
-            const float scale_dequant0 = scale_dequant[i];            
-
-            int j=0;
-            for (; j+3<N; j=j+4)
-            {
-                signed char* vb = bottom_tm.channel(j/4);
-                signed char* va = kernel_tm.channel(i/4 + i%4);
-                int sum[4] = {0};
-
-                int k=0;
-                for (; k+1<K; k=k+2)
-                {
-                    for (int n=0; n<4; n++)
-                    {
-                        sum[n] += (int)va[0] * vb[2*n];
-                        sum[n] += (int)va[1] * vb[2*n+1];
-                    }
-                    va += 2;
-                    vb += 8;
-                }
-
-                for (; k<K; k++)
-                {
-                    for (int n=0; n<4; n++)
-                    {
-                        sum[n] += (int)va[0] * vb[n];
-                    }
-                    va += 1;
-                    vb += 4;
-                }
-
-                for (int n=0; n<4; n++)
-                {
-                    output[n] = (float)sum[n] * scale_dequant0 + bias0;
-                }
-                output += 4;
-            }
-
-            for (; j<N; j++)
-            {
-                int sum = 0;
-
-                signed char* vb = bottom_tm.channel(j/4 + j%4);
-                signed char* va = kernel_tm.channel(i/4 + i%4);
-
-                for (int k=0; k<K; k++)
-                {
-                    sum += (int)va[0] * vb[0];
-
-                    va += 1;
-                    vb += 1;
-                }
-                output[0] = (float)sum * scale_dequant0 + bias0;
-
-                output++;
-            }
+        signed char* outptr = (signed char*)top_blob.channel(p) + j;
+        const float bias0 = bias ? bias[p] : 0.f;
+        const float scale_requant_in0 = scale_requant[2*p];
+        const float scale_requant_out0 = scale_requant[2*p+1];
+        int x = 0;
+#if __SSE2__
+        __m128 _scale_in = _mm_set1_ps(scale_requant_in0);
+        __m128 _scale_out = _mm_set1_ps(scale_requant_out0);
+        __m128 _bias = _mm_set1_ps(bias0);
+        for (; x+15<n; x+=16)
+        {
+            __m128 _v0 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(sum + x))), _scale_in), _bias), _scale_out);
+            __m128 _v1 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(sum + x + 4))), _scale_in), _bias), _scale_out);
+            __m128 _v2 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(sum + x + 8))), _scale_in), _bias), _scale_out);
+            __m128 _v3 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(sum + x + 12))), _scale_in), _bias), _scale_out);
+            _mm_storeu_si128((__m128i*)(outptr + x), float2int8_sse(_v0, _v1, _v2, _v3));
+        }
+#endif // __SSE2__
+        for (; x<n; x++)
+        {
+            outptr[x] = float2int8(((float)sum[x] * scale_requant_in0 + bias0) * scale_requant_out0);
         }
     }
 
-    // // sgemm(int M, int N, int K, float* A, float* B, float* C)
-    // {
-    //     for (int i=0; i<M; i++)
-    //     {
-    //         int* output = top_blob.channel(i);
-
-    //         for (int j=0; j<N; j++)
-    //         {
-    //             int sum = 0;
-
-    //             signed char* vb = (signed char*)bottom_im2row + K * j;
-    //             const signed char* va = kernel + K * i;
-
-    //             for (int k=0; k<K; k++)
-    //             {
-    //                 sum += (int)va[0] * vb[0];
-
-    //                 va += 1;
-    //                 vb += 1;
-    //             }
-    //             output[0] = sum;
+    Mat& top_blob;
+    const float* bias;
+    const std::vector<float>& scale_requant;
+};
 
-    //             output++;
-    //         }
-    //     }
-    // }
-}
-
-static void conv_im2col_sgemm_int8_requant_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, \
-            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const Mat &_bias, std::vector<float> scale_requant, const Option& opt)
+// M = outch, N = outw * outh, K = kernel_w * kernel_h * inch
+// 8 x 32 blocks, the store op writes each output channel row of a block
+template<typename Op>
+static void conv_im2col_sgemm_int8_run(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, \
+            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, Op& op, const Option& opt)
 {
-    int w = bottom_blob.w;
     int inch = bottom_blob.c;
 
     int outw = top_blob.w;
     int outh = top_blob.h;
     int outch = top_blob.c;
 
-    const signed char *kernel = _kernel;
-    const float* bias = _bias;
-
-    // im2row
-    Mat bottom_im2row(kernel_h*kernel_w*inch, outw*outh, 1UL, opt.workspace_allocator);
-    {
-        signed char* ret = (signed char*)bottom_im2row;
-        int retID = 0;
-    
-        for (int i=0; i<outh; i++)
-        {
-            for (int j=0; j<outw; j++)
-            {
-                for (int p=0; p<inch; p++)
-                {
-                    const signed char* input = bottom_blob.channel(p);
-                    for (int u=0; u<kernel_h; u++)
-                    {
-                        for (int v=0; v<kernel_w; v++)
-                        {    
-                            int row = u + i * stride_h;
-                            int col = v + j * stride_w;
-                            int index = row * w + col;
-                            ret[retID] = input[index];
-                            retID++;
-                        }
-                    }                
-                }
-            }
-        }
-    }    
+    const int N = outw * outh;
+    const int K = kernel_w * kernel_h * inch;
+    const int Kq = (K + 3) / 4;
 
-    int kernel_size = kernel_w * kernel_h;
-    int out_size = outw * outh;
+    Mat bottom_tm;
+    conv_im2col_pack_int8_sse(bottom_blob, bottom_tm, kernel_w, kernel_h, stride_w, stride_h, outw, outh, opt);
 
-    // int M = outch;  // outch
-    int N = outw * outh; // outsize or out stride
-    int K = kernel_w * kernel_h * inch; // ksize * inch
+    const int nn = bottom_tm.c;
 
-    // bottom_im2row memory packed 4 x 4
-    Mat bottom_tm(4*kernel_size, inch, out_size/4 + out_size%4, (size_t)1u, opt.workspace_allocator);
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int g=0; g<kernel_tm.c; g++)
     {
-        int nn_size = out_size >> 2;
-        int remain_size_start = nn_size << 2;
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int ii=0; ii<nn_size; ii++)
-        {
-            int i = ii * 4;
+        const signed char* kptr = kernel_tm.channel(g);
 
-            const signed char* img0 = bottom_im2row.row<signed char>(i);
-            const signed char* img1 = bottom_im2row.row<signed char>(i+1);
-            const signed char* img2 = bottom_im2row.row<signed char>(i+2);
-            const signed char* img3 = bottom_im2row.row<signed char>(i+3);
-
-            signed char* tmpptr = bottom_tm.channel(i/4);
-
-            int q = 0;
-            for (; q+1<inch*kernel_size; q=q+2)
-            {
-                tmpptr[0] = img0[0];
-                tmpptr[1] = img0[1];
-                tmpptr[2] = img1[0];
-                tmpptr[3] = img1[1];
-                tmpptr[4] = img2[0];
-                tmpptr[5] = img2[1];
-                tmpptr[6] = img3[0];
-                tmpptr[7] = img3[1];
+        const int rows = std::min(outch - g * 8, 8);
 
-                tmpptr += 8;
-                img0 += 2;
-                img1 += 2;
-                img2 += 2;
-                img3 += 2;
-            }
-
-            for (; q<inch*kernel_size; q++)
-            {
-                tmpptr[0] = img0[0];
-                tmpptr[1] = img1[0];
-                tmpptr[2] = img2[0];
-                tmpptr[3] = img3[0];
-
-                tmpptr += 4;
-                img0 += 1;
-                img1 += 1;
-                img2 += 1;
-                img3 += 1;                
-            }
-        }
+        int sum[8 * 32];
 
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int i=remain_size_start; i<out_size; i++)
+        int jj = 0;
+        for (; jj+1<nn; jj+=2)
         {
-            const signed char* img0 = bottom_im2row.row<signed char>(i);
+            int8_gemm_8x32(kptr, bottom_tm.channel(jj), bottom_tm.channel(jj+1), Kq, sum);
 
-            signed char* tmpptr = bottom_tm.channel(i/4 + i%4);
-
-            int q=0;
-            for (; q+1<inch*kernel_size; q=q+2)
-            {
-                tmpptr[0] = img0[0];
-                tmpptr[1] = img0[1];
-
-                tmpptr += 2;
-                img0 += 2;
-            }
-
-            for (; q<inch*kernel_size; q++)
+            const int n = std::min(N - jj * 16, 32);
+            for (int r=0; r<rows; r++)
             {
-                tmpptr[0] = img0[0];
-
-                tmpptr += 1;
-                img0 += 1;
-            }
-        }       
-    }
-
-    // kernel memory packed 4 x 4
-    Mat kernel_tm(4*kernel_size, inch, outch/4 + outch%4, (size_t)1u, opt.workspace_allocator);
-    {
-        int nn_outch = 0;
-        int remain_outch_start = 0;
-
-        nn_outch = outch >> 2;
-        remain_outch_start = nn_outch << 2;
-        
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int pp=0; pp<nn_outch; pp++)
-        {
-            int p = pp * 4;
-
-            const signed char* k0 = kernel + (p+0)*inch*kernel_size;
-            const signed char* k1 = kernel + (p+1)*inch*kernel_size;
-            const signed char* k2 = kernel + (p+2)*inch*kernel_size;
-            const signed char* k3 = kernel + (p+3)*inch*kernel_size;
-
-            signed char* ktmp = kernel_tm.channel(p/4);
-
-            int q=0;
-            for (; q+1<inch*kernel_size; q+=2)
-            {
-                ktmp[0] = k0[0];
-                ktmp[1] = k0[1];
-                ktmp[2] = k1[0];
-                ktmp[3] = k1[1];
-                ktmp[4] = k2[0];
-                ktmp[5] = k2[1];
-                ktmp[6] = k3[0];
-                ktmp[7] = k3[1];
-
-                ktmp += 8;
-
-                k0 += 2;
-                k1 += 2;
-                k2 += 2;
-                k3 += 2;
-            }
-
-            for (; q<inch*kernel_size; q++)
-            { 
-                ktmp[0] = k0[0];
-                ktmp[1] = k1[0];
-                ktmp[2] = k2[0];
-                ktmp[3] = k3[0];
-                ktmp += 4;
-
-                k0 += 1;
-                k1 += 1;
-                k2 += 1;
-                k3 += 1;
-            }           
-        }
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int p=remain_outch_start; p<outch; p++)
-        {
-            const signed char* k0 = kernel + (p+0)*inch*kernel_size;
-
-            signed char* ktmp = kernel_tm.channel(p/4 + p%4);
-
-            int q=0;
-            for (; q+1<inch*kernel_size; q=q+2)
-            {
-                ktmp[0] = k0[0];
-                ktmp[1] = k0[1];
-                ktmp += 2;
-                k0 += 2;
-            }
-
-            for (; q<inch*kernel_size; q++)
-            {
-                ktmp[0] = k0[0];
-                ktmp++;
-                k0++;
-            }
-        }
-    }    
-
-    // 4x4
-    // sgemm(int M, int N, int K, float* A, float* B, float* C)
-    {
-        // int M = outch;  // outch
-        // int N = outw * outh; // outsize or out stride
-        // int L = kernel_w * kernel_h * inch; // ksize * inch
-
-        int nn_outch = 0;
-        int remain_outch_start = 0;
-
-        nn_outch = outch >> 2;
-        remain_outch_start = nn_outch << 2;
-        
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int pp=0; pp<nn_outch; pp++)
-        {
-            int i = pp * 4;
-
-            signed char* output0 = top_blob.channel(i);
-            signed char* output1 = top_blob.channel(i+1);
-            signed char* output2 = top_blob.channel(i+2);
-            signed char* output3 = top_blob.channel(i+3);
-
-            const float bias0 = bias ? bias[i] : 0.f;
-            const float bias1 = bias ? bias[i+1] : 0.f;
-            const float bias2 = bias ? bias[i+2] : 0.f;
-            const float bias3 = bias ? bias[i+3] : 0.f;
-
-            const float scale_requant_in0  = scale_requant[2*i];
-            const float scale_requant_out0 = scale_requant[2*i+1];
-            const float scale_requant_in1  = scale_requant[2*(i+1)];
-            const float scale_requant_out1 = scale_requant[2*(i+1)+1];
-            const float scale_requant_in2  = scale_requant[2*(i+2)];
-            const float scale_requant_out2 = scale_requant[2*(i+2)+1];
-            const float scale_requant_in3  = scale_requant[2*(i+3)];
-            const float scale_requant_out3 = scale_requant[2*(i+3)+1];
-
-            int j=0;
-            for (; j+3<N; j=j+4)
-            {
-                signed char* vb = bottom_tm.channel(j/4);
-                signed char* va = kernel_tm.channel(i/4);
-                
-                int sum0[4] = {0};
-                int sum1[4] = {0};
-                int sum2[4] = {0};
-                int sum3[4] = {0};
-               
-                int k=0;
-
-                for (; k+1<K; k=k+2)
-                {
-                    for (int n=0; n<4; n++)
-                    {
-                        sum0[n] += (int)va[0] * vb[2*n];   // k0
-                        sum0[n] += (int)va[1] * vb[2*n+1];
-
-                        sum1[n] += (int)va[2] * vb[2*n];   // k1
-                        sum1[n] += (int)va[3] * vb[2*n+1];
-
-                        sum2[n] += (int)va[4] * vb[2*n];   // k2
-                        sum2[n] += (int)va[5] * vb[2*n+1];
-
-                        sum3[n] += (int)va[6] * vb[2*n];   // k3
-                        sum3[n] += (int)va[7] * vb[2*n+1];
-                    }
-
-                    va += 8;
-                    vb += 8;
-                }
-
-                for (; k<K; k++)
-                {
-                    for (int n=0; n<4; n++)
-                    {
-                        sum0[n] += (int)va[0] * vb[n];
-                        sum1[n] += (int)va[1] * vb[n];
-                        sum2[n] += (int)va[2] * vb[n];
-                        sum3[n] += (int)va[3] * vb[n];
-                    }
-                    
-                    va += 4;
-                    vb += 4;
-                }
-
-                for (int n=0; n<4; n++)
-                {
-                    output0[n] = float2int8(((float)sum0[n] * scale_requant_in0 + bias0) * scale_requant_out0);
-                    output1[n] = float2int8(((float)sum1[n] * scale_requant_in1 + bias1) * scale_requant_out1);
-                    output2[n] = float2int8(((float)sum2[n] * scale_requant_in2 + bias2) * scale_requant_out2);
-                    output3[n] = float2int8(((float)sum3[n] * scale_requant_in3 + bias3) * scale_requant_out3);
-                }
-                output0 += 4;
-                output1 += 4;
-                output2 += 4;
-                output3 += 4;
-            }
-
-            for (; j<N; j++)
-            {                
-                int sum0 = 0;
-                int sum1 = 0;
-                int sum2 = 0;
-                int sum3 = 0;
-
-                signed char* vb = bottom_tm.channel(j/4 + j%4);
-                signed char* va = kernel_tm.channel(i/4);
-
-                int k=0;
-
-                for (; k+1<K; k=k+2)
-                {
-                    sum0 += (int)va[0] * vb[0];
-                    sum0 += (int)va[1] * vb[1];
-
-                    sum1 += (int)va[2] * vb[0];
-                    sum1 += (int)va[3] * vb[1];
-
-                    sum2 += (int)va[4] * vb[0];
-                    sum2 += (int)va[5] * vb[1];
-
-                    sum3 += (int)va[6] * vb[0];
-                    sum3 += (int)va[7] * vb[1];
-
-                    va += 8;
-                    vb += 2;
-                }
-
-                for (; k<K; k++)
-                {
-                    sum0 += (int)va[0] * vb[0];
-                    sum1 += (int)va[1] * vb[0];
-                    sum2 += (int)va[2] * vb[0];
-                    sum3 += (int)va[3] * vb[0];
-
-                    va += 4;
-                    vb += 1;
-                }
-                
-                output0[0] = float2int8(((float)sum0 * scale_requant_in0 + bias0) * scale_requant_out0);
-                output1[0] = float2int8(((float)sum1 * scale_requant_in1 + bias1) * scale_requant_out1);
-                output2[0] = float2int8(((float)sum2 * scale_requant_in2 + bias2) * scale_requant_out2);
-                output3[0] = float2int8(((float)sum3 * scale_requant_in3 + bias3) * scale_requant_out3);
-
-                output0++;
-                output1++;
-                output2++;
-                output3++;
+                op(g * 8 + r, jj * 16, n, sum + r * 32);
             }
         }
 
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int i=remain_outch_start; i<outch; i++)
+        for (; jj<nn; jj++)
         {
-            signed char* output = top_blob.channel(i);
-
-            const float bias0 = bias ? bias[i] : 0.f;
-
-            const float scale_requant_in0  = scale_requant[2*i];
-            const float scale_requant_out0 = scale_requant[2*i+1];            
-
-            int j=0;
-            for (; j+3<N; j=j+4)
-            {
-                signed char* vb = bottom_tm.channel(j/4);
-                signed char* va = kernel_tm.channel(i/4 + i%4);
-                int sum[4] = {0};
-
-                int k=0;
-                for (; k+1<K; k=k+2)
-                {
-                    for (int n=0; n<4; n++)
-                    {
-                        sum[n] += (int)va[0] * vb[2*n];
-                        sum[n] += (int)va[1] * vb[2*n+1];
-                    }
-                    va += 2;
-                    vb += 8;
-                }
-
-                for (; k<K; k++)
-                {
-                    for (int n=0; n<4; n++)
-                    {
-                        sum[n] += (int)va[0] * vb[n];
-                    }
-                    va += 1;
-                    vb += 4;
-                }
+            int8_gemm_8x16(kptr, bottom_tm.channel(jj), Kq, sum);
 
-                for (int n=0; n<4; n++)
-                {
-                    output[n] = float2int8(((float)sum[n] * scale_requant_in0 + bias0) * scale_requant_out0);
-                }
-                output += 4;
-            }
-
-            for (; j<N; j++)
+            const int n = std::min(N - jj * 16, 16);
+            for (int r=0; r<rows; r++)
             {
-                int sum = 0;
-
-                signed char* vb = bottom_tm.channel(j/4 + j%4);
-                signed char* va = kernel_tm.channel(i/4 + i%4);
-
-                for (int k=0; k<K; k++)
-                {
-                    sum += (int)va[0] * vb[0];
-
-                    va += 1;
-                    vb += 1;
-                }
-                output[0] = float2int8(((float)sum * scale_requant_in0 + bias0) * scale_requant_out0);
-
-                output++;
+                op(g * 8 + r, jj * 16, n, sum + r * 32);
             }
         }
     }
+}
 
-    // // sgemm(int M, int N, int K, float* A, float* B, float* C)
-    // {
-    //     for (int i=0; i<M; i++)
-    //     {
-    //         int* output = top_blob.channel(i);
-
-    //         for (int j=0; j<N; j++)
-    //         {
-    //             int sum = 0;
+static void conv_im2col_sgemm_int8_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, \
+            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const Option& opt)
+{
+    int inch = bottom_blob.c;
+    int outch = top_blob.c;
 
-    //             signed char* vb = (signed char*)bottom_im2row + K * j;
-    //             const signed char* va = kernel + K * i;
+    Mat kernel_tm;
+    conv_im2col_sgemm_transform_kernel_int8_sse(_kernel, kernel_tm, inch, outch, kernel_w * kernel_h);
 
-    //             for (int k=0; k<K; k++)
-    //             {
-    //                 sum += (int)va[0] * vb[0];
+    conv_int8_store op(top_blob);
+    conv_im2col_sgemm_int8_run(bottom_blob, top_blob, kernel_tm, kernel_w, kernel_h, stride_w, stride_h, op, opt);
+}
 
-    //                 va += 1;
-    //                 vb += 1;
-    //             }
-    //             output[0] = sum;
+static void conv_im2col_sgemm_int8_dequant_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &kernel_tm, \
+            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const Mat &_bias, std::vector<float> scale_dequant, const Option& opt)
+{
+    conv_int8_store_dequant op(top_blob, _bias, scale_dequant);
+    conv_im2col_sgemm_int8_run(bottom_blob, top_blob, kernel_tm, kernel_w, kernel_h, stride_w, stride_h, op, opt);
+}
 
-    //             output++;
-    //         }
-    //     }
-    // }
+static void conv_im2col_sgemm_int8_requant_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &kernel_tm, \
+            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const Mat &_bias, std::vector<float> scale_requant, const Option& opt)
+{
+    conv_int8_store_requant op(top_blob, _bias, scale_requant);
+    conv_im2col_sgemm_int8_run(bottom_blob, top_blob, kernel_tm, kernel_w, kernel_h, stride_w, stride_h, op, opt);
 }
@@ -0,0 +1,546 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// winograd F(4,3) and F(6,3) for 3x3 stride 1 convolution
+//
+// the transforms work on V::lanes tiles at once, one tile per lane
+// and the tile products of every transformed position are batched into one gemm
+//   bottom_blob_tm  channel = position, row = tile block,   [inch][lanes]
+//   kernel_tm       channel = position, row = outch block,  [inch][8]
+//   top_blob_tm     channel = outch,    row = position,     [tiles]
+
+// multiplications of the tile products for an output tile size, the transforms are not counted
+static int conv3x3s1_winograd_cost(int outw, int outh, int tile)
+{
+    const int tiles = ((outw + tile - 1) / tile) * ((outh + tile - 1) / tile);
+    return tiles * (tile + 2) * (tile + 2);
+}
+
+// output tile with the fewest multiplications for this output size, 0 when none is available
+// the smaller tile wins ties as it is numerically more accurate
+static int conv3x3s1_winograd_tile(int outw, int outh, bool has_winograd43, bool has_winograd63)
+{
+    if (has_winograd43 && has_winograd63)
+        return conv3x3s1_winograd_cost(outw, outh, 6) < conv3x3s1_winograd_cost(outw, outh, 4) ? 6 : 4;
+
+    if (has_winograd43)
+        return 4;
+
+    if (has_winograd63)
+        return 6;
+
+    return 0;
+}
+
+static void conv3x3s1_winograd_transform_kernel_sse(const Mat& kernel, Mat& kernel_tm, int inch, int outch, int tile)
+{
+    // G
+    const float ktm43[6][3] = {
+        {  1.0f/4,     0.0f,    0.0f},
+        { -1.0f/6,  -1.0f/6, -1.0f/6},
+        { -1.0f/6,   1.0f/6, -1.0f/6},
+        { 1.0f/24,  1.0f/12,  1.0f/6},
+        { 1.0f/24, -1.0f/12,  1.0f/6},
+        {    0.0f,     0.0f,    1.0f}
+    };
+
+    const float ktm63[8][3] = {
+        {    1.0f,      0.0f,     0.0f},
+        { -2.0f/9,   -2.0f/9,  -2.0f/9},
+        { -2.0f/9,    2.0f/9,  -2.0f/9},
+        { 1.0f/90,   1.0f/45,  2.0f/45},
+        { 1.0f/90,  -1.0f/45,  2.0f/45},
+        { 1.0f/45,   1.0f/90, 1.0f/180},
+        { 1.0f/45,  -1.0f/90, 1.0f/180},
+        {    0.0f,      0.0f,     1.0f}
+    };
+
+    const int n = tile + 2;
+    const float* ktm = tile == 6 ? &ktm63[0][0] : &ktm43[0][0];
+
+    const int nn_outch = (outch + 7) / 8;
+
+    kernel_tm.create(inch * 8, nn_outch, n * n);
+    kernel_tm.fill(0.f);
+
+    #pragma omp parallel for
+    for (int p=0; p<outch; p++)
+    {
+        float* ktmp = (float*)kernel_tm + kernel_tm.w * (p / 8) + p % 8;
+
+        for (int q=0; q<inch; q++)
+        {
+            const float* k0 = (const float*)kernel + (p * inch + q) * 9;
+
+            // h
+            float tmp[8][3];
+            for (int i=0; i<n; i++)
+            {
+                for (int j=0; j<3; j++)
+                {
+                    tmp[i][j] = k0[j] * ktm[i*3] + k0[3 + j] * ktm[i*3 + 1] + k0[6 + j] * ktm[i*3 + 2];
+                }
+            }
+
+            // U
+            for (int i=0; i<n; i++)
+            {
+                for (int j=0; j<n; j++)
+                {
+                    float u = tmp[i][0] * ktm[j*3] + tmp[i][1] * ktm[j*3 + 1] + tmp[i][2] * ktm[j*3 + 2];
+                    ktmp[kernel_tm.cstep * (i * n + j) + q * 8] = u;
+                }
+            }
+        }
+    }
+}
+
+#if __SSE2__
+// BT of F(4,3) along six values, d and o are strided by ds and os
+template<typename V>
+static inline void winograd43_transform_input(const typename V::vec* d, int ds, typename V::vec* o, int os)
+{
+    typedef typename V::vec vec;
+
+    const vec _4 = V::set1(4.f);
+    const vec _2 = V::set1(2.f);
+    const vec _n4 = V::set1(-4.f);
+    const vec _n5 = V::set1(-5.f);
+
+    vec d0 = d[0];
+    vec d1 = d[ds];
+    vec d2 = d[ds * 2];
+    vec d3 = d[ds * 3];
+    vec d4 = d[ds * 4];
+    vec d5 = d[ds * 5];
+
+    vec t12a = V::fmadd(_n4, d2, d4);
+    vec t12b = V::fmadd(_n4, d1, d3);
+    vec t34a = V::sub(d4, d2);
+    vec t34b = V::mul(_2, V::sub(d3, d1));
+
+    o[0] = V::fmadd(_n5, d2, V::fmadd(_4, d0, d4));
+    o[os] = V::add(t12a, t12b);
+    o[os * 2] = V::sub(t12a, t12b);
+    o[os * 3] = V::add(t34a, t34b);
+    o[os * 4] = V::sub(t34a, t34b);
+    o[os * 5] = V::fmadd(_n5, d3, V::fmadd(_4, d1, d5));
+}
+
+// AT of F(4,3)
+template<typename V>
+static inline void winograd43_transform_output(const typename V::vec* s, int ss, typename V::vec* o, int os)
+{
+    typedef typename V::vec vec;
+
+    const vec _2 = V::set1(2.f);
+    const vec _4 = V::set1(4.f);
+    const vec _8 = V::set1(8.f);
+
+    vec a = V::add(s[ss], s[ss * 2]);
+    vec b = V::sub(s[ss], s[ss * 2]);
+    vec c = V::add(s[ss * 3], s[ss * 4]);
+    vec e = V::sub(s[ss * 3], s[ss * 4]);
+
+    o[0] = V::add(V::add(s[0], a), c);
+    o[os] = V::fmadd(_2, e, b);
+    o[os * 2] = V::fmadd(_4, c, a);
+    o[os * 3] = V::add(V::fmadd(_8, e, b), s[ss * 5]);
+}
+
+// BT of F(6,3)
+template<typename V>
+static inline void winograd63_transform_input(const typename V::vec* d, int ds, typename V::vec* o, int os)
+{
+    typedef typename V::vec vec;
+
+    const vec _2 = V::set1(2.f);
+    const vec _4 = V::set1(4.f);
+    const vec _0_25 = V::set1(0.25f);
+    const vec _0_5 = V::set1(0.5f);
+    const vec _n1_25 = V::set1(-1.25f);
+    const vec _n2_5 = V::set1(-2.5f);
+    const vec _n4_25 = V::set1(-4.25f);
+    const vec _5_25 = V::set1(5.25f);
+
+    vec d0 = d[0];
+    vec d1 = d[ds];
+    vec d2 = d[ds * 2];
+    vec d3 = d[ds * 3];
+    vec d4 = d[ds * 4];
+    vec d5 = d[ds * 5];
+    vec d6 = d[ds * 6];
+    vec d7 = d[ds * 7];
+
+    vec t12a = V::fmadd(_n4_25, d4, V::add(d2, d6));
+    vec t12b = V::fmadd(_n4_25, d3, V::add(d1, d5));
+    vec t34a = V::fmadd(_n1_25, d4, V::fmadd(_0_25, d2, d6));
+    vec t34b = V::fmadd(_2, d5, V::fmadd(_n2_5, d3, V::mul(_0_5, d1)));
+    vec t56a = V::fmadd(_4, V::fmadd(_n1_25, d4, d2), d6);
+    vec t56b = V::fmadd(_0_5, d5, V::fmadd(_n2_5, d3, V::mul(_2, d1)));
+
+    o[0] = V::fmadd(_5_25, V::sub(d4, d2), V::sub(d0, d6));
+    o[os] = V::add(t12a, t12b);
+    o[os * 2] = V::sub(t12a, t12b);
+    o[os * 3] = V::add(t34a, t34b);
+    o[os * 4] = V::sub(t34a, t34b);
+    o[os * 5] = V::add(t56a, t56b);
+    o[os * 6] = V::sub(t56a, t56b);
+    o[os * 7] = V::fmadd(_5_25, V::sub(d3, d5), V::sub(d7, d1));
+}
+
+// AT of F(6,3)
+template<typename V>
+static inline void winograd63_transform_output(const typename V::vec* s, int ss, typename V::vec* o, int os)
+{
+    typedef typename V::vec vec;
+
+    const vec _2 = V::set1(2.f);
+    const vec _4 = V::set1(4.f);
+    const vec _8 = V::set1(8.f);
+    const vec _16 = V::set1(16.f);
+    const vec _32 = V::set1(32.f);
+
+    vec a1 = V::add(s[ss], s[ss * 2]);
+    vec b1 = V::sub(s[ss], s[ss * 2]);
+    vec a2 = V::add(s[ss * 3], s[ss * 4]);
+    vec b2 = V::sub(s[ss * 3], s[ss * 4]);
+    vec a3 = V::add(s[ss * 5], s[ss * 6]);
+    vec b3 = V::sub(s[ss * 5], s[ss * 6]);
+
+    o[0] = V::fmadd(_32, a3, V::add(V::add(s[0], a1), a2));
+    o[os] = V::fmadd(_16, b3, V::fmadd(_2, b2, b1));
+    o[os * 2] = V::fmadd(_8, a3, V::fmadd(_4, a2, a1));
+    o[os * 3] = V::fmadd(_4, b3, V::fmadd(_8, b2, b1));
+    o[os * 4] = V::fmadd(_2, a3, V::fmadd(_16, a2, a1));
+    o[os * 5] = V::add(V::fmadd(_32, b2, V::add(b1, b3)), s[ss * 7]);
+}
+
+// tile products of one transformed position, eight output channels against V::lanes tiles
+// two tile blocks share every broadcast kernel value while both are left
+template<typename V>
+static void conv3x3s1_winograd_dot(const float* bb, const float* kk, float* const* outptr, int nn_outch_valid, int nn_blocks, int inch)
+{
+    typedef typename V::vec vec;
+    const int lanes = V::lanes;
+
+    int b = 0;
+    for (; b+1<nn_blocks; b+=2)
+    {
+        const float* r0 = bb + inch * lanes * b;
+        const float* r1 = r0 + inch * lanes;
+
+        for (int h=0; h<2; h++)
+        {
+            const float* k0 = kk + h * 4;
+
+            vec _sum00 = V::zero();
+            vec _sum01 = V::zero();
+            vec _sum02 = V::zero();
+            vec _sum03 = V::zero();
+            vec _sum10 = V::zero();
+            vec _sum11 = V::zero();
+            vec _sum12 = V::zero();
+            vec _sum13 = V::zero();
+
+            for (int q=0; q<inch; q++)
+            {
+                vec _r0 = V::load(r0 + q * lanes);
+                vec _r1 = V::load(r1 + q * lanes);
+
+                vec _k0 = V::set1(k0[0]);
+                vec _k1 = V::set1(k0[1]);
+                vec _k2 = V::set1(k0[2]);
+                vec _k3 = V::set1(k0[3]);
+
+                _sum00 = V::fmadd(_r0, _k0, _sum00);
+                _sum01 = V::fmadd(_r0, _k1, _sum01);
+                _sum02 = V::fmadd(_r0, _k2, _sum02);
+                _sum03 = V::fmadd(_r0, _k3, _sum03);
+                _sum10 = V::fmadd(_r1, _k0, _sum10);
+                _sum11 = V::fmadd(_r1, _k1, _sum11);
+                _sum12 = V::fmadd(_r1, _k2, _sum12);
+                _sum13 = V::fmadd(_r1, _k3, _sum13);
+
+                k0 += 8;
+            }
+
+            vec _sum0[4] = { _sum00, _sum01, _sum02, _sum03 };
+            vec _sum1[4] = { _sum10, _sum11, _sum12, _sum13 };
+            for (int k=0; k<4 && h*4+k<nn_outch_valid; k++)
+            {
+                V::store(outptr[h*4+k] + b * lanes, _sum0[k]);
+                V::store(outptr[h*4+k] + (b + 1) * lanes, _sum1[k]);
+            }
+        }
+    }
+
+    for (; b<nn_blocks; b++)
+    {
+        const float* r0 = bb + inch * lanes * b;
+        const float* k0 = kk;
+
+        vec _sum0 = V::zero();
+        vec _sum1 = V::zero();
+        vec _sum2 = V::zero();
+        vec _sum3 = V::zero();
+        vec _sum4 = V::zero();
+        vec _sum5 = V::zero();
+        vec _sum6 = V::zero();
+        vec _sum7 = V::zero();
+
+        for (int q=0; q<inch; q++)
+        {
+            vec _r0 = V::load(r0 + q * lanes);
+
+            _sum0 = V::fmadd(_r0, V::set1(k0[0]), _sum0);
+            _sum1 = V::fmadd(_r0, V::set1(k0[1]), _sum1);
+            _sum2 = V::fmadd(_r0, V::set1(k0[2]), _sum2);
+            _sum3 = V::fmadd(_r0, V::set1(k0[3]), _sum3);
+            _sum4 = V::fmadd(_r0, V::set1(k0[4]), _sum4);
+            _sum5 = V::fmadd(_r0, V::set1(k0[5]), _sum5);
+            _sum6 = V::fmadd(_r0, V::set1(k0[6]), _sum6);
+            _sum7 = V::fmadd(_r0, V::set1(k0[7]), _sum7);
+
+            k0 += 8;
+        }
+
+        vec _sum[8] = { _sum0, _sum1, _sum2, _sum3, _sum4, _sum5, _sum6, _sum7 };
+        for (int k=0; k<nn_outch_valid; k++)
+        {
+            V::store(outptr[k] + b * lanes, _sum[k]);
+        }
+    }
+}
+
+template<typename V>
+static int conv3x3s1_winograd_pack_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, int tile, const Option& opt)
+{
+    typedef typename V::vec vec;
+    const int lanes = V::lanes;
+
+    const int n = tile + 2;
+    const int nn = n * n;
+
+    const int inch = bottom_blob.c;
+    const int outch = top_blob.c;
+
+    const int tiles_w = (top_blob.w + tile - 1) / tile;
+    const int tiles_h = (top_blob.h + tile - 1) / tile;
+    const int tiles = tiles_w * tiles_h;
+    const int nn_blocks = (tiles + lanes - 1) / lanes;
+
+    // pad to tile * k + 2
+    const int outw = tiles_w * tile;
+    const int outh = tiles_h * tile;
+
+    Mat bottom_blob_bordered = bottom_blob;
+    if (bottom_blob.w != outw + 2 || bottom_blob.h != outh + 2)
+    {
+        Option opt_b = opt;
+        opt_b.blob_allocator = opt.workspace_allocator;
+        copy_make_border(bottom_blob, bottom_blob_bordered, 0, outh + 2 - bottom_blob.h, 0, outw + 2 - bottom_blob.w, BORDER_CONSTANT, 0.f, opt_b);
+        if (bottom_blob_bordered.empty())
+            return -100;
+    }
+
+    const int w = bottom_blob_bordered.w;
+
+    // BEGIN transform input
+    Mat bottom_blob_tm(inch * lanes, nn_blocks, nn, 4u, opt.workspace_allocator);
+    if (bottom_blob_tm.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<inch; q++)
+    {
+        const float* img = bottom_blob_bordered.channel(q);
+
+        float tmp[64 * 8];
+        vec d[64];
+        vec t[64];
+
+        for (int b=0; b<nn_blocks; b++)
+        {
+            // gather one tile per lane, tiles beyond the last stay zero
+            for (int l=0; l<lanes; l++)
+            {
+                const int ti = b * lanes + l;
+                if (ti >= tiles)
+                {
+                    for (int k=0; k<nn; k++)
+                        tmp[k * lanes + l] = 0.f;
+                    continue;
+                }
+
+                const float* r0 = img + (ti / tiles_w) * tile * w + (ti % tiles_w) * tile;
+                for (int y=0; y<n; y++)
+                {
+                    for (int x=0; x<n; x++)
+                    {
+                        tmp[(y * n + x) * lanes + l] = r0[x];
+                    }
+                    r0 += w;
+                }
+            }
+
+            for (int k=0; k<nn; k++)
+                d[k] = V::load(tmp + k * lanes);
+
+            // columns then rows
+            if (tile == 6)
+            {
+                for (int x=0; x<n; x++)
+                    winograd63_transform_input<V>(d + x, n, t + x, n);
+                for (int y=0; y<n; y++)
+                    winograd63_transform_input<V>(t + y * n, 1, d + y * n, 1);
+            }
+            else
+            {
+                for (int x=0; x<n; x++)
+                    winograd43_transform_input<V>(d + x, n, t + x, n);
+                for (int y=0; y<n; y++)
+                    winograd43_transform_input<V>(t + y * n, 1, d + y * n, 1);
+            }
+
+            for (int k=0; k<nn; k++)
+            {
+                float* outptr = bottom_blob_tm.channel(k).row(b);
+                V::store(outptr + q * lanes, d[k]);
+            }
+        }
+    }
+    bottom_blob_bordered = Mat();
+    // END transform input
+
+    // BEGIN dot
+    const int tiles_stride = nn_blocks * lanes;
+
+    Mat top_blob_tm(tiles_stride, nn, outch, 4u, opt.workspace_allocator);
+    if (top_blob_tm.empty())
+        return -100;
+
+    {
+        const int nn_outch = (outch + 7) / 8;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int rp=0; rp<nn * nn_outch; rp++)
+        {
+            const int r = rp / nn_outch;
+            const int pp = rp % nn_outch;
+
+            const float* bb = bottom_blob_tm.channel(r);
+            const float* kk = kernel_tm.channel(r).row(pp);
+
+            const int nn_outch_valid = std::min(8, outch - pp * 8);
+
+            float* outptr[8];
+            for (int k=0; k<nn_outch_valid; k++)
+            {
+                outptr[k] = top_blob_tm.channel(pp * 8 + k).row(r);
+            }
+
+            conv3x3s1_winograd_dot<V>(bb, kk, outptr, nn_outch_valid, nn_blocks, inch);
+        }
+    }
+    bottom_blob_tm = Mat();
+    // END dot
+
+    // BEGIN transform output
+    Mat top_blob_bordered = top_blob;
+    if (top_blob.w != outw || top_blob.h != outh)
+    {
+        top_blob_bordered.create(outw, outh, outch, 4u, opt.workspace_allocator);
+        if (top_blob_bordered.empty())
+            return -100;
+    }
+
+    const float* bias = _bias;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<outch; p++)
+    {
+        const Mat out_tm = top_blob_tm.channel(p);
+        float* outptr = top_blob_bordered.channel(p);
+
+        const vec _bias0 = V::set1(bias ? bias[p] : 0.f);
+
+        float tmp[36 * 8];
+        vec s[64];
+        vec t[64];
+
+        for (int b=0; b<nn_blocks; b++)
+        {
+            for (int k=0; k<nn; k++)
+                s[k] = V::load(out_tm.row(k) + b * lanes);
+
+            // columns then rows
+            if (tile == 6)
+            {
+                for (int x=0; x<n; x++)
+                    winograd63_transform_output<V>(s + x, n, t + x, n);
+                for (int y=0; y<tile; y++)
+                    winograd63_transform_output<V>(t + y * n, 1, s + y * tile, 1);
+            }
+            else
+            {
+                for (int x=0; x<n; x++)
+                    winograd43_transform_output<V>(s + x, n, t + x, n);
+                for (int y=0; y<tile; y++)
+                    winograd43_transform_output<V>(t + y * n, 1, s + y * tile, 1);
+            }
+
+            for (int k=0; k<tile * tile; k++)
+                V::store(tmp + k * lanes, V::add(s[k], _bias0));
+
+            // scatter one tile per lane
+            for (int l=0; l<lanes; l++)
+            {
+                const int ti = b * lanes + l;
+                if (ti >= tiles)
+                    break;
+
+                float* o0 = outptr + (ti / tiles_w) * tile * outw + (ti % tiles_w) * tile;
+                for (int y=0; y<tile; y++)
+                {
+                    for (int x=0; x<tile; x++)
+                    {
+                        o0[x] = tmp[(y * tile + x) * lanes + l];
+                    }
+                    o0 += outw;
+                }
+            }
+        }
+    }
+    // END transform output
+
+    // cut result pad
+    if (top_blob_bordered.data != top_blob.data)
+        copy_cut_border(top_blob_bordered, top_blob, 0, outh - top_blob.h, 0, outw - top_blob.w, opt);
+
+    return 0;
+}
+#endif // __SSE2__
+
+// top_blob is allocated, tile is 4 or 6
+static int conv3x3s1_winograd_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, int tile, const Option& opt)
+{
+#if __AVX__
+    return conv3x3s1_winograd_pack_sse<pack8_avx>(bottom_blob, top_blob, kernel_tm, _bias, tile, opt);
+#elif __SSE2__
+    return conv3x3s1_winograd_pack_sse<pack4_sse>(bottom_blob, top_blob, kernel_tm, _bias, tile, opt);
+#else
+    return -1;
+#endif
+}
@@ -14,6 +14,9 @@
 
 #include "convolution_x86.h"
 
+#include <string.h>
+#include <algorithm>
+
 #include "platform.h"
 #if __SSE2__
 #include <emmintrin.h>
@@ -24,25 +27,37 @@
 
 #include "layer_type.h"
 #include "benchmark.h"
+#include "cpu.h"
+#include "x86_usability.h"
 
 namespace ncnn {
 
+#include "x86_sgemm.h"
 #include "convolution_sgemm.h"
 #include "convolution_1x1.h"
 #include "convolution_3x3.h"
+#include "convolution_winograd.h"
 #include "convolution_5x5.h"
 #include "convolution_7x7.h"
+#include "x86_int8.h"
 #include "convolution_sgemm_int8.h"
 #include "convolution_1x1_int8.h"
 #include "convolution_3x3_int8.h"
 #include "convolution_5x5_int8.h"
 #include "convolution_7x7_int8.h"
+#if __SSE2__
+#include "convolution_pack.h"
+#endif // __SSE2__
 
 DEFINE_LAYER_CREATOR(Convolution_x86)
 
 Convolution_x86::Convolution_x86()
 {
     activation = 0;
+    use_packing = false;
+    support_batch = true;
+    in_elempack = 1;
+    out_elempack = 1;
 }
 
 int Convolution_x86::create_pipeline(const Option& opt)
@@ -85,6 +100,12 @@ int Convolution_x86::create_pipeline(const Option& opt)
     }
 
     use_winograd3x3 = false;
+    use_packing = false;
+    support_packing = false;
+
+    // product-quantized weight runs the lookup table forward of Convolution
+    if (!weight_codebook.empty())
+        return 0;
 
     if (opt.use_winograd_convolution && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
     {
@@ -94,7 +115,60 @@ int Convolution_x86::create_pipeline(const Option& opt)
             use_winograd3x3 = true;
     }           
 
-    if (use_winograd3x3)
+#if __AVX2__
+    // the int8 sgemm outruns the int8 winograd F(4,3) with avx2 and vnni dot products
+    if (use_int8_inference)
+        use_winograd3x3 = false;
+#endif // __AVX2__
+
+#if __SSE2__
+    bool packing_ok = opt.use_packing_layout && !use_int8_inference;
+#if __AVX__
+    // pack8 direct convolution only catches up with winograd F(2,3)
+    packing_ok = packing_ok && !(use_winograd3x3 && (opt.use_winograd43_convolution || opt.use_winograd63_convolution));
+    // the packed 1x1 and strided kernels are slower than the pack1 sgemm, keep pack1 for them
+    packing_ok = packing_ok && kernel_w * kernel_h > 1 && stride_w == 1 && stride_h == 1;
+#else
+    // pack4 direct convolution does not catch up with winograd on sse2
+    packing_ok = packing_ok && !use_winograd3x3;
+#endif
+#if BISONAI_KILL_THE_BITS
+    packing_ok = packing_ok && !use_channel_reduction;
+#endif // BISONAI_KILL_THE_BITS
+    if (packing_ok)
+    {
+        const int maxk = kernel_w * kernel_h;
+        const int num_input = weight_data_size / maxk / num_output;
+
+        in_elempack = x86_elempack(num_input);
+        out_elempack = x86_elempack(num_output);
+
+        // unpacked output keeps the pack1 kernels
+        use_packing = out_elempack > 1;
+    }
+
+    if (use_packing)
+    {
+        support_packing = true;
+        use_winograd3x3 = false;
+
+        if (!pipeline_weights_restored)
+        {
+            const int maxk = kernel_w * kernel_h;
+            const int num_input = weight_data_size / maxk / num_output;
+
+            conv_transform_kernel_pack_sse(weight_data, weight_data_pack, num_input, num_output, maxk, in_elempack, out_elempack);
+        }
+
+        // packed forward only reads the transformed kernel
+        if (opt.use_weight_data_release)
+            weight_data.release();
+
+        return 0;
+    }
+#endif // __SSE2__
+
+    if (use_winograd3x3 && !pipeline_weights_restored)
     {
         int num_input = weight_data_size / 9 / num_output;
 
@@ -102,11 +176,33 @@ int Convolution_x86::create_pipeline(const Option& opt)
             // conv3x3s1_winograd23_transform_kernel_int8_sse(weight_data, weight_3x3_winograd23_data, num_input, num_output);
             conv3x3s1_winograd43_transform_kernel_int8_sse(weight_data, weight_3x3_winograd23_data, num_input, num_output);
         else
-            conv3x3s1_winograd23_transform_kernel_sse(weight_data, weight_3x3_winograd23_data, num_input, num_output);
-//             conv3x3s1_winograd43_transform_kernel_sse(weight_data, weight_3x3_winograd43_data, num_input, num_output);
+        {
+            bool winograd43 = false;
+            bool winograd63 = false;
+#if __SSE2__
+            winograd43 = opt.use_winograd43_convolution;
+            // F(6,3) kernels are 64/36 the size of F(4,3) ones, only keep both for narrow layers
+            winograd63 = opt.use_winograd63_convolution && (!winograd43 || (num_input <= 128 && num_output <= 128));
+#endif // __SSE2__
+
+            if (winograd43)
+                conv3x3s1_winograd_transform_kernel_sse(weight_data, weight_3x3_winograd43_data, num_input, num_output, 4);
+            if (winograd63)
+                conv3x3s1_winograd_transform_kernel_sse(weight_data, weight_3x3_winograd63_data, num_input, num_output, 6);
+            if (!winograd43 && !winograd63)
+                conv3x3s1_winograd23_transform_kernel_sse(weight_data, weight_3x3_winograd23_data, num_input, num_output);
+        }
     }
 
-    if (use_int8_inference == false)
+    if (use_int8_inference && !use_winograd3x3 && !pipeline_weights_restored)
+    {
+        int kernel_size = kernel_w * kernel_h;
+        int num_input = weight_data_size / kernel_size / num_output;
+
+        conv_im2col_sgemm_transform_kernel_int8_sse(weight_data, weight_sgemm_int8_data, num_input, num_output, kernel_size);
+    }
+
+    if (use_int8_inference == false && !pipeline_weights_restored)
     {
         int kernel_size = kernel_w * kernel_h;
         int num_input = weight_data_size / kernel_size / num_output;
@@ -114,6 +210,16 @@ int Convolution_x86::create_pipeline(const Option& opt)
         conv_im2col_sgemm_transform_kernel_sse(weight_data, weight_sgemm_data, num_input, num_output, kernel_size);
     }       
 
+    if (opt.use_weight_data_release && use_int8_inference == false)
+    {
+        // float32 forward of these shapes only reads the transformed kernels
+        bool square = kernel_w == kernel_h && stride_w == stride_h && dilation_w == 1 && dilation_h == 1;
+        bool kernel_ok = kernel_w == 1 || kernel_w == 3 || kernel_w == 5 || kernel_w == 7;
+        bool stride_ok = stride_w == 1 || stride_w == 2;
+        if (square && kernel_ok && stride_ok)
+            weight_data.release();
+    }
+
     return 0;
 }
 
@@ -129,6 +235,19 @@ int Convolution_x86::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+int Convolution_x86::pipeline_weights(std::vector<Mat*>& weights)
+{
+    weights.clear();
+    weights.push_back(&weight_3x3_winograd23_data);
+    weights.push_back(&weight_3x3_winograd43_data);
+    weights.push_back(&weight_3x3_winograd63_data);
+    weights.push_back(&weight_sgemm_data);
+    weights.push_back(&weight_data_pack);
+    weights.push_back(&weight_sgemm_int8_data);
+
+    return 0;
+}
+
 int Convolution_x86::forwardDilation(const Mat& bottom_blob, Mat& top_blob, conv_func conv, const Option& opt) const
 {
     int w = bottom_blob.w;
@@ -261,13 +380,190 @@ int Convolution_x86::forwardDilation(const Mat& bottom_blob, Mat& top_blob, conv
     return 0;
 }
 
+int Convolution_x86::make_padding(const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt) const
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    bottom_blob_bordered = bottom_blob;
+
+    // the int8 bottom blob pads with the quantized pad value
+    const float border_value = bottom_blob.elemsize == 1 ? pad_value * bottom_blob_int8_scale + bottom_blob_int8_zero_point : pad_value;
+
+    Option opt_b = opt;
+    opt_b.blob_allocator = opt.workspace_allocator;
+
+    if (pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0)
+    {
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, border_value, opt_b);
+        if (bottom_blob_bordered.empty())
+            return -100;
+    }
+    else if (pad_left == -233 && pad_right == -233 && pad_top == -233 && pad_bottom == -233)
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            copy_make_border(bottom_blob, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, border_value, opt_b);
+            if (bottom_blob_bordered.empty())
+                return -100;
+        }
+    }
+    else if (pad_left == -234 && pad_right == -234 && pad_top == -234 && pad_bottom == -234)
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            copy_make_border(bottom_blob, bottom_blob_bordered, hpad - hpad / 2, hpad / 2, wpad - wpad / 2, wpad / 2, BORDER_CONSTANT, border_value, opt_b);
+            if (bottom_blob_bordered.empty())
+                return -100;
+        }
+    }
+
+    return 0;
+}
+
+bool Convolution_x86::kernel_available(int kernel) const
+{
+    if (kernel == KERNEL_SGEMM)
+        return !weight_sgemm_data.empty();
+    if (kernel == KERNEL_WINOGRAD23)
+        return use_winograd3x3 && !weight_3x3_winograd23_data.empty();
+    if (kernel == KERNEL_WINOGRAD43)
+        return use_winograd3x3 && !weight_3x3_winograd43_data.empty();
+    if (kernel == KERNEL_WINOGRAD63)
+        return use_winograd3x3 && !weight_3x3_winograd63_data.empty();
+    if (kernel == KERNEL_DIRECT)
+        // the 5x5s2 and 7x7 direct kernels are sgemm already
+        return !weight_data.empty() && kernel_w != 7 && !(kernel_w == 5 && stride_w == 2);
+
+    return false;
+}
+
+int Convolution_x86::default_kernel(int outw, int outh) const
+{
+    if (use_winograd3x3 && outw >= 8 && outh >= 8)
+    {
+        int tile = conv3x3s1_winograd_tile(outw, outh, !weight_3x3_winograd43_data.empty(), !weight_3x3_winograd63_data.empty());
+        return tile == 0 ? KERNEL_WINOGRAD23 : tile == 4 ? KERNEL_WINOGRAD43 : KERNEL_WINOGRAD63;
+    }
+
+    return KERNEL_SGEMM;
+}
+
+void Convolution_x86::output_size(int w, int h, int& outw, int& outh) const
+{
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    if (pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0)
+    {
+        w += pad_left + pad_right;
+        h += pad_top + pad_bottom;
+    }
+    else if ((pad_left == -233 && pad_right == -233 && pad_top == -233 && pad_bottom == -233)
+             || (pad_left == -234 && pad_right == -234 && pad_top == -234 && pad_bottom == -234))
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            w += wpad;
+            h += hpad;
+        }
+    }
+
+    outw = (w - kernel_extent_w) / stride_w + 1;
+    outh = (h - kernel_extent_h) / stride_h + 1;
+}
+
+int Convolution_x86::select_kernel(const Mat& bottom_blob, const Option& /*opt*/) const
+{
+    // the same checks forward makes before its float32 kernels
+    if (!weight_codebook.empty() || use_packing || use_int8_inference || bottom_blob.dims != 3)
+        return -1;
+
+    if (kernel_w != kernel_h || stride_w != stride_h || dilation_w != 1 || dilation_h != 1)
+        return -1;
+
+    if ((kernel_w != 1 && kernel_w != 3 && kernel_w != 5 && kernel_w != 7) || (stride_w != 1 && stride_w != 2))
+        return -1;
+
+    int outw;
+    int outh;
+    output_size(bottom_blob.w, bottom_blob.h, outw, outh);
+
+    return default_kernel(outw, outh);
+}
+
+int Convolution_x86::candidate_kernels(const Mat& bottom_blob, std::vector<int>& kernels, const Option& opt) const
+{
+    kernels.clear();
+
+    if (select_kernel(bottom_blob, opt) == -1)
+        return 0;
+
+    for (int kernel=KERNEL_SGEMM; kernel<=KERNEL_DIRECT; kernel++)
+    {
+        if (kernel_available(kernel))
+            kernels.push_back(kernel);
+    }
+
+    return 0;
+}
+
 int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    return forward_with_kernel(bottom_blob, top_blob, -1, opt);
+}
+
+int Convolution_x86::forward_with_kernel(const Mat& bottom_blob, Mat& top_blob, int forward_kernel, const Option& opt) const
 {
     // convolv with NxN kernel
     // value = value + bias
 
+    #if BISONAI_KILL_THE_BITS
+    if (use_channel_reduction && bottom_blob.dims == 3 && bottom_blob.c == original_input_channels)
+    {
+        Mat bottom_blob_reduced;
+        int ret = reduce_input_channels(bottom_blob, bottom_blob_reduced, opt);
+        if (ret != 0)
+            return ret;
+
+        return forward(bottom_blob_reduced, top_blob, opt);
+    }
+    #endif // BISONAI_KILL_THE_BITS
+
+    if (!weight_codebook.empty())
+    {
+        return Convolution::forward(bottom_blob, top_blob, opt);
+    }
+
+    if (use_packing)
+    {
+        return forward_pack(bottom_blob, top_blob, opt);
+    }
+
+    if (bottom_blob.elempack != 1)
+    {
+        Mat bottom_blob_unpacked;
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt);
+        return forward(bottom_blob_unpacked, top_blob, opt);
+    }
+
     if (bottom_blob.dims != 3)
     {
+        if (weight_data.empty())
+        {
+            fprintf(stderr, "Convolution_x86 weight_data released, %d-dim input not supported\n", bottom_blob.dims);
+            return -1;
+        }
+
         return Convolution::forward(bottom_blob, top_blob, opt);
     }
 
@@ -457,7 +753,16 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
             if (stride != 1)
                 return Convolution::forward(bottom_blob, top_blob, opt);
 
-            return forwardDilation(bottom_blob, top_blob, conv, opt);
+            int ret = forwardDilation(bottom_blob, top_blob, conv, opt);
+            if (ret != 0)
+                return ret;
+
+            if (activation)
+            {
+                activation->forward_inplace(top_blob, opt);
+            }
+
+            return 0;
         }
     }
 
@@ -485,88 +790,37 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         bottom_blob_unbordered = bottom_blob_int8;
     }
 
-    Mat bottom_blob_bordered = bottom_blob_unbordered;
-    if (pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0)
-    {
-        Option opt_b = opt;
-        opt_b.blob_allocator = opt.workspace_allocator;
-        copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, pad_value, opt_b);
-        if (bottom_blob_bordered.empty())
-            return -100;
-
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
-    }
-    else if (pad_left == -233 && pad_right == -233 && pad_top == -233 && pad_bottom == -233)
-    {
-        int wpad = kernel_size + (w - 1) / stride * stride - w;
-        int hpad = kernel_size + (h - 1) / stride * stride - h;
-        if (wpad > 0 || hpad > 0)
-        {
-            Option opt_b = opt;
-            opt_b.blob_allocator = opt.workspace_allocator;
-            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
-            if (bottom_blob_bordered.empty())
-                return -100;
-        }
-
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
-    }
-    else if (pad_left == -234 && pad_right == -234 && pad_top == -234 && pad_bottom == -234)
-    {
-        int wpad = kernel_size + (w - 1) / stride * stride - w;
-        int hpad = kernel_size + (h - 1) / stride * stride - h;
-        if (wpad > 0 || hpad > 0)
-        {
-            Option opt_b = opt;
-            opt_b.blob_allocator = opt.workspace_allocator;
-            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad - hpad / 2, hpad / 2, wpad - wpad / 2, wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
-            if (bottom_blob_bordered.empty())
-                return -100;
-        }
+    Mat bottom_blob_bordered;
+    int ret = make_padding(bottom_blob_unbordered, bottom_blob_bordered, opt);
+    if (ret != 0)
+        return ret;
 
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
-    }
+    w = bottom_blob_bordered.w;
+    h = bottom_blob_bordered.h;
 
     int outw = (w - kernel_size) / stride + 1;
     int outh = (h - kernel_size) / stride + 1;
 
     // int8
     if (use_int8_inference)
-    {         
+    {
+        // activations the store epilogue applies itself
+        bool activation_fused = false;
+
         if (use_int8_requantize == true)
         {
-            Mat top_blob_tm;
-            top_blob_tm.create(outw, outh, num_output, (size_t)4u, opt.workspace_allocator);
-            if (top_blob_tm.empty())
-                return -100;
-            
             top_blob.create(outw, outh, num_output, (size_t)1u, opt.blob_allocator);
             if (top_blob.empty())
-                return -100; 
+                return -100;
 
             if (use_winograd3x3)
             {
-                // conv3x3s1_winograd23_int8_sse(bottom_blob_bordered, top_blob_tm, weight_3x3_winograd23_data, opt);
-                conv3x3s1_winograd43_int8_sse(bottom_blob_bordered, top_blob_tm, weight_3x3_winograd23_data, opt);
-
-                // requantize, reverse scale inplace
-                #pragma omp parallel for num_threads(opt.num_threads)
-                for (int p=0; p<num_output; p++)
-                {
-                    ncnn::Option opt_g = opt;
-                    opt_g.num_threads = 1;
-                    opt_g.blob_allocator = top_blob.allocator;
-
-                    Mat top_blob_tm_g = top_blob_tm.channel_range(p, 1);
-                    Mat top_blob_g = top_blob.channel_range(p, 1);
-                    requantize_ops[p]->forward(top_blob_tm_g, top_blob_g, opt_g);
-                }
+                // requantize, relu fused into the output transform
+                activation_fused = activation_type == 1;
+                conv3x3s1_winograd43_int8_requant_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd23_data, bias_data, requantize_scales, activation_fused, opt);
             }
             else
-                conv_int8_requant(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);
+                conv_int8_requant(bottom_blob_bordered, top_blob, weight_sgemm_int8_data, bias_data, requantize_scales, opt);
         }
         else
         {
@@ -576,26 +830,15 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
 
             if (use_winograd3x3)
             {
-                // conv3x3s1_winograd23_int8_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd23_data, opt);
-                conv3x3s1_winograd43_int8_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd23_data, opt);
-
-                // dequantize, reverse scale inplace
-                #pragma omp parallel for num_threads(opt.num_threads)
-                for (int p=0; p<num_output; p++)
-                {
-                    ncnn::Option opt_g = opt;
-                    opt_g.num_threads = 1;
-                    opt_g.blob_allocator = top_blob.allocator;
-
-                    Mat top_blob_g = top_blob.channel_range(p, 1);
-                    dequantize_ops[p]->forward_inplace(top_blob_g, opt_g);
-                }
+                // dequantize, activation fused into the output transform
+                activation_fused = true;
+                conv3x3s1_winograd43_int8_dequant_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd23_data, bias_data, dequantize_scales, activation_type, activation_params, opt);
             }
             else
-                conv_int8_dequant(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, opt);     
+                conv_int8_dequant(bottom_blob_bordered, top_blob, weight_sgemm_int8_data, bias_data, dequantize_scales, opt);     
         }
 
-        if (activation)
+        if (activation && !activation_fused)
         {
             activation->forward_inplace(top_blob, opt);
         }        
@@ -608,14 +851,32 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     if (top_blob.empty())
         return -100;    
 
-    if (use_winograd3x3 && outw >= 8 && outh >=8)
+    // the kernel memoized for this shape, or the one picked by output size
+    int kernel = forward_kernel;
+    if (!kernel_available(kernel))
+        kernel = default_kernel(outw, outh);
+
+    if (kernel == KERNEL_WINOGRAD23)
     {
         conv3x3s1_winograd23_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd23_data, bias_data, opt);
-//         conv3x3s1_winograd43_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd43_data, bias_data, opt);
+    }
+    else if (kernel == KERNEL_WINOGRAD43 || kernel == KERNEL_WINOGRAD63)
+    {
+        const Mat& kernel_tm = kernel == KERNEL_WINOGRAD63 ? weight_3x3_winograd63_data : weight_3x3_winograd43_data;
+        ret = conv3x3s1_winograd_sse(bottom_blob_bordered, top_blob, kernel_tm, bias_data, kernel == KERNEL_WINOGRAD63 ? 6 : 4, opt);
+        if (ret != 0)
+            return ret;
+    }
+    else if (kernel == KERNEL_DIRECT)
+    {
+        conv(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
     }
     else
-        //conv(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
-        conv_im2col_sgemm_sse(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, stride_w, stride_h, opt);
+    {
+        ret = conv_im2col_sgemm_sse(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, stride_w, stride_h, opt);
+        if (ret != 0)
+            return ret;
+    }
 
     if (activation)
     {
@@ -625,4 +886,249 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     return 0;
 }
 
+int Convolution_x86::forward_batch(const std::vector<Mat>& bottom_batch, std::vector<Mat>& top_batch, const Option& opt) const
+{
+    const int batch = bottom_batch.size();
+    const Mat& bottom_blob = bottom_batch[0];
+
+    // only the float32 sgemm path shares its packed weight across samples
+    bool batched = batch > 1 && weight_codebook.empty() && !use_packing && !use_int8_inference && !weight_sgemm_data.empty()
+                   && dilation_w == 1 && dilation_h == 1 && bottom_blob.dims == 3 && bottom_blob.elempack == 1 && bottom_blob.elemsize == 4u;
+#if BISONAI_KILL_THE_BITS
+    batched = batched && !use_channel_reduction;
+#endif // BISONAI_KILL_THE_BITS
+    for (int b=1; b<batch && batched; b++)
+    {
+        const Mat& m = bottom_batch[b];
+        batched = m.dims == 3 && m.w == bottom_blob.w && m.h == bottom_blob.h && m.c == bottom_blob.c && m.elempack == 1 && m.elemsize == 4u;
+    }
+
+    std::vector<Mat> bottom_batch_bordered(batch);
+    int outw = 0;
+    int outh = 0;
+    if (batched)
+    {
+        for (int b=0; b<batch; b++)
+        {
+            int ret = make_padding(bottom_batch[b], bottom_batch_bordered[b], opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        outw = (bottom_batch_bordered[0].w - kernel_w) / stride_w + 1;
+        outh = (bottom_batch_bordered[0].h - kernel_h) / stride_h + 1;
+
+        // a sample filling a column block by itself gains nothing from sharing the blocks
+        // winograd takes the larger 3x3 stride 1 outputs
+        batched = outw * outh < sgemm_nc && default_kernel(outw, outh) == KERNEL_SGEMM;
+    }
+
+    if (!batched)
+        return Layer::forward_batch(bottom_batch, top_batch, opt);
+
+    const int out_size = outw * outh;
+    const int inch = bottom_blob.c;
+    const int K = kernel_w * kernel_h * inch;
+    const int N = out_size * batch;
+
+    // all samples side by side as the columns of one sgemm
+    Mat top_blob_tm(N, num_output, 4u, opt.workspace_allocator);
+    if (top_blob_tm.empty())
+        return -100;
+
+    const float* bias = bias_data;
+
+    int ret = 0;
+    if (kernel_w == 1 && kernel_h == 1 && stride_w == 1 && stride_h == 1)
+    {
+        std::vector<sgemm_b_matrix> bs(batch);
+        for (int b=0; b<batch; b++)
+        {
+            bs[b].data = bottom_batch_bordered[b];
+            bs[b].ldb = bottom_batch_bordered[b].cstep;
+        }
+
+        sgemm_b_batch<sgemm_b_matrix> bb;
+        bb.b = &bs[0];
+        bb.n = out_size;
+
+        ret = sgemm_x86(num_output, N, K, weight_sgemm_data, bb, bias, top_blob_tm, N, opt);
+    }
+    else
+    {
+        std::vector<sgemm_b_im2col> bs(batch);
+        for (int b=0; b<batch; b++)
+        {
+            bs[b].data = bottom_batch_bordered[b];
+            bs[b].cstep = bottom_batch_bordered[b].cstep;
+            bs[b].w = bottom_batch_bordered[b].w;
+            bs[b].outw = outw;
+            bs[b].kernel_w = kernel_w;
+            bs[b].maxk = kernel_w * kernel_h;
+            bs[b].stride_w = stride_w;
+            bs[b].stride_h = stride_h;
+        }
+
+        sgemm_b_batch<sgemm_b_im2col> bb;
+        bb.b = &bs[0];
+        bb.n = out_size;
+
+        ret = sgemm_x86(num_output, N, K, weight_sgemm_data, bb, bias, top_blob_tm, N, opt);
+    }
+    if (ret != 0)
+        return ret;
+
+    bottom_batch_bordered.clear();
+
+    top_batch.resize(batch);
+    for (int b=0; b<batch; b++)
+    {
+        Mat& top_blob = top_batch[b];
+        top_blob.create(outw, outh, num_output, 4u, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p=0; p<num_output; p++)
+        {
+            memcpy(top_blob.channel(p), (const float*)top_blob_tm.row(p) + b * out_size, out_size * sizeof(float));
+        }
+
+        if (activation)
+        {
+            activation->forward_inplace(top_blob, opt);
+        }
+    }
+
+    return 0;
+}
+
+int Convolution_x86::forward_pack(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    if (bottom_blob.dims != 3)
+    {
+        if (weight_data.empty())
+        {
+            fprintf(stderr, "Convolution_x86 weight_data released, %d-dim input not supported\n", bottom_blob.dims);
+            return -1;
+        }
+
+        Mat bottom_blob_unpacked;
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt);
+        return Convolution::forward(bottom_blob_unpacked, top_blob, opt);
+    }
+
+#if __SSE2__
+    Mat bottom_blob_packed = bottom_blob;
+    if (bottom_blob.elempack != in_elempack)
+    {
+        Option opt_p = opt;
+        opt_p.blob_allocator = opt.workspace_allocator;
+        convert_packing(bottom_blob, bottom_blob_packed, in_elempack, opt_p);
+    }
+
+    int w = bottom_blob_packed.w;
+    int h = bottom_blob_packed.h;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    Mat bottom_blob_bordered = bottom_blob_packed;
+    Option opt_b = opt;
+    opt_b.blob_allocator = opt.workspace_allocator;
+    if (pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0)
+    {
+        copy_make_border(bottom_blob_packed, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, pad_value, opt_b);
+    }
+    else if (pad_left == -233 && pad_right == -233 && pad_top == -233 && pad_bottom == -233)
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+            copy_make_border(bottom_blob_packed, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
+    }
+    else if (pad_left == -234 && pad_right == -234 && pad_top == -234 && pad_bottom == -234)
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+            copy_make_border(bottom_blob_packed, bottom_blob_bordered, hpad - hpad / 2, hpad / 2, wpad - wpad / 2, wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
+    }
+    if (bottom_blob_bordered.empty())
+        return -100;
+
+    w = bottom_blob_bordered.w;
+    h = bottom_blob_bordered.h;
+
+    int outw = (w - kernel_extent_w) / stride_w + 1;
+    int outh = (h - kernel_extent_h) / stride_h + 1;
+
+    const int maxk = kernel_w * kernel_h;
+
+    // kernel offsets in packed elements
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    {
+        int p1 = 0;
+        int p2 = 0;
+        int gap = w * dilation_h - kernel_w * dilation_w;
+        for (int i = 0; i < kernel_h; i++)
+        {
+            for (int j = 0; j < kernel_w; j++)
+            {
+                space_ofs[p1] = p2;
+                p1++;
+                p2 += dilation_w;
+            }
+            p2 += gap;
+        }
+    }
+
+    // packed blob is only handed on when the net runs the packing layout
+    Mat top_blob_packed;
+    Option opt_t = opt;
+    if (!opt.use_packing_layout)
+        opt_t.blob_allocator = opt.workspace_allocator;
+
+    top_blob_packed.create(outw, outh, num_output / out_elempack, 4u * out_elempack, out_elempack, opt_t.blob_allocator);
+    if (top_blob_packed.empty())
+        return -100;
+
+#if __AVX__
+    if (out_elempack == 8)
+    {
+        if (in_elempack == 8)
+            conv_pack_sse<pack8_avx, 8>(bottom_blob_bordered, top_blob_packed, weight_data_pack, bias_data, stride_w, stride_h, space_ofs, maxk, activation_type, activation_params, opt);
+        else if (in_elempack == 4)
+            conv_pack_sse<pack8_avx, 4>(bottom_blob_bordered, top_blob_packed, weight_data_pack, bias_data, stride_w, stride_h, space_ofs, maxk, activation_type, activation_params, opt);
+        else
+            conv_pack_sse<pack8_avx, 1>(bottom_blob_bordered, top_blob_packed, weight_data_pack, bias_data, stride_w, stride_h, space_ofs, maxk, activation_type, activation_params, opt);
+    }
+    else if (in_elempack == 8)
+    {
+        conv_pack_sse<pack4_sse, 8>(bottom_blob_bordered, top_blob_packed, weight_data_pack, bias_data, stride_w, stride_h, space_ofs, maxk, activation_type, activation_params, opt);
+    }
+    else
+#endif // __AVX__
+    if (in_elempack == 4)
+    {
+        conv_pack_sse<pack4_sse, 4>(bottom_blob_bordered, top_blob_packed, weight_data_pack, bias_data, stride_w, stride_h, space_ofs, maxk, activation_type, activation_params, opt);
+    }
+    else
+    {
+        conv_pack_sse<pack4_sse, 1>(bottom_blob_bordered, top_blob_packed, weight_data_pack, bias_data, stride_w, stride_h, space_ofs, maxk, activation_type, activation_params, opt);
+    }
+
+    if (!opt.use_packing_layout)
+    {
+        convert_packing(top_blob_packed, top_blob, 1, opt);
+        return top_blob.empty() ? -100 : 0;
+    }
+
+    top_blob = top_blob_packed;
+#endif // __SSE2__
+
+    return 0;
+}
+
 } // namespace ncnn
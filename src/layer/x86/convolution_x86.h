@@ -29,15 +29,60 @@ public:
     virtual int create_pipeline(const Option& opt);
     virtual int destroy_pipeline(const Option& opt);
 
+    virtual int pipeline_weights(std::vector<Mat*>& weights);
+
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+    virtual int forward_with_kernel(const Mat& bottom_blob, Mat& top_blob, int kernel, const Option& opt) const;
     virtual int forwardDilation(const Mat& bottom_blob, Mat &top_blob, conv_func conv, const Option& opt) const;
 
+    // small outputs of a batch run as one sgemm reading the weight panels once
+    virtual int forward_batch(const std::vector<Mat>& bottom_batch, std::vector<Mat>& top_batch, const Option& opt) const;
+
+    // float32 kernel forward picks for the output size of bottom_blob
+    virtual int select_kernel(const Mat& bottom_blob, const Option& opt) const;
+
+    // every available float32 kernel for bottom_blob
+    virtual int candidate_kernels(const Mat& bottom_blob, std::vector<int>& kernels, const Option& opt) const;
+
+    // float32 kernels of forward, in select_kernel and forward_with_kernel
+    enum
+    {
+        KERNEL_SGEMM = 0,
+        KERNEL_WINOGRAD23 = 1,
+        KERNEL_WINOGRAD43 = 2,
+        KERNEL_WINOGRAD63 = 3,
+        KERNEL_DIRECT = 4
+    };
+
+    // the transformed weight of kernel exists
+    bool kernel_available(int kernel) const;
+    // float32 kernel for an outw x outh output
+    int default_kernel(int outw, int outh) const;
+    // output size of a w x h input after padding
+    void output_size(int w, int h, int& outw, int& outh) const;
+
+    // border the input by the pad params into workspace memory
+    // return 0 if success
+    int make_padding(const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt) const;
+
+    // direct convolution on pack4 or pack8 blobs
+    int forward_pack(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
 public:
     Layer* activation;
     bool use_winograd3x3;
     Mat weight_3x3_winograd23_data;
     Mat weight_sgemm_data;
-    std::vector<Mat> weight_3x3_winograd43_data;
+    Mat weight_3x3_winograd43_data;
+    Mat weight_3x3_winograd63_data;
+    // int8 kernel in the sgemm int8 4 x 4 panels
+    Mat weight_sgemm_int8_data;
+
+    // packed layout, input and output elempack follow the channel counts
+    bool use_packing;
+    int in_elempack;
+    int out_elempack;
+    Mat weight_data_pack;
 };
 
 } // namespace ncnn
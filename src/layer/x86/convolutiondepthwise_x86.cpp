@@ -19,6 +19,7 @@
 #endif
 
 #include "layer_type.h"
+#include "x86_usability.h"
 
 namespace ncnn {
 
@@ -31,6 +32,8 @@ DEFINE_LAYER_CREATOR(ConvolutionDepthWise_x86)
 ConvolutionDepthWise_x86::ConvolutionDepthWise_x86()
 {
     activation = 0;
+    use_packing = false;
+    elempack = 1;
 }
 
 int ConvolutionDepthWise_x86::create_pipeline(const Option& opt)
@@ -81,6 +84,39 @@ int ConvolutionDepthWise_x86::create_pipeline(const Option& opt)
 
     group_ops.clear();      
 
+    use_packing = false;
+    support_packing = false;
+
+#if __SSE2__
+    if (opt.use_packing_layout && !use_int8_inference && channels == group && group == num_output)
+    {
+        elempack = x86_elempack(channels);
+        use_packing = elempack > 1;
+    }
+
+    if (use_packing)
+    {
+        support_packing = true;
+
+        // weight_data_pack holds the lanes of every kernel tap contiguous
+        weight_data_pack.create(maxk * elempack, group / elempack);
+        for (int g=0; g<group / elempack; g++)
+        {
+            float* kptr = weight_data_pack.row(g);
+
+            for (int k=0; k<maxk; k++)
+            {
+                for (int l=0; l<elempack; l++)
+                {
+                    kptr[k * elempack + l] = weight_data[(g * elempack + l) * maxk + k];
+                }
+            }
+        }
+
+        return 0;
+    }
+#endif // __SSE2__
+
     if (channels == group && group == num_output)
     {
         // depth-wise specific
@@ -153,7 +189,10 @@ int ConvolutionDepthWise_x86::create_pipeline(const Option& opt)
             op->load_model(ModelBinFromMatArray(weights));
         }
 
-        op->create_pipeline(opt);
+        // group outputs are written into channel ranges of the unpacked top blob
+        ncnn::Option opt_g = opt;
+        opt_g.use_packing_layout = false;
+        op->create_pipeline(opt_g);
 
         group_ops[g] = op;
     }      
@@ -185,6 +224,18 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
     // convolv with NxN kernel
     // value = value + bias
 
+    if (use_packing)
+    {
+        return forward_pack(bottom_blob, top_blob, opt);
+    }
+
+    if (bottom_blob.elempack != 1)
+    {
+        Mat bottom_blob_unpacked;
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt);
+        return forward(bottom_blob_unpacked, top_blob, opt);
+    }
+
     int w = bottom_blob.w;
     int h = bottom_blob.h;
     int channels = bottom_blob.c;
@@ -512,4 +563,149 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
     return 0;
 }
 
+#if __SSE2__
+template<typename V>
+static void convdw_pack_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data_pack, const Mat& bias_data, int stride_w, int stride_h, const int* space_ofs, int maxk, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    typedef typename V::vec vec;
+    const int L = V::lanes;
+
+    const int w = bottom_blob.w;
+    const int channels = top_blob.c;
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int g=0; g<channels; g++)
+    {
+        const float* ptr = bottom_blob.channel(g);
+        const float* kptr = weight_data_pack.row(g);
+        float* outptr = top_blob.channel(g);
+
+        vec _bias = bias_data.empty() ? V::zero() : V::load((const float*)bias_data + g * L);
+
+        for (int i=0; i<outh; i++)
+        {
+            for (int j=0; j<outw; j++)
+            {
+                const float* sptr = ptr + (i * stride_h * w + j * stride_w) * L;
+
+                vec _sum = _bias;
+                for (int k=0; k<maxk; k++)
+                {
+                    _sum = V::fmadd(V::load(sptr + space_ofs[k] * L), V::load(kptr + k * L), _sum);
+                }
+
+                V::store(outptr + j * L, activation_pack<V>(_sum, activation_type, activation_params));
+            }
+
+            outptr += outw * L;
+        }
+    }
+}
+#endif // __SSE2__
+
+int ConvolutionDepthWise_x86::forward_pack(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+#if __SSE2__
+    Mat bottom_blob_packed = bottom_blob;
+    if (bottom_blob.elempack != elempack)
+    {
+        Option opt_p = opt;
+        opt_p.blob_allocator = opt.workspace_allocator;
+        convert_packing(bottom_blob, bottom_blob_packed, elempack, opt_p);
+    }
+
+    if (bottom_blob_packed.c * elempack != group)
+    {
+        // reject invalid group
+        return -100;
+    }
+
+    int w = bottom_blob_packed.w;
+    int h = bottom_blob_packed.h;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    Mat bottom_blob_bordered = bottom_blob_packed;
+    Option opt_b = opt;
+    opt_b.blob_allocator = opt.workspace_allocator;
+    if (pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0)
+    {
+        copy_make_border(bottom_blob_packed, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, pad_value, opt_b);
+    }
+    else if (pad_left == -233 && pad_right == -233 && pad_top == -233 && pad_bottom == -233)
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+            copy_make_border(bottom_blob_packed, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
+    }
+    else if (pad_left == -234 && pad_right == -234 && pad_top == -234 && pad_bottom == -234)
+    {
+        int wpad = kernel_extent_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+            copy_make_border(bottom_blob_packed, bottom_blob_bordered, hpad - hpad / 2, hpad / 2, wpad - wpad / 2, wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
+    }
+    if (bottom_blob_bordered.empty())
+        return -100;
+
+    w = bottom_blob_bordered.w;
+    h = bottom_blob_bordered.h;
+
+    int outw = (w - kernel_extent_w) / stride_w + 1;
+    int outh = (h - kernel_extent_h) / stride_h + 1;
+
+    const int maxk = kernel_w * kernel_h;
+
+    // kernel offsets in packed elements
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    {
+        int p1 = 0;
+        int p2 = 0;
+        int gap = w * dilation_h - kernel_w * dilation_w;
+        for (int i = 0; i < kernel_h; i++)
+        {
+            for (int j = 0; j < kernel_w; j++)
+            {
+                space_ofs[p1] = p2;
+                p1++;
+                p2 += dilation_w;
+            }
+            p2 += gap;
+        }
+    }
+
+    // packed blob is only handed on when the net runs the packing layout
+    Mat top_blob_packed;
+    Option opt_t = opt;
+    if (!opt.use_packing_layout)
+        opt_t.blob_allocator = opt.workspace_allocator;
+
+    top_blob_packed.create(outw, outh, num_output / elempack, 4u * elempack, elempack, opt_t.blob_allocator);
+    if (top_blob_packed.empty())
+        return -100;
+
+#if __AVX__
+    if (elempack == 8)
+        convdw_pack_sse<pack8_avx>(bottom_blob_bordered, top_blob_packed, weight_data_pack, bias_data, stride_w, stride_h, space_ofs, maxk, activation_type, activation_params, opt);
+    else
+#endif // __AVX__
+        convdw_pack_sse<pack4_sse>(bottom_blob_bordered, top_blob_packed, weight_data_pack, bias_data, stride_w, stride_h, space_ofs, maxk, activation_type, activation_params, opt);
+
+    if (!opt.use_packing_layout)
+    {
+        convert_packing(top_blob_packed, top_blob, 1, opt);
+        return top_blob.empty() ? -100 : 0;
+    }
+
+    top_blob = top_blob_packed;
+#endif // __SSE2__
+
+    return 0;
+}
+
 } // namespace ncnn
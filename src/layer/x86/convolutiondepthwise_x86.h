@@ -29,9 +29,17 @@ public:
 
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
+    // depth-wise convolution on pack4 or pack8 blobs
+    int forward_pack(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
 public:
     Layer* activation;
     std::vector<ncnn::Layer*> group_ops;
+
+    // packed layout of depth-wise convolution, one elempack for input and output
+    bool use_packing;
+    int elempack;
+    Mat weight_data_pack;
 };
 
 } // namespace ncnn
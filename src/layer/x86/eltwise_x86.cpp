@@ -0,0 +1,129 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "eltwise_x86.h"
+
+#include <algorithm>
+
+#include "x86_usability.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Eltwise_x86)
+
+Eltwise_x86::Eltwise_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+#if __SSE2__
+template<typename V>
+static inline typename V::vec eltwise_op(int op_type, typename V::vec a, typename V::vec b, typename V::vec cb)
+{
+    if (op_type == Eltwise::Operation_PROD)
+        return V::mul(a, b);
+    if (op_type == Eltwise::Operation_SUM)
+        return V::fmadd(b, cb, a);
+    return V::max(a, b);
+}
+#endif // __SSE2__
+
+static inline float eltwise_op(int op_type, float a, float b, float cb)
+{
+    if (op_type == Eltwise::Operation_PROD)
+        return a * b;
+    if (op_type == Eltwise::Operation_SUM)
+        return a + b * cb;
+    return std::max(a, b);
+}
+
+// outptr = op(a * ca, b * cb), coefficients only apply to sum
+static void eltwise_channel(int op_type, const float* a, float ca, const float* b, float cb, float* outptr, int size)
+{
+    int i = 0;
+#if __AVX__
+    {
+        __m256 _ca = _mm256_set1_ps(ca);
+        __m256 _cb = _mm256_set1_ps(cb);
+        for (; i+7<size; i+=8)
+        {
+            __m256 _a = _mm256_loadu_ps(a + i);
+            if (op_type == Eltwise::Operation_SUM && ca != 1.f)
+                _a = _mm256_mul_ps(_a, _ca);
+            _mm256_storeu_ps(outptr + i, eltwise_op<pack8_avx>(op_type, _a, _mm256_loadu_ps(b + i), _cb));
+        }
+    }
+#endif // __AVX__
+#if __SSE2__
+    {
+        __m128 _ca = _mm_set1_ps(ca);
+        __m128 _cb = _mm_set1_ps(cb);
+        for (; i+3<size; i+=4)
+        {
+            __m128 _a = _mm_loadu_ps(a + i);
+            if (op_type == Eltwise::Operation_SUM && ca != 1.f)
+                _a = _mm_mul_ps(_a, _ca);
+            _mm_storeu_ps(outptr + i, eltwise_op<pack4_sse>(op_type, _a, _mm_loadu_ps(b + i), _cb));
+        }
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        float _a = a[i];
+        if (op_type == Eltwise::Operation_SUM && ca != 1.f)
+            _a *= ca;
+        outptr[i] = eltwise_op(op_type, _a, b[i], cb);
+    }
+}
+
+int Eltwise_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    if (bottom_blobs[0].elemsize == 1u)
+        return Eltwise::forward_int8(bottom_blobs, top_blobs, opt);
+
+    const Mat& bottom_blob = bottom_blobs[0];
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    // lanes of a packed element are independent
+    int size = w * h * bottom_blob.elempack;
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create_like(bottom_blob, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // all bottom blobs of a channel are reduced while it is still in cache
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* outptr = top_blob.channel(q);
+
+        float coeff0 = coeffs.w == 0 ? 1.f : coeffs[0];
+        float coeff1 = coeffs.w == 0 ? 1.f : coeffs[1];
+        eltwise_channel(op_type, bottom_blob.channel(q), coeff0, bottom_blobs[1].channel(q), coeff1, outptr, size);
+
+        for (size_t b=2; b<bottom_blobs.size(); b++)
+        {
+            float coeff = coeffs.w == 0 ? 1.f : coeffs[b];
+            eltwise_channel(op_type, outptr, 1.f, bottom_blobs[b].channel(q), coeff, outptr, size);
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,337 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "innerproduct_x86.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "cpu.h"
+#include "x86_usability.h"
+
+namespace ncnn {
+
+#include "x86_sgemm.h"
+#include "x86_int8.h"
+
+// flatten into one contiguous vector in unpacked order
+// a blob already in that order is referenced, not copied
+static int flatten(const Mat& bottom_blob, Mat& bottom_blob_flattened, const Option& opt)
+{
+    const int elempack = bottom_blob.elempack;
+    const int dims = bottom_blob.dims;
+    // rows of a 2-dim blob are flattened like channels of size w
+    const int channels = dims == 3 ? bottom_blob.c : dims == 2 ? bottom_blob.h : 1;
+    const int size = dims == 3 ? bottom_blob.w * bottom_blob.h : bottom_blob.w;
+    const size_t cstep = dims == 3 ? bottom_blob.cstep : (size_t)size;
+    const int num_input = channels * elempack * size;
+
+    if (dims == 1 || (elempack == 1 && cstep == (size_t)size))
+    {
+        bottom_blob_flattened = Mat(num_input, bottom_blob.data, 4u);
+        return 0;
+    }
+
+    bottom_blob_flattened.create(num_input, 4u, opt.workspace_allocator);
+    if (bottom_blob_flattened.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const float* ptr = (const float*)bottom_blob.data + q * cstep * elempack;
+        float* outptr = (float*)bottom_blob_flattened + q * elempack * size;
+
+        for (int l=0; l<elempack; l++)
+        {
+            for (int i=0; i<size; i++)
+            {
+                outptr[l * size + i] = ptr[i * elempack + l];
+            }
+        }
+    }
+
+    return 0;
+}
+
+DEFINE_LAYER_CREATOR(InnerProduct_x86)
+
+InnerProduct_x86::InnerProduct_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+    support_batch = true;
+}
+
+int InnerProduct_x86::create_pipeline(const Option& opt)
+{
+    // product-quantized weight runs the plain InnerProduct forward, int8 runs forward_int8
+    if (!weight_codebook.empty() || use_int8_inference)
+    {
+        support_packing = false;
+        return 0;
+    }
+
+    if (!pipeline_weights_restored)
+    {
+        const int num_input = weight_data_size / num_output;
+
+        sgemm_transform_a(weight_data, num_input, weight_data_tm, num_output, num_input);
+    }
+
+    // float32 forward only reads the transformed weight
+    if (opt.use_weight_data_release)
+        weight_data.release();
+
+    return 0;
+}
+
+int InnerProduct_x86::pipeline_weights(std::vector<Mat*>& weights)
+{
+    weights.clear();
+    weights.push_back(&weight_data_tm);
+
+    return 0;
+}
+
+float InnerProduct_x86::activate(float sum) const
+{
+    if (activation_type == 1)
+    {
+        sum = std::max(sum, 0.f);
+    }
+    else if (activation_type == 2)
+    {
+        float slope = activation_params[0];
+        sum = sum > 0.f ? sum : sum * slope;
+    }
+    else if (activation_type == 3)
+    {
+        float min = activation_params[0];
+        float max = activation_params[1];
+        if (sum < min)
+            sum = min;
+        if (sum > max)
+            sum = max;
+    }
+    else if (activation_type == 4)
+    {
+        sum = 1.f / (1.f + exp(-sum));
+    }
+
+    return sum;
+}
+
+int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    if (use_int8_inference && bottom_blob.elempack == 1)
+    {
+        return forward_int8(bottom_blob, top_blob, opt);
+    }
+
+    if (!weight_codebook.empty() || use_int8_inference || bottom_blob.elemsize != 4u * bottom_blob.elempack)
+    {
+        if (weight_data.empty() && weight_codebook.empty())
+        {
+            fprintf(stderr, "InnerProduct_x86 weight_data released, elemsize %d input not supported\n", (int)bottom_blob.elemsize);
+            return -1;
+        }
+
+        if (bottom_blob.elempack == 1)
+            return InnerProduct::forward(bottom_blob, top_blob, opt);
+
+        Mat bottom_blob_unpacked;
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt);
+        return InnerProduct::forward(bottom_blob_unpacked, top_blob, opt);
+    }
+
+    Mat bottom_blob_flattened;
+    int ret = flatten(bottom_blob, bottom_blob_flattened, opt);
+    if (ret != 0)
+        return ret;
+
+    const int num_input = bottom_blob_flattened.w;
+
+    top_blob.create(num_output, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    sgemm_b_matrix b;
+    b.data = bottom_blob_flattened;
+    b.ldb = 1;
+
+    ret = sgemm_x86(num_output, 1, num_input, weight_data_tm, b, bias_term ? (const float*)bias_data : 0, top_blob, 1, opt);
+    if (ret != 0)
+        return ret;
+
+    if (activation_type == 0)
+        return 0;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<num_output; p++)
+    {
+        top_blob[p] = activate(top_blob[p]);
+    }
+
+    return 0;
+}
+
+int InnerProduct_x86::forward_batch(const std::vector<Mat>& bottom_batch, std::vector<Mat>& top_batch, const Option& opt) const
+{
+    const int batch = bottom_batch.size();
+
+    bool batched = batch > 1 && weight_codebook.empty() && !use_int8_inference;
+    for (int b=0; b<batch && batched; b++)
+    {
+        batched = !bottom_batch[b].empty() && bottom_batch[b].elemsize == 4u * bottom_batch[b].elempack;
+    }
+
+    if (!batched)
+        return Layer::forward_batch(bottom_batch, top_batch, opt);
+
+    // the samples as the columns of B, so every weight panel streams once for the batch
+    Mat bottom_blob_tm;
+    int num_input = 0;
+    for (int b=0; b<batch; b++)
+    {
+        Mat bottom_blob_flattened;
+        int ret = flatten(bottom_batch[b], bottom_blob_flattened, opt);
+        if (ret != 0)
+            return ret;
+
+        if (b == 0)
+        {
+            num_input = bottom_blob_flattened.w;
+
+            bottom_blob_tm.create(batch, num_input, 4u, opt.workspace_allocator);
+            if (bottom_blob_tm.empty())
+                return -100;
+        }
+        else if (bottom_blob_flattened.w != num_input)
+        {
+            fprintf(stderr, "InnerProduct_x86 batch sample %d has %d inputs, %d expected\n", b, bottom_blob_flattened.w, num_input);
+            return -1;
+        }
+
+        const float* ptr = bottom_blob_flattened;
+        float* outptr = (float*)bottom_blob_tm + b;
+        for (int k=0; k<num_input; k++)
+        {
+            outptr[k * batch] = ptr[k];
+        }
+    }
+
+    Mat top_blob_tm(batch, num_output, 4u, opt.workspace_allocator);
+    if (top_blob_tm.empty())
+        return -100;
+
+    sgemm_b_matrix b;
+    b.data = bottom_blob_tm;
+    b.ldb = batch;
+
+    int ret = sgemm_x86(num_output, batch, num_input, weight_data_tm, b, bias_term ? (const float*)bias_data : 0, top_blob_tm, batch, opt);
+    if (ret != 0)
+        return ret;
+
+    top_batch.resize(batch);
+    for (int b=0; b<batch; b++)
+    {
+        top_batch[b].create(num_output, 4u, opt.blob_allocator);
+        if (top_batch[b].empty())
+            return -100;
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<num_output; p++)
+    {
+        const float* ptr = top_blob_tm.row(p);
+
+        for (int b=0; b<batch; b++)
+        {
+            top_batch[b][p] = activate(ptr[b]);
+        }
+    }
+
+    return 0;
+}
+
+int InnerProduct_x86::forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int size = bottom_blob.w * bottom_blob.h;
+    const int channels = bottom_blob.c;
+    const int num_input = weight_data_size / num_output;
+
+    if (size * channels != num_input)
+    {
+        fprintf(stderr, "InnerProduct_x86 int8 forward needs input of size %d\n", num_input);
+        return -1;
+    }
+
+    Mat bottom_blob_int8 = bottom_blob;
+    if (bottom_blob.elemsize != 1)
+    {
+        bottom_blob_int8.create(bottom_blob.w, bottom_blob.h, channels, (size_t)1u, opt.workspace_allocator);
+        if (bottom_blob_int8.empty())
+            return -100;
+
+        // quantize, scale and round to nearest
+        Option opt_g = opt;
+        opt_g.blob_allocator = bottom_blob_int8.allocator;
+
+        quantize->forward(bottom_blob, bottom_blob_int8, opt_g);
+    }
+
+    // one contiguous input vector for the dot products
+    Mat bottom_blob_flattened = bottom_blob_int8;
+    if (channels > 1 && (int)bottom_blob_int8.cstep != size)
+    {
+        bottom_blob_flattened.create(num_input, (size_t)1u, opt.workspace_allocator);
+        if (bottom_blob_flattened.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const signed char* ptr = bottom_blob_int8.channel(q);
+            signed char* outptr = (signed char*)bottom_blob_flattened + size * q;
+
+            memcpy(outptr, ptr, size);
+        }
+    }
+
+    top_blob.create(num_output, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const signed char* x = bottom_blob_flattened;
+    const signed char* weight = weight_data;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<num_output; p++)
+    {
+        int sum = int8_dot(x, weight + num_input * p, num_input);
+
+        float sumf = sum * dequantize_scales[p];
+
+        if (bias_term)
+            sumf += bias_data[p];
+
+        top_blob[p] = activate(sumf);
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,49 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_INNERPRODUCT_X86_H
+#define LAYER_INNERPRODUCT_X86_H
+
+#include "innerproduct.h"
+
+namespace ncnn {
+
+class InnerProduct_x86 : virtual public InnerProduct
+{
+public:
+    InnerProduct_x86();
+
+    virtual int create_pipeline(const Option& opt);
+
+    virtual int pipeline_weights(std::vector<Mat*>& weights);
+
+    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
+    // the batch runs as one sgemm with a column per sample
+    virtual int forward_batch(const std::vector<Mat>& bottom_batch, std::vector<Mat>& top_batch, const Option& opt) const;
+
+    // int8 dot per output with dequantize, bias and activation fused
+    int forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
+    // apply activation_type to one output value
+    float activate(float sum) const;
+
+public:
+    // weight in sgemm panels
+    Mat weight_data_tm;
+};
+
+} // namespace ncnn
+
+#endif // LAYER_INNERPRODUCT_X86_H
@@ -0,0 +1,160 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "packing_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Packing_x86)
+
+int Packing_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    int elempack = bottom_blob.elempack;
+
+    if (elempack == out_elempack)
+    {
+        top_blob = bottom_blob;
+        return 0;
+    }
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    int dims = bottom_blob.dims;
+    size_t elemsize = bottom_blob.elemsize;
+
+    // 1-dim repacking is a plain copy, padding and non-fp32 lanes go generic
+    if (dims == 1 || elemsize != 4u * elempack)
+        return Packing::forward(bottom_blob, top_blob, opt);
+
+    // rows of a 2-dim blob are repacked like channels of size w
+    int elemcount = (dims == 3 ? channels : h) * elempack;
+    if (elemcount % out_elempack != 0)
+        return Packing::forward(bottom_blob, top_blob, opt);
+
+    int outc = elemcount / out_elempack;
+    int size = dims == 3 ? w * h : w;
+    size_t out_elemsize = 4u * out_elempack;
+
+    if (dims == 3)
+        top_blob.create(w, h, outc, out_elemsize, out_elempack, opt.blob_allocator);
+    else
+        top_blob.create(w, outc, out_elemsize, out_elempack, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const size_t in_cstep = dims == 3 ? bottom_blob.cstep : (size_t)w;
+    const size_t out_cstep = dims == 3 ? top_blob.cstep : (size_t)w;
+
+#if __SSE2__
+    if (elempack == 4 && out_elempack == 1)
+    {
+        const int inc = elemcount / 4;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<inc; q++)
+        {
+            const float* ptr = (const float*)bottom_blob.data + q * in_cstep * 4;
+            float* o0 = (float*)top_blob.data + (q * 4) * out_cstep;
+            float* o1 = o0 + out_cstep;
+            float* o2 = o1 + out_cstep;
+            float* o3 = o2 + out_cstep;
+
+            int i = 0;
+            for (; i+3<size; i+=4)
+            {
+                __m128 _r0 = _mm_loadu_ps(ptr + i * 4);
+                __m128 _r1 = _mm_loadu_ps(ptr + i * 4 + 4);
+                __m128 _r2 = _mm_loadu_ps(ptr + i * 4 + 8);
+                __m128 _r3 = _mm_loadu_ps(ptr + i * 4 + 12);
+                _MM_TRANSPOSE4_PS(_r0, _r1, _r2, _r3);
+                _mm_storeu_ps(o0 + i, _r0);
+                _mm_storeu_ps(o1 + i, _r1);
+                _mm_storeu_ps(o2 + i, _r2);
+                _mm_storeu_ps(o3 + i, _r3);
+            }
+            for (; i<size; i++)
+            {
+                o0[i] = ptr[i * 4];
+                o1[i] = ptr[i * 4 + 1];
+                o2[i] = ptr[i * 4 + 2];
+                o3[i] = ptr[i * 4 + 3];
+            }
+        }
+
+        return 0;
+    }
+#endif // __SSE2__
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<outc; q++)
+    {
+        float* outptr = (float*)top_blob.data + q * out_cstep * out_elempack;
+
+#if __SSE2__
+        if (elempack == 1 && out_elempack == 4)
+        {
+            const float* r0 = (const float*)bottom_blob.data + (q * 4) * in_cstep;
+            const float* r1 = r0 + in_cstep;
+            const float* r2 = r1 + in_cstep;
+            const float* r3 = r2 + in_cstep;
+
+            int i = 0;
+            for (; i+3<size; i+=4)
+            {
+                __m128 _r0 = _mm_loadu_ps(r0 + i);
+                __m128 _r1 = _mm_loadu_ps(r1 + i);
+                __m128 _r2 = _mm_loadu_ps(r2 + i);
+                __m128 _r3 = _mm_loadu_ps(r3 + i);
+                _MM_TRANSPOSE4_PS(_r0, _r1, _r2, _r3);
+                _mm_storeu_ps(outptr + i * 4, _r0);
+                _mm_storeu_ps(outptr + i * 4 + 4, _r1);
+                _mm_storeu_ps(outptr + i * 4 + 8, _r2);
+                _mm_storeu_ps(outptr + i * 4 + 12, _r3);
+            }
+            for (; i<size; i++)
+            {
+                outptr[i * 4] = r0[i];
+                outptr[i * 4 + 1] = r1[i];
+                outptr[i * 4 + 2] = r2[i];
+                outptr[i * 4 + 3] = r3[i];
+            }
+            continue;
+        }
+#endif // __SSE2__
+
+        // strided lane copy for the other combinations
+        for (int k=0; k<out_elempack; k++)
+        {
+            int srcq = (q * out_elempack + k) / elempack;
+            int srck = (q * out_elempack + k) % elempack;
+
+            const float* ptr = (const float*)bottom_blob.data + srcq * in_cstep * elempack + srck;
+            float* optr = outptr + k;
+
+            for (int i=0; i<size; i++)
+            {
+                optr[i * out_elempack] = ptr[i * elempack];
+            }
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,140 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "padding_x86.h"
+
+#include <string.h>
+
+#include "x86_usability.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Padding_x86)
+
+Padding_x86::Padding_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+#if __SSE2__
+// source index of a border position, 1=REPLICATE 2=REFLECT
+static inline int border_index(int i, int n, int type)
+{
+    if (type == 1)
+        return i < 0 ? 0 : i >= n ? n - 1 : i;
+
+    return i < 0 ? -i : i >= n ? 2 * n - 2 - i : i;
+}
+
+template<typename V>
+static void copy_make_border_pack(const Mat& src, Mat& dst, int top, int left, int type, float v)
+{
+    const int L = V::lanes;
+    const int w = src.w;
+    const int h = src.h;
+    const int outw = dst.w;
+    const int outh = dst.h;
+
+    typename V::vec _v = V::set1(v);
+
+    const float* ptr = src;
+    float* outptr = dst;
+
+    for (int y=0; y<outh; y++)
+    {
+        int sy = y - top;
+        if (type == 0 && (sy < 0 || sy >= h))
+        {
+            for (int x=0; x<outw; x++)
+            {
+                V::store(outptr + x * L, _v);
+            }
+            outptr += outw * L;
+            continue;
+        }
+
+        const float* row = ptr + border_index(sy, h, type) * w * L;
+
+        int x = 0;
+        for (; x<left; x++)
+        {
+            V::store(outptr + x * L, type == 0 ? _v : V::load(row + border_index(x - left, w, type) * L));
+        }
+        memcpy(outptr + x * L, row, w * L * sizeof(float));
+        x += w;
+        for (; x<outw; x++)
+        {
+            V::store(outptr + x * L, type == 0 ? _v : V::load(row + border_index(x - left, w, type) * L));
+        }
+
+        outptr += outw * L;
+    }
+}
+#endif // __SSE2__
+
+int Padding_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    if (top == 0 && bottom == 0 && left == 0 && right == 0)
+    {
+        top_blob = bottom_blob;
+        return 0;
+    }
+
+    int elempack = bottom_blob.elempack;
+    if (elempack == 1)
+        return Padding::forward(bottom_blob, top_blob, opt);
+
+    // only the spatial axes of a packed blob can be padded in place
+    if (bottom_blob.dims != 3 || bottom_blob.elemsize != 4u * elempack || !x86_elempack_supported(elempack))
+    {
+        Mat bottom_blob_unpacked;
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt);
+        return Padding::forward(bottom_blob_unpacked, top_blob, opt);
+    }
+
+#if __SSE2__
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+
+    int outw = w + left + right;
+    int outh = h + top + bottom;
+
+    top_blob.create(outw, outh, channels, bottom_blob.elemsize, elempack, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const Mat m = bottom_blob.channel(q);
+        Mat borderm = top_blob.channel(q);
+
+#if __AVX__
+        if (elempack == 8)
+        {
+            copy_make_border_pack<pack8_avx>(m, borderm, top, left, type, value);
+            continue;
+        }
+#endif // __AVX__
+        copy_make_border_pack<pack4_sse>(m, borderm, top, left, type, value);
+    }
+#endif // __SSE2__
+
+    return 0;
+}
+
+} // namespace ncnn
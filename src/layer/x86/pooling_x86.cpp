@@ -0,0 +1,295 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "pooling_x86.h"
+
+#include <float.h>
+
+#include "x86_usability.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Pooling_x86)
+
+Pooling_x86::Pooling_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+#if __SSE2__
+template<typename V>
+static void pooling_global_pack(const Mat& bottom_blob, Mat& top_blob, int pooling_type, const Option& opt)
+{
+    const int L = V::lanes;
+    const int channels = bottom_blob.c;
+    const int size = bottom_blob.w * bottom_blob.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const float* ptr = bottom_blob.channel(q);
+
+        typename V::vec _r = V::load(ptr);
+        if (pooling_type == Pooling::PoolMethod_MAX)
+        {
+            for (int i=1; i<size; i++)
+            {
+                _r = V::max(_r, V::load(ptr + i * L));
+            }
+        }
+        else
+        {
+            for (int i=1; i<size; i++)
+            {
+                _r = V::add(_r, V::load(ptr + i * L));
+            }
+            _r = V::div(_r, V::set1((float)size));
+        }
+
+        V::store((float*)top_blob + q * L, _r);
+    }
+}
+
+template<typename V>
+static void pooling_pack(const Mat& bottom_blob_bordered, Mat& top_blob, int pooling_type, int stride_w, int stride_h, const int* space_ofs, int maxk, const Option& opt)
+{
+    const int L = V::lanes;
+    const int w = bottom_blob_bordered.w;
+    const int channels = top_blob.c;
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const float* ptr = bottom_blob_bordered.channel(q);
+        float* outptr = top_blob.channel(q);
+
+        for (int i = 0; i < outh; i++)
+        {
+            for (int j = 0; j < outw; j++)
+            {
+                const float* sptr = ptr + (i * stride_h * w + j * stride_w) * L;
+
+                typename V::vec _r = V::load(sptr);
+                if (pooling_type == Pooling::PoolMethod_MAX)
+                {
+                    for (int k = 1; k < maxk; k++)
+                    {
+                        _r = V::max(_r, V::load(sptr + space_ofs[k] * L));
+                    }
+                }
+                else
+                {
+                    for (int k = 1; k < maxk; k++)
+                    {
+                        _r = V::add(_r, V::load(sptr + space_ofs[k] * L));
+                    }
+                    _r = V::div(_r, V::set1((float)maxk));
+                }
+
+                V::store(outptr + j * L, _r);
+            }
+
+            outptr += outw * L;
+        }
+    }
+}
+#endif // __SSE2__
+
+int Pooling_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    int elempack = bottom_blob.elempack;
+    if (elempack == 1)
+        return Pooling::forward(bottom_blob, top_blob, opt);
+
+    if (bottom_blob.dims != 3 || bottom_blob.elemsize != 4u * elempack || !x86_elempack_supported(elempack))
+    {
+        Mat bottom_blob_unpacked;
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt);
+        return Pooling::forward(bottom_blob_unpacked, top_blob, opt);
+    }
+
+#if __SSE2__
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    if (global_pooling)
+    {
+        top_blob.create(channels, elemsize, elempack, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+#if __AVX__
+        if (elempack == 8)
+        {
+            pooling_global_pack<pack8_avx>(bottom_blob, top_blob, pooling_type, opt);
+            return 0;
+        }
+#endif // __AVX__
+        pooling_global_pack<pack4_sse>(bottom_blob, top_blob, pooling_type, opt);
+        return 0;
+    }
+
+    Mat bottom_blob_bordered = bottom_blob;
+
+    float pad_value = pooling_type == PoolMethod_MAX ? -FLT_MAX : 0.f;
+
+    int wtailpad = 0;
+    int htailpad = 0;
+
+    Option opt_b = opt;
+    opt_b.blob_allocator = opt.workspace_allocator;
+
+    if (pad_mode == 0) // full padding
+    {
+        int wtail = (w + pad_left + pad_right - kernel_w) % stride_w;
+        int htail = (h + pad_top + pad_bottom - kernel_h) % stride_h;
+
+        if (wtail != 0)
+            wtailpad = stride_w - wtail;
+        if (htail != 0)
+            htailpad = stride_h - htail;
+
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_top, pad_bottom + htailpad, pad_left, pad_right + wtailpad, BORDER_CONSTANT, pad_value, opt_b);
+    }
+    else if (pad_mode == 1) // valid padding
+    {
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, pad_value, opt_b);
+    }
+    else if (pad_mode == 2) // tensorflow padding=SAME or onnx padding=SAME_UPPER
+    {
+        int wpad = kernel_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+            copy_make_border(bottom_blob, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
+    }
+    else if (pad_mode == 3) // onnx padding=SAME_LOWER
+    {
+        int wpad = kernel_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+            copy_make_border(bottom_blob, bottom_blob_bordered, hpad - hpad / 2, hpad / 2, wpad - wpad / 2, wpad / 2, BORDER_CONSTANT, pad_value, opt_b);
+    }
+    if (bottom_blob_bordered.empty())
+        return -100;
+
+    w = bottom_blob_bordered.w;
+    h = bottom_blob_bordered.h;
+
+    int outw = (w - kernel_w) / stride_w + 1;
+    int outh = (h - kernel_h) / stride_h + 1;
+
+    top_blob.create(outw, outh, channels, elemsize, elempack, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const int maxk = kernel_w * kernel_h;
+
+    // kernel offsets in packed elements
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    {
+        int p1 = 0;
+        int p2 = 0;
+        int gap = w - kernel_w;
+        for (int i = 0; i < kernel_h; i++)
+        {
+            for (int j = 0; j < kernel_w; j++)
+            {
+                space_ofs[p1] = p2;
+                p1++;
+                p2++;
+            }
+            p2 += gap;
+        }
+    }
+
+#if __AVX__
+    if (elempack == 8)
+        pooling_pack<pack8_avx>(bottom_blob_bordered, top_blob, pooling_type, stride_w, stride_h, space_ofs, maxk, opt);
+    else
+#endif // __AVX__
+        pooling_pack<pack4_sse>(bottom_blob_bordered, top_blob, pooling_type, stride_w, stride_h, space_ofs, maxk, opt);
+
+    if (pooling_type == PoolMethod_AVE && avgpool_count_include_pad == 0)
+    {
+        // fix pad, lanes of the border elements share one scale
+        const int L = elempack;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            Mat m = top_blob.channel(q);
+
+            if (pad_top != 0)
+            {
+                const float scale = (float)kernel_h / (kernel_h - pad_top);
+
+                float* outptr = m.row(0);
+                for (int i = 0; i < outw * L; i++)
+                {
+                    outptr[i] *= scale;
+                }
+            }
+            if (pad_bottom + htailpad != 0)
+            {
+                const float scale = (float)kernel_h / (kernel_h - pad_bottom - htailpad);
+
+                float* outptr = (float*)m + (outh - 1) * outw * L;
+                for (int i = 0; i < outw * L; i++)
+                {
+                    outptr[i] *= scale;
+                }
+            }
+            if (pad_left != 0)
+            {
+                const float scale = (float)kernel_w / (kernel_w - pad_left);
+
+                float* outptr = m;
+                for (int i = 0; i < outh; i++)
+                {
+                    for (int l = 0; l < L; l++)
+                    {
+                        outptr[l] *= scale;
+                    }
+                    outptr += outw * L;
+                }
+            }
+            if (pad_right + wtailpad != 0)
+            {
+                const float scale = (float)kernel_w / (kernel_w - pad_right - wtailpad);
+
+                float* outptr = (float*)m + (outw - 1) * L;
+                for (int i = 0; i < outh; i++)
+                {
+                    for (int l = 0; l < L; l++)
+                    {
+                        outptr[l] *= scale;
+                    }
+                    outptr += outw * L;
+                }
+            }
+        }
+    }
+#endif // __SSE2__
+
+    return 0;
+}
+
+} // namespace ncnn
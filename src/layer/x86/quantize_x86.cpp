@@ -0,0 +1,112 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "quantize_x86.h"
+
+#include <math.h>
+
+#include "x86_usability.h"
+
+namespace ncnn {
+
+#include "x86_int8.h"
+
+DEFINE_LAYER_CREATOR(Quantize_x86)
+
+static inline signed char float2int8(float v)
+{
+    int int32 = round(v);
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
+}
+
+static void quantize_row(const float* ptr, signed char* outptr, int size, float s, float zp)
+{
+    int i = 0;
+#if __SSE2__
+    __m128 _s = _mm_set1_ps(s);
+    __m128 _zp = _mm_set1_ps(zp);
+    for (; i+15<size; i+=16)
+    {
+        __m128 _v0 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ptr), _s), _zp);
+        __m128 _v1 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ptr + 4), _s), _zp);
+        __m128 _v2 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ptr + 8), _s), _zp);
+        __m128 _v3 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ptr + 12), _s), _zp);
+        _mm_storeu_si128((__m128i*)outptr, float2int8_sse(_v0, _v1, _v2, _v3));
+
+        ptr += 16;
+        outptr += 16;
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        *outptr++ = float2int8(*ptr++ * s + zp);
+    }
+}
+
+int Quantize_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    int dims = bottom_blob.dims;
+
+    if (dims == 1)
+        return Quantize::forward(bottom_blob, top_blob, opt);
+
+    if (scale_data_size > 1 && scale_data_size != (dims == 2 ? bottom_blob.h : bottom_blob.c))
+        return -100;
+
+    const float zp = (float)zero_point;
+
+    if (dims == 2)
+    {
+        int w = bottom_blob.w;
+        int h = bottom_blob.h;
+
+        top_blob.create(w, h, (size_t)1u, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i=0; i<h; i++)
+        {
+            const float s = scale_data_size > 1 ? scale_data[i] : scale;
+
+            quantize_row(bottom_blob.row(i), top_blob.row<signed char>(i), w, s, zp);
+        }
+    }
+
+    if (dims == 3)
+    {
+        int w = bottom_blob.w;
+        int h = bottom_blob.h;
+        int channels = bottom_blob.c;
+        int size = w * h;
+
+        top_blob.create(w, h, channels, (size_t)1u, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const float s = scale_data_size > 1 ? scale_data[q] : scale;
+
+            quantize_row(bottom_blob.channel(q), top_blob.channel(q), size, s, zp);
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
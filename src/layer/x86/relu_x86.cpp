@@ -0,0 +1,83 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "relu_x86.h"
+
+#include "x86_usability.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(ReLU_x86)
+
+ReLU_x86::ReLU_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+int ReLU_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    if (bottom_top_blob.elemsize == 1u)
+        return ReLU::forward_inplace_int8(bottom_top_blob, opt);
+
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int channels = bottom_top_blob.c;
+    // lanes of a packed element are independent
+    int size = w * h * bottom_top_blob.elempack;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = bottom_top_blob.channel(q);
+
+        int i = 0;
+#if __AVX__
+        __m256 _zero8 = _mm256_setzero_ps();
+        __m256 _slope8 = _mm256_set1_ps(slope);
+        for (; i+7<size; i+=8)
+        {
+            __m256 _p = _mm256_loadu_ps(ptr + i);
+            if (slope == 0.f)
+                _p = _mm256_max_ps(_p, _zero8);
+            else
+                _p = pack8_avx::fmadd(_slope8, _mm256_min_ps(_p, _zero8), _mm256_max_ps(_p, _zero8));
+            _mm256_storeu_ps(ptr + i, _p);
+        }
+#endif // __AVX__
+#if __SSE2__
+        __m128 _zero = _mm_setzero_ps();
+        __m128 _slope = _mm_set1_ps(slope);
+        for (; i+3<size; i+=4)
+        {
+            __m128 _p = _mm_loadu_ps(ptr + i);
+            if (slope == 0.f)
+                _p = _mm_max_ps(_p, _zero);
+            else
+                _p = _mm_add_ps(_mm_mul_ps(_slope, _mm_min_ps(_p, _zero)), _mm_max_ps(_p, _zero));
+            _mm_storeu_ps(ptr + i, _p);
+        }
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            if (ptr[i] < 0)
+                ptr[i] *= slope;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,474 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// int8 dot products shared by the x86 layers, int32 accumulation
+//
+// avx512 vnni  vpdpbusd multiplies u8 by s8, four products into each int32
+//              the s8 input is offset by 128 to u8 and 128 * sum(weight) is taken off again
+// avx2         vpmaddubsw on |input| and the weight with the input sign, vpmaddwd sums the pairs
+//              |input| <= 128 and |weight| <= 127 keep the int16 pair sum from saturating
+// sse2         vpmaddwd on sign extended int16, two products into each int32
+//
+// every path is exact, results match the scalar loop bit for bit
+
+#if __AVX512VNNI__ && __AVX512VL__
+#define X86_INT8_VNNI 1
+#endif
+
+#if __SSE2__ && !__AVX2__
+// sign extend the low 8 bytes to int16
+static inline __m128i int8_to_int16_sse(__m128i _v)
+{
+    return _mm_srai_epi16(_mm_unpacklo_epi8(_v, _v), 8);
+}
+#endif // __SSE2__ && !__AVX2__
+
+#if __SSE2__
+// round half away from zero and clamp to [-127, 127], the same as the scalar float2int8
+static inline __m128i float2int32_sse(__m128 _v)
+{
+    _v = _mm_min_ps(_mm_max_ps(_v, _mm_set1_ps(-127.f)), _mm_set1_ps(127.f));
+
+    __m128i _r = _mm_cvttps_epi32(_v);
+    __m128 _frac = _mm_sub_ps(_v, _mm_cvtepi32_ps(_r));
+
+    // the compare masks are -1
+    _r = _mm_sub_epi32(_r, _mm_castps_si128(_mm_cmpge_ps(_frac, _mm_set1_ps(0.5f))));
+    _r = _mm_add_epi32(_r, _mm_castps_si128(_mm_cmple_ps(_frac, _mm_set1_ps(-0.5f))));
+    return _r;
+}
+
+// 16 floats to 16 int8
+static inline __m128i float2int8_sse(__m128 _v0, __m128 _v1, __m128 _v2, __m128 _v3)
+{
+    __m128i _r01 = _mm_packs_epi32(float2int32_sse(_v0), float2int32_sse(_v1));
+    __m128i _r23 = _mm_packs_epi32(float2int32_sse(_v2), float2int32_sse(_v3));
+    return _mm_packs_epi16(_r01, _r23);
+}
+#endif // __SSE2__
+
+// sum of a[i] * b[i], i < n
+static inline int int8_dot(const signed char* a, const signed char* b, int n)
+{
+    int sum = 0;
+    int i = 0;
+
+#if X86_INT8_VNNI
+    {
+        const __m256i _v128 = _mm256_set1_epi8((char)0x80);
+        __m256i _sum = _mm256_setzero_si256();
+        __m256i _comp = _mm256_setzero_si256();
+        for (; i+31<n; i+=32)
+        {
+            __m256i _a = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)), _v128);
+            __m256i _b = _mm256_loadu_si256((const __m256i*)(b + i));
+            _sum = _mm256_dpbusd_epi32(_sum, _a, _b);
+            _comp = _mm256_dpbusd_epi32(_comp, _v128, _b);
+        }
+        _sum = _mm256_sub_epi32(_sum, _comp);
+        __m128i _s = _mm_add_epi32(_mm256_castsi256_si128(_sum), _mm256_extracti128_si256(_sum, 1));
+        _s = _mm_add_epi32(_s, _mm_shuffle_epi32(_s, _MM_SHUFFLE(1, 0, 3, 2)));
+        _s = _mm_add_epi32(_s, _mm_shuffle_epi32(_s, _MM_SHUFFLE(2, 3, 0, 1)));
+        sum += _mm_cvtsi128_si32(_s);
+    }
+#endif // X86_INT8_VNNI
+
+#if __AVX2__
+    {
+        __m256i _sum = _mm256_setzero_si256();
+        for (; i+15<n; i+=16)
+        {
+            __m256i _a = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(a + i)));
+            __m256i _b = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(b + i)));
+            _sum = _mm256_add_epi32(_sum, _mm256_madd_epi16(_a, _b));
+        }
+        __m128i _s = _mm_add_epi32(_mm256_castsi256_si128(_sum), _mm256_extracti128_si256(_sum, 1));
+        _s = _mm_add_epi32(_s, _mm_shuffle_epi32(_s, _MM_SHUFFLE(1, 0, 3, 2)));
+        _s = _mm_add_epi32(_s, _mm_shuffle_epi32(_s, _MM_SHUFFLE(2, 3, 0, 1)));
+        sum += _mm_cvtsi128_si32(_s);
+    }
+#elif __SSE2__
+    {
+        __m128i _sum = _mm_setzero_si128();
+        for (; i+7<n; i+=8)
+        {
+            __m128i _a = int8_to_int16_sse(_mm_loadl_epi64((const __m128i*)(a + i)));
+            __m128i _b = int8_to_int16_sse(_mm_loadl_epi64((const __m128i*)(b + i)));
+            _sum = _mm_add_epi32(_sum, _mm_madd_epi16(_a, _b));
+        }
+        _sum = _mm_add_epi32(_sum, _mm_shuffle_epi32(_sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        _sum = _mm_add_epi32(_sum, _mm_shuffle_epi32(_sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        sum += _mm_cvtsi128_si32(_sum);
+    }
+#endif // __AVX2__
+
+    for (; i<n; i++)
+    {
+        sum += (int)a[i] * b[i];
+    }
+
+    return sum;
+}
+
+// int8 sgemm, 8 output channels by 16 output pixels per block
+//
+//   kernel_tm  channel g  output channels 8g .. 8g+7
+//              [K/4][8][4] s8 weights, then 8 int32 of 128 * sum(weight)
+//   bottom_tm  channel j  output pixels 16j .. 16j+15
+//              [K/4][16][4] u8, the s8 input offset by 128
+//
+// K is padded to a multiple of 4 and outch to a multiple of 8 with zero weights
+// so every k quad is one int32 lane of vpdpbusd and the sums land one pixel per lane
+// the kernel is packed once in create_pipeline, the input once per forward
+
+static void int8_gemm_transform_kernel(const signed char* kernel, Mat& kernel_tm, int K, int outch)
+{
+    const int Kq = (K + 3) / 4;
+
+    kernel_tm.create(Kq * 32 + 32, 1, (outch + 7) / 8, (size_t)1u);
+
+    for (int g=0; g<kernel_tm.c; g++)
+    {
+        signed char* kptr = kernel_tm.channel(g);
+        int* comp = (int*)(kptr + Kq * 32);
+
+        for (int r=0; r<8; r++)
+        {
+            const int p = g * 8 + r;
+            const signed char* k0 = kernel + (size_t)p * K;
+
+            int sum = 0;
+            for (int k=0; k<Kq*4; k++)
+            {
+                signed char v = p < outch && k < K ? k0[k] : 0;
+                kptr[(k / 4) * 32 + r * 4 + k % 4] = v;
+                sum += v;
+            }
+
+            comp[r] = 128 * sum;
+        }
+    }
+}
+
+// bottom_im2col row k holds the N input values of k
+static void int8_gemm_pack_input(const Mat& bottom_im2col, Mat& bottom_tm, int K, int N, const Option& opt)
+{
+    const int Kq = (K + 3) / 4;
+    const int nn = (N + 15) / 16;
+
+    bottom_tm.create(Kq * 64, 1, nn, (size_t)1u, opt.workspace_allocator);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int jj=0; jj<nn; jj++)
+    {
+        const int j = jj * 16;
+        const int n = std::min(N - j, 16);
+
+        unsigned char* outptr = bottom_tm.channel(jj);
+
+        int kq = 0;
+#if __SSE2__
+        if (n == 16)
+        {
+            const __m128i _v128 = _mm_set1_epi8((char)0x80);
+            for (; kq*4+3<K; kq++)
+            {
+                __m128i _r0 = _mm_loadu_si128((const __m128i*)((const signed char*)bottom_im2col.channel(kq*4) + j));
+                __m128i _r1 = _mm_loadu_si128((const __m128i*)((const signed char*)bottom_im2col.channel(kq*4+1) + j));
+                __m128i _r2 = _mm_loadu_si128((const __m128i*)((const signed char*)bottom_im2col.channel(kq*4+2) + j));
+                __m128i _r3 = _mm_loadu_si128((const __m128i*)((const signed char*)bottom_im2col.channel(kq*4+3) + j));
+
+                __m128i _r01l = _mm_unpacklo_epi8(_r0, _r1);
+                __m128i _r01h = _mm_unpackhi_epi8(_r0, _r1);
+                __m128i _r23l = _mm_unpacklo_epi8(_r2, _r3);
+                __m128i _r23h = _mm_unpackhi_epi8(_r2, _r3);
+
+                _mm_storeu_si128((__m128i*)outptr, _mm_xor_si128(_mm_unpacklo_epi16(_r01l, _r23l), _v128));
+                _mm_storeu_si128((__m128i*)(outptr + 16), _mm_xor_si128(_mm_unpackhi_epi16(_r01l, _r23l), _v128));
+                _mm_storeu_si128((__m128i*)(outptr + 32), _mm_xor_si128(_mm_unpacklo_epi16(_r01h, _r23h), _v128));
+                _mm_storeu_si128((__m128i*)(outptr + 48), _mm_xor_si128(_mm_unpackhi_epi16(_r01h, _r23h), _v128));
+
+                outptr += 64;
+            }
+        }
+#endif // __SSE2__
+
+        // partial block and k tail, the padding is input 0
+        for (; kq<Kq; kq++)
+        {
+            for (int t=0; t<4; t++)
+            {
+                const int k = kq * 4 + t;
+                const signed char* r0 = k < K ? (const signed char*)bottom_im2col.channel(k) + j : 0;
+
+                for (int x=0; x<16; x++)
+                {
+                    outptr[x * 4 + t] = (unsigned char)((r0 && x < n ? r0[x] : 0) + 128);
+                }
+            }
+
+            outptr += 64;
+        }
+    }
+}
+
+// sum[r * 32 + x] = output channel r of the kernel block dot output pixel x of the bottom block
+static inline void int8_gemm_8x16(const signed char* kptr, const unsigned char* bptr, int Kq, int* sum)
+{
+#if X86_INT8_VNNI
+    __m512i _sum0 = _mm512_setzero_si512();
+    __m512i _sum1 = _mm512_setzero_si512();
+    __m512i _sum2 = _mm512_setzero_si512();
+    __m512i _sum3 = _mm512_setzero_si512();
+    __m512i _sum4 = _mm512_setzero_si512();
+    __m512i _sum5 = _mm512_setzero_si512();
+    __m512i _sum6 = _mm512_setzero_si512();
+    __m512i _sum7 = _mm512_setzero_si512();
+
+    const int* kp = (const int*)kptr;
+    for (int kq=0; kq<Kq; kq++)
+    {
+        __m512i _b = _mm512_loadu_si512((const __m512i*)bptr);
+
+        _sum0 = _mm512_dpbusd_epi32(_sum0, _b, _mm512_set1_epi32(kp[0]));
+        _sum1 = _mm512_dpbusd_epi32(_sum1, _b, _mm512_set1_epi32(kp[1]));
+        _sum2 = _mm512_dpbusd_epi32(_sum2, _b, _mm512_set1_epi32(kp[2]));
+        _sum3 = _mm512_dpbusd_epi32(_sum3, _b, _mm512_set1_epi32(kp[3]));
+        _sum4 = _mm512_dpbusd_epi32(_sum4, _b, _mm512_set1_epi32(kp[4]));
+        _sum5 = _mm512_dpbusd_epi32(_sum5, _b, _mm512_set1_epi32(kp[5]));
+        _sum6 = _mm512_dpbusd_epi32(_sum6, _b, _mm512_set1_epi32(kp[6]));
+        _sum7 = _mm512_dpbusd_epi32(_sum7, _b, _mm512_set1_epi32(kp[7]));
+
+        kp += 8;
+        bptr += 64;
+    }
+
+    // take the input offset off again
+    _mm512_storeu_si512((__m512i*)(sum + 0), _mm512_sub_epi32(_sum0, _mm512_set1_epi32(kp[0])));
+    _mm512_storeu_si512((__m512i*)(sum + 32), _mm512_sub_epi32(_sum1, _mm512_set1_epi32(kp[1])));
+    _mm512_storeu_si512((__m512i*)(sum + 64), _mm512_sub_epi32(_sum2, _mm512_set1_epi32(kp[2])));
+    _mm512_storeu_si512((__m512i*)(sum + 96), _mm512_sub_epi32(_sum3, _mm512_set1_epi32(kp[3])));
+    _mm512_storeu_si512((__m512i*)(sum + 128), _mm512_sub_epi32(_sum4, _mm512_set1_epi32(kp[4])));
+    _mm512_storeu_si512((__m512i*)(sum + 160), _mm512_sub_epi32(_sum5, _mm512_set1_epi32(kp[5])));
+    _mm512_storeu_si512((__m512i*)(sum + 192), _mm512_sub_epi32(_sum6, _mm512_set1_epi32(kp[6])));
+    _mm512_storeu_si512((__m512i*)(sum + 224), _mm512_sub_epi32(_sum7, _mm512_set1_epi32(kp[7])));
+#elif __AVX2__
+    const __m256i _v128 = _mm256_set1_epi8((char)0x80);
+    const __m256i _one = _mm256_set1_epi16(1);
+
+    // 8 output pixels at a time
+    for (int h=0; h<2; h++)
+    {
+        __m256i _sum0 = _mm256_setzero_si256();
+        __m256i _sum1 = _mm256_setzero_si256();
+        __m256i _sum2 = _mm256_setzero_si256();
+        __m256i _sum3 = _mm256_setzero_si256();
+        __m256i _sum4 = _mm256_setzero_si256();
+        __m256i _sum5 = _mm256_setzero_si256();
+        __m256i _sum6 = _mm256_setzero_si256();
+        __m256i _sum7 = _mm256_setzero_si256();
+
+        const int* kp = (const int*)kptr;
+        const unsigned char* bp = bptr + h * 32;
+        for (int kq=0; kq<Kq; kq++)
+        {
+            __m256i _b = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)bp), _v128);
+            __m256i _babs = _mm256_abs_epi8(_b);
+
+#define INT8_GEMM_AVX2_ROW(r) \
+            _sum##r = _mm256_add_epi32(_sum##r, _mm256_madd_epi16(_mm256_maddubs_epi16(_babs, _mm256_sign_epi8(_mm256_set1_epi32(kp[r]), _b)), _one));
+
+            INT8_GEMM_AVX2_ROW(0)
+            INT8_GEMM_AVX2_ROW(1)
+            INT8_GEMM_AVX2_ROW(2)
+            INT8_GEMM_AVX2_ROW(3)
+            INT8_GEMM_AVX2_ROW(4)
+            INT8_GEMM_AVX2_ROW(5)
+            INT8_GEMM_AVX2_ROW(6)
+            INT8_GEMM_AVX2_ROW(7)
+
+#undef INT8_GEMM_AVX2_ROW
+
+            kp += 8;
+            bp += 64;
+        }
+
+        _mm256_storeu_si256((__m256i*)(sum + h * 8), _sum0);
+        _mm256_storeu_si256((__m256i*)(sum + 32 + h * 8), _sum1);
+        _mm256_storeu_si256((__m256i*)(sum + 64 + h * 8), _sum2);
+        _mm256_storeu_si256((__m256i*)(sum + 96 + h * 8), _sum3);
+        _mm256_storeu_si256((__m256i*)(sum + 128 + h * 8), _sum4);
+        _mm256_storeu_si256((__m256i*)(sum + 160 + h * 8), _sum5);
+        _mm256_storeu_si256((__m256i*)(sum + 192 + h * 8), _sum6);
+        _mm256_storeu_si256((__m256i*)(sum + 224 + h * 8), _sum7);
+    }
+#elif __SSE2__
+    const __m128i _v128 = _mm_set1_epi8((char)0x80);
+
+    // 4 output pixels and 4 output channels at a time
+    for (int h=0; h<4; h++)
+    {
+        for (int rh=0; rh<2; rh++)
+        {
+            __m128i _sum00 = _mm_setzero_si128();
+            __m128i _sum01 = _mm_setzero_si128();
+            __m128i _sum10 = _mm_setzero_si128();
+            __m128i _sum11 = _mm_setzero_si128();
+            __m128i _sum20 = _mm_setzero_si128();
+            __m128i _sum21 = _mm_setzero_si128();
+            __m128i _sum30 = _mm_setzero_si128();
+            __m128i _sum31 = _mm_setzero_si128();
+
+            const signed char* kp = kptr + rh * 16;
+            const unsigned char* bp = bptr + h * 16;
+            for (int kq=0; kq<Kq; kq++)
+            {
+                // pixels 0 1 and 2 3, k quad each
+                __m128i _b = _mm_xor_si128(_mm_loadu_si128((const __m128i*)bp), _v128);
+                __m128i _b01 = int8_to_int16_sse(_b);
+                __m128i _b23 = int8_to_int16_sse(_mm_unpackhi_epi64(_b, _b));
+
+                // output channels 0 1 and 2 3, k quad each
+                __m128i _k = _mm_loadu_si128((const __m128i*)kp);
+                __m128i _k01 = int8_to_int16_sse(_k);
+                __m128i _k23 = int8_to_int16_sse(_mm_unpackhi_epi64(_k, _k));
+
+                __m128i _k0 = _mm_shuffle_epi32(_k01, _MM_SHUFFLE(1, 0, 1, 0));
+                __m128i _k1 = _mm_shuffle_epi32(_k01, _MM_SHUFFLE(3, 2, 3, 2));
+                __m128i _k2 = _mm_shuffle_epi32(_k23, _MM_SHUFFLE(1, 0, 1, 0));
+                __m128i _k3 = _mm_shuffle_epi32(_k23, _MM_SHUFFLE(3, 2, 3, 2));
+
+                _sum00 = _mm_add_epi32(_sum00, _mm_madd_epi16(_b01, _k0));
+                _sum01 = _mm_add_epi32(_sum01, _mm_madd_epi16(_b23, _k0));
+                _sum10 = _mm_add_epi32(_sum10, _mm_madd_epi16(_b01, _k1));
+                _sum11 = _mm_add_epi32(_sum11, _mm_madd_epi16(_b23, _k1));
+                _sum20 = _mm_add_epi32(_sum20, _mm_madd_epi16(_b01, _k2));
+                _sum21 = _mm_add_epi32(_sum21, _mm_madd_epi16(_b23, _k2));
+                _sum30 = _mm_add_epi32(_sum30, _mm_madd_epi16(_b01, _k3));
+                _sum31 = _mm_add_epi32(_sum31, _mm_madd_epi16(_b23, _k3));
+
+                kp += 32;
+                bp += 64;
+            }
+
+            // each pixel holds the k01 and k23 partial sums side by side
+#define INT8_GEMM_SSE2_STORE(r) \
+            { \
+                __m128 _lo = _mm_castsi128_ps(_sum##r##0); \
+                __m128 _hi = _mm_castsi128_ps(_sum##r##1); \
+                __m128i _even = _mm_castps_si128(_mm_shuffle_ps(_lo, _hi, _MM_SHUFFLE(2, 0, 2, 0))); \
+                __m128i _odd = _mm_castps_si128(_mm_shuffle_ps(_lo, _hi, _MM_SHUFFLE(3, 1, 3, 1))); \
+                _mm_storeu_si128((__m128i*)(sum + (rh * 4 + r) * 32 + h * 4), _mm_add_epi32(_even, _odd)); \
+            }
+
+            INT8_GEMM_SSE2_STORE(0)
+            INT8_GEMM_SSE2_STORE(1)
+            INT8_GEMM_SSE2_STORE(2)
+            INT8_GEMM_SSE2_STORE(3)
+
+#undef INT8_GEMM_SSE2_STORE
+        }
+    }
+#else
+    for (int r=0; r<8; r++)
+    {
+        for (int x=0; x<16; x++)
+        {
+            int s = 0;
+            for (int kq=0; kq<Kq; kq++)
+            {
+                for (int t=0; t<4; t++)
+                {
+                    s += (int)kptr[kq * 32 + r * 4 + t] * ((int)bptr[kq * 64 + x * 4 + t] - 128);
+                }
+            }
+            sum[r * 32 + x] = s;
+        }
+    }
+#endif // X86_INT8_VNNI
+}
+
+// two bottom blocks side by side, 8 output channels by 32 output pixels
+static inline void int8_gemm_8x32(const signed char* kptr, const unsigned char* bptr0, const unsigned char* bptr1, int Kq, int* sum)
+{
+#if X86_INT8_VNNI
+    __m512i _sum00 = _mm512_setzero_si512();
+    __m512i _sum01 = _mm512_setzero_si512();
+    __m512i _sum10 = _mm512_setzero_si512();
+    __m512i _sum11 = _mm512_setzero_si512();
+    __m512i _sum20 = _mm512_setzero_si512();
+    __m512i _sum21 = _mm512_setzero_si512();
+    __m512i _sum30 = _mm512_setzero_si512();
+    __m512i _sum31 = _mm512_setzero_si512();
+    __m512i _sum40 = _mm512_setzero_si512();
+    __m512i _sum41 = _mm512_setzero_si512();
+    __m512i _sum50 = _mm512_setzero_si512();
+    __m512i _sum51 = _mm512_setzero_si512();
+    __m512i _sum60 = _mm512_setzero_si512();
+    __m512i _sum61 = _mm512_setzero_si512();
+    __m512i _sum70 = _mm512_setzero_si512();
+    __m512i _sum71 = _mm512_setzero_si512();
+
+    const int* kp = (const int*)kptr;
+    for (int kq=0; kq<Kq; kq++)
+    {
+        __m512i _b0 = _mm512_loadu_si512((const __m512i*)bptr0);
+        __m512i _b1 = _mm512_loadu_si512((const __m512i*)bptr1);
+
+#define INT8_GEMM_VNNI_ROW(r) \
+        { \
+            __m512i _k = _mm512_set1_epi32(kp[r]); \
+            _sum##r##0 = _mm512_dpbusd_epi32(_sum##r##0, _b0, _k); \
+            _sum##r##1 = _mm512_dpbusd_epi32(_sum##r##1, _b1, _k); \
+        }
+
+        INT8_GEMM_VNNI_ROW(0)
+        INT8_GEMM_VNNI_ROW(1)
+        INT8_GEMM_VNNI_ROW(2)
+        INT8_GEMM_VNNI_ROW(3)
+        INT8_GEMM_VNNI_ROW(4)
+        INT8_GEMM_VNNI_ROW(5)
+        INT8_GEMM_VNNI_ROW(6)
+        INT8_GEMM_VNNI_ROW(7)
+
+#undef INT8_GEMM_VNNI_ROW
+
+        kp += 8;
+        bptr0 += 64;
+        bptr1 += 64;
+    }
+
+    // take the input offset off again
+#define INT8_GEMM_VNNI_STORE(r) \
+    { \
+        __m512i _comp = _mm512_set1_epi32(kp[r]); \
+        _mm512_storeu_si512((__m512i*)(sum + r * 32), _mm512_sub_epi32(_sum##r##0, _comp)); \
+        _mm512_storeu_si512((__m512i*)(sum + r * 32 + 16), _mm512_sub_epi32(_sum##r##1, _comp)); \
+    }
+
+    INT8_GEMM_VNNI_STORE(0)
+    INT8_GEMM_VNNI_STORE(1)
+    INT8_GEMM_VNNI_STORE(2)
+    INT8_GEMM_VNNI_STORE(3)
+    INT8_GEMM_VNNI_STORE(4)
+    INT8_GEMM_VNNI_STORE(5)
+    INT8_GEMM_VNNI_STORE(6)
+    INT8_GEMM_VNNI_STORE(7)
+
+#undef INT8_GEMM_VNNI_STORE
+#else
+    int8_gemm_8x16(kptr, bptr0, Kq, sum);
+    int8_gemm_8x16(kptr, bptr1, Kq, sum + 16);
+#endif // X86_INT8_VNNI
+}
@@ -0,0 +1,460 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// packed sgemm shared by the x86 layers, C = A * B + bias
+//
+//   A  M x K, packed once into panels of 8 rows, K x 8 each, rows past M are zero
+//   B  K x N, packed on the fly into panels of V::lanes columns, K x lanes each
+//      the columns after the last full panel are packed one by one
+//   C  M x N, row i at C + i * ldc
+//
+// a block of sgemm_kc x sgemm_nc B values stays in L2
+// while the kc x 8 slice of every A panel runs across it from L1
+
+// rows of B packed per block
+static const int sgemm_kc = 256;
+// columns of B packed per block, a multiple of every lanes count
+static const int sgemm_nc = 128;
+
+static void sgemm_transform_a(const float* A, int lda, Mat& A_tm, int M, int K)
+{
+    const int nn_panels = (M + 7) / 8;
+
+    A_tm.create(8 * K, nn_panels);
+    A_tm.fill(0.f);
+
+    for (int pp=0; pp<nn_panels; pp++)
+    {
+        float* ktmp = A_tm.row(pp);
+
+        for (int i=0; i<8 && pp * 8 + i < M; i++)
+        {
+            const float* k0 = A + (pp * 8 + i) * lda;
+
+            for (int k=0; k<K; k++)
+            {
+                ktmp[k * 8 + i] = k0[k];
+            }
+        }
+    }
+}
+
+// copy lanes floats, the constant sizes let the compiler use vector moves
+static inline void sgemm_copy_lanes(float* dst, const float* src, int lanes)
+{
+    switch (lanes)
+    {
+    case 16:
+        memcpy(dst, src, 16 * sizeof(float));
+        break;
+    case 8:
+        memcpy(dst, src, 8 * sizeof(float));
+        break;
+    case 4:
+        memcpy(dst, src, 4 * sizeof(float));
+        break;
+    default:
+        memcpy(dst, src, lanes * sizeof(float));
+        break;
+    }
+}
+
+// B stored as a matrix, row k at data + k * ldb
+struct sgemm_b_matrix
+{
+    const float* data;
+    size_t ldb;
+
+    // pack rows k0 to k0 + kc of the columns n0 to n0 + nc
+    void pack(float* tm, int k0, int kc, int n0, int nc, int lanes) const
+    {
+        int j = 0;
+        for (; j + lanes - 1 < nc; j += lanes)
+        {
+            const float* ptr = data + k0 * ldb + n0 + j;
+
+            for (int k=0; k<kc; k++)
+            {
+                sgemm_copy_lanes(tm, ptr, lanes);
+                tm += lanes;
+                ptr += ldb;
+            }
+        }
+        for (; j<nc; j++)
+        {
+            const float* ptr = data + k0 * ldb + n0 + j;
+
+            for (int k=0; k<kc; k++)
+            {
+                tm[0] = ptr[0];
+                tm += 1;
+                ptr += ldb;
+            }
+        }
+    }
+};
+
+// B of a batch side by side, columns n * i to n * i + n come from b[i]
+template<typename BPack>
+struct sgemm_b_batch
+{
+    const BPack* b;
+    int n;
+
+    // pack rows k0 to k0 + kc of the columns n0 to n0 + nc
+    void pack(float* tm, int k0, int kc, int n0, int nc, int lanes) const
+    {
+        int j = 0;
+        for (; j + lanes - 1 < nc; j += lanes)
+        {
+            pack_panel(tm, k0, kc, n0 + j, lanes);
+            tm += kc * lanes;
+        }
+        for (; j<nc; j++)
+        {
+            pack_panel(tm, k0, kc, n0 + j, 1);
+            tm += kc;
+        }
+    }
+
+    // rows k0 to k0 + kc of nn adjacent columns, nn values per row
+    void pack_panel(float* tm, int k0, int kc, int n0, int nn) const
+    {
+        const int s = n0 / n;
+        if ((n0 + nn - 1) / n == s)
+        {
+            // one sample packs the whole panel
+            b[s].pack(tm, k0, kc, n0 - s * n, nn, nn);
+            return;
+        }
+
+        // a panel across samples goes column by column
+        float tmp[sgemm_kc];
+        for (int l=0; l<nn; l++)
+        {
+            const int j = n0 + l;
+
+            for (int kk=0; kk<kc; kk+=sgemm_kc)
+            {
+                const int kn = std::min(sgemm_kc, kc - kk);
+
+                b[j / n].pack(tmp, k0 + kk, kn, j % n, 1, nn);
+
+                for (int k=0; k<kn; k++)
+                {
+                    tm[(kk + k) * nn + l] = tmp[k];
+                }
+            }
+        }
+    }
+};
+
+#if !__SSE2__
+// plain float in place of a vector register
+struct sgemm_scalar
+{
+    typedef float vec;
+    enum { lanes = 1 };
+
+    static inline vec load(const float* ptr) { return *ptr; }
+    static inline void store(float* ptr, vec v) { *ptr = v; }
+    static inline vec set1(float v) { return v; }
+    static inline vec zero() { return 0.f; }
+    static inline vec fmadd(vec a, vec b, vec c) { return a * b + c; }
+};
+#endif // !__SSE2__
+
+// 8 rows of C against V::lanes columns, bias holds 8 values
+// the first k block starts from bias, the later ones accumulate into C
+template<typename V>
+static inline void sgemm_kernel_8xn(const float* a, const float* b, int kc, float* c, size_t ldc, int mr, const float* bias, bool first)
+{
+    typedef typename V::vec vec;
+
+    vec _sum0;
+    vec _sum1;
+    vec _sum2;
+    vec _sum3;
+    vec _sum4;
+    vec _sum5;
+    vec _sum6;
+    vec _sum7;
+
+    if (first)
+    {
+        _sum0 = V::set1(bias[0]);
+        _sum1 = V::set1(bias[1]);
+        _sum2 = V::set1(bias[2]);
+        _sum3 = V::set1(bias[3]);
+        _sum4 = V::set1(bias[4]);
+        _sum5 = V::set1(bias[5]);
+        _sum6 = V::set1(bias[6]);
+        _sum7 = V::set1(bias[7]);
+    }
+    else
+    {
+        _sum0 = V::load(c);
+        _sum1 = mr > 1 ? V::load(c + ldc) : V::zero();
+        _sum2 = mr > 2 ? V::load(c + ldc * 2) : V::zero();
+        _sum3 = mr > 3 ? V::load(c + ldc * 3) : V::zero();
+        _sum4 = mr > 4 ? V::load(c + ldc * 4) : V::zero();
+        _sum5 = mr > 5 ? V::load(c + ldc * 5) : V::zero();
+        _sum6 = mr > 6 ? V::load(c + ldc * 6) : V::zero();
+        _sum7 = mr > 7 ? V::load(c + ldc * 7) : V::zero();
+    }
+
+    for (int k=0; k<kc; k++)
+    {
+        vec _b = V::load(b);
+
+        _sum0 = V::fmadd(V::set1(a[0]), _b, _sum0);
+        _sum1 = V::fmadd(V::set1(a[1]), _b, _sum1);
+        _sum2 = V::fmadd(V::set1(a[2]), _b, _sum2);
+        _sum3 = V::fmadd(V::set1(a[3]), _b, _sum3);
+        _sum4 = V::fmadd(V::set1(a[4]), _b, _sum4);
+        _sum5 = V::fmadd(V::set1(a[5]), _b, _sum5);
+        _sum6 = V::fmadd(V::set1(a[6]), _b, _sum6);
+        _sum7 = V::fmadd(V::set1(a[7]), _b, _sum7);
+
+        a += 8;
+        b += V::lanes;
+    }
+
+    V::store(c, _sum0);
+    if (mr > 1) V::store(c + ldc, _sum1);
+    if (mr > 2) V::store(c + ldc * 2, _sum2);
+    if (mr > 3) V::store(c + ldc * 3, _sum3);
+    if (mr > 4) V::store(c + ldc * 4, _sum4);
+    if (mr > 5) V::store(c + ldc * 5, _sum5);
+    if (mr > 6) V::store(c + ldc * 6, _sum6);
+    if (mr > 7) V::store(c + ldc * 7, _sum7);
+}
+
+// 8 rows of C against one column, vectorized over the rows
+static inline void sgemm_kernel_8x1(const float* a, const float* b, int kc, float* c, size_t ldc, int mr, const float* bias, bool first)
+{
+    float sum[8];
+
+    int k = 0;
+#if __AVX__
+    __m256 _sum0 = _mm256_setzero_ps();
+    __m256 _sum1 = _mm256_setzero_ps();
+    __m256 _sum2 = _mm256_setzero_ps();
+    __m256 _sum3 = _mm256_setzero_ps();
+    for (; k+3<kc; k+=4)
+    {
+        _sum0 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(a), _mm256_set1_ps(b[0]), _sum0);
+        _sum1 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(a + 8), _mm256_set1_ps(b[1]), _sum1);
+        _sum2 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(a + 16), _mm256_set1_ps(b[2]), _sum2);
+        _sum3 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(a + 24), _mm256_set1_ps(b[3]), _sum3);
+
+        a += 32;
+        b += 4;
+    }
+    for (; k<kc; k++)
+    {
+        _sum0 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(a), _mm256_set1_ps(b[0]), _sum0);
+
+        a += 8;
+        b += 1;
+    }
+
+    _sum0 = _mm256_add_ps(_mm256_add_ps(_sum0, _sum1), _mm256_add_ps(_sum2, _sum3));
+    _mm256_storeu_ps(sum, _sum0);
+#elif __SSE2__
+    __m128 _sum00 = _mm_setzero_ps();
+    __m128 _sum01 = _mm_setzero_ps();
+    __m128 _sum10 = _mm_setzero_ps();
+    __m128 _sum11 = _mm_setzero_ps();
+    for (; k+1<kc; k+=2)
+    {
+        __m128 _b0 = _mm_set1_ps(b[0]);
+        __m128 _b1 = _mm_set1_ps(b[1]);
+        _sum00 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a), _b0), _sum00);
+        _sum01 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + 4), _b0), _sum01);
+        _sum10 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + 8), _b1), _sum10);
+        _sum11 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + 12), _b1), _sum11);
+
+        a += 16;
+        b += 2;
+    }
+    for (; k<kc; k++)
+    {
+        __m128 _b0 = _mm_set1_ps(b[0]);
+        _sum00 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a), _b0), _sum00);
+        _sum01 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + 4), _b0), _sum01);
+
+        a += 8;
+        b += 1;
+    }
+
+    _mm_storeu_ps(sum, _mm_add_ps(_sum00, _sum10));
+    _mm_storeu_ps(sum + 4, _mm_add_ps(_sum01, _sum11));
+#else
+    for (int i=0; i<8; i++)
+    {
+        sum[i] = 0.f;
+    }
+    for (; k<kc; k++)
+    {
+        for (int i=0; i<8; i++)
+        {
+            sum[i] += a[i] * b[0];
+        }
+
+        a += 8;
+        b += 1;
+    }
+#endif // __AVX__
+
+    for (int i=0; i<mr; i++)
+    {
+        c[i * ldc] = (first ? bias[i] : c[i * ldc]) + sum[i];
+    }
+}
+
+// rows m0 to m0 + 8 of C across the columns of one packed B block
+template<typename V>
+static inline void sgemm_block(const float* a, const float* tm, int kc, int nc, float* c, size_t ldc, int mr, const float* bias, bool first)
+{
+    const int lanes = V::lanes;
+
+    int j = 0;
+    for (; j + lanes - 1 < nc; j += lanes)
+    {
+        sgemm_kernel_8xn<V>(a, tm, kc, c + j, ldc, mr, bias, first);
+        tm += kc * lanes;
+    }
+    for (; j<nc; j++)
+    {
+        sgemm_kernel_8x1(a, tm, kc, c + j, ldc, mr, bias, first);
+        tm += kc;
+    }
+}
+
+template<typename V, typename BPack>
+static int sgemm_x86_pack(int M, int N, int K, const Mat& A_tm, const BPack& b, const float* bias, float* C, size_t ldc, const Option& opt)
+{
+    const int lanes = V::lanes;
+    const int nn_panels = (M + 7) / 8;
+    const int num_threads = opt.num_threads;
+
+    // bias of every panel row, zero past M
+    Mat bias_tm(nn_panels * 8, 4u, opt.workspace_allocator);
+    if (bias_tm.empty())
+        return -100;
+    bias_tm.fill(0.f);
+    if (bias)
+        memcpy(bias_tm, bias, M * sizeof(float));
+
+    // give every thread a block of columns, at least one panel wide
+    int nc = sgemm_nc;
+    if ((N + nc - 1) / nc < num_threads)
+        nc = std::max(lanes, ((N + num_threads - 1) / num_threads + lanes - 1) / lanes * lanes);
+    const int nn_blocks = (N + nc - 1) / nc;
+
+    if (nn_blocks == 1 || (nn_blocks < num_threads && nn_blocks < nn_panels))
+    {
+        // too few columns to share, pack all of B once and split the rows of A
+        // every A panel then streams through once, which matters most for gemv
+        Mat B_tm(K * N, 4u, opt.workspace_allocator);
+        if (B_tm.empty())
+            return -100;
+
+        const int nn_full = N / lanes;
+
+        #pragma omp parallel for num_threads(num_threads)
+        for (int j=0; j<N - nn_full * (lanes - 1); j++)
+        {
+            if (j < nn_full)
+                b.pack((float*)B_tm + j * K * lanes, 0, K, j * lanes, lanes, lanes);
+            else
+                b.pack((float*)B_tm + nn_full * K * lanes + (j - nn_full) * K, 0, K, j - nn_full + nn_full * lanes, 1, lanes);
+        }
+
+        #pragma omp parallel for num_threads(num_threads)
+        for (int pp=0; pp<nn_panels; pp++)
+        {
+            const float* a = A_tm.row(pp);
+            const int mr = std::min(8, M - pp * 8);
+
+            for (int k0=0; k0<K; k0+=sgemm_kc)
+            {
+                const int kc = std::min(sgemm_kc, K - k0);
+
+                // the k0 slice of a panel packed over all of K
+                const float* tm = B_tm;
+                int j = 0;
+                for (; j + lanes - 1 < N; j += lanes)
+                {
+                    sgemm_kernel_8xn<V>(a + k0 * 8, tm + k0 * lanes, kc, C + pp * 8 * ldc + j, ldc, mr, (const float*)bias_tm + pp * 8, k0 == 0);
+                    tm += K * lanes;
+                }
+                for (; j<N; j++)
+                {
+                    sgemm_kernel_8x1(a + k0 * 8, tm + k0, kc, C + pp * 8 * ldc + j, ldc, mr, (const float*)bias_tm + pp * 8, k0 == 0);
+                    tm += K;
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    // one B block buffer per thread
+    Mat B_tm(sgemm_kc * nc, num_threads, 4u, opt.workspace_allocator);
+    if (B_tm.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(num_threads)
+    for (int jb=0; jb<nn_blocks; jb++)
+    {
+        float* tm = B_tm.row(get_omp_thread_num());
+
+        const int n0 = jb * nc;
+        const int ncur = std::min(nc, N - n0);
+
+        for (int k0=0; k0<K; k0+=sgemm_kc)
+        {
+            const int kc = std::min(sgemm_kc, K - k0);
+
+            b.pack(tm, k0, kc, n0, ncur, lanes);
+
+            for (int pp=0; pp<nn_panels; pp++)
+            {
+                const float* a = (const float*)A_tm.row(pp) + k0 * 8;
+                const int mr = std::min(8, M - pp * 8);
+
+                sgemm_block<V>(a, tm, kc, ncur, C + pp * 8 * ldc + n0, ldc, mr, (const float*)bias_tm + pp * 8, k0 == 0);
+            }
+        }
+    }
+
+    return 0;
+}
+
+// A_tm from sgemm_transform_a, b packs like sgemm_b_matrix, bias may be null
+template<typename BPack>
+static int sgemm_x86(int M, int N, int K, const Mat& A_tm, const BPack& b, const float* bias, float* C, size_t ldc, const Option& opt)
+{
+#if __AVX512F__
+    return sgemm_x86_pack<pack16_avx512>(M, N, K, A_tm, b, bias, C, ldc, opt);
+#elif __AVX__
+    return sgemm_x86_pack<pack8_avx>(M, N, K, A_tm, b, bias, C, ldc, opt);
+#elif __SSE2__
+    return sgemm_x86_pack<pack4_sse>(M, N, K, A_tm, b, bias, C, ldc, opt);
+#else
+    return sgemm_x86_pack<sgemm_scalar>(M, N, K, A_tm, b, bias, C, ldc, opt);
+#endif
+}
@@ -0,0 +1,199 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef X86_USABILITY_H
+#define X86_USABILITY_H
+
+#include <math.h>
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif
+
+#include "mat.h"
+
+namespace ncnn {
+
+// elempack used for a blob of elemcount fp32 lanes, pack8 on avx, pack4 on sse2
+static inline int x86_elempack(int elemcount)
+{
+#if __AVX__
+    if (elemcount % 8 == 0)
+        return 8;
+#endif
+#if __SSE2__
+    if (elemcount % 4 == 0)
+        return 4;
+#endif
+    return 1;
+}
+
+// elempack the packed kernels of this build are compiled for
+static inline bool x86_elempack_supported(int elempack)
+{
+#if __AVX__
+    if (elempack == 8)
+        return true;
+#endif
+#if __SSE2__
+    if (elempack == 4)
+        return true;
+#endif
+    return elempack == 1;
+}
+
+#if __AVX__
+// a * b + c, fused when the build targets fma
+static inline __m128 _mm_comp_fmadd_ps(__m128 a, __m128 b, __m128 c)
+{
+#if __FMA__
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+static inline __m256 _mm256_comp_fmadd_ps(__m256 a, __m256 b, __m256 c)
+{
+#if __FMA__
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+#endif // __AVX__
+
+#if __SSE2__
+// the same x86 source is compiled once per instruction set with runtime cpu dispatch
+// internal linkage keeps the linker from merging the inline members across variants
+namespace {
+
+// one pack4 element in a sse register
+struct pack4_sse
+{
+    typedef __m128 vec;
+    enum { lanes = 4 };
+
+    static inline vec load(const float* ptr) { return _mm_loadu_ps(ptr); }
+    static inline void store(float* ptr, vec v) { _mm_storeu_ps(ptr, v); }
+    static inline vec set1(float v) { return _mm_set1_ps(v); }
+    static inline vec zero() { return _mm_setzero_ps(); }
+    static inline vec add(vec a, vec b) { return _mm_add_ps(a, b); }
+    static inline vec sub(vec a, vec b) { return _mm_sub_ps(a, b); }
+    static inline vec mul(vec a, vec b) { return _mm_mul_ps(a, b); }
+    static inline vec div(vec a, vec b) { return _mm_div_ps(a, b); }
+    static inline vec max(vec a, vec b) { return _mm_max_ps(a, b); }
+    static inline vec min(vec a, vec b) { return _mm_min_ps(a, b); }
+    // a * b + c
+    static inline vec fmadd(vec a, vec b, vec c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static inline float reduce_add(vec v)
+    {
+        float tmp[4];
+        _mm_storeu_ps(tmp, v);
+        return tmp[0] + tmp[1] + tmp[2] + tmp[3];
+    }
+};
+
+#if __AVX__
+// one pack8 element in an avx register
+struct pack8_avx
+{
+    typedef __m256 vec;
+    enum { lanes = 8 };
+
+    static inline vec load(const float* ptr) { return _mm256_loadu_ps(ptr); }
+    static inline void store(float* ptr, vec v) { _mm256_storeu_ps(ptr, v); }
+    static inline vec set1(float v) { return _mm256_set1_ps(v); }
+    static inline vec zero() { return _mm256_setzero_ps(); }
+    static inline vec add(vec a, vec b) { return _mm256_add_ps(a, b); }
+    static inline vec sub(vec a, vec b) { return _mm256_sub_ps(a, b); }
+    static inline vec mul(vec a, vec b) { return _mm256_mul_ps(a, b); }
+    static inline vec div(vec a, vec b) { return _mm256_div_ps(a, b); }
+    static inline vec max(vec a, vec b) { return _mm256_max_ps(a, b); }
+    static inline vec min(vec a, vec b) { return _mm256_min_ps(a, b); }
+    // a * b + c
+    static inline vec fmadd(vec a, vec b, vec c) { return _mm256_comp_fmadd_ps(a, b, c); }
+    static inline float reduce_add(vec v)
+    {
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+};
+#endif // __AVX__
+
+#if __AVX512F__
+// sixteen floats in an avx512 register, no blob layout uses it
+struct pack16_avx512
+{
+    typedef __m512 vec;
+    enum { lanes = 16 };
+
+    static inline vec load(const float* ptr) { return _mm512_loadu_ps(ptr); }
+    static inline void store(float* ptr, vec v) { _mm512_storeu_ps(ptr, v); }
+    static inline vec set1(float v) { return _mm512_set1_ps(v); }
+    static inline vec zero() { return _mm512_setzero_ps(); }
+    static inline vec add(vec a, vec b) { return _mm512_add_ps(a, b); }
+    static inline vec sub(vec a, vec b) { return _mm512_sub_ps(a, b); }
+    static inline vec mul(vec a, vec b) { return _mm512_mul_ps(a, b); }
+    static inline vec div(vec a, vec b) { return _mm512_div_ps(a, b); }
+    static inline vec max(vec a, vec b) { return _mm512_max_ps(a, b); }
+    static inline vec min(vec a, vec b) { return _mm512_min_ps(a, b); }
+    // a * b + c
+    static inline vec fmadd(vec a, vec b, vec c) { return _mm512_fmadd_ps(a, b, c); }
+    static inline float reduce_add(vec v) { return _mm512_reduce_add_ps(v); }
+};
+#endif // __AVX512F__
+
+} // namespace
+
+// fused activation of convolution and innerproduct on a packed element
+template<typename V>
+static inline typename V::vec activation_pack(typename V::vec v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 1)
+    {
+        v = V::max(v, V::zero());
+    }
+    else if (activation_type == 2)
+    {
+        typename V::vec slope = V::set1(activation_params[0]);
+        v = V::fmadd(slope, V::min(v, V::zero()), V::max(v, V::zero()));
+    }
+    else if (activation_type == 3)
+    {
+        v = V::min(V::max(v, V::set1(activation_params[0])), V::set1(activation_params[1]));
+    }
+    else if (activation_type == 4)
+    {
+        float tmp[V::lanes];
+        V::store(tmp, v);
+        for (int i=0; i<V::lanes; i++)
+        {
+            tmp[i] = 1.f / (1.f + exp(-tmp[i]));
+        }
+        v = V::load(tmp);
+    }
+
+    return v;
+}
+#endif // __SSE2__
+
+} // namespace ncnn
+
+#endif // X86_USABILITY_H
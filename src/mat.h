@@ -396,96 +396,96 @@ void convert_packing(const Mat& src, Mat& dst, int elempack, const Option& opt =
 void cast_float32_to_float16(const Mat& src, Mat& dst, const Option& opt = Option());
 void cast_float16_to_float32(const Mat& src, Mat& dst, const Option& opt = Option());
 
-inline Mat::Mat()
+NCNN_FORCEINLINE Mat::Mat()
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
 }
 
-inline Mat::Mat(int _w, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, size_t _elemsize, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _elemsize, _allocator);
 }
 
-inline Mat::Mat(int _w, int _h, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, size_t _elemsize, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _elemsize, _allocator);
 }
 
-inline Mat::Mat(int _w, int _h, int _c, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, int _c, size_t _elemsize, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _c, _elemsize, _allocator);
 }
 
-inline Mat::Mat(int _w, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _elemsize, _elempack, _allocator);
 }
 
-inline Mat::Mat(int _w, int _h, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _elemsize, _elempack, _allocator);
 }
 
-inline Mat::Mat(int _w, int _h, int _c, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, int _c, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _c, _elemsize, _elempack, _allocator);
 }
 
-inline Mat::Mat(const Mat& m)
+NCNN_FORCEINLINE Mat::Mat(const Mat& m)
     : data(m.data), refcount(m.refcount), elemsize(m.elemsize), elempack(m.elempack), allocator(m.allocator), dims(m.dims), w(m.w), h(m.h), c(m.c), cstep(m.cstep)
 {
     if (refcount)
         NCNN_XADD(refcount, 1);
 }
 
-inline Mat::Mat(int _w, void* _data, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, void* _data, size_t _elemsize, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(1), allocator(_allocator), dims(1), w(_w), h(1), c(1)
 {
     cstep = w;
 }
 
-inline Mat::Mat(int _w, int _h, void* _data, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, void* _data, size_t _elemsize, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(1), allocator(_allocator), dims(2), w(_w), h(_h), c(1)
 {
     cstep = w * h;
 }
 
-inline Mat::Mat(int _w, int _h, int _c, void* _data, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, int _c, void* _data, size_t _elemsize, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(1), allocator(_allocator), dims(3), w(_w), h(_h), c(_c)
 {
     cstep = alignSize(w * h * elemsize, 16) / elemsize;
 }
 
-inline Mat::Mat(int _w, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(_elempack), allocator(_allocator), dims(1), w(_w), h(1), c(1)
 {
     cstep = w;
 }
 
-inline Mat::Mat(int _w, int _h, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(_elempack), allocator(_allocator), dims(2), w(_w), h(_h), c(1)
 {
     cstep = w * h;
 }
 
-inline Mat::Mat(int _w, int _h, int _c, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, int _c, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(_elempack), allocator(_allocator), dims(3), w(_w), h(_h), c(_c)
 {
     cstep = alignSize(w * h * elemsize, 16) / elemsize;
 }
 
-inline Mat::~Mat()
+NCNN_FORCEINLINE Mat::~Mat()
 {
     release();
 }
 
-inline Mat& Mat::operator=(const Mat& m)
+NCNN_FORCEINLINE Mat& Mat::operator=(const Mat& m)
 {
     if (this == &m)
         return *this;
@@ -511,7 +511,7 @@ inline Mat& Mat::operator=(const Mat& m)
     return *this;
 }
 
-inline void Mat::fill(float _v)
+NCNN_FORCEINLINE void Mat::fill(float _v)
 {
     int size = (int)total();
     float* ptr = (float*)data;
@@ -565,7 +565,7 @@ inline void Mat::fill(float _v)
     }
 }
 
-inline void Mat::fill(int _v)
+NCNN_FORCEINLINE void Mat::fill(int _v)
 {
     int size = (int)total();
     int* ptr = (int*)data;
@@ -620,7 +620,7 @@ inline void Mat::fill(int _v)
 }
 
 #if __ARM_NEON
-inline void Mat::fill(float32x4_t _v)
+NCNN_FORCEINLINE void Mat::fill(float32x4_t _v)
 {
     int size = total();
     float* ptr = (float*)data;
@@ -633,7 +633,7 @@ inline void Mat::fill(float32x4_t _v)
 #endif // __ARM_NEON
 
 template <typename T>
-inline void Mat::fill(T _v)
+NCNN_FORCEINLINE void Mat::fill(T _v)
 {
     int size = total();
     T* ptr = (T*)data;
@@ -643,7 +643,7 @@ inline void Mat::fill(T _v)
     }
 }
 
-inline Mat Mat::clone(Allocator* allocator) const
+NCNN_FORCEINLINE Mat Mat::clone(Allocator* allocator) const
 {
     if (empty())
         return Mat();
@@ -664,7 +664,7 @@ inline Mat Mat::clone(Allocator* allocator) const
     return m;
 }
 
-inline Mat Mat::reshape(int _w, Allocator* _allocator) const
+NCNN_FORCEINLINE Mat Mat::reshape(int _w, Allocator* _allocator) const
 {
     if (w * h * c != _w)
         return Mat();
@@ -697,7 +697,7 @@ inline Mat Mat::reshape(int _w, Allocator* _allocator) const
     return m;
 }
 
-inline Mat Mat::reshape(int _w, int _h, Allocator* _allocator) const
+NCNN_FORCEINLINE Mat Mat::reshape(int _w, int _h, Allocator* _allocator) const
 {
     if (w * h * c != _w * _h)
         return Mat();
@@ -730,7 +730,7 @@ inline Mat Mat::reshape(int _w, int _h, Allocator* _allocator) const
     return m;
 }
 
-inline Mat Mat::reshape(int _w, int _h, int _c, Allocator* _allocator) const
+NCNN_FORCEINLINE Mat Mat::reshape(int _w, int _h, int _c, Allocator* _allocator) const
 {
     if (w * h * c != _w * _h * _c)
         return Mat();
@@ -772,7 +772,7 @@ inline Mat Mat::reshape(int _w, int _h, int _c, Allocator* _allocator) const
     return m;
 }
 
-inline void Mat::create(int _w, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, size_t _elemsize, Allocator* _allocator)
 {
     if (dims == 1 && w == _w && elemsize == _elemsize && elempack == 1 && allocator == _allocator)
         return;
@@ -802,7 +802,7 @@ inline void Mat::create(int _w, size_t _elemsize, Allocator* _allocator)
     }
 }
 
-inline void Mat::create(int _w, int _h, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, int _h, size_t _elemsize, Allocator* _allocator)
 {
     if (dims == 2 && w == _w && h == _h && elemsize == _elemsize && elempack == 1 && allocator == _allocator)
         return;
@@ -832,7 +832,7 @@ inline void Mat::create(int _w, int _h, size_t _elemsize, Allocator* _allocator)
     }
 }
 
-inline void Mat::create(int _w, int _h, int _c, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, int _h, int _c, size_t _elemsize, Allocator* _allocator)
 {
     if (dims == 3 && w == _w && h == _h && c == _c && elemsize == _elemsize && elempack == 1 && allocator == _allocator)
         return;
@@ -862,7 +862,7 @@ inline void Mat::create(int _w, int _h, int _c, size_t _elemsize, Allocator* _al
     }
 }
 
-inline void Mat::create(int _w, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, size_t _elemsize, int _elempack, Allocator* _allocator)
 {
     if (dims == 1 && w == _w && elemsize == _elemsize && elempack == _elempack && allocator == _allocator)
         return;
@@ -892,7 +892,7 @@ inline void Mat::create(int _w, size_t _elemsize, int _elempack, Allocator* _all
     }
 }
 
-inline void Mat::create(int _w, int _h, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, int _h, size_t _elemsize, int _elempack, Allocator* _allocator)
 {
     if (dims == 2 && w == _w && h == _h && elemsize == _elemsize && elempack == _elempack && allocator == _allocator)
         return;
@@ -922,7 +922,7 @@ inline void Mat::create(int _w, int _h, size_t _elemsize, int _elempack, Allocat
     }
 }
 
-inline void Mat::create(int _w, int _h, int _c, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, int _h, int _c, size_t _elemsize, int _elempack, Allocator* _allocator)
 {
     if (dims == 3 && w == _w && h == _h && c == _c && elemsize == _elemsize && elempack == _elempack && allocator == _allocator)
         return;
@@ -952,7 +952,7 @@ inline void Mat::create(int _w, int _h, int _c, size_t _elemsize, int _elempack,
     }
 }
 
-inline void Mat::create_like(const Mat& m, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create_like(const Mat& m, Allocator* _allocator)
 {
     if (m.dims == 1)
         create(m.w, m.elemsize, m.elempack, _allocator);
@@ -963,7 +963,7 @@ inline void Mat::create_like(const Mat& m, Allocator* _allocator)
 }
 
 #if NCNN_VULKAN
-inline void Mat::create_like(const VkMat& m, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create_like(const VkMat& m, Allocator* _allocator)
 {
     if (m.dims == 1)
         create(m.w, m.elemsize, m.elempack, _allocator);
@@ -974,13 +974,13 @@ inline void Mat::create_like(const VkMat& m, Allocator* _allocator)
 }
 #endif // NCNN_VULKAN
 
-inline void Mat::addref()
+NCNN_FORCEINLINE void Mat::addref()
 {
     if (refcount)
         NCNN_XADD(refcount, 1);
 }
 
-inline void Mat::release()
+NCNN_FORCEINLINE void Mat::release()
 {
     if (refcount && NCNN_XADD(refcount, -1) == 1)
     {
@@ -1005,144 +1005,144 @@ inline void Mat::release()
     refcount = 0;
 }
 
-inline bool Mat::empty() const
+NCNN_FORCEINLINE bool Mat::empty() const
 {
     return data == 0 || total() == 0;
 }
 
-inline size_t Mat::total() const
+NCNN_FORCEINLINE size_t Mat::total() const
 {
     return cstep * c;
 }
 
-inline Mat Mat::channel(int _c)
+NCNN_FORCEINLINE Mat Mat::channel(int _c)
 {
     return Mat(w, h, (unsigned char*)data + cstep * _c * elemsize, elemsize, elempack, allocator);
 }
 
-inline const Mat Mat::channel(int _c) const
+NCNN_FORCEINLINE const Mat Mat::channel(int _c) const
 {
     return Mat(w, h, (unsigned char*)data + cstep * _c * elemsize, elemsize, elempack, allocator);
 }
 
-inline float* Mat::row(int y)
+NCNN_FORCEINLINE float* Mat::row(int y)
 {
     return (float*)((unsigned char*)data + w * y * elemsize);
 }
 
-inline const float* Mat::row(int y) const
+NCNN_FORCEINLINE const float* Mat::row(int y) const
 {
     return (const float*)((unsigned char*)data + w * y * elemsize);
 }
 
 template <typename T>
-inline T* Mat::row(int y)
+NCNN_FORCEINLINE T* Mat::row(int y)
 {
     return (T*)((unsigned char*)data + w * y * elemsize);
 }
 
 template <typename T>
-inline const T* Mat::row(int y) const
+NCNN_FORCEINLINE const T* Mat::row(int y) const
 {
     return (const T*)((unsigned char*)data + w * y * elemsize);
 }
 
-inline Mat Mat::channel_range(int _c, int channels)
+NCNN_FORCEINLINE Mat Mat::channel_range(int _c, int channels)
 {
     return Mat(w, h, channels, (unsigned char*)data + cstep * _c * elemsize, elemsize, elempack, allocator);
 }
 
-inline const Mat Mat::channel_range(int _c, int channels) const
+NCNN_FORCEINLINE const Mat Mat::channel_range(int _c, int channels) const
 {
     return Mat(w, h, channels, (unsigned char*)data + cstep * _c * elemsize, elemsize, elempack, allocator);
 }
 
-inline Mat Mat::row_range(int y, int rows)
+NCNN_FORCEINLINE Mat Mat::row_range(int y, int rows)
 {
     return Mat(w, rows, (unsigned char*)data + w * y * elemsize, elemsize, elempack, allocator);
 }
 
-inline const Mat Mat::row_range(int y, int rows) const
+NCNN_FORCEINLINE const Mat Mat::row_range(int y, int rows) const
 {
     return Mat(w, rows, (unsigned char*)data + w * y * elemsize, elemsize, elempack, allocator);
 }
 
-inline Mat Mat::range(int x, int n)
+NCNN_FORCEINLINE Mat Mat::range(int x, int n)
 {
     return Mat(n, (unsigned char*)data + x * elemsize, elemsize, elempack, allocator);
 }
 
-inline const Mat Mat::range(int x, int n) const
+NCNN_FORCEINLINE const Mat Mat::range(int x, int n) const
 {
     return Mat(n, (unsigned char*)data + x * elemsize, elemsize, elempack, allocator);
 }
 
 template <typename T>
-inline Mat::operator T*()
+NCNN_FORCEINLINE Mat::operator T*()
 {
     return (T*)data;
 }
 
 template <typename T>
-inline Mat::operator const T*() const
+NCNN_FORCEINLINE Mat::operator const T*() const
 {
     return (const T*)data;
 }
 
-inline float& Mat::operator[](int i)
+NCNN_FORCEINLINE float& Mat::operator[](int i)
 {
     return ((float*)data)[i];
 }
 
-inline const float& Mat::operator[](int i) const
+NCNN_FORCEINLINE const float& Mat::operator[](int i) const
 {
     return ((const float*)data)[i];
 }
 
 #if NCNN_VULKAN
 
-inline VkMat::VkMat()
+NCNN_FORCEINLINE VkMat::VkMat()
     : data(0), offset(0), staging_data(0), refcount(0), staging_refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
 }
 
-inline VkMat::VkMat(int _w, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(0), offset(0), staging_data(0), refcount(0), staging_refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _elemsize, _allocator, _staging_allocator);
 }
 
-inline VkMat::VkMat(int _w, int _h, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, int _h, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(0), offset(0), staging_data(0), refcount(0), staging_refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _elemsize, _allocator, _staging_allocator);
 }
 
-inline VkMat::VkMat(int _w, int _h, int _c, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, int _h, int _c, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(0), offset(0), staging_data(0), refcount(0), staging_refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _c, _elemsize, _allocator, _staging_allocator);
 }
 
-inline VkMat::VkMat(int _w, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(0), offset(0), staging_data(0), refcount(0), staging_refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _elemsize, _elempack, _allocator, _staging_allocator);
 }
 
-inline VkMat::VkMat(int _w, int _h, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, int _h, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(0), offset(0), staging_data(0), refcount(0), staging_refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _elemsize, _elempack, _allocator, _staging_allocator);
 }
 
-inline VkMat::VkMat(int _w, int _h, int _c, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, int _h, int _c, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(0), offset(0), staging_data(0), refcount(0), staging_refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _c, _elemsize, _elempack, _allocator, _staging_allocator);
 }
 
-inline VkMat::VkMat(const VkMat& m)
+NCNN_FORCEINLINE VkMat::VkMat(const VkMat& m)
     : data(m.data), offset(m.offset), staging_data(m.staging_data), refcount(m.refcount), staging_refcount(m.staging_refcount), elemsize(m.elemsize), elempack(m.elempack), allocator(m.allocator), staging_allocator(m.staging_allocator), dims(m.dims), w(m.w), h(m.h), c(m.c)
 {
     if (refcount)
@@ -1154,48 +1154,48 @@ inline VkMat::VkMat(const VkMat& m)
     cstep = m.cstep;
 }
 
-inline VkMat::VkMat(int _w, VkBufferMemory* _data, size_t _offset, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, VkBufferMemory* _data, size_t _offset, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(_data), offset(_offset), staging_data(0), refcount(0), staging_refcount(0), elemsize(_elemsize), elempack(1), allocator(_allocator), staging_allocator(_staging_allocator), dims(1), w(_w), h(1), c(1)
 {
     cstep = w;
 }
 
-inline VkMat::VkMat(int _w, int _h, VkBufferMemory* _data, size_t _offset, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, int _h, VkBufferMemory* _data, size_t _offset, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(_data), offset(_offset), staging_data(0), refcount(0), staging_refcount(0), elemsize(_elemsize), elempack(1), allocator(_allocator), staging_allocator(_staging_allocator), dims(2), w(_w), h(_h), c(1)
 {
     cstep = w * h;
 }
 
-inline VkMat::VkMat(int _w, int _h, int _c, VkBufferMemory* _data, size_t _offset, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, int _h, int _c, VkBufferMemory* _data, size_t _offset, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(_data), offset(_offset), staging_data(0), refcount(0), staging_refcount(0), elemsize(_elemsize), elempack(1), allocator(_allocator), staging_allocator(_staging_allocator), dims(3), w(_w), h(_h), c(_c)
 {
     cstep = alignSize(w * h * elemsize, 16) / elemsize;
 }
 
-inline VkMat::VkMat(int _w, VkBufferMemory* _data, size_t _offset, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, VkBufferMemory* _data, size_t _offset, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(_data), offset(_offset), staging_data(0), refcount(0), staging_refcount(0), elemsize(_elemsize), elempack(_elempack), allocator(_allocator), staging_allocator(_staging_allocator), dims(1), w(_w), h(1), c(1)
 {
     cstep = w;
 }
 
-inline VkMat::VkMat(int _w, int _h, VkBufferMemory* _data, size_t _offset, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, int _h, VkBufferMemory* _data, size_t _offset, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(_data), offset(_offset), staging_data(0), refcount(0), staging_refcount(0), elemsize(_elemsize), elempack(_elempack), allocator(_allocator), staging_allocator(_staging_allocator), dims(2), w(_w), h(_h), c(1)
 {
     cstep = w * h;
 }
 
-inline VkMat::VkMat(int _w, int _h, int _c, VkBufferMemory* _data, size_t _offset, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE VkMat::VkMat(int _w, int _h, int _c, VkBufferMemory* _data, size_t _offset, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
     : data(_data), offset(_offset), staging_data(0), refcount(0), staging_refcount(0), elemsize(_elemsize), elempack(_elempack), allocator(_allocator), staging_allocator(_staging_allocator), dims(3), w(_w), h(_h), c(_c)
 {
     cstep = alignSize(w * h * elemsize, 16) / elemsize;
 }
 
-inline VkMat::~VkMat()
+NCNN_FORCEINLINE VkMat::~VkMat()
 {
     release();
 }
 
-inline VkMat& VkMat::operator=(const VkMat& m)
+NCNN_FORCEINLINE VkMat& VkMat::operator=(const VkMat& m)
 {
     if (this == &m)
         return *this;
@@ -1228,7 +1228,7 @@ inline VkMat& VkMat::operator=(const VkMat& m)
     return *this;
 }
 
-inline void VkMat::create(int _w, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE void VkMat::create(int _w, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
 {
     if (dims == 1 && w == _w && elemsize == _elemsize && elempack == 1 && allocator == _allocator && staging_allocator == _staging_allocator)
         return;
@@ -1259,7 +1259,7 @@ inline void VkMat::create(int _w, size_t _elemsize, VkAllocator* _allocator, VkA
     }
 }
 
-inline void VkMat::create(int _w, int _h, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE void VkMat::create(int _w, int _h, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
 {
     if (dims == 2 && w == _w && h == _h && elemsize == _elemsize && elempack == 1 && allocator == _allocator && staging_allocator == _staging_allocator)
         return;
@@ -1290,7 +1290,7 @@ inline void VkMat::create(int _w, int _h, size_t _elemsize, VkAllocator* _alloca
     }
 }
 
-inline void VkMat::create(int _w, int _h, int _c, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE void VkMat::create(int _w, int _h, int _c, size_t _elemsize, VkAllocator* _allocator, VkAllocator* _staging_allocator)
 {
     if (dims == 3 && w == _w && h == _h && c == _c && elemsize == _elemsize && elempack == 1 && allocator == _allocator && staging_allocator == _staging_allocator)
         return;
@@ -1321,7 +1321,7 @@ inline void VkMat::create(int _w, int _h, int _c, size_t _elemsize, VkAllocator*
     }
 }
 
-inline void VkMat::create(int _w, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE void VkMat::create(int _w, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
 {
     if (dims == 1 && w == _w && elemsize == _elemsize && elempack == _elempack && allocator == _allocator && staging_allocator == _staging_allocator)
         return;
@@ -1352,7 +1352,7 @@ inline void VkMat::create(int _w, size_t _elemsize, int _elempack, VkAllocator*
     }
 }
 
-inline void VkMat::create(int _w, int _h, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE void VkMat::create(int _w, int _h, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
 {
     if (dims == 2 && w == _w && h == _h && elemsize == _elemsize && elempack == _elempack && allocator == _allocator && staging_allocator == _staging_allocator)
         return;
@@ -1383,7 +1383,7 @@ inline void VkMat::create(int _w, int _h, size_t _elemsize, int _elempack, VkAll
     }
 }
 
-inline void VkMat::create(int _w, int _h, int _c, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE void VkMat::create(int _w, int _h, int _c, size_t _elemsize, int _elempack, VkAllocator* _allocator, VkAllocator* _staging_allocator)
 {
     if (dims == 3 && w == _w && h == _h && c == _c && elemsize == _elemsize && elempack == _elempack && allocator == _allocator && staging_allocator == _staging_allocator)
         return;
@@ -1414,7 +1414,7 @@ inline void VkMat::create(int _w, int _h, int _c, size_t _elemsize, int _elempac
     }
 }
 
-inline void VkMat::create_like(const Mat& m, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE void VkMat::create_like(const Mat& m, VkAllocator* _allocator, VkAllocator* _staging_allocator)
 {
     if (m.dims == 1)
         create(m.w, m.elemsize, m.elempack, _allocator, _staging_allocator);
@@ -1424,7 +1424,7 @@ inline void VkMat::create_like(const Mat& m, VkAllocator* _allocator, VkAllocato
         create(m.w, m.h, m.c, m.elemsize, m.elempack, _allocator, _staging_allocator);
 }
 
-inline void VkMat::create_like(const VkMat& m, VkAllocator* _allocator, VkAllocator* _staging_allocator)
+NCNN_FORCEINLINE void VkMat::create_like(const VkMat& m, VkAllocator* _allocator, VkAllocator* _staging_allocator)
 {
     if (m.dims == 1)
         create(m.w, m.elemsize, m.elempack, _allocator, _staging_allocator);
@@ -1434,7 +1434,7 @@ inline void VkMat::create_like(const VkMat& m, VkAllocator* _allocator, VkAlloca
         create(m.w, m.h, m.c, m.elemsize, m.elempack, _allocator, _staging_allocator);
 }
 
-inline void VkMat::prepare_staging_buffer()
+NCNN_FORCEINLINE void VkMat::prepare_staging_buffer()
 {
     if (allocator->mappable)
         return;
@@ -1449,7 +1449,7 @@ inline void VkMat::prepare_staging_buffer()
     *staging_refcount = 1;
 }
 
-inline void VkMat::discard_staging_buffer()
+NCNN_FORCEINLINE void VkMat::discard_staging_buffer()
 {
     if (allocator->mappable)
         return;
@@ -1466,17 +1466,17 @@ inline void VkMat::discard_staging_buffer()
     staging_refcount = 0;
 }
 
-inline void VkMat::upload(const Mat& m)
+NCNN_FORCEINLINE void VkMat::upload(const Mat& m)
 {
     memcpy(mapped_ptr(), m.data, m.total() * m.elemsize);
 }
 
-inline void VkMat::download(Mat& m) const
+NCNN_FORCEINLINE void VkMat::download(Mat& m) const
 {
     memcpy(m.data, mapped_ptr(), total() * elemsize);
 }
 
-inline Mat VkMat::mapped() const
+NCNN_FORCEINLINE Mat VkMat::mapped() const
 {
     if (dims == 1)
         return Mat(w, mapped_ptr(), elemsize, elempack, 0);
@@ -1490,13 +1490,13 @@ inline Mat VkMat::mapped() const
     return Mat();
 }
 
-inline void* VkMat::mapped_ptr() const
+NCNN_FORCEINLINE void* VkMat::mapped_ptr() const
 {
     VkBufferMemory* mappable_data = allocator->mappable ? data : staging_data;
     return (unsigned char*)mappable_data->mapped_ptr + mappable_data->offset + offset;
 }
 
-inline void VkMat::addref()
+NCNN_FORCEINLINE void VkMat::addref()
 {
     if (refcount)
         NCNN_XADD(refcount, 1);
@@ -1505,7 +1505,7 @@ inline void VkMat::addref()
         NCNN_XADD(staging_refcount, 1);
 }
 
-inline void VkMat::release()
+NCNN_FORCEINLINE void VkMat::release()
 {
     if (refcount && NCNN_XADD(refcount, -1) == 1)
     {
@@ -1541,72 +1541,72 @@ inline void VkMat::release()
     staging_refcount = 0;
 }
 
-inline bool VkMat::empty() const
+NCNN_FORCEINLINE bool VkMat::empty() const
 {
     return data == 0 || total() == 0;
 }
 
-inline size_t VkMat::total() const
+NCNN_FORCEINLINE size_t VkMat::total() const
 {
     return cstep * c;
 }
 
-inline VkMat VkMat::channel(int _c)
+NCNN_FORCEINLINE VkMat VkMat::channel(int _c)
 {
     return VkMat(w, h, data, cstep * _c * elemsize, elemsize, elempack, allocator, staging_allocator);
 }
 
-inline const VkMat VkMat::channel(int _c) const
+NCNN_FORCEINLINE const VkMat VkMat::channel(int _c) const
 {
     return VkMat(w, h, data, cstep * _c * elemsize, elemsize, elempack, allocator, staging_allocator);
 }
 
-inline VkMat VkMat::channel_range(int _c, int channels)
+NCNN_FORCEINLINE VkMat VkMat::channel_range(int _c, int channels)
 {
     return VkMat(w, h, channels, data, cstep * _c * elemsize, elemsize, elempack, allocator, staging_allocator);
 }
 
-inline const VkMat VkMat::channel_range(int _c, int channels) const
+NCNN_FORCEINLINE const VkMat VkMat::channel_range(int _c, int channels) const
 {
     return VkMat(w, h, channels, data, cstep * _c * elemsize, elemsize, elempack, allocator, staging_allocator);
 }
 
-inline VkMat VkMat::row_range(int y, int rows)
+NCNN_FORCEINLINE VkMat VkMat::row_range(int y, int rows)
 {
     return VkMat(w, rows, data, w * y * elemsize, elemsize, elempack, allocator, staging_allocator);
 }
 
-inline const VkMat VkMat::row_range(int y, int rows) const
+NCNN_FORCEINLINE const VkMat VkMat::row_range(int y, int rows) const
 {
     return VkMat(w, rows, data, w * y * elemsize, elemsize, elempack, allocator, staging_allocator);
 }
 
-inline VkMat VkMat::range(int x, int n)
+NCNN_FORCEINLINE VkMat VkMat::range(int x, int n)
 {
     return VkMat(n, data, x * elemsize, elemsize, elempack, allocator, staging_allocator);
 }
 
-inline const VkMat VkMat::range(int x, int n) const
+NCNN_FORCEINLINE const VkMat VkMat::range(int x, int n) const
 {
     return VkMat(n, data, x * elemsize, elemsize, elempack, allocator, staging_allocator);
 }
 
-inline VkBuffer VkMat::buffer() const
+NCNN_FORCEINLINE VkBuffer VkMat::buffer() const
 {
     return data->buffer;
 }
 
-inline size_t VkMat::buffer_offset() const
+NCNN_FORCEINLINE size_t VkMat::buffer_offset() const
 {
     return data->offset + offset;
 }
 
-inline VkBuffer VkMat::staging_buffer() const
+NCNN_FORCEINLINE VkBuffer VkMat::staging_buffer() const
 {
     return staging_data->buffer;
 }
 
-inline size_t VkMat::staging_buffer_offset() const
+NCNN_FORCEINLINE size_t VkMat::staging_buffer_offset() const
 {
     return staging_data->offset;
 }
@@ -43,12 +43,87 @@ Mat ModelBin::load(int w, int h, int c, int type) const
     return m.reshape(w, h, c);
 }
 
+Mat ModelBin::load_pq(int w, int type, Mat& codebook) const
+{
+    codebook.release();
+
+    return load(w, type);
+}
+
+Mat pq_decode(const Mat& codebook, const Mat& codes)
+{
+    const int d = codebook.w;
+    const int n = codes.w;
+
+    Mat m(n * d);
+    if (m.empty())
+        return m;
+
+    const unsigned char* code_ptr = codes;
+    float* ptr = m;
+    for (int i = 0; i < n; i++)
+    {
+        const float* cw = codebook.row(code_ptr[i]);
+        for (int j = 0; j < d; j++)
+        {
+            ptr[j] = cw[j];
+        }
+        ptr += d;
+    }
+
+    return m;
+}
+
 ModelBinFromDataReader::ModelBinFromDataReader(const DataReader& _dr) : dr(_dr)
 {
 }
 
+// raw float32 data is referenced in place when the reader supports it
+// so that mapped or external model memory is not copied
+static Mat load_float32(const DataReader& dr, int w)
+{
+    const void* refbuf = 0;
+    int nref = dr.reference(w * sizeof(float), &refbuf);
+    if (nref == w * (int)sizeof(float) && ((size_t)refbuf & 3) == 0)
+    {
+        return Mat(w, (void*)refbuf);
+    }
+
+    Mat m(w);
+    if (m.empty())
+        return m;
+
+    if (nref == w * (int)sizeof(float))
+    {
+        // unaligned reference, fall back to copy
+        memcpy(m.data, refbuf, w * sizeof(float));
+        return m;
+    }
+
+    int nread = dr.read(m, w * sizeof(float));
+    if (nread != w * (int)sizeof(float))
+    {
+        fprintf(stderr, "ModelBin read weight_data failed %d\n", nread);
+        return Mat();
+    }
+
+    return m;
+}
+
 Mat ModelBinFromDataReader::load(int w, int type) const
 {
+    Mat codebook;
+    Mat m = load_pq(w, type, codebook);
+    if (m.empty() || codebook.empty())
+        return m;
+
+    return pq_decode(codebook, m);
+}
+
+Mat ModelBinFromDataReader::load_pq(int w, int type, Mat& codebook) const
+{
+    codebook.release();
+
     if (type == 0)
     {
         int nread;
@@ -112,81 +187,107 @@ Mat ModelBinFromDataReader::load(int w, int type) const
         }
         else if (flag_struct.tag == 0x0002C056)
         {
-            Mat m(w);
-            if (m.empty())
-                return m;
-
             // raw data with extra scaling
-            nread = dr.read(m, w * sizeof(float));
-            if (nread != w * (int)sizeof(float))
+            return load_float32(dr, w);
+        }
+        else if (flag_struct.tag == 0x0051500D)
+        {
+            // product-quantized data
+            // int d, int k, float codebook[k][d], unsigned char codes[w / d]
+            int pq_header[2];
+            nread = dr.read(pq_header, sizeof(pq_header));
+            if (nread != (int)sizeof(pq_header))
             {
-                fprintf(stderr, "ModelBin read weight_data failed %d\n", nread);
+                fprintf(stderr, "ModelBin read pq_header failed %d\n", nread);
                 return Mat();
             }
 
-            return m;
-        }
-
-        Mat m(w);
-        if (m.empty())
-            return m;
-
-        if (flag != 0)
-        {
-            // quantized data
-            float quantization_value[256];
-            nread = dr.read(quantization_value, 256 * sizeof(float));
-            if (nread != 256 * (int)sizeof(float))
+            const int d = pq_header[0];
+            const int k = pq_header[1];
+            if (d <= 0 || k <= 0 || k > 256 || w % d != 0)
             {
-                fprintf(stderr, "ModelBin read quantization_value failed %d\n", nread);
+                fprintf(stderr, "ModelBin invalid pq d=%d k=%d for w=%d\n", d, k, w);
                 return Mat();
             }
 
-            int align_weight_data_size = alignSize(w * sizeof(unsigned char), 4);
-            std::vector<unsigned char> index_array;
-            index_array.resize(align_weight_data_size);
-            nread = dr.read(index_array.data(), align_weight_data_size);
-            if (nread != align_weight_data_size)
+            Mat cb = load_float32(dr, k * d);
+            if (cb.empty())
+                return Mat();
+
+            const int n = w / d;
+            Mat codes(n, (size_t)1u);
+            if (codes.empty())
+                return codes;
+
+            int align_code_size = alignSize(n, 4);
+            nread = dr.read(codes, n);
+            if (nread != n)
             {
-                fprintf(stderr, "ModelBin read index_array failed %d\n", nread);
+                fprintf(stderr, "ModelBin read pq codes failed %d\n", nread);
                 return Mat();
             }
+            if (align_code_size != n)
+            {
+                unsigned char padding[4];
+                dr.read(padding, align_code_size - n);
+            }
 
-            float* ptr = m;
-            for (int i = 0; i < w; i++)
+            const unsigned char* code_ptr = codes;
+            for (int i = 0; i < n; i++)
             {
-                ptr[i] = quantization_value[ index_array[i] ];
+                if (code_ptr[i] >= k)
+                {
+                    fprintf(stderr, "ModelBin pq code %d out of range %d\n", code_ptr[i], k);
+                    return Mat();
+                }
             }
+
+            codebook = cb.reshape(d, k);
+            return codes;
         }
-        else if (flag_struct.f0 == 0)
+
+        if (flag == 0)
         {
             // raw data
-            nread = dr.read(m, w * sizeof(float));
-            if (nread != w * (int)sizeof(float))
-            {
-                fprintf(stderr, "ModelBin read weight_data failed %d\n", nread);
-                return Mat();
-            }
+            return load_float32(dr, w);
         }
 
-        return m;
-    }
-    else if (type == 1)
-    {
+        // quantized data
         Mat m(w);
         if (m.empty())
             return m;
 
-        // raw data
-        int nread = dr.read(m, w * sizeof(float));
-        if (nread != w * (int)sizeof(float))
+        float quantization_value[256];
+        nread = dr.read(quantization_value, 256 * sizeof(float));
+        if (nread != 256 * (int)sizeof(float))
+        {
+            fprintf(stderr, "ModelBin read quantization_value failed %d\n", nread);
+            return Mat();
+        }
+
+        int align_weight_data_size = alignSize(w * sizeof(unsigned char), 4);
+        std::vector<unsigned char> index_array;
+        index_array.resize(align_weight_data_size);
+        nread = dr.read(index_array.data(), align_weight_data_size);
+        if (nread != align_weight_data_size)
         {
-            fprintf(stderr, "ModelBin read weight_data failed %d\n", nread);
+            fprintf(stderr, "ModelBin read index_array failed %d\n", nread);
             return Mat();
         }
 
+        float* ptr = m;
+        for (int i = 0; i < w; i++)
+        {
+            ptr[i] = quantization_value[ index_array[i] ];
+        }
+
         return m;
     }
+    else if (type == 1)
+    {
+        // raw data
+        return load_float32(dr, w);
+    }
     else
     {
         fprintf(stderr, "ModelBin load type %d not implemented\n", type);
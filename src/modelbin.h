@@ -35,8 +35,15 @@ public:
     virtual Mat load(int w, int h, int type) const;
     // load dim
     virtual Mat load(int w, int h, int c, int type) const;
+    // load vec that may be stored product-quantized
+    // returns the byte codes and sets codebook to k x d when the data is product-quantized,
+    // otherwise returns the plain weight and leaves codebook empty
+    virtual Mat load_pq(int w, int type, Mat& codebook) const;
 };
 
+// expand product-quantized codes to float32 weight
+Mat pq_decode(const Mat& codebook, const Mat& codes);
+
 class ModelBinFromDataReader : public ModelBin
 {
 public:
@@ -44,6 +51,8 @@ public:
 
     virtual Mat load(int w, int type) const;
 
+    virtual Mat load_pq(int w, int type, Mat& codebook) const;
+
 protected:
     const DataReader& dr;
 };
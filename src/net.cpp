@@ -19,20 +19,31 @@
 #include "paramdict.h"
 #include "convolution.h"
 #include "convolutiondepthwise.h"
+#include "eltwise.h"
+#include "padding.h"
 #include "relu.h"
+#include "cpu.h"
 
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <algorithm>
+#include <functional>
 
 #ifdef _OPENMP
 #include <omp.h>
 #endif // _OPENMP
 
-#if NCNN_BENCHMARK
+#if NCNN_STDIO && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // NCNN_STDIO && !defined(_WIN32)
+
 #include "benchmark.h"
-#endif // NCNN_BENCHMARK
 
 #if NCNN_VULKAN
 #include "command.h"
@@ -40,8 +51,28 @@
 
 namespace ncnn {
 
+BlobMemoryPlan::BlobMemoryPlan()
+{
+    blob_index = -1;
+    lightmode = true;
+    arena_size = 0;
+    key = 0;
+    refcount = 0;
+}
+
 Net::Net()
 {
+    model_mapping = 0;
+    model_mapping_size = 0;
+
+    param_hash = 0;
+    tuned_num_threads = 0;
+
+    packing_eliminated_count = 0;
+
+    weight_cache_mapping = 0;
+    weight_cache_mapping_size = 0;
+
 #if NCNN_VULKAN
     vkdev = 0;
     weight_vkallocator = 0;
@@ -121,6 +152,82 @@ int Net::register_custom_layer(int index, layer_creator_func creator)
     return 0;
 }
 
+// 64-bit fnv-1a style hash over 8-byte words
+// used for param and weight cache keys, not for security
+static uint64_t hash_init()
+{
+    return 0xcbf29ce484222325ULL;
+}
+
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* p = (const unsigned char*)data;
+
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        hash = (hash ^ v) * 0x100000001b3ULL;
+        hash ^= hash >> 32;
+    }
+
+    for (; size > 0; size--, p++)
+    {
+        hash = (hash ^ *p) * 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t hash_value(uint64_t hash, uint64_t v)
+{
+    return hash_bytes(hash, &v, sizeof(v));
+}
+
+// hash model data on its way to ModelBin
+class DataReaderHashing : public DataReader
+{
+public:
+    DataReaderHashing(const DataReader& _dr) : dr(_dr), hash(hash_init()) {}
+
+    virtual int read(void* buf, int size) const
+    {
+        int nread = dr.read(buf, size);
+        if (nread > 0)
+            hash = hash_bytes(hash, buf, nread);
+        return nread;
+    }
+
+    virtual int reference(int size, const void** buf) const
+    {
+        int nref = dr.reference(size, buf);
+        if (nref > 0)
+            hash = hash_bytes(hash, *buf, nref);
+        return nref;
+    }
+
+    const DataReader& dr;
+    mutable uint64_t hash;
+};
+
+void Net::update_param_hash(int typeindex, const ParamDict& pd)
+{
+    param_hash = hash_value(param_hash, (uint64_t)(unsigned int)typeindex);
+
+    for (int i=0; i<NCNN_MAX_PARAM_COUNT; i++)
+    {
+        if (!pd.params[i].loaded)
+            continue;
+
+        param_hash = hash_value(param_hash, (uint64_t)i);
+        param_hash = hash_value(param_hash, (uint64_t)(unsigned int)pd.params[i].i);
+
+        const Mat& v = pd.params[i].v;
+        if (!v.empty())
+            param_hash = hash_bytes(param_hash, v.data, v.total() * v.elemsize);
+    }
+}
+
 int Net::load_param(const DataReader& dr)
 {
 #define SCAN_VALUE(fmt, v) \
@@ -150,6 +257,8 @@ int Net::load_param(const DataReader& dr)
     }
 
     layers.resize((size_t)layer_count);
+
+    param_hash = hash_init();
     blobs.resize((size_t)blob_count);
 
 #if NCNN_VULKAN
@@ -264,11 +373,13 @@ int Net::load_param(const DataReader& dr)
             continue;
         }
 
+        update_param_hash(layer->typeindex, pd);
+
         layers[i] = layer;
     }
 
 #undef SCAN_VALUE
-    return 0;
+    return build_schedule();
 }
 
 int Net::load_param_bin(const DataReader& dr)
@@ -299,6 +410,8 @@ int Net::load_param_bin(const DataReader& dr)
     }
 
     layers.resize(layer_count);
+
+    param_hash = hash_init();
     blobs.resize(blob_count);
 
 #if NCNN_VULKAN
@@ -395,11 +508,275 @@ int Net::load_param_bin(const DataReader& dr)
             continue;
         }
 
+        update_param_hash(layer->typeindex, pd);
+
         layers[i] = layer;
     }
 
 #undef READ_VALUE
-    return 0;
+    return build_schedule();
+}
+
+static const int GRAPH_PARAM_MAGIC = 0x6e636770;
+static const int GRAPH_PARAM_VERSION = 1;
+// upper bound of the layer, blob and type counts of a graph param header
+static const int GRAPH_PARAM_MAX_COUNT = 1 << 24;
+
+int Net::load_param_graph(const DataReader& dr)
+{
+    // magic, version, layer_count, blob_count, type_count, string_bytes, layer_words
+    int header[7];
+    if (dr.read(header, sizeof(header)) != (int)sizeof(header))
+    {
+        fprintf(stderr, "read graph param header failed\n");
+        return -1;
+    }
+
+    if (header[0] != GRAPH_PARAM_MAGIC || header[1] != GRAPH_PARAM_VERSION)
+    {
+        fprintf(stderr, "graph param magic or version mismatch, please regenerate\n");
+        return -1;
+    }
+
+    const int layer_count = header[2];
+    const int blob_count = header[3];
+    const int type_count = header[4];
+    const int string_bytes = header[5];
+    const int layer_words = header[6];
+    if (layer_count <= 0 || blob_count <= 0 || type_count <= 0 || string_bytes <= 0 || string_bytes % 4 != 0 || layer_words <= 0
+        || layer_count > GRAPH_PARAM_MAX_COUNT || blob_count > GRAPH_PARAM_MAX_COUNT || type_count > GRAPH_PARAM_MAX_COUNT)
+    {
+        fprintf(stderr, "invalid graph param header\n");
+        return -1;
+    }
+
+    // string table, type table, blob table and layer records in one block
+    // referenced in place when the reader can, read at once otherwise
+    // the header fields are untrusted, sum them without overflow
+    const uint64_t body_words64 = (uint64_t)string_bytes / 4 + (uint64_t)type_count * 2 + (uint64_t)blob_count + (uint64_t)layer_words;
+    const uint64_t body_bytes64 = body_words64 * sizeof(int);
+
+    // every layer record takes at least type, name, bottom_count, top_count and param count
+    if (body_bytes64 > (uint64_t)INT_MAX || (uint64_t)layer_count * 5 > (uint64_t)layer_words)
+    {
+        fprintf(stderr, "invalid graph param header\n");
+        return -1;
+    }
+
+    const size_t body_words = (size_t)body_words64;
+    const int body_bytes = (int)body_bytes64;
+
+    const int* body = 0;
+    std::vector<int> body_data;
+    if (dr.reference(body_bytes, (const void**)&body) != body_bytes)
+    {
+        // grow with the bytes actually read, a truncated file fails before a huge allocation
+        const size_t chunk_words = 1 << 18;
+        for (size_t read_words = 0; read_words < body_words; )
+        {
+            const size_t words = std::min(body_words - read_words, chunk_words);
+            body_data.resize(read_words + words);
+            if (dr.read(body_data.data() + read_words, (int)(words * sizeof(int))) != (int)(words * sizeof(int)))
+            {
+                fprintf(stderr, "read graph param body failed\n");
+                return -1;
+            }
+
+            read_words += words;
+        }
+
+        body = body_data.data();
+    }
+
+    const char* strings = (const char*)body;
+    const int* type_table = body + string_bytes / 4;
+    const int* blob_table = type_table + type_count * 2;
+    const int* mem = blob_table + blob_count;
+    const int* end = mem + layer_words;
+
+    if (strings[string_bytes - 1] != '\0')
+    {
+        fprintf(stderr, "invalid graph param string table\n");
+        return -1;
+    }
+
+    layers.resize(layer_count);
+
+    param_hash = hash_init();
+    blobs.resize(blob_count);
+
+#if NCNN_VULKAN
+    if (opt.use_vulkan_compute)
+    {
+        if (!vkdev) vkdev = get_gpu_device();
+        if (!vkdev) opt.use_vulkan_compute = false;// no vulkan device, fallback to cpu
+    }
+    if (opt.use_vulkan_compute)
+    {
+        // sanitize use options
+        if (!vkdev->info.support_fp16_packed) opt.use_fp16_packed = false;
+        if (!vkdev->info.support_fp16_storage) opt.use_fp16_storage = false;
+        if (!vkdev->info.support_fp16_arithmetic) opt.use_fp16_arithmetic = false;
+        if (!vkdev->info.support_int8_storage) opt.use_int8_storage = false;
+        if (!vkdev->info.support_int8_arithmetic) opt.use_int8_arithmetic = false;
+    }
+#endif // NCNN_VULKAN
+
+    // resolve each layer type once
+    std::vector<int> typeindexes(type_count);
+    for (int i=0; i<type_count; i++)
+    {
+        const int type_offset = type_table[i * 2];
+        if (type_offset < 0 || type_offset >= string_bytes)
+        {
+            fprintf(stderr, "invalid graph param type %d\n", i);
+            clear();
+            return -1;
+        }
+
+#if NCNN_STRING
+        const char* layer_type = strings + type_offset;
+        int typeindex = layer_to_index(layer_type);
+        if (typeindex == -1)
+        {
+            int custom_index = custom_layer_to_index(layer_type);
+            if (custom_index != -1)
+                typeindex = custom_index | LayerType::CustomBit;
+        }
+#else
+        // registry index at conversion time
+        int typeindex = type_table[i * 2 + 1];
+#endif // NCNN_STRING
+
+        typeindexes[i] = typeindex;
+    }
+
+#if NCNN_STRING
+    for (int i=0; i<blob_count; i++)
+    {
+        const int name_offset = blob_table[i];
+        if (name_offset < 0 || name_offset >= string_bytes)
+        {
+            fprintf(stderr, "invalid graph param blob %d\n", i);
+            clear();
+            return -1;
+        }
+
+        blobs[i].name = std::string(strings + name_offset);
+    }
+#endif // NCNN_STRING
+
+    ParamDict pd;
+
+    for (int i=0; i<layer_count; i++)
+    {
+        // type, name, bottom_count, top_count, bottoms, tops, params
+        if (end - mem < 4)
+        {
+            fprintf(stderr, "read graph param layer %d failed\n", i);
+            clear();
+            return -1;
+        }
+
+        const int type = mem[0];
+        const int name_offset = mem[1];
+        const int bottom_count = mem[2];
+        const int top_count = mem[3];
+        mem += 4;
+
+        if (type < 0 || type >= type_count || name_offset < 0 || name_offset >= string_bytes
+            || bottom_count < 0 || top_count < 0 || (int64_t)(end - mem) < (int64_t)bottom_count + top_count)
+        {
+            fprintf(stderr, "invalid graph param layer %d\n", i);
+            clear();
+            return -1;
+        }
+
+        const int typeindex = typeindexes[type];
+
+        Layer* layer = 0;
+        if (typeindex != -1)
+        {
+            if (typeindex & LayerType::CustomBit)
+                layer = create_custom_layer(typeindex & ~LayerType::CustomBit);
+            else
+                layer = create_layer(typeindex);
+        }
+        if (!layer)
+        {
+            fprintf(stderr, "layer %s not exists or registered\n", strings + type_table[type * 2]);
+            clear();
+            return -1;
+        }
+
+#if NCNN_VULKAN
+        if (opt.use_vulkan_compute)
+            layer->vkdev = vkdev;
+#endif // NCNN_VULKAN
+
+#if NCNN_STRING
+        layer->type = std::string(strings + type_table[type * 2]);
+        layer->name = std::string(strings + name_offset);
+#endif // NCNN_STRING
+
+        layer->bottoms.resize(bottom_count);
+        for (int j=0; j<bottom_count; j++)
+        {
+            int bottom_blob_index = *mem++;
+            if (bottom_blob_index < 0 || bottom_blob_index >= blob_count)
+            {
+                fprintf(stderr, "invalid graph param blob index %d\n", bottom_blob_index);
+                delete layer;
+                clear();
+                return -1;
+            }
+
+            blobs[bottom_blob_index].consumers.push_back(i);
+
+            layer->bottoms[j] = bottom_blob_index;
+        }
+
+        layer->tops.resize(top_count);
+        for (int j=0; j<top_count; j++)
+        {
+            int top_blob_index = *mem++;
+            if (top_blob_index < 0 || top_blob_index >= blob_count)
+            {
+                fprintf(stderr, "invalid graph param blob index %d\n", top_blob_index);
+                delete layer;
+                clear();
+                return -1;
+            }
+
+            blobs[top_blob_index].producer = i;
+
+            layer->tops[j] = top_blob_index;
+        }
+
+        // layer specific params
+        int pdlr = pd.load_param_graph(mem, end);
+        if (pdlr != 0)
+        {
+            fprintf(stderr, "ParamDict load_param failed\n");
+            delete layer;
+            clear();
+            return -1;
+        }
+
+        int lr = layer->load_param(pd);
+        if (lr != 0)
+        {
+            fprintf(stderr, "layer load_param failed\n");
+            delete layer;
+            continue;
+        }
+
+        update_param_hash(layer->typeindex, pd);
+
+        layers[i] = layer;
+    }
+
+    return build_schedule();
 }
 
 int Net::load_model(const DataReader& dr)
@@ -416,7 +793,14 @@ int Net::load_model(const DataReader& dr)
     // load file
     int ret = 0;
 
+#if NCNN_STDIO
+    // weight data is hashed for the weight cache key
+    const bool use_weight_cache = !weight_cache_dir.empty();
+    DataReaderHashing hdr(dr);
+    ModelBinFromDataReader mb(use_weight_cache ? (const DataReader&)hdr : dr);
+#else
     ModelBinFromDataReader mb(dr);
+#endif // NCNN_STDIO
     for (size_t i=0; i<layers.size(); i++)
     {
         Layer* layer = layers[i];
@@ -436,6 +820,27 @@ int Net::load_model(const DataReader& dr)
             ret = -1;
             break;
         }
+    }
+
+#if NCNN_STDIO
+    uint64_t cache_key = 0;
+    std::string cache_path;
+    bool cache_restored = false;
+    if (ret == 0 && use_weight_cache)
+    {
+        cache_key = weight_cache_key(hdr.hash);
+
+        char cache_name[64];
+        sprintf(cache_name, "/%016llx.ncnnweightcache", (unsigned long long)cache_key);
+        cache_path = weight_cache_dir + cache_name;
+
+        cache_restored = load_weight_cache(cache_path.c_str(), cache_key) == 0;
+    }
+#endif // NCNN_STDIO
+
+    for (size_t i=0; i<layers.size() && ret == 0; i++)
+    {
+        Layer* layer = layers[i];
 
         int cret = layer->create_pipeline(opt);
         if (cret != 0)
@@ -446,6 +851,14 @@ int Net::load_model(const DataReader& dr)
         }
     }
 
+#if NCNN_STDIO
+    if (ret == 0 && use_weight_cache && !cache_restored)
+    {
+        // a cache we can not write only costs the transforms next time
+        save_weight_cache(cache_path.c_str(), cache_key);
+    }
+#endif // NCNN_STDIO
+
 #if NCNN_VULKAN
     if (opt.use_vulkan_compute)
     {
@@ -457,6 +870,11 @@ int Net::load_model(const DataReader& dr)
 
     fuse_network();
 
+    if (ret == 0 && opt.use_packing_layout && !opt.use_vulkan_compute)
+    {
+        ret = plan_packing_layout();
+    }
+
     return ret;
 }
 
@@ -513,6 +931,26 @@ int Net::load_param_bin(const char* protopath)
     return ret;
 }
 
+int Net::load_param_graph(FILE* fp)
+{
+    DataReaderFromStdio dr(fp);
+    return load_param_graph(dr);
+}
+
+int Net::load_param_graph(const char* graphpath)
+{
+    FILE* fp = fopen(graphpath, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", graphpath);
+        return -1;
+    }
+
+    int ret = load_param_graph(fp);
+    fclose(fp);
+    return ret;
+}
+
 int Net::load_model(FILE* fp)
 {
     DataReaderFromStdio dr(fp);
@@ -532,484 +970,2125 @@ int Net::load_model(const char* modelpath)
     fclose(fp);
     return ret;
 }
-#endif // NCNN_STDIO
 
-int Net::load_param(const unsigned char* _mem)
+static void unmap_file(void* mapping, size_t size)
 {
-    const unsigned char* mem = _mem;
-    DataReaderFromMemory dr(mem);
-    load_param_bin(dr);
-    return mem - _mem;
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, size);
+#endif
 }
 
-int Net::load_model(const unsigned char* _mem)
+// map the whole file copy on write
+// data stays shared with the page cache unless written
+// return null if failed
+static void* map_file(const char* path, size_t* size)
 {
-    const unsigned char* mem = _mem;
-    DataReaderFromMemory dr(mem);
-    load_model(dr);
-    return mem - _mem;
-}
+    void* mapping = 0;
+    *size = 0;
 
-#if __ANDROID_API__ >= 9
-#if NCNN_STRING
-int Net::load_param(AAsset* asset)
-{
-    DataReaderFromAndroidAsset dr(asset);
-    return load_param(dr);
-}
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
 
-int Net::load_param(AAssetManager* mgr, const char* assetpath)
-{
-    AAsset* asset = AAssetManager_open(mgr, assetpath, AASSET_MODE_BUFFER);
-    if (!asset)
+    LARGE_INTEGER filesize;
+    if (GetFileSizeEx(file, &filesize) && filesize.QuadPart > 0)
     {
-        fprintf(stderr, "AAssetManager_open %s failed\n", assetpath);
-        return -1;
+        HANDLE filemapping = CreateFileMappingA(file, 0, PAGE_WRITECOPY, 0, 0, 0);
+        if (filemapping)
+        {
+            mapping = MapViewOfFile(filemapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(filemapping);
+        }
+
+        if (mapping)
+            *size = (size_t)filesize.QuadPart;
     }
 
-    int ret = load_param(asset);
-    AAsset_close(asset);
-    return ret;
-}
-#endif // NCNN_STRING
+    CloseHandle(file);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
 
-int Net::load_param_bin(AAsset* asset)
-{
-    DataReaderFromAndroidAsset dr(asset);
-    return load_param_bin(dr);
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        mapping = mmap(0, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+            mapping = 0;
+
+        if (mapping)
+            *size = (size_t)st.st_size;
+    }
+
+    close(fd);
+#endif
+
+    return mapping;
 }
 
-int Net::load_param_bin(AAssetManager* mgr, const char* assetpath)
+int Net::load_model_mmap(const char* modelpath)
 {
-    AAsset* asset = AAssetManager_open(mgr, assetpath, AASSET_MODE_BUFFER);
-    if (!asset)
+    size_t size = 0;
+    void* mapping = map_file(modelpath, &size);
+    if (!mapping)
     {
-        fprintf(stderr, "AAssetManager_open %s failed\n", assetpath);
+        fprintf(stderr, "mmap %s failed\n", modelpath);
         return -1;
     }
 
-    int ret = load_param_bin(asset);
-    AAsset_close(asset);
+    DataReaderFromMapping dr((const unsigned char*)mapping, size);
+    int ret = load_model(dr);
+    if (ret != 0)
+    {
+        // layers reached by the failed load reference the new mapping, the others still the old one
+        // drop every layer before releasing either mapping
+        clear();
+        unmap_file(mapping, size);
+        return ret;
+    }
+
+    // every layer reloaded its weight data from the new mapping
+    if (model_mapping)
+        unmap_file(model_mapping, model_mapping_size);
+
+    model_mapping = mapping;
+    model_mapping_size = size;
+
     return ret;
 }
 
-int Net::load_model(AAsset* asset)
+int Net::set_weight_cache_dir(const char* cachedir)
 {
-    DataReaderFromAndroidAsset dr(asset);
-    return load_model(dr);
+    weight_cache_dir = cachedir ? cachedir : "";
+    return 0;
 }
 
-int Net::load_model(AAssetManager* mgr, const char* assetpath)
+// weight cache file layout
+// header, one entry per pipeline weight of every layer in layer order,
+// then mat data at 64-byte aligned offsets
+struct WeightCacheHeader
 {
-    AAsset* asset = AAssetManager_open(mgr, assetpath, AASSET_MODE_STREAMING);
-    if (!asset)
-    {
-        fprintf(stderr, "AAssetManager_open %s failed\n", assetpath);
-        return -1;
-    }
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint64_t entry_count;
+};
 
-    int ret = load_model(asset);
-    AAsset_close(asset);
-    return ret;
+struct WeightCacheEntry
+{
+    int32_t layer_index;
+    int32_t weight_index;
+    int32_t dims;
+    int32_t w;
+    int32_t h;
+    int32_t c;
+    int32_t elempack;
+    int32_t elemsize;
+    uint64_t cstep;
+    uint64_t offset;
+};
+
+static const uint32_t WEIGHT_CACHE_MAGIC = 0x6e63776b;
+static const uint32_t WEIGHT_CACHE_VERSION = 5;
+
+uint64_t Net::weight_cache_key(uint64_t weight_hash) const
+{
+    // instruction sets the transforms were compiled for
+    uint64_t isa = sizeof(void*);
+#if __SSE2__
+    isa |= 1 << 8;
+#endif
+#if __AVX__
+    isa |= 1 << 9;
+#endif
+#if __AVX2__
+    isa |= 1 << 10;
+#endif
+#if __FMA__
+    isa |= 1 << 11;
+#endif
+#if __AVX512F__
+    isa |= 1 << 12;
+#endif
+#if __AVX512VNNI__
+    isa |= 1 << 13;
+#endif
+#if __ARM_NEON
+    isa |= 1 << 16;
+#endif
+#if __aarch64__
+    isa |= 1 << 17;
+#endif
+#if NCNN_AVX2
+    isa |= 1 << 24;
+#endif
+#if BISONAI_KILL_THE_BITS
+    isa |= 1 << 25;
+#endif
+    // x86 layer variant picked at runtime
+    isa |= (uint64_t)get_cpu_x86_isa() << 26;
+
+    // option flags deciding which transforms create_pipeline runs
+    uint64_t flags = 0;
+    flags |= opt.use_winograd_convolution ? 1 : 0;
+    flags |= opt.use_sgemm_convolution ? 2 : 0;
+    flags |= opt.use_int8_inference ? 4 : 0;
+    flags |= opt.use_packing_layout ? 8 : 0;
+    flags |= opt.use_winograd43_convolution ? 16 : 0;
+    flags |= opt.use_winograd63_convolution ? 32 : 0;
+    flags |= opt.use_pq_lookup_table ? 64 : 0;
+    // use_implicit_gemm_convolution only changes how forward reads the input
+    // both sgemm paths take the same transformed kernel, so it is left out of the key
+
+    uint64_t key = hash_init();
+    key = hash_value(key, WEIGHT_CACHE_VERSION);
+    key = hash_value(key, param_hash);
+    key = hash_value(key, weight_hash);
+    key = hash_value(key, isa);
+    key = hash_value(key, flags);
+    return key;
 }
-#endif // __ANDROID_API__ >= 9
 
-int Net::fuse_network()
+int Net::load_weight_cache(const char* cachepath, uint64_t key)
 {
-    // set the int8 op fusion:requantize
-#if NCNN_STRING && NCNN_REQUANT
-    // fprintf(stderr, "Test op fusion to int8 implement:\n");
-    // parse the network whether is a quantization model
-    bool net_quantized = false;
-    for (size_t i=0; i<layers.size(); i++)
+    size_t size = 0;
+    unsigned char* mapping = (unsigned char*)map_file(cachepath, &size);
+    if (!mapping)
+        return -1;
+
+    const WeightCacheHeader* header = (const WeightCacheHeader*)mapping;
+    if (size < sizeof(WeightCacheHeader) || header->magic != WEIGHT_CACHE_MAGIC || header->version != WEIGHT_CACHE_VERSION || header->key != key
+        || header->entry_count > (size - sizeof(WeightCacheHeader)) / sizeof(WeightCacheEntry))
     {
-        Layer* layer = layers[i];
-        if (layer->type == "Convolution" || layer->type == "ConvolutionDepthWise")
-        {
-            if (layer->type == "Convolution" && (((Convolution*)layer)->use_int8_inference == false))
-                continue;
-            if (layer->type == "ConvolutionDepthWise" && (((ConvolutionDepthWise*)layer)->use_int8_inference == false))
-                continue;
-            net_quantized = true;
-        }
+        fprintf(stderr, "weight cache %s mismatch, rebuild\n", cachepath);
+        unmap_file(mapping, size);
+        return -1;
     }
 
-    if (net_quantized == false)
-        return 0;
+    const WeightCacheEntry* entries = (const WeightCacheEntry*)(mapping + sizeof(WeightCacheHeader));
+    const size_t entry_count = (size_t)header->entry_count;
 
-    for (size_t i=0; i<layers.size(); i++)
+    int ret = 0;
+    size_t entry = 0;
+    std::vector<Mat*> weights;
+    for (size_t i=0; i<layers.size() && ret == 0; i++)
     {
-        Layer* layer = layers[i];
+        layers[i]->pipeline_weights(weights);
 
-        if (layer->type == "Convolution" || layer->type == "ConvolutionDepthWise")
+        for (size_t j=0; j<weights.size(); j++, entry++)
         {
-            if (layer->type == "Convolution" && (((Convolution*)layer)->use_int8_inference == false))
-                continue;
-            if (layer->type == "ConvolutionDepthWise" && (((ConvolutionDepthWise*)layer)->use_int8_inference == false))
-                continue;
+            if (entry >= entry_count)
+            {
+                ret = -1;
+                break;
+            }
 
-            for (size_t n=0; n<blobs[layer->tops[0]].consumers.size(); n++)
+            const WeightCacheEntry& e = entries[entry];
+            if (e.layer_index != (int)i || e.weight_index != (int)j)
             {
-                int layer_next_index = blobs[layer->tops[0]].consumers[n];
-                Layer* layer_next = layers[layer_next_index];
+                ret = -1;
+                break;
+            }
 
-                if (layer_next->type == "Convolution" || layer_next->type == "ConvolutionDepthWise")
-                {
-                    if (layer_next->type == "Convolution" && ((Convolution*)layer_next)->use_int8_inference == false)
-                        continue;
-                    if (layer_next->type == "ConvolutionDepthWise" && ((ConvolutionDepthWise*)layer_next)->use_int8_inference == false)
-                        continue;
+            if (e.dims == 0)
+            {
+                *weights[j] = Mat();
+                continue;
+            }
 
-                    // fprintf(stderr, "%s, %s\n", layer->name.c_str(), layer_next->name.c_str());
-                    if (layer->type == "Convolution" && layer_next->type == "Convolution")
-                    {
-                        ((Convolution*)layer)->use_int8_requantize = true;
-                        ((Convolution*)layer)->top_blob_int8_scale = ((Convolution*)layer_next)->bottom_blob_int8_scale;
-                        ((Convolution*)layer)->create_requantize_op();
-                    }
-                    else if (layer->type == "ConvolutionDepthWise" && layer_next->type == "Convolution")
-                    {
-                        ((ConvolutionDepthWise*)layer)->use_int8_requantize = true;
-                        ((ConvolutionDepthWise*)layer)->top_blob_int8_scale = ((Convolution*)layer_next)->bottom_blob_int8_scale;
-                        ((ConvolutionDepthWise*)layer)->create_requantize_op();
-                    }
-                    else if (layer->type == "Convolution" && layer_next->type == "ConvolutionDepthWise")
-                    {
-                        ((Convolution*)layer)->use_int8_requantize = true;
-                        ((Convolution*)layer)->top_blob_int8_scale = ((ConvolutionDepthWise*)layer_next)->bottom_blob_int8_scales[0];
-                        ((Convolution*)layer)->create_requantize_op();
-                    }
-                    else
-                    {
-                        ((ConvolutionDepthWise*)layer)->use_int8_requantize = true;
-                        ((ConvolutionDepthWise*)layer)->top_blob_int8_scale = ((ConvolutionDepthWise*)layer_next)->bottom_blob_int8_scales[0];
-                        ((ConvolutionDepthWise*)layer)->create_requantize_op();
-                    }
-                }
-                else if (layer_next->type == "ReLU")
-                {
-                    int layer_next_2_index = blobs[layer_next->tops[0]].consumers[0];
-                    Layer* layer_next_2 = layers[layer_next_2_index];
+            Mat m;
+            if (e.dims == 1)
+                m = Mat(e.w, (void*)0, (size_t)e.elemsize, e.elempack);
+            else if (e.dims == 2)
+                m = Mat(e.w, e.h, (void*)0, (size_t)e.elemsize, e.elempack);
+            else if (e.dims == 3)
+                m = Mat(e.w, e.h, e.c, (void*)0, (size_t)e.elemsize, e.elempack);
 
-                    if (layer_next_2->type == "Convolution" || layer_next_2->type == "ConvolutionDepthWise")
-                    {
-                        if (layer_next_2->type == "Convolution" && ((Convolution*)layer_next_2)->use_int8_inference == false)
-                            continue;
-                        if (layer_next_2->type == "ConvolutionDepthWise" && ((ConvolutionDepthWise*)layer_next_2)->use_int8_inference == false)
-                            continue;
+            size_t nbytes = m.cstep * m.c * m.elemsize;
+            if (m.dims == 0 || m.cstep != e.cstep || e.offset % 64 != 0 || e.offset > size || nbytes > size - e.offset)
+            {
+                ret = -1;
+                break;
+            }
 
-                        fprintf(stderr, "%s, %s, %s\n", layer->name.c_str(), layer_next->name.c_str(), layer_next_2->name.c_str());
-                        if (layer->type == "Convolution" && layer_next_2->type == "Convolution")
-                        {
-                            ((Convolution*)layer)->use_int8_requantize = true;
-                            ((Convolution*)layer)->top_blob_int8_scale = ((Convolution*)layer_next_2)->bottom_blob_int8_scale;
-                            ((Convolution*)layer)->create_requantize_op();
-                        }
-                        else if (layer->type == "ConvolutionDepthWise" && layer_next_2->type == "Convolution")
-                        {
-                            ((ConvolutionDepthWise*)layer)->use_int8_requantize = true;
-                            ((ConvolutionDepthWise*)layer)->top_blob_int8_scale = ((Convolution*)layer_next_2)->bottom_blob_int8_scale;
-                            ((ConvolutionDepthWise*)layer)->create_requantize_op();
-                        }
-                        else if (layer->type == "Convolution" && layer_next_2->type == "ConvolutionDepthWise")
-                        {
-                            ((Convolution*)layer)->use_int8_requantize = true;
-                            ((Convolution*)layer)->top_blob_int8_scale = ((ConvolutionDepthWise*)layer_next_2)->bottom_blob_int8_scales[0];
-                            ((Convolution*)layer)->create_requantize_op();
-                        }
-                        else
-                        {
-                            ((ConvolutionDepthWise*)layer)->use_int8_requantize = true;
-                            ((ConvolutionDepthWise*)layer)->top_blob_int8_scale = ((ConvolutionDepthWise*)layer_next_2)->bottom_blob_int8_scales[0];
-                            ((ConvolutionDepthWise*)layer)->create_requantize_op();
-                        }
-                    }
-                    else if (layer_next_2->type == "Split")
-                    {
-                        bool all_conv = true;
-                        for (size_t i=0; i<layer_next_2->tops.size(); i++)
-                        {
-                            int layer_next_3_index = blobs[layer_next_2->tops[i]].consumers[0];
-                            if (layers[layer_next_3_index]->type != "Convolution" && layers[layer_next_3_index]->type != "ConvolutionDepthWise" && layers[layer_next_3_index]->type != "PriorBox" )
-                            {
-                                // fprintf(stderr, "%s, %s, %s, %s\n", layer->name.c_str(), layer_next->name.c_str(), layer_next_2->name.c_str(), layers[layer_next_3_index]->name.c_str());
-                                all_conv = false;
-                            }
-                        }
+            m.data = mapping + e.offset;
+            *weights[j] = m;
+        }
 
-                        if (all_conv == true && layer_next_2->tops.size() >= size_t(2))
-                        {
-                            // fprintf(stderr, "%s, %s, %s, ", layer->name.c_str(), layer_next->name.c_str(), layer_next_2->name.c_str());
-                            for (size_t i=0; i<layer_next_2->tops.size(); i++)
-                            {
-                                int layer_next_3_index = blobs[layer_next_2->tops[i]].consumers[0];
-                                Layer* layer_next_3 = layers[layer_next_3_index];
-
-                                // fprintf(stderr, "%s, ", layer_next_3->name.c_str());
-                                if (layer_next_3->type == "Convolution")
-                                {
-                                    ((Convolution*)layer)->top_blob_int8_scale = ((Convolution*)layer_next_3)->bottom_blob_int8_scale;
-                                }
-                            }
+        layers[i]->pipeline_weights_restored = !weights.empty();
+    }
 
-                            ((Convolution*)layer)->use_int8_requantize = true;
-                            ((Convolution*)layer)->create_requantize_op();
-                            // fprintf(stderr, "\n");
-                        }
-                    }
-                    else
-                    {
-                        // fprintf(stderr, "%s, %s\n", layer->name.c_str(), layer_next->name.c_str());
-                    }
-                }
-                else if (layer_next->type == "Pooling")
-                {
-                    // ToDo
-                }
-                else
-                {
-                    // fprintf(stderr, "%s\n", layer->name.c_str());
-                }
+    if (ret == 0 && entry != entry_count)
+        ret = -1;
+
+    if (ret != 0)
+    {
+        fprintf(stderr, "weight cache %s corrupted, rebuild\n", cachepath);
+
+        for (size_t i=0; i<layers.size(); i++)
+        {
+            layers[i]->pipeline_weights(weights);
+            for (size_t j=0; j<weights.size(); j++)
+            {
+                *weights[j] = Mat();
             }
+            layers[i]->pipeline_weights_restored = false;
         }
+
+        unmap_file(mapping, size);
+        return -1;
     }
-#endif
+
+    if (weight_cache_mapping)
+        unmap_file(weight_cache_mapping, weight_cache_mapping_size);
+
+    weight_cache_mapping = mapping;
+    weight_cache_mapping_size = size;
+
     return 0;
 }
 
-void Net::clear()
+int Net::save_weight_cache(const char* cachepath, uint64_t key)
 {
-#if NCNN_VULKAN
-    destroy_pipeline();
-#endif // NCNN_VULKAN
+    std::vector<WeightCacheEntry> entries;
+    std::vector<const Mat*> mats;
 
-    blobs.clear();
+    std::vector<Mat*> weights;
+    uint64_t offset = 0;
     for (size_t i=0; i<layers.size(); i++)
     {
-        int dret = layers[i]->destroy_pipeline(opt);
-        if (dret != 0)
+        layers[i]->pipeline_weights(weights);
+
+        for (size_t j=0; j<weights.size(); j++)
         {
-            fprintf(stderr, "layer destroy_pipeline failed\n");
-            // ignore anyway
+            const Mat& m = *weights[j];
+
+            WeightCacheEntry e;
+            memset(&e, 0, sizeof(e));
+            e.layer_index = (int)i;
+            e.weight_index = (int)j;
+
+            if (!m.empty())
+            {
+                e.dims = m.dims;
+                e.w = m.w;
+                e.h = m.h;
+                e.c = m.c;
+                e.elempack = m.elempack;
+                e.elemsize = (int)m.elemsize;
+                e.cstep = m.cstep;
+                e.offset = offset;
+
+                offset += alignSize(m.cstep * m.c * m.elemsize, 64);
+            }
+
+            entries.push_back(e);
+            mats.push_back(&m);
         }
+    }
 
-        delete layers[i];
+    if (entries.empty())
+        return 0;
+
+    const uint64_t data_offset = alignSize(sizeof(WeightCacheHeader) + entries.size() * sizeof(WeightCacheEntry), 64);
+    for (size_t i=0; i<entries.size(); i++)
+    {
+        if (entries[i].dims != 0)
+            entries[i].offset += data_offset;
     }
-    layers.clear();
 
-#if NCNN_VULKAN
-    if (weight_vkallocator)
+    // write aside and rename so that readers never see a partial file
+    std::string tmppath = std::string(cachepath) + ".tmp";
+    FILE* fp = fopen(tmppath.c_str(), "wb");
+    if (!fp)
     {
-        delete weight_vkallocator;
-        weight_vkallocator = 0;
+        fprintf(stderr, "fopen %s failed\n", tmppath.c_str());
+        return -1;
     }
-    if (weight_staging_vkallocator)
+
+    WeightCacheHeader header;
+    header.magic = WEIGHT_CACHE_MAGIC;
+    header.version = WEIGHT_CACHE_VERSION;
+    header.key = key;
+    header.entry_count = entries.size();
+
+    static const unsigned char zeros[64] = {0};
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    ok = ok && fwrite(entries.data(), sizeof(WeightCacheEntry), entries.size(), fp) == entries.size();
+
+    uint64_t written = sizeof(header) + entries.size() * sizeof(WeightCacheEntry);
+    for (size_t i=0; i<entries.size() && ok; i++)
     {
-        delete weight_staging_vkallocator;
-        weight_staging_vkallocator = 0;
+        const WeightCacheEntry& e = entries[i];
+        if (e.dims == 0)
+            continue;
+
+        ok = fwrite(zeros, 1, (size_t)(e.offset - written), fp) == (size_t)(e.offset - written);
+
+        size_t nbytes = mats[i]->cstep * mats[i]->c * mats[i]->elemsize;
+        ok = ok && fwrite(mats[i]->data, 1, nbytes, fp) == nbytes;
+
+        written = e.offset + nbytes;
     }
-#endif // NCNN_VULKAN
-}
 
-Extractor Net::create_extractor()
-{
-    return Extractor(this, blobs.size());
-}
+    ok = fclose(fp) == 0 && ok;
 
-#if NCNN_VULKAN
-void Net::set_vulkan_device(int device_index)
-{
-    vkdev = get_gpu_device(device_index);
-}
+    if (!ok || rename(tmppath.c_str(), cachepath) != 0)
+    {
+        fprintf(stderr, "write weight cache %s failed\n", cachepath);
+        remove(tmppath.c_str());
+        return -1;
+    }
 
-void Net::set_vulkan_device(const VulkanDevice* _vkdev)
-{
-    vkdev = _vkdev;
+    return 0;
 }
 
-const VulkanDevice* Net::vulkan_device() const
+static const int KERNEL_TABLE_VERSION = 1;
+
+uint64_t Net::kernel_table_key(int num_threads) const
 {
-    return vkdev;
+    // kernel timings only hold for the same model, isa, options and thread count
+    return hash_value(weight_cache_key(0), (uint64_t)num_threads);
 }
 
-int Net::upload_model()
+int Net::save_kernel_table(const char* tablepath) const
 {
-    ncnn::VkTransfer cmd(vkdev);
-
-    // create gpu device allocator if null
-    if (!weight_vkallocator)
-    {
-        weight_vkallocator = new VkWeightBufferAllocator(vkdev);
-    }
-    if (!weight_staging_vkallocator)
+    FILE* fp = fopen(tablepath, "wb");
+    if (!fp)
     {
-        weight_staging_vkallocator = new VkWeightStagingBufferAllocator(vkdev);
+        fprintf(stderr, "fopen %s failed\n", tablepath);
+        return -1;
     }
 
-    cmd.weight_vkallocator = weight_vkallocator;
-    cmd.staging_vkallocator = weight_staging_vkallocator;
+    // header, then one line per layer and bottom blob shape
+    // layer_index layer_name w h c elempack kernel
+    fprintf(fp, "%d %016llx\n", KERNEL_TABLE_VERSION, (unsigned long long)kernel_table_key(tuned_num_threads));
 
-    for (size_t i=0; i<layers.size(); i++)
+    for (size_t i=0; i<tuned_kernels.size(); i++)
     {
-        if (layers[i]->support_vulkan)
+        for (size_t j=0; j<tuned_kernels[i].size(); j++)
         {
-            int uret = layers[i]->upload_model(cmd, opt);
-            if (uret != 0)
-            {
-                fprintf(stderr, "layer upload_model %d failed\n", (int)i);
-                return -1;
-            }
+            const TunedKernel& t = tuned_kernels[i][j];
+            fprintf(fp, "%d %s %d %d %d %d %d\n", (int)i, layers[i]->name.empty() ? "-" : layers[i]->name.c_str(), t.w, t.h, t.c, t.elempack, t.kernel);
         }
     }
 
-    cmd.submit_and_wait();
+    if (fclose(fp) != 0)
+    {
+        fprintf(stderr, "write kernel table %s failed\n", tablepath);
+        return -1;
+    }
 
     return 0;
 }
 
-int Net::create_pipeline()
+int Net::load_kernel_table(const char* tablepath)
 {
-    if (opt.use_fp16_storage && vkdev->info.type != 0)
+    FILE* fp = fopen(tablepath, "rb");
+    if (!fp)
     {
-        {
-        cast_float32_to_float16 = ncnn::create_layer(ncnn::LayerType::Cast);
-        cast_float32_to_float16->vkdev = vkdev;
+        fprintf(stderr, "fopen %s failed\n", tablepath);
+        return -1;
+    }
 
-        ncnn::ParamDict pd;
-        pd.set(0, 1);
-        pd.set(1, 2);
+    int version = 0;
+    unsigned long long key = 0;
+    int nscan = fscanf(fp, "%d %llx", &version, &key);
+    if (nscan != 2 || version != KERNEL_TABLE_VERSION || key != (unsigned long long)kernel_table_key(opt.num_threads))
+    {
+        fprintf(stderr, "kernel table %s mismatch, autotune again\n", tablepath);
+        fclose(fp);
+        return -1;
+    }
 
-        cast_float32_to_float16->load_param(pd);
+    std::vector< std::vector<TunedKernel> > table(layers.size());
+
+    int layer_index = 0;
+    char layer_name[256];
+    TunedKernel t;
+    while (fscanf(fp, "%d %255s %d %d %d %d %d", &layer_index, layer_name, &t.w, &t.h, &t.c, &t.elempack, &t.kernel) == 7)
+    {
+        if (layer_index < 0 || layer_index >= (int)layers.size() || !layers[layer_index])
+        {
+            fprintf(stderr, "kernel table %s layer %d out of range\n", tablepath, layer_index);
+            fclose(fp);
+            return -1;
+        }
+
+        table[layer_index].push_back(t);
+    }
+
+    fclose(fp);
+
+    tuned_kernels.swap(table);
+    tuned_num_threads = opt.num_threads;
+
+    // shape plans memoized the kernels picked without the table
+    clear_memory_plans();
+
+    return 0;
+}
+#endif // NCNN_STDIO
+
+int Net::load_param(const unsigned char* _mem)
+{
+    const unsigned char* mem = _mem;
+    DataReaderFromMemory dr(mem);
+    load_param_bin(dr);
+    return mem - _mem;
+}
+
+int Net::load_param_graph(const unsigned char* _mem)
+{
+    const unsigned char* mem = _mem;
+    DataReaderFromMemory dr(mem);
+    int ret = load_param_graph(dr);
+    if (ret != 0)
+        return 0;
+    return mem - _mem;
+}
+
+int Net::load_model(const unsigned char* _mem)
+{
+    const unsigned char* mem = _mem;
+    DataReaderFromMemory dr(mem);
+    load_model(dr);
+    return mem - _mem;
+}
+
+#if __ANDROID_API__ >= 9
+#if NCNN_STRING
+int Net::load_param(AAsset* asset)
+{
+    DataReaderFromAndroidAsset dr(asset);
+    return load_param(dr);
+}
+
+int Net::load_param(AAssetManager* mgr, const char* assetpath)
+{
+    AAsset* asset = AAssetManager_open(mgr, assetpath, AASSET_MODE_BUFFER);
+    if (!asset)
+    {
+        fprintf(stderr, "AAssetManager_open %s failed\n", assetpath);
+        return -1;
+    }
+
+    int ret = load_param(asset);
+    AAsset_close(asset);
+    return ret;
+}
+#endif // NCNN_STRING
+
+int Net::load_param_bin(AAsset* asset)
+{
+    DataReaderFromAndroidAsset dr(asset);
+    return load_param_bin(dr);
+}
+
+int Net::load_param_bin(AAssetManager* mgr, const char* assetpath)
+{
+    AAsset* asset = AAssetManager_open(mgr, assetpath, AASSET_MODE_BUFFER);
+    if (!asset)
+    {
+        fprintf(stderr, "AAssetManager_open %s failed\n", assetpath);
+        return -1;
+    }
+
+    int ret = load_param_bin(asset);
+    AAsset_close(asset);
+    return ret;
+}
+
+int Net::load_model(AAsset* asset)
+{
+    DataReaderFromAndroidAsset dr(asset);
+    return load_model(dr);
+}
+
+int Net::load_model(AAssetManager* mgr, const char* assetpath)
+{
+    AAsset* asset = AAssetManager_open(mgr, assetpath, AASSET_MODE_STREAMING);
+    if (!asset)
+    {
+        fprintf(stderr, "AAssetManager_open %s failed\n", assetpath);
+        return -1;
+    }
+
+    int ret = load_model(asset);
+    AAsset_close(asset);
+    return ret;
+}
+#endif // __ANDROID_API__ >= 9
+
+#if NCNN_STRING && NCNN_REQUANT
+// int8 convolutions take an int8 bottom blob in any scale and requantize the top blob
+static bool int8_convolution(Layer* layer)
+{
+    if (layer->type == "Convolution")
+        return ((Convolution*)layer)->use_int8_inference;
+    if (layer->type == "ConvolutionDepthWise")
+        return ((ConvolutionDepthWise*)layer)->use_int8_inference;
+    return false;
+}
+
+// int8 convolution quantizing its bottom blob with one symmetric scale
+static bool int8_convolution_per_tensor(Layer* layer)
+{
+    if (layer->type == "Convolution")
+        return ((Convolution*)layer)->use_int8_inference && ((Convolution*)layer)->int8_scale_term != 3 && ((Convolution*)layer)->bottom_blob_int8_zero_point == 0;
+    if (layer->type == "ConvolutionDepthWise")
+        return ((ConvolutionDepthWise*)layer)->use_int8_inference && ((ConvolutionDepthWise*)layer)->int8_scale_term != 3;
+    return false;
+}
+
+// leading bottom blobs a layer forwards in int8, the rest are shape references
+// all but Eltwise keep the scale of the int8 bottom blobs on the top blobs
+static int int8_bottom_count(const Layer* layer)
+{
+    if (layer->type == "ReLU" || layer->type == "Split" || layer->type == "Pooling" || layer->type == "Crop" || layer->type == "Padding")
+        return 1;
+    if (layer->type == "Concat" || layer->type == "Eltwise")
+        return (int)layer->bottoms.size();
+    return 0;
+}
+
+// blobs sharing one int8 scale, union find over blob indexes
+static int int8_scale_group(std::vector<int>& group, int i)
+{
+    while (group[i] != i)
+    {
+        group[i] = group[group[i]];
+        i = group[i];
+    }
+    return i;
+}
+#endif // NCNN_STRING && NCNN_REQUANT
+
+int Net::fuse_network()
+{
+    // keep the blobs between int8 layers in int8:requantize
+#if NCNN_STRING && NCNN_REQUANT
+    const int layer_count = layers.size();
+    const int blob_count = blobs.size();
+
+    // blobs int8 layers produce and only int8 layers consume
+    std::vector<int> blob_int8(blob_count, 0);
+    for (int i=0; i<blob_count; i++)
+    {
+        const int producer = blobs[i].producer;
+        if (producer == -1 || !layers[producer])
+            continue;
+
+        Layer* layer = layers[producer];
+
+        // the requantize fuses relu only
+        bool int8 = int8_bottom_count(layer) > 0;
+        if (layer->type == "Convolution")
+            int8 = ((Convolution*)layer)->use_int8_inference && ((Convolution*)layer)->activation_type <= 1;
+        else if (layer->type == "ConvolutionDepthWise")
+            int8 = ((ConvolutionDepthWise*)layer)->use_int8_inference && ((ConvolutionDepthWise*)layer)->activation_type <= 1;
+
+        for (size_t j=0; int8 && j<blobs[i].consumers.size(); j++)
+        {
+            Layer* layer_next = layers[blobs[i].consumers[j]];
+            int8 = layer_next && (int8_convolution_per_tensor(layer_next) || int8_bottom_count(layer_next) > 0);
+        }
+
+        blob_int8[i] = int8 ? 1 : 0;
+    }
+
+    std::vector<int> group(blob_count);
+    std::vector<float> group_scales(blob_count);
+
+    bool dropped = true;
+    while (dropped)
+    {
+        // a layer forwarding int8 takes and makes int8 blobs only
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+
+            for (int i=0; i<layer_count; i++)
+            {
+                const Layer* layer = layers[i];
+                if (!layer)
+                    continue;
+
+                const int int8_bottoms = int8_bottom_count(layer);
+                if (int8_bottoms == 0)
+                    continue;
+
+                bool int8 = true;
+                for (int j=0; j<int8_bottoms; j++)
+                    int8 = int8 && blob_int8[layer->bottoms[j]];
+                for (size_t j=0; j<layer->tops.size(); j++)
+                    int8 = int8 && blob_int8[layer->tops[j]];
+
+                if (int8)
+                    continue;
+
+                for (int j=0; j<int8_bottoms; j++)
+                {
+                    changed = changed || blob_int8[layer->bottoms[j]];
+                    blob_int8[layer->bottoms[j]] = 0;
+                }
+                for (size_t j=0; j<layer->tops.size(); j++)
+                {
+                    changed = changed || blob_int8[layer->tops[j]];
+                    blob_int8[layer->tops[j]] = 0;
+                }
+            }
+        }
+
+        // blobs forwarded without requantize share the scale
+        for (int i=0; i<blob_count; i++)
+        {
+            group[i] = i;
+            group_scales[i] = 0.f;
+        }
+
+        for (int i=0; i<layer_count; i++)
+        {
+            const Layer* layer = layers[i];
+            if (!layer || layer->type == "Eltwise")
+                continue;
+
+            const int int8_bottoms = int8_bottom_count(layer);
+            if (int8_bottoms == 0 || !blob_int8[layer->bottoms[0]])
+                continue;
+
+            const int g = int8_scale_group(group, layer->bottoms[0]);
+            for (int j=1; j<int8_bottoms; j++)
+                group[int8_scale_group(group, layer->bottoms[j])] = g;
+            for (size_t j=0; j<layer->tops.size(); j++)
+                group[int8_scale_group(group, layer->tops[j])] = g;
+        }
+
+        // the widest range any int8 convolution consuming the group was calibrated with
+        for (int i=0; i<layer_count; i++)
+        {
+            Layer* layer = layers[i];
+            if (!layer || !int8_convolution(layer) || !blob_int8[layer->bottoms[0]])
+                continue;
+
+            float scale = layer->type == "Convolution" ? ((Convolution*)layer)->bottom_blob_int8_scale : ((ConvolutionDepthWise*)layer)->bottom_blob_int8_scales[0];
+
+            float& group_scale = group_scales[int8_scale_group(group, layer->bottoms[0])];
+            if (scale > 0.f && (group_scale == 0.f || scale < group_scale))
+                group_scale = scale;
+        }
+
+        // blobs only summed by Eltwise borrow the scale of its top blob
+        changed = true;
+        while (changed)
+        {
+            changed = false;
+
+            for (int i=0; i<layer_count; i++)
+            {
+                const Layer* layer = layers[i];
+                if (!layer || layer->type != "Eltwise" || !blob_int8[layer->tops[0]])
+                    continue;
+
+                const float scale = group_scales[int8_scale_group(group, layer->tops[0])];
+                if (scale == 0.f)
+                    continue;
+
+                for (size_t j=0; j<layer->bottoms.size(); j++)
+                {
+                    float& group_scale = group_scales[int8_scale_group(group, layer->bottoms[j])];
+                    if (group_scale == 0.f)
+                    {
+                        group_scale = scale;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        // blobs without any calibrated scale stay in fp32
+        dropped = false;
+        for (int i=0; i<blob_count; i++)
+        {
+            if (blob_int8[i] && group_scales[int8_scale_group(group, i)] == 0.f)
+            {
+                blob_int8[i] = 0;
+                dropped = true;
+            }
+        }
+    }
+
+    for (int i=0; i<layer_count; i++)
+    {
+        Layer* layer = layers[i];
+        if (!layer)
+            continue;
+
+        if (int8_convolution(layer))
+        {
+            // dequantize with the scale the int8 bottom blob comes in
+            const int bottom_blob_index = layer->bottoms[0];
+            if (blob_int8[bottom_blob_index])
+            {
+                const float scale = group_scales[int8_scale_group(group, bottom_blob_index)];
+                if (layer->type == "Convolution" && ((Convolution*)layer)->bottom_blob_int8_scale != scale)
+                {
+                    ((Convolution*)layer)->bottom_blob_int8_scale = scale;
+                    ((Convolution*)layer)->create_dequantize_op();
+                }
+                else if (layer->type == "ConvolutionDepthWise" && ((ConvolutionDepthWise*)layer)->bottom_blob_int8_scales[0] != scale)
+                {
+                    ((ConvolutionDepthWise*)layer)->bottom_blob_int8_scales.fill(scale);
+                    ((ConvolutionDepthWise*)layer)->create_dequantize_op();
+                }
+            }
+
+            const int top_blob_index = layer->tops[0];
+            if (blob_int8[top_blob_index])
+            {
+                const float scale = group_scales[int8_scale_group(group, top_blob_index)];
+                if (layer->type == "Convolution")
+                {
+                    ((Convolution*)layer)->use_int8_requantize = true;
+                    ((Convolution*)layer)->top_blob_int8_scale = scale;
+                    ((Convolution*)layer)->create_requantize_op();
+                }
+                else
+                {
+                    ((ConvolutionDepthWise*)layer)->use_int8_requantize = true;
+                    ((ConvolutionDepthWise*)layer)->top_blob_int8_scale = scale;
+                    ((ConvolutionDepthWise*)layer)->create_requantize_op();
+                }
+            }
+        }
+        else if (layer->type == "Eltwise" && blob_int8[layer->tops[0]])
+        {
+            Eltwise* eltwise = (Eltwise*)layer;
+
+            eltwise->bottom_blob_int8_scales.resize(layer->bottoms.size());
+            for (size_t j=0; j<layer->bottoms.size(); j++)
+            {
+                eltwise->bottom_blob_int8_scales[j] = group_scales[int8_scale_group(group, layer->bottoms[j])];
+            }
+            eltwise->top_blob_int8_scale = group_scales[int8_scale_group(group, layer->tops[0])];
+        }
+        else if (layer->type == "Padding" && blob_int8[layer->bottoms[0]])
+        {
+            ((Padding*)layer)->bottom_blob_int8_scale = group_scales[int8_scale_group(group, layer->bottoms[0])];
+        }
+    }
+#endif
+    return 0;
+}
+
+void Net::clear()
+{
+#if NCNN_VULKAN
+    destroy_pipeline();
+#endif // NCNN_VULKAN
+
+    blobs.clear();
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        // layers failing load_param are left null
+        if (!layers[i])
+            continue;
+
+        int dret = layers[i]->destroy_pipeline(opt);
+        if (dret != 0)
+        {
+            fprintf(stderr, "layer destroy_pipeline failed\n");
+            // ignore anyway
+        }
+
+        delete layers[i];
+    }
+    layers.clear();
+    layer_schedule.clear();
+    layer_packing.clear();
+    packing_eliminated_count = 0;
+    tuned_kernels.clear();
+    tuned_num_threads = 0;
+
+#if NCNN_STDIO
+    if (model_mapping)
+    {
+        unmap_file(model_mapping, model_mapping_size);
+        model_mapping = 0;
+        model_mapping_size = 0;
+    }
+    if (weight_cache_mapping)
+    {
+        unmap_file(weight_cache_mapping, weight_cache_mapping_size);
+        weight_cache_mapping = 0;
+        weight_cache_mapping_size = 0;
+    }
+#endif // NCNN_STDIO
+
+    clear_memory_plans();
+
+#if NCNN_VULKAN
+    if (weight_vkallocator)
+    {
+        delete weight_vkallocator;
+        weight_vkallocator = 0;
+    }
+    if (weight_staging_vkallocator)
+    {
+        delete weight_staging_vkallocator;
+        weight_staging_vkallocator = 0;
+    }
+#endif // NCNN_VULKAN
+}
+
+int Net::packing_conversions_eliminated() const
+{
+    return packing_eliminated_count;
+}
+
+Extractor Net::create_extractor()
+{
+    return Extractor(this, blobs.size());
+}
+
+#if NCNN_VULKAN
+void Net::set_vulkan_device(int device_index)
+{
+    vkdev = get_gpu_device(device_index);
+}
+
+void Net::set_vulkan_device(const VulkanDevice* _vkdev)
+{
+    vkdev = _vkdev;
+}
+
+const VulkanDevice* Net::vulkan_device() const
+{
+    return vkdev;
+}
+
+int Net::upload_model()
+{
+    ncnn::VkTransfer cmd(vkdev);
+
+    // create gpu device allocator if null
+    if (!weight_vkallocator)
+    {
+        weight_vkallocator = new VkWeightBufferAllocator(vkdev);
+    }
+    if (!weight_staging_vkallocator)
+    {
+        weight_staging_vkallocator = new VkWeightStagingBufferAllocator(vkdev);
+    }
+
+    cmd.weight_vkallocator = weight_vkallocator;
+    cmd.staging_vkallocator = weight_staging_vkallocator;
+
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        if (layers[i]->support_vulkan)
+        {
+            int uret = layers[i]->upload_model(cmd, opt);
+            if (uret != 0)
+            {
+                fprintf(stderr, "layer upload_model %d failed\n", (int)i);
+                return -1;
+            }
+        }
+    }
+
+    cmd.submit_and_wait();
+
+    return 0;
+}
+
+int Net::create_pipeline()
+{
+    if (opt.use_fp16_storage && vkdev->info.type != 0)
+    {
+        {
+        cast_float32_to_float16 = ncnn::create_layer(ncnn::LayerType::Cast);
+        cast_float32_to_float16->vkdev = vkdev;
+
+        ncnn::ParamDict pd;
+        pd.set(0, 1);
+        pd.set(1, 2);
+
+        cast_float32_to_float16->load_param(pd);
+        }
+
+        {
+        cast_float16_to_float32 = ncnn::create_layer(ncnn::LayerType::Cast);
+        cast_float16_to_float32->vkdev = vkdev;
+
+        ncnn::ParamDict pd;
+        pd.set(0, 2);
+        pd.set(1, 1);
+
+        cast_float16_to_float32->load_param(pd);
+        }
+
+        cast_float32_to_float16->create_pipeline(opt);
+
+        cast_float16_to_float32->create_pipeline(opt);
+    }
+
+    {
+    packing_pack1 = ncnn::create_layer(ncnn::LayerType::Packing);
+    packing_pack1->vkdev = vkdev;
+
+    ncnn::ParamDict pd;
+    pd.set(0, 1);
+
+    packing_pack1->load_param(pd);
+    }
+
+    {
+    packing_pack4 = ncnn::create_layer(ncnn::LayerType::Packing);
+    packing_pack4->vkdev = vkdev;
+
+    ncnn::ParamDict pd;
+    pd.set(0, 4);
+
+    packing_pack4->load_param(pd);
+    }
+
+    packing_pack1->create_pipeline(opt);
+
+    packing_pack4->create_pipeline(opt);
+
+    return 0;
+}
+
+int Net::destroy_pipeline()
+{
+    if (cast_float32_to_float16)
+        cast_float32_to_float16->destroy_pipeline(opt);
+
+    if (cast_float16_to_float32)
+        cast_float16_to_float32->destroy_pipeline(opt);
+
+    if (packing_pack1)
+        packing_pack1->destroy_pipeline(opt);
+
+    if (packing_pack4)
+        packing_pack4->destroy_pipeline(opt);
+
+    return 0;
+}
+#endif // NCNN_VULKAN
+
+#if NCNN_STRING
+int Net::find_blob_index_by_name(const char* name) const
+{
+    for (size_t i=0; i<blobs.size(); i++)
+    {
+        const Blob& blob = blobs[i];
+        if (blob.name == name)
+        {
+            return i;
+        }
+    }
+
+    fprintf(stderr, "find_blob_index_by_name %s failed\n", name);
+    return -1;
+}
+
+int Net::find_layer_index_by_name(const char* name) const
+{
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        const Layer* layer = layers[i];
+        if (layer->name == name)
+        {
+            return i;
+        }
+    }
+
+    fprintf(stderr, "find_layer_index_by_name %s failed\n", name);
+    return -1;
+}
+
+int Net::custom_layer_to_index(const char* type)
+{
+    const int custom_layer_registry_entry_count = custom_layer_registry.size();
+    for (int i=0; i<custom_layer_registry_entry_count; i++)
+    {
+        if (strcmp(type, custom_layer_registry[i].name) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+Layer* Net::create_custom_layer(const char* type)
+{
+    int index = custom_layer_to_index(type);
+    if (index == -1)
+        return 0;
+
+    return create_custom_layer(index);
+}
+#endif // NCNN_STRING
+
+Layer* Net::create_custom_layer(int index)
+{
+    const int custom_layer_registry_entry_count = custom_layer_registry.size();
+    if (index < 0 || index >= custom_layer_registry_entry_count)
+        return 0;
+
+    layer_creator_func layer_creator = custom_layer_registry[index].creator;
+    if (!layer_creator)
+        return 0;
+
+    Layer* layer = layer_creator();
+    if (layer)
+        layer->typeindex = index | LayerType::CustomBit;
+    return layer;
+}
+
+#if !__ARM_NEON && __SSE2__
+// x86 layers run pack8 kernels when built for avx or dispatched to an avx variant
+static bool packing_x86_avx()
+{
+#if __AVX__
+    return true;
+#else
+    return get_cpu_x86_isa() >= 1;
+#endif
+}
+#endif
+
+// elempack a layer takes its bottom blob in when use_packing_layout is set
+// packing is the layout planned for the layer, 0 = pack1, 1 = packed, -1 = as is
+static int packing_elempack(const Layer* layer, int packing, const Mat& m)
+{
+    if (packing == -1)
+        return m.elempack;
+
+    if (!layer->support_packing || packing == 0)
+        return 1;
+
+    const int elemcount = (m.dims == 3 ? m.c : m.dims == 2 ? m.h : m.w) * m.elempack;
+
+#if !__ARM_NEON && __SSE2__
+    // x86 layers pack fp32 blobs only, eight lanes on avx and four on sse2
+    if (m.elemsize != 4u * m.elempack)
+        return 1;
+    if (packing_x86_avx() && elemcount % 8 == 0)
+        return 8;
+#endif
+
+    return elemcount % 4 == 0 ? 4 : 1;
+}
+
+// widest elempack of packing layers on this build
+static int packing_elempack_max()
+{
+#if !__ARM_NEON && __SSE2__
+    if (packing_x86_avx())
+        return 8;
+#endif
+    return 4;
+}
+
+// layers whose packed kernels pack the output whatever the input layout is
+static bool packing_source(const Layer* layer)
+{
+#if NCNN_STRING
+    // disabled layer types are not registered and never match
+    static const char* const source_types[] = { "Convolution", "ConvolutionDepthWise", "Deconvolution", "DeconvolutionDepthWise" };
+    for (int i=0; i<4; i++)
+    {
+        if (layer->typeindex == layer_to_index(source_types[i]))
+            return true;
+    }
+    return false;
+#else
+    return layer->typeindex == LayerType::Convolution;
+#endif // NCNN_STRING
+}
+
+// shape only mat header
+static Mat mat_shape(const Mat& m)
+{
+    if (m.dims == 1)
+        return Mat(m.w, (void*)0, m.elemsize, m.elempack);
+    if (m.dims == 2)
+        return Mat(m.w, m.h, (void*)0, m.elemsize, m.elempack);
+    if (m.dims == 3)
+        return Mat(m.w, m.h, m.c, (void*)0, m.elemsize, m.elempack);
+
+    return Mat();
+}
+
+static bool mat_shape_equal(const Mat& a, const Mat& b)
+{
+    return a.dims == b.dims && a.w == b.w && a.h == b.h && a.c == b.c && a.elemsize == b.elemsize && a.elempack == b.elempack;
+}
+
+// arena bytes taken by a blob, including the trailing refcount as Mat::create does
+static size_t planned_blob_size(const Mat& shape)
+{
+    size_t totalsize = alignSize(shape.total() * shape.elemsize, 4);
+    return alignSize(totalsize + sizeof(int), MALLOC_ALIGN);
+}
+
+static bool mat_overlap(const Mat& a, const Mat& b)
+{
+    if (!a.data || !b.data)
+        return false;
+
+    const unsigned char* a0 = (const unsigned char*)a.data;
+    const unsigned char* a1 = a0 + a.total() * a.elemsize;
+    const unsigned char* b0 = (const unsigned char*)b.data;
+    const unsigned char* b1 = b0 + b.total() * b.elemsize;
+
+    return a0 < b1 && b0 < a1;
+}
+
+static void record_planned_blob(BlobMemoryPlan* plan, const Layer* layer, int top_i, const Mat& top_blob, const Mat* bottom_blobs, const Option& opt)
+{
+    int top_blob_index = layer->tops[top_i];
+
+    // inplace and view-like layers share memory with one of the bottom blobs
+    for (size_t j=0; j<layer->bottoms.size(); j++)
+    {
+        if (mat_overlap(top_blob, bottom_blobs[j]))
+        {
+            plan->blob_alias[top_blob_index] = layer->bottoms[j];
+            return;
+        }
+    }
+
+    // only blobs freshly allocated by blob allocator can be placed in arena
+    if (top_blob.refcount && top_blob.allocator == opt.blob_allocator)
+    {
+        plan->blob_shapes[top_blob_index] = mat_shape(top_blob);
+    }
+}
+
+// construct top blob on the planned arena memory
+// the layer keeps it as long as the top blob shape matches the plan
+static void bind_planned_blob(const BlobMemoryPlan* plan, ArenaAllocator* arena, int blob_index, Mat& m)
+{
+    const Mat& shape = plan->blob_shapes[blob_index];
+    if (shape.dims == 0)
+        return;
+
+    unsigned char* ptr = arena->at(plan->blob_offsets[blob_index]);
+
+    if (shape.dims == 1)
+        m = Mat(shape.w, ptr, shape.elemsize, shape.elempack, arena);
+    if (shape.dims == 2)
+        m = Mat(shape.w, shape.h, ptr, shape.elemsize, shape.elempack, arena);
+    if (shape.dims == 3)
+        m = Mat(shape.w, shape.h, shape.c, ptr, shape.elemsize, shape.elempack, arena);
+
+    size_t totalsize = alignSize(m.total() * m.elemsize, 4);
+    m.refcount = (int*)(ptr + totalsize);
+    *m.refcount = 1;
+}
+
+// plans kept per net, the least recently used is dropped beyond this
+// extractors still holding a dropped plan keep it alive until they die
+static const size_t max_memory_plans = 16;
+
+// hash of the extracted blob and light mode, input shapes are folded in one by one
+static uint64_t memory_plan_key(int blob_index, bool lightmode)
+{
+    uint64_t key = hash_value(hash_init(), (uint64_t)(unsigned int)blob_index);
+    return hash_value(key, lightmode ? 1 : 0);
+}
+
+static uint64_t memory_plan_key(uint64_t key, int input_blob_index, const Mat& m)
+{
+    key = hash_value(key, (uint64_t)(unsigned int)input_blob_index);
+    key = hash_value(key, ((uint64_t)(unsigned int)m.dims << 32) | (unsigned int)m.elempack);
+    key = hash_value(key, ((uint64_t)(unsigned int)m.w << 32) | (unsigned int)m.h);
+    key = hash_value(key, ((uint64_t)(unsigned int)m.c << 32) | (unsigned int)m.elemsize);
+    return key;
+}
+
+const BlobMemoryPlan* Net::find_memory_plan(int blob_index, const std::vector<Mat>& blob_mats, const Option& opt)
+{
+    uint64_t key = memory_plan_key(blob_index, opt.lightmode);
+    for (size_t j=0; j<blob_mats.size(); j++)
+    {
+        if (blob_mats[j].dims != 0)
+            key = memory_plan_key(key, j, blob_mats[j]);
+    }
+
+    MutexLockGuard lock(memory_plans_lock);
+
+    for (size_t i=0; i<memory_plans.size(); i++)
+    {
+        BlobMemoryPlan* plan = memory_plans[i];
+        if (plan->key != key || plan->blob_index != blob_index || plan->lightmode != opt.lightmode)
+            continue;
+
+        // the extractor must hold exactly the planned inputs
+        size_t input_count = 0;
+        bool matched = true;
+        for (size_t j=0; j<blob_mats.size(); j++)
+        {
+            if (blob_mats[j].dims == 0)
+                continue;
+
+            if (input_count >= plan->input_blob_indexes.size() || plan->input_blob_indexes[input_count] != (int)j
+                || !mat_shape_equal(blob_mats[j], plan->input_blob_shapes[input_count]))
+            {
+                matched = false;
+                break;
+            }
+
+            input_count++;
+        }
+
+        if (!matched || input_count != plan->input_blob_indexes.size())
+            continue;
+
+        // most recently used last
+        memory_plans.erase(memory_plans.begin() + i);
+        memory_plans.push_back(plan);
+
+        plan->refcount++;
+        return plan;
+    }
+
+    return 0;
+}
+
+void Net::release_memory_plan(const BlobMemoryPlan* plan)
+{
+    MutexLockGuard lock(memory_plans_lock);
+
+    if (--((BlobMemoryPlan*)plan)->refcount == 0)
+        delete plan;
+}
+
+void Net::retain_memory_plan(const BlobMemoryPlan* plan)
+{
+    MutexLockGuard lock(memory_plans_lock);
+
+    ((BlobMemoryPlan*)plan)->refcount++;
+}
+
+void Net::clear_memory_plans()
+{
+    MutexLockGuard lock(memory_plans_lock);
+
+    for (size_t i=0; i<memory_plans.size(); i++)
+    {
+        if (--memory_plans[i]->refcount == 0)
+            delete memory_plans[i];
+    }
+    memory_plans.clear();
+}
+
+const BlobMemoryPlan* Net::add_memory_plan(BlobMemoryPlan* plan)
+{
+    const int blob_count = blobs.size();
+    const int step_count = plan->layer_order.size();
+
+    std::vector<int> layer_steps(layers.size(), -1);
+    for (int i=0; i<step_count; i++)
+    {
+        layer_steps[ plan->layer_order[i] ] = i;
+    }
+
+    // lifetime of each storage owner, in steps of layer execution order
+    // blobs not released before the extractor dies live till step_count
+    // the extracted blob escapes to the caller and is never placed in arena
+    std::vector<int> lifetime_begin(blob_count, -1);
+    std::vector<int> lifetime_end(blob_count, -1);
+    std::vector<bool> escaped(blob_count, false);
+
+    for (int i=0; i<blob_count; i++)
+    {
+        const Blob& blob = blobs[i];
+        if (blob.producer < 0 || layer_steps[blob.producer] == -1)
+            continue;
+
+        int end = -1;
+        if (!plan->lightmode || blob.consumers.empty())
+            end = step_count;
+
+        for (size_t j=0; j<blob.consumers.size(); j++)
+        {
+            int step = layer_steps[ blob.consumers[j] ];
+            end = std::max(end, step == -1 ? step_count : step);
+        }
+
+        int owner = i;
+        while (plan->blob_alias[owner] != -1)
+            owner = plan->blob_alias[owner];
+
+        if (owner == i)
+            lifetime_begin[i] = layer_steps[blob.producer];
+
+        lifetime_end[owner] = std::max(lifetime_end[owner], end);
+
+        if (i == plan->blob_index)
+            escaped[owner] = true;
+    }
+
+    // greedy placement, largest blob first
+    std::vector<std::pair<size_t, int> > placement_order;
+    for (int i=0; i<blob_count; i++)
+    {
+        if (plan->blob_shapes[i].dims == 0)
+            continue;
+
+        if (lifetime_begin[i] == -1 || escaped[i])
+        {
+            plan->blob_shapes[i] = Mat();
+            continue;
+        }
+
+        placement_order.push_back(std::make_pair(planned_blob_size(plan->blob_shapes[i]), i));
+    }
+
+    std::sort(placement_order.begin(), placement_order.end(), std::greater< std::pair<size_t, int> >());
+
+    plan->arena_size = 0;
+
+    std::vector<int> placed;
+    for (size_t i=0; i<placement_order.size(); i++)
+    {
+        size_t size = placement_order[i].first;
+        int b = placement_order[i].second;
+
+        // arena ranges occupied during the lifetime of b
+        std::vector<std::pair<size_t, size_t> > occupied;
+        for (size_t j=0; j<placed.size(); j++)
+        {
+            int p = placed[j];
+            if (lifetime_begin[p] <= lifetime_end[b] && lifetime_begin[b] <= lifetime_end[p])
+            {
+                size_t offset = plan->blob_offsets[p];
+                occupied.push_back(std::make_pair(offset, offset + planned_blob_size(plan->blob_shapes[p])));
+            }
+        }
+
+        std::sort(occupied.begin(), occupied.end());
+
+        // first fit
+        size_t offset = 0;
+        for (size_t j=0; j<occupied.size(); j++)
+        {
+            if (offset + size <= occupied[j].first)
+                break;
+
+            offset = std::max(offset, occupied[j].second);
+        }
+
+        plan->blob_offsets[b] = offset;
+        plan->arena_size = std::max(plan->arena_size, offset + size);
+
+        placed.push_back(b);
+    }
+
+    plan->key = memory_plan_key(plan->blob_index, plan->lightmode);
+    for (size_t i=0; i<plan->input_blob_indexes.size(); i++)
+    {
+        plan->key = memory_plan_key(plan->key, plan->input_blob_indexes[i], plan->input_blob_shapes[i]);
+    }
+
+    MutexLockGuard lock(memory_plans_lock);
+
+    // another extractor may have planned the same
+    for (size_t i=0; i<memory_plans.size(); i++)
+    {
+        BlobMemoryPlan* p = memory_plans[i];
+        if (p->key == plan->key && p->blob_index == plan->blob_index && p->lightmode == plan->lightmode && p->input_blob_indexes == plan->input_blob_indexes)
+        {
+            bool same_shapes = true;
+            for (size_t j=0; j<p->input_blob_shapes.size(); j++)
+            {
+                same_shapes = same_shapes && mat_shape_equal(p->input_blob_shapes[j], plan->input_blob_shapes[j]);
+            }
+
+            if (same_shapes)
+            {
+                delete plan;
+                p->refcount++;
+                return p;
+            }
+        }
+    }
+
+    // one reference for the net and one for the caller
+    plan->refcount = 2;
+    memory_plans.push_back(plan);
+
+    if (memory_plans.size() > max_memory_plans)
+    {
+        BlobMemoryPlan* lru = memory_plans[0];
+        memory_plans.erase(memory_plans.begin());
+
+        if (--lru->refcount == 0)
+            delete lru;
+    }
+
+    return plan;
+}
+
+int Net::build_schedule()
+{
+    const int layer_count = layers.size();
+
+    layer_schedule.clear();
+    layer_schedule.reserve(layer_count);
+
+    // kahn algorithm, layers that failed to load are left out
+    std::vector<int> indegrees(layer_count, 0);
+    std::vector<int> ready;
+    for (int i=0; i<layer_count; i++)
+    {
+        const Layer* layer = layers[i];
+        if (!layer)
+            continue;
+
+        for (size_t j=0; j<layer->bottoms.size(); j++)
+        {
+            int producer = blobs[layer->bottoms[j]].producer;
+            if (producer != -1 && layers[producer])
+                indegrees[i]++;
+        }
+
+        if (indegrees[i] == 0)
+            ready.push_back(i);
+    }
+
+    // keep the param file order whenever possible
+    size_t ready_pos = 0;
+    while (ready_pos < ready.size())
+    {
+        int i = ready[ready_pos++];
+        layer_schedule.push_back(i);
+
+        const Layer* layer = layers[i];
+        for (size_t j=0; j<layer->tops.size(); j++)
+        {
+            const Blob& blob = blobs[layer->tops[j]];
+            for (size_t k=0; k<blob.consumers.size(); k++)
+            {
+                int consumer = blob.consumers[k];
+                if (layers[consumer] && --indegrees[consumer] == 0)
+                    ready.push_back(consumer);
+            }
+        }
+    }
+
+    for (int i=0; i<layer_count; i++)
+    {
+        if (layers[i] && indegrees[i] != 0)
+        {
+            fprintf(stderr, "layer %d %s is in a cycle\n", i, layers[i]->name.c_str());
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// conversions a blob produced in packing layout needs, one per other layout its consumers take
+static int packing_conversion_count(const Blob& blob, int packing, const std::vector<int>& layer_packing)
+{
+    bool convert[2] = { false, false };
+    for (size_t i=0; i<blob.consumers.size(); i++)
+    {
+        const int consumer_packing = layer_packing[blob.consumers[i]];
+        if (consumer_packing != -1 && consumer_packing != packing)
+            convert[consumer_packing] = true;
+    }
+
+    return (convert[0] ? 1 : 0) + (convert[1] ? 1 : 0);
+}
+
+int Net::plan_packing_layout()
+{
+    // load_model on a planned net keeps the plan
+    if (!layer_packing.empty())
+        return 0;
+
+    const int layer_count = layers.size();
+    const int blob_count = blobs.size();
+
+    // layers that failed to load take nothing
+    layer_packing.resize(layer_count, -1);
+
+    // layout each blob is produced in, 0 = pack1, 1 = packed
+    std::vector<int> blob_packing(blob_count, 0);
+
+    // without the plan every packing layer packs its bottom blobs
+    // and every other layer unpacks them, once per consumer
+    std::vector<int> blob_packing_unplanned(blob_count, 0);
+    int conversion_count_unplanned = 0;
+
+    for (size_t i=0; i<layer_schedule.size(); i++)
+    {
+        const int layer_index = layer_schedule[i];
+        const Layer* layer = layers[layer_index];
+
+        // elementwise layers follow their bottom blobs so that a pack1 region stays pack1
+        int packing = 0;
+        if (layer->support_packing)
+        {
+            packing = packing_source(layer) ? 1 : 0;
+            for (size_t j=0; j<layer->bottoms.size(); j++)
+            {
+                packing |= blob_packing[layer->bottoms[j]];
+            }
+        }
+
+        layer_packing[layer_index] = packing;
+
+        const int packing_unplanned = layer->support_packing ? 1 : 0;
+        for (size_t j=0; j<layer->bottoms.size(); j++)
+        {
+            if (blob_packing_unplanned[layer->bottoms[j]] != packing_unplanned)
+                conversion_count_unplanned++;
+        }
+
+        for (size_t j=0; j<layer->tops.size(); j++)
+        {
+            blob_packing[layer->tops[j]] = packing;
+            blob_packing_unplanned[layer->tops[j]] = packing_unplanned;
+        }
+    }
+
+    // flip the layers that follow their bottom blobs wherever the other layout
+    // needs fewer conversions around them, every flip lowers the total so this ends
+    bool flipped = true;
+    while (flipped)
+    {
+        flipped = false;
+
+        for (int i=(int)layer_schedule.size() - 1; i>=0; i--)
+        {
+            const int layer_index = layer_schedule[i];
+            const Layer* layer = layers[layer_index];
+            if (!layer->support_packing || packing_source(layer))
+                continue;
+
+            int conversion_count[2] = { 0, 0 };
+            const int packing = layer_packing[layer_index];
+            for (int m=0; m<2; m++)
+            {
+                layer_packing[layer_index] = m;
+
+                for (size_t j=0; j<layer->bottoms.size(); j++)
+                {
+                    const int bottom_blob_index = layer->bottoms[j];
+
+                    // a blob taken twice counts once
+                    if (std::find(layer->bottoms.begin(), layer->bottoms.begin() + j, bottom_blob_index) != layer->bottoms.begin() + j)
+                        continue;
+
+                    conversion_count[m] += packing_conversion_count(blobs[bottom_blob_index], blob_packing[bottom_blob_index], layer_packing);
+                }
+                for (size_t j=0; j<layer->tops.size(); j++)
+                {
+                    conversion_count[m] += packing_conversion_count(blobs[layer->tops[j]], m, layer_packing);
+                }
+            }
+
+            if (conversion_count[1 - packing] < conversion_count[packing])
+            {
+                layer_packing[layer_index] = 1 - packing;
+                for (size_t j=0; j<layer->tops.size(); j++)
+                {
+                    blob_packing[layer->tops[j]] = 1 - packing;
+                }
+                flipped = true;
+            }
+            else
+            {
+                layer_packing[layer_index] = packing;
+            }
         }
+    }
+
+    // one Packing layer per blob and layout, shared by all consumers taking that layout
+    int conversion_count = 0;
+    for (int i=0; i<blob_count; i++)
+    {
+        const int producer = blobs[i].producer;
+        if (producer == -1 || !layers[producer])
+            continue;
+
+        int converted_blob_index[2] = { -1, -1 };
 
+        const std::vector<int> consumers = blobs[i].consumers;
+        std::vector<int> consumers_kept;
+        for (size_t j=0; j<consumers.size(); j++)
         {
-        cast_float16_to_float32 = ncnn::create_layer(ncnn::LayerType::Cast);
-        cast_float16_to_float32->vkdev = vkdev;
+            const int consumer = consumers[j];
+            Layer* layer = layers[consumer];
+            if (!layer || layer_packing[consumer] == -1 || layer_packing[consumer] == blob_packing[i])
+            {
+                consumers_kept.push_back(consumer);
+                continue;
+            }
 
-        ncnn::ParamDict pd;
-        pd.set(0, 2);
-        pd.set(1, 1);
+            const int packing = layer_packing[consumer];
+            if (converted_blob_index[packing] == -1)
+            {
+                Layer* packing_layer = create_layer(LayerType::Packing);
 
-        cast_float16_to_float32->load_param(pd);
-        }
+                ParamDict pd;
+                pd.set(0, packing ? packing_elempack_max() : 1);
+                packing_layer->load_param(pd);
 
-        cast_float32_to_float16->create_pipeline(opt);
+                int cret = packing_layer->create_pipeline(opt);
+                if (cret != 0)
+                {
+                    fprintf(stderr, "packing layer create_pipeline failed\n");
+                    delete packing_layer;
+                    return -1;
+                }
 
-        cast_float16_to_float32->create_pipeline(opt);
+                const int converted_index = blobs.size();
+                blobs.push_back(Blob());
+#if NCNN_STRING
+                blobs[converted_index].name = blobs[i].name + (packing ? "_packed" : "_unpacked");
+                packing_layer->type = "Packing";
+                packing_layer->name = blobs[converted_index].name;
+#endif // NCNN_STRING
+                blobs[converted_index].producer = layers.size();
+
+                packing_layer->bottoms.push_back(i);
+                packing_layer->tops.push_back(converted_index);
+
+                consumers_kept.push_back(layers.size());
+                layers.push_back(packing_layer);
+                // the packing layer converts its bottom blob itself
+                layer_packing.push_back(-1);
+
+                converted_blob_index[packing] = converted_index;
+                conversion_count++;
+            }
+
+            // a layer taking the blob twice is listed twice, rebind one bottom per entry
+            for (size_t k=0; k<layer->bottoms.size(); k++)
+            {
+                if (layer->bottoms[k] == i)
+                {
+                    layer->bottoms[k] = converted_blob_index[packing];
+                    break;
+                }
+            }
+
+            blobs[converted_blob_index[packing]].consumers.push_back(consumer);
+        }
+
+        blobs[i].consumers = consumers_kept;
     }
 
+    packing_eliminated_count = conversion_count_unplanned - conversion_count;
+
+#if NCNN_BENCHMARK
+    fprintf(stderr, "packing layout conversions %d -> %d\n", conversion_count_unplanned, conversion_count);
+#endif // NCNN_BENCHMARK
+
+    if (conversion_count == 0)
+        return 0;
+
+    return build_schedule();
+}
+
+int Net::collect_required(int blob_index, const std::vector<Mat>& blob_mats, std::vector<unsigned char>& required, int& required_count, std::vector<int>& blob_uses) const
+{
+    required.assign(layers.size(), 0);
+    blob_uses.assign(blobs.size(), 0);
+    std::vector<int> stack;
+
+    required_count = 0;
+    stack.push_back(blob_index);
+    while (!stack.empty())
     {
-    packing_pack1 = ncnn::create_layer(ncnn::LayerType::Packing);
-    packing_pack1->vkdev = vkdev;
+        int top_blob_index = stack.back();
+        stack.pop_back();
 
-    ncnn::ParamDict pd;
-    pd.set(0, 1);
+        int layer_index = blobs[top_blob_index].producer;
+        if (layer_index == -1 || !layers[layer_index])
+        {
+            fprintf(stderr, "blob %d is neither fed nor produced by any loaded layer\n", top_blob_index);
+            return -1;
+        }
 
-    packing_pack1->load_param(pd);
+        if (required[layer_index])
+            continue;
+
+        required[layer_index] = 1;
+        required_count++;
+
+        const Layer* layer = layers[layer_index];
+        for (size_t i=0; i<layer->bottoms.size(); i++)
+        {
+            int bottom_blob_index = layer->bottoms[i];
+            blob_uses[bottom_blob_index]++;
+
+            if (blob_mats[bottom_blob_index].dims == 0)
+                stack.push_back(bottom_blob_index);
+        }
     }
 
+    return 0;
+}
+
+int Net::forward_blob(int blob_index, std::vector<Mat>& blob_mats, Option& opt, BlobMemoryPlan* record_plan, const BlobMemoryPlan* plan, ArenaAllocator* arena)
+{
+    // scratch blob lists reused by every multi-blob layer
+    std::vector<Mat> bottom_blobs;
+    std::vector<Mat> top_blobs;
+
+    if (plan)
     {
-    packing_pack4 = ncnn::create_layer(ncnn::LayerType::Packing);
-    packing_pack4->vkdev = vkdev;
+        // the plan already knows the layers to run and the blob uses
+        std::vector<int> blob_uses = plan->blob_uses;
 
-    ncnn::ParamDict pd;
-    pd.set(0, 4);
+        for (size_t i=0; i<plan->layer_order.size(); i++)
+        {
+            int ret = forward_layer(plan->layer_order[i], blob_mats, opt, blob_uses, bottom_blobs, top_blobs, 0, plan, arena);
+            if (ret != 0)
+                return ret;
+        }
 
-    packing_pack4->load_param(pd);
+        return 0;
     }
 
-    packing_pack1->create_pipeline(opt);
+    std::vector<unsigned char> required;
+    std::vector<int> blob_uses;
+    int required_count = 0;
 
-    packing_pack4->create_pipeline(opt);
+    int ret = collect_required(blob_index, blob_mats, required, required_count, blob_uses);
+    if (ret != 0)
+        return ret;
+
+    if (opt.num_branch_workers > 1 && required_count > 1 && !record_plan)
+        return forward_branches(blob_mats, opt, required, required_count, blob_uses);
+
+    if (record_plan)
+        record_plan->blob_uses = blob_uses;
+
+    for (size_t i=0; i<layer_schedule.size() && required_count > 0; i++)
+    {
+        int layer_index = layer_schedule[i];
+        if (!required[layer_index])
+            continue;
+
+        ret = forward_layer(layer_index, blob_mats, opt, blob_uses, bottom_blobs, top_blobs, record_plan, 0, 0);
+        if (ret != 0)
+            return ret;
+
+        required_count--;
+    }
 
     return 0;
 }
 
-int Net::destroy_pipeline()
+int Net::forward_blob_batch(int blob_index, std::vector< std::vector<Mat> >& batch_blob_mats, Option& opt)
 {
-    if (cast_float32_to_float16)
-        cast_float32_to_float16->destroy_pipeline(opt);
+    const int batch = batch_blob_mats.size();
 
-    if (cast_float16_to_float32)
-        cast_float16_to_float32->destroy_pipeline(opt);
+    // every sample was fed the same blobs, so they share one set of required layers
+    std::vector<unsigned char> required;
+    std::vector<int> blob_uses;
+    int required_count = 0;
 
-    if (packing_pack1)
-        packing_pack1->destroy_pipeline(opt);
+    int ret = collect_required(blob_index, batch_blob_mats[0], required, required_count, blob_uses);
+    if (ret != 0)
+        return ret;
 
-    if (packing_pack4)
-        packing_pack4->destroy_pipeline(opt);
+    std::vector< std::vector<int> > batch_blob_uses(batch, blob_uses);
+
+    std::vector<Mat> bottom_blobs;
+    std::vector<Mat> top_blobs;
+
+    for (size_t i=0; i<layer_schedule.size() && required_count > 0; i++)
+    {
+        int layer_index = layer_schedule[i];
+        if (!required[layer_index])
+            continue;
+
+        if (layers[layer_index]->support_batch)
+        {
+            ret = forward_layer_batch(layer_index, batch_blob_mats, opt, batch_blob_uses);
+            if (ret != 0)
+                return ret;
+        }
+        else
+        {
+            for (int b=0; b<batch; b++)
+            {
+                ret = forward_layer(layer_index, batch_blob_mats[b], opt, batch_blob_uses[b], bottom_blobs, top_blobs, 0, 0, 0);
+                if (ret != 0)
+                    return ret;
+            }
+        }
+
+        required_count--;
+    }
 
     return 0;
 }
-#endif // NCNN_VULKAN
 
-#if NCNN_STRING
-int Net::find_blob_index_by_name(const char* name) const
+int Net::forward_layer_batch(int layer_index, std::vector< std::vector<Mat> >& batch_blob_mats, Option& opt, std::vector< std::vector<int> >& batch_blob_uses)
 {
-    for (size_t i=0; i<blobs.size(); i++)
+    const Layer* layer = layers[layer_index];
+    const int batch = batch_blob_mats.size();
+
+    // load bottom blobs of every sample
+    std::vector< std::vector<Mat> > bottom_batch(batch);
+    for (int b=0; b<batch; b++)
     {
-        const Blob& blob = blobs[i];
-        if (blob.name == name)
+        std::vector<Mat>& blob_mats = batch_blob_mats[b];
+
+        bottom_batch[b].resize(layer->bottoms.size());
+        for (size_t i=0; i<layer->bottoms.size(); i++)
         {
-            return i;
+            int bottom_blob_index = layer->bottoms[i];
+
+            Mat bottom_blob = blob_mats[bottom_blob_index];
+
+            if (opt.lightmode && --batch_blob_uses[b][bottom_blob_index] == 0)
+            {
+                // delete after taken by the last user in light mode
+                blob_mats[bottom_blob_index].release();
+            }
+
+            if (opt.use_packing_layout)
+            {
+                int elempack = packing_elempack(layer, layer_packing.empty() ? 1 : layer_packing[layer_index], bottom_blob);
+
+                Mat bottom_blob_packed;
+                convert_packing(bottom_blob, bottom_blob_packed, elempack, opt);
+                bottom_blob = bottom_blob_packed;
+            }
+
+            bottom_batch[b][i] = bottom_blob;
         }
     }
 
-    fprintf(stderr, "find_blob_index_by_name %s failed\n", name);
-    return -1;
-}
+#if NCNN_BENCHMARK
+    double start = get_current_time();
+#endif // NCNN_BENCHMARK
 
-int Net::find_layer_index_by_name(const char* name) const
-{
-    for (size_t i=0; i<layers.size(); i++)
+    if (layer->one_blob_only)
     {
-        const Layer* layer = layers[i];
-        if (layer->name == name)
+        std::vector<Mat> bottom_blobs(batch);
+        for (int b=0; b<batch; b++)
         {
-            return i;
+            bottom_blobs[b] = bottom_batch[b][0];
+        }
+        bottom_batch.clear();
+
+        // the kernel autotune picked for the shape of each sample, as forward_layer does
+        // tuned samples run one by one since the batched kernel was not timed against them
+        std::vector<int> forward_kernels(batch, -1);
+        bool tuned = false;
+        if (!tuned_kernels.empty())
+        {
+            for (int b=0; b<batch; b++)
+            {
+                forward_kernels[b] = tuned_kernel(layer_index, bottom_blobs[b]);
+                tuned = tuned || forward_kernels[b] != -1;
+            }
+        }
+
+        std::vector<Mat> top_blobs(batch);
+        if (tuned)
+        {
+            for (int b=0; b<batch; b++)
+            {
+                int ret = layer->forward_with_kernel(bottom_blobs[b], top_blobs[b], forward_kernels[b], opt);
+                if (ret != 0)
+                    return ret;
+            }
+        }
+        else
+        {
+            int ret = layer->forward_batch(bottom_blobs, top_blobs, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        // store top blob
+        for (int b=0; b<batch; b++)
+        {
+            batch_blob_mats[b][layer->tops[0]] = top_blobs[b];
+        }
+    }
+    else
+    {
+        std::vector< std::vector<Mat> > top_batch(batch, std::vector<Mat>(layer->tops.size()));
+        int ret = layer->forward_batch(bottom_batch, top_batch, opt);
+        if (ret != 0)
+            return ret;
+
+        // store top blobs
+        for (int b=0; b<batch; b++)
+        {
+            for (size_t i=0; i<layer->tops.size(); i++)
+            {
+                batch_blob_mats[b][layer->tops[i]] = top_batch[b][i];
+            }
         }
     }
 
-    fprintf(stderr, "find_layer_index_by_name %s failed\n", name);
-    return -1;
+#if NCNN_BENCHMARK
+    double end = get_current_time();
+    benchmark(layer, start, end);
+#endif // NCNN_BENCHMARK
+
+    return 0;
 }
 
-int Net::custom_layer_to_index(const char* type)
+class BranchSchedule
 {
-    const int custom_layer_registry_entry_count = custom_layer_registry.size();
-    for (int i=0; i<custom_layer_registry_entry_count; i++)
+public:
+    Net* net;
+    std::vector<Mat>* blob_mats;
+    std::vector<int>* blob_uses;
+    const std::vector<unsigned char>* required;
+    Option opt;
+
+    Mutex lock;
+    ConditionVariable cond;
+
+    // unproduced bottom blob count of each layer
+    std::vector<int> pending;
+    // layers with all bottom blobs produced
+    std::vector<int> ready;
+    int remaining;
+    int ret;
+};
+
+void* Net::branch_worker(void* args)
+{
+    BranchSchedule* schedule = (BranchSchedule*)args;
+    schedule->net->run_branch_worker(schedule);
+    return 0;
+}
+
+void Net::run_branch_worker(BranchSchedule* schedule)
+{
+    std::vector<Mat> bottom_blobs;
+    std::vector<Mat> top_blobs;
+
+    Option& opt = schedule->opt;
+
+    schedule->lock.lock();
+
+    for (;;)
     {
-        if (strcmp(type, custom_layer_registry[i].name) == 0)
-            return i;
+        while (schedule->ready.empty() && schedule->remaining > 0 && schedule->ret == 0)
+        {
+            schedule->cond.wait(schedule->lock);
+        }
+
+        if (schedule->remaining == 0 || schedule->ret != 0)
+            break;
+
+        int layer_index = schedule->ready.back();
+        schedule->ready.pop_back();
+
+        schedule->lock.unlock();
+
+        int ret = forward_layer(layer_index, *schedule->blob_mats, opt, *schedule->blob_uses, bottom_blobs, top_blobs, 0, 0, 0, &schedule->lock);
+
+        schedule->lock.lock();
+
+        if (ret != 0)
+        {
+            schedule->ret = ret;
+            schedule->cond.broadcast();
+            break;
+        }
+
+        schedule->remaining--;
+
+        // release consumers whose bottom blobs are all produced
+        const Layer* layer = layers[layer_index];
+        for (size_t i=0; i<layer->tops.size(); i++)
+        {
+            const Blob& blob = blobs[layer->tops[i]];
+            for (size_t j=0; j<blob.consumers.size(); j++)
+            {
+                int consumer = blob.consumers[j];
+                if ((*schedule->required)[consumer] && --schedule->pending[consumer] == 0)
+                    schedule->ready.push_back(consumer);
+            }
+        }
+
+        schedule->cond.broadcast();
     }
 
-    return -1;
+    schedule->lock.unlock();
 }
 
-Layer* Net::create_custom_layer(const char* type)
+int Net::forward_branches(std::vector<Mat>& blob_mats, Option& opt, const std::vector<unsigned char>& required, int required_count, std::vector<int>& blob_uses)
 {
-    int index = custom_layer_to_index(type);
-    if (index == -1)
-        return 0;
+    const int worker_count = std::min(opt.num_branch_workers, required_count);
+
+    BranchSchedule schedule;
+    schedule.net = this;
+    schedule.blob_mats = &blob_mats;
+    schedule.blob_uses = &blob_uses;
+    schedule.required = &required;
+    schedule.opt = opt;
+    schedule.opt.num_threads = std::max(1, opt.num_threads / worker_count);
+    schedule.remaining = required_count;
+    schedule.ret = 0;
+
+    schedule.pending.resize(layers.size(), 0);
+    for (int i=(int)layer_schedule.size()-1; i>=0; i--)
+    {
+        int layer_index = layer_schedule[i];
+        if (!required[layer_index])
+            continue;
 
-    return create_custom_layer(index);
-}
-#endif // NCNN_STRING
+        const Layer* layer = layers[layer_index];
+        for (size_t j=0; j<layer->bottoms.size(); j++)
+        {
+            int producer = blobs[layer->bottoms[j]].producer;
+            if (producer != -1 && required[producer])
+                schedule.pending[layer_index]++;
+        }
 
-Layer* Net::create_custom_layer(int index)
-{
-    const int custom_layer_registry_entry_count = custom_layer_registry.size();
-    if (index < 0 || index >= custom_layer_registry_entry_count)
-        return 0;
+        // popped from back, so the earliest scheduled layer goes first
+        if (schedule.pending[layer_index] == 0)
+            schedule.ready.push_back(layer_index);
+    }
+
+    std::vector<Thread*> workers(worker_count - 1);
+    for (int i=0; i<worker_count - 1; i++)
+    {
+        workers[i] = new Thread(branch_worker, &schedule);
+    }
 
-    layer_creator_func layer_creator = custom_layer_registry[index].creator;
-    if (!layer_creator)
-        return 0;
+    run_branch_worker(&schedule);
+
+    for (int i=0; i<worker_count - 1; i++)
+    {
+        workers[i]->join();
+        delete workers[i];
+    }
 
-    return layer_creator();
+    return schedule.ret;
 }
 
-int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt)
+int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt, std::vector<int>& blob_uses, std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, BlobMemoryPlan* record_plan, const BlobMemoryPlan* plan, ArenaAllocator* arena, Mutex* blob_lock)
 {
     Layer* layer = layers[layer_index];
 
@@ -1023,19 +3102,22 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
         int bottom_blob_index = layer->bottoms[0];
         int top_blob_index = layer->tops[0];
 
-        if (blob_mats[bottom_blob_index].dims == 0)
+        if (blob_lock)
+            blob_lock->lock();
+
+        Mat bottom_blob = blob_mats[bottom_blob_index];
+
+        if (opt.lightmode && --blob_uses[bottom_blob_index] == 0)
         {
-            int ret = forward_layer(blobs[bottom_blob_index].producer, blob_mats, opt);
-            if (ret != 0)
-                return ret;
+            // delete after taken by the last user in light mode
+            blob_mats[bottom_blob_index].release();
         }
 
-        Mat bottom_blob = blob_mats[bottom_blob_index];
+        if (blob_lock)
+            blob_lock->unlock();
 
         if (opt.lightmode)
         {
-            // delete after taken in light mode
-            blob_mats[bottom_blob_index].release();
             // deep copy for inplace forward if data is shared
             if (layer->support_inplace && *bottom_blob.refcount != 1)
             {
@@ -1045,13 +3127,26 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
 
         if (opt.use_packing_layout)
         {
-            int elempack = layer->support_packing ? 4 : 1;
+            int elempack = packing_elempack(layer, layer_packing.empty() ? 1 : layer_packing[layer_index], bottom_blob);
 
             Mat bottom_blob_packed;
             convert_packing(bottom_blob, bottom_blob_packed, elempack, opt);
             bottom_blob = bottom_blob_packed;
         }
 
+        // run the kernel memoized for these input shapes
+        int forward_kernel = plan ? plan->layer_kernels[layer_index] : -1;
+
+        // plans are dropped whenever tuned_kernels changes, so they already hold the tuned kernel
+        if (!plan && !tuned_kernels.empty())
+        {
+            // the kernel autotune picked for this shape
+            forward_kernel = tuned_kernel(layer_index, bottom_blob);
+        }
+
+        if (record_plan)
+            record_plan->layer_kernels[layer_index] = forward_kernel != -1 ? forward_kernel : layer->select_kernel(bottom_blob, opt);
+
         // forward
         if (opt.lightmode && layer->support_inplace)
         {
@@ -1069,47 +3164,62 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
 
             // store top blob
             blob_mats[top_blob_index] = bottom_top_blob;
+
+            if (record_plan)
+                record_planned_blob(record_plan, layer, 0, bottom_top_blob, &bottom_top_blob, opt);
         }
         else
         {
             Mat top_blob;
+            if (arena)
+                bind_planned_blob(plan, arena, top_blob_index, top_blob);
 #if NCNN_BENCHMARK
             double start = get_current_time();
-            int ret = layer->forward(bottom_blob, top_blob, opt);
+            int ret = layer->forward_with_kernel(bottom_blob, top_blob, forward_kernel, opt);
             double end = get_current_time();
             benchmark(layer, bottom_blob, top_blob, start, end);
 #else
-            int ret = layer->forward(bottom_blob, top_blob, opt);
+            int ret = layer->forward_with_kernel(bottom_blob, top_blob, forward_kernel, opt);
 #endif // NCNN_BENCHMARK
             if (ret != 0)
                 return ret;
 
             // store top blob
             blob_mats[top_blob_index] = top_blob;
+
+            if (record_plan)
+                record_planned_blob(record_plan, layer, 0, top_blob, &bottom_blob, opt);
         }
 
     }
     else
     {
         // load bottom blobs
-        std::vector<Mat> bottom_blobs(layer->bottoms.size());
+        bottom_blobs.resize(layer->bottoms.size());
+
+        if (blob_lock)
+            blob_lock->lock();
+
         for (size_t i=0; i<layer->bottoms.size(); i++)
         {
             int bottom_blob_index = layer->bottoms[i];
 
-            if (blob_mats[bottom_blob_index].dims == 0)
+            bottom_blobs[i] = blob_mats[bottom_blob_index];
+
+            if (opt.lightmode && --blob_uses[bottom_blob_index] == 0)
             {
-                int ret = forward_layer(blobs[bottom_blob_index].producer, blob_mats, opt);
-                if (ret != 0)
-                    return ret;
+                // delete after taken by the last user in light mode
+                blob_mats[bottom_blob_index].release();
             }
+        }
 
-            bottom_blobs[i] = blob_mats[bottom_blob_index];
+        if (blob_lock)
+            blob_lock->unlock();
 
+        for (size_t i=0; i<layer->bottoms.size(); i++)
+        {
             if (opt.lightmode)
             {
-                // delete after taken in light mode
-                blob_mats[bottom_blob_index].release();
                 // deep copy for inplace forward if data is shared
                 if (layer->support_inplace && *bottom_blobs[i].refcount != 1)
                 {
@@ -1119,7 +3229,7 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
 
             if (opt.use_packing_layout)
             {
-                int elempack = layer->support_packing ? 4 : 1;
+                int elempack = packing_elempack(layer, layer_packing.empty() ? 1 : layer_packing[layer_index], bottom_blobs[i]);
 
                 Mat bottom_blob_packed;
                 convert_packing(bottom_blobs[i], bottom_blob_packed, elempack, opt);
@@ -1140,7 +3250,10 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
             int ret = layer->forward_inplace(bottom_top_blobs, opt);
 #endif // NCNN_BENCHMARK
             if (ret != 0)
+            {
+                bottom_blobs.clear();
                 return ret;
+            }
 
             // store top blobs
             for (size_t i=0; i<layer->tops.size(); i++)
@@ -1148,11 +3261,21 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
                 int top_blob_index = layer->tops[i];
 
                 blob_mats[top_blob_index] = bottom_top_blobs[i];
+
+                if (record_plan)
+                    record_planned_blob(record_plan, layer, i, bottom_top_blobs[i], bottom_top_blobs.empty() ? 0 : &bottom_top_blobs[0], opt);
             }
         }
         else
         {
-            std::vector<Mat> top_blobs(layer->tops.size());
+            top_blobs.resize(layer->tops.size());
+            if (arena)
+            {
+                for (size_t i=0; i<layer->tops.size(); i++)
+                {
+                    bind_planned_blob(plan, arena, layer->tops[i], top_blobs[i]);
+                }
+            }
 #if NCNN_BENCHMARK
             double start = get_current_time();
             int ret = layer->forward(bottom_blobs, top_blobs, opt);
@@ -1162,7 +3285,11 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
             int ret = layer->forward(bottom_blobs, top_blobs, opt);
 #endif // NCNN_BENCHMARK
             if (ret != 0)
+            {
+                bottom_blobs.clear();
+                top_blobs.clear();
                 return ret;
+            }
 
             // store top blobs
             for (size_t i=0; i<layer->tops.size(); i++)
@@ -1170,10 +3297,20 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
                 int top_blob_index = layer->tops[i];
 
                 blob_mats[top_blob_index] = top_blobs[i];
+
+                if (record_plan)
+                    record_planned_blob(record_plan, layer, i, top_blobs[i], bottom_blobs.empty() ? 0 : &bottom_blobs[0], opt);
             }
         }
+
+        // drop references but keep the capacity for the next layer
+        bottom_blobs.clear();
+        top_blobs.clear();
     }
 
+    if (record_plan)
+        record_plan->layer_order.push_back(layer_index);
+
 //     fprintf(stderr, "forward_layer %d %s done\n", layer_index, layer->name.c_str());
 //     const Mat& blob = blob_mats[layer->tops[0]];
 //     fprintf(stderr, "[%-2d %-16s %-16s]  %d    blobs count = %-3d   size = %-3d x %-3d\n", layer_index, layer->type.c_str(), layer->name.c_str(), layer->tops[0], blob.c, blob.h, blob.w);
@@ -1181,6 +3318,126 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
     return 0;
 }
 
+int Net::tuned_kernel(int layer_index, const Mat& bottom_blob) const
+{
+    if (layer_index >= (int)tuned_kernels.size())
+        return -1;
+
+    const std::vector<TunedKernel>& tuned = tuned_kernels[layer_index];
+    for (size_t i=0; i<tuned.size(); i++)
+    {
+        const TunedKernel& t = tuned[i];
+        if (t.w == bottom_blob.w && t.h == bottom_blob.h && t.c == bottom_blob.c && t.elempack == bottom_blob.elempack)
+            return t.kernel;
+    }
+
+    return -1;
+}
+
+void Net::set_tuned_kernel(int layer_index, const Mat& bottom_blob, int kernel)
+{
+    if (tuned_kernels.size() < layers.size())
+        tuned_kernels.resize(layers.size());
+
+    std::vector<TunedKernel>& tuned = tuned_kernels[layer_index];
+    for (size_t i=0; i<tuned.size(); i++)
+    {
+        TunedKernel& t = tuned[i];
+        if (t.w == bottom_blob.w && t.h == bottom_blob.h && t.c == bottom_blob.c && t.elempack == bottom_blob.elempack)
+        {
+            t.kernel = kernel;
+            return;
+        }
+    }
+
+    TunedKernel t;
+    t.w = bottom_blob.w;
+    t.h = bottom_blob.h;
+    t.c = bottom_blob.c;
+    t.elempack = bottom_blob.elempack;
+    t.kernel = kernel;
+    tuned.push_back(t);
+}
+
+int Net::autotune_blob(int blob_index, const std::vector<Mat>& input_blob_mats, const Option& _opt, int loop_count)
+{
+    // keep every intermediate blob to rerun the layers one by one
+    std::vector<Mat> blob_mats = input_blob_mats;
+    Option opt = _opt;
+    opt.lightmode = false;
+    opt.num_branch_workers = 1;
+
+    std::vector<unsigned char> required;
+    std::vector<int> blob_uses;
+    int required_count = 0;
+    int ret = collect_required(blob_index, blob_mats, required, required_count, blob_uses);
+    if (ret != 0)
+        return ret;
+
+    ret = forward_blob(blob_index, blob_mats, opt);
+    if (ret != 0)
+        return ret;
+
+    std::vector<int> kernels;
+    for (size_t i=0; i<layer_schedule.size(); i++)
+    {
+        int layer_index = layer_schedule[i];
+        const Layer* layer = layers[layer_index];
+        if (!required[layer_index] || !layer->one_blob_only)
+            continue;
+
+        Mat bottom_blob = blob_mats[layer->bottoms[0]];
+
+        if (opt.use_packing_layout)
+        {
+            int elempack = packing_elempack(layer, layer_packing.empty() ? 1 : layer_packing[layer_index], bottom_blob);
+
+            Mat bottom_blob_packed;
+            convert_packing(bottom_blob, bottom_blob_packed, elempack, opt);
+            bottom_blob = bottom_blob_packed;
+        }
+
+        layer->candidate_kernels(bottom_blob, kernels, opt);
+        if (kernels.size() < 2)
+            continue;
+
+        int best_kernel = -1;
+        double best_time = 0;
+        for (size_t j=0; j<kernels.size(); j++)
+        {
+            // the first run warms up caches and is not counted
+            double kernel_time = 0;
+            for (int k=0; k<=loop_count; k++)
+            {
+                Mat top_blob;
+                double start = get_current_time();
+                ret = layer->forward_with_kernel(bottom_blob, top_blob, kernels[j], opt);
+                double end = get_current_time();
+                if (ret != 0)
+                    return ret;
+
+                if (k == 1 || (k > 1 && end - start < kernel_time))
+                    kernel_time = end - start;
+            }
+
+            if (best_kernel == -1 || kernel_time < best_time)
+            {
+                best_kernel = kernels[j];
+                best_time = kernel_time;
+            }
+        }
+
+        set_tuned_kernel(layer_index, bottom_blob, best_kernel);
+    }
+
+    tuned_num_threads = opt.num_threads;
+
+    // shape plans memoized the kernels picked before tuning
+    clear_memory_plans();
+
+    return 0;
+}
+
 #if NCNN_VULKAN
 int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector<VkMat>& blob_mats_gpu, VkCompute& cmd, Option& opt)
 {
@@ -1546,7 +3803,7 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector
 
             if (opt.use_packing_layout)
             {
-                int elempack = layer->support_packing ? 4 : 1;
+                int elempack = packing_elempack(layer, layer_packing.empty() ? 1 : layer_packing[layer_index], bottom_blob);
 
                 Mat bottom_blob_packed;
                 convert_packing(bottom_blob, bottom_blob_packed, elempack, opt);
@@ -1722,7 +3979,7 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector
 
                 if (opt.use_packing_layout)
                 {
-                    int elempack = layer->support_packing ? 4 : 1;
+                    int elempack = packing_elempack(layer, layer_packing.empty() ? 1 : layer_packing[layer_index], bottom_blobs[i]);
 
                     Mat bottom_blob_packed;
                     convert_packing(bottom_blobs[i], bottom_blob_packed, elempack, opt);
@@ -1792,6 +4049,12 @@ Extractor::Extractor(Net* _net, int blob_count) : net(_net)
     blob_mats.resize(blob_count);
     opt = net->opt;
 
+    blob_arena = 0;
+    memory_plan = 0;
+    local_workspace_allocator = 0;
+
+    create_local_allocator();
+
 #if NCNN_VULKAN
     if (net->opt.use_vulkan_compute)
     {
@@ -1800,6 +4063,191 @@ Extractor::Extractor(Net* _net, int blob_count) : net(_net)
 #endif // NCNN_VULKAN
 }
 
+Extractor::~Extractor()
+{
+    // blob mats may live in arena
+    blob_mats.clear();
+
+    if (memory_plan)
+        net->release_memory_plan(memory_plan);
+
+    delete blob_arena;
+    delete local_workspace_allocator;
+}
+
+Extractor::Extractor(const Extractor& rhs) : net(rhs.net)
+{
+    blob_mats = rhs.blob_mats;
+    batch_blob_mats = rhs.batch_blob_mats;
+    opt = rhs.opt;
+
+#if NCNN_VULKAN
+    blob_mats_gpu = rhs.blob_mats_gpu;
+#endif // NCNN_VULKAN
+
+    blob_arena = 0;
+    memory_plan = rhs.memory_plan;
+    local_workspace_allocator = 0;
+
+    if (memory_plan)
+        net->retain_memory_plan(memory_plan);
+
+    copy_arena_blobs(rhs);
+
+    // never share the local pool of rhs
+    if (rhs.local_workspace_allocator && opt.workspace_allocator == rhs.local_workspace_allocator)
+    {
+        opt.workspace_allocator = 0;
+        create_local_allocator();
+    }
+}
+
+Extractor& Extractor::operator=(const Extractor& rhs)
+{
+    if (this == &rhs)
+        return *this;
+
+    blob_mats = rhs.blob_mats;
+    batch_blob_mats = rhs.batch_blob_mats;
+
+    delete blob_arena;
+    blob_arena = 0;
+
+    if (memory_plan)
+        net->release_memory_plan(memory_plan);
+
+    net = rhs.net;
+    opt = rhs.opt;
+
+#if NCNN_VULKAN
+    blob_mats_gpu = rhs.blob_mats_gpu;
+#endif // NCNN_VULKAN
+
+    memory_plan = rhs.memory_plan;
+    if (memory_plan)
+        net->retain_memory_plan(memory_plan);
+
+    copy_arena_blobs(rhs);
+
+    // never share the local pool of rhs
+    if (rhs.local_workspace_allocator && opt.workspace_allocator == rhs.local_workspace_allocator)
+    {
+        opt.workspace_allocator = 0;
+        create_local_allocator();
+    }
+
+    return *this;
+}
+
+void Extractor::create_local_allocator()
+{
+    if (!opt.use_local_pool_allocator || opt.workspace_allocator)
+        return;
+
+    // workspace may be requested from several threads inside one layer
+    if (!local_workspace_allocator)
+        local_workspace_allocator = new PoolAllocator;
+
+    opt.workspace_allocator = local_workspace_allocator;
+}
+
+void Extractor::copy_arena_blobs(const Extractor& rhs)
+{
+    if (!rhs.blob_arena)
+        return;
+
+    // the arena of rhs dies with rhs
+    for (size_t i=0; i<blob_mats.size(); i++)
+    {
+        if (blob_mats[i].allocator == rhs.blob_arena || rhs.blob_arena->contains(blob_mats[i].data))
+        {
+            blob_mats[i] = blob_mats[i].clone(opt.blob_allocator);
+        }
+    }
+}
+
+int Extractor::forward_planned(int blob_index)
+{
+    // plan on the first inference only
+    // lifetimes and kernels are not deterministic when branches run concurrently
+    if ((!opt.use_blob_memory_plan && !opt.use_shape_specialization) || memory_plan || opt.num_branch_workers > 1)
+        return net->forward_blob(blob_index, blob_mats, opt);
+
+    const BlobMemoryPlan* plan = net->find_memory_plan(blob_index, blob_mats, opt);
+    if (plan)
+    {
+        memory_plan = plan;
+
+        if (!opt.use_blob_memory_plan)
+            return net->forward_blob(blob_index, blob_mats, opt, 0, plan, 0);
+
+        blob_arena = new ArenaAllocator(opt.blob_allocator);
+        if (blob_arena->reserve(plan->arena_size) != 0)
+        {
+            delete blob_arena;
+            blob_arena = 0;
+            return net->forward_blob(blob_index, blob_mats, opt, 0, plan, 0);
+        }
+
+        Option opt_arena = opt;
+        opt_arena.blob_allocator = blob_arena;
+
+        return net->forward_blob(blob_index, blob_mats, opt_arena, 0, plan, blob_arena);
+    }
+
+    // record blob lifetimes and shapes
+    BlobMemoryPlan* new_plan = new BlobMemoryPlan;
+    new_plan->blob_index = blob_index;
+    new_plan->lightmode = opt.lightmode;
+    for (size_t i=0; i<blob_mats.size(); i++)
+    {
+        if (blob_mats[i].dims == 0)
+            continue;
+
+        new_plan->input_blob_indexes.push_back(i);
+        new_plan->input_blob_shapes.push_back(mat_shape(blob_mats[i]));
+    }
+    new_plan->blob_alias.resize(blob_mats.size(), -1);
+    new_plan->blob_shapes.resize(blob_mats.size());
+    new_plan->blob_offsets.resize(blob_mats.size(), 0);
+    new_plan->layer_kernels.resize(net->layers.size(), -1);
+
+    int ret = net->forward_blob(blob_index, blob_mats, opt, new_plan);
+    if (ret != 0)
+    {
+        delete new_plan;
+        return ret;
+    }
+
+    memory_plan = net->add_memory_plan(new_plan);
+
+    return 0;
+}
+
+size_t Extractor::planned_arena_size() const
+{
+    return memory_plan && opt.use_blob_memory_plan ? memory_plan->arena_size : 0;
+}
+
+#if NCNN_STRING
+int Extractor::autotune(const char* blob_name, int loop_count)
+{
+    int blob_index = net->find_blob_index_by_name(blob_name);
+    if (blob_index == -1)
+        return -1;
+
+    return autotune(blob_index, loop_count);
+}
+#endif // NCNN_STRING
+
+int Extractor::autotune(int blob_index, int loop_count)
+{
+    if (blob_index < 0 || blob_index >= (int)blob_mats.size())
+        return -1;
+
+    return net->autotune_blob(blob_index, blob_mats, opt, std::max(loop_count, 1));
+}
+
 void Extractor::set_light_mode(bool enable)
 {
     opt.lightmode = enable;
@@ -1810,6 +4258,11 @@ void Extractor::set_num_threads(int num_threads)
     opt.num_threads = num_threads;
 }
 
+void Extractor::set_num_branch_workers(int num_branch_workers)
+{
+    opt.num_branch_workers = num_branch_workers;
+}
+
 void Extractor::set_blob_allocator(Allocator* allocator)
 {
     opt.blob_allocator = allocator;
@@ -1818,6 +4271,8 @@ void Extractor::set_blob_allocator(Allocator* allocator)
 void Extractor::set_workspace_allocator(Allocator* allocator)
 {
     opt.workspace_allocator = allocator;
+
+    create_local_allocator();
 }
 
 #if NCNN_VULKAN
@@ -1875,8 +4330,85 @@ int Extractor::extract(const char* blob_name, Mat& feat)
 
     return extract(blob_index, feat);
 }
+
+int Extractor::input(const char* blob_name, const std::vector<Mat>& in)
+{
+    int blob_index = net->find_blob_index_by_name(blob_name);
+    if (blob_index == -1)
+        return -1;
+
+    return input(blob_index, in);
+}
+
+int Extractor::extract(const char* blob_name, std::vector<Mat>& feats)
+{
+    int blob_index = net->find_blob_index_by_name(blob_name);
+    if (blob_index == -1)
+        return -1;
+
+    return extract(blob_index, feats);
+}
 #endif // NCNN_STRING
 
+int Extractor::input(int blob_index, const std::vector<Mat>& in)
+{
+    if (blob_index < 0 || blob_index >= (int)blob_mats.size() || in.empty())
+        return -1;
+
+    if (batch_blob_mats.empty())
+    {
+        batch_blob_mats.resize(in.size(), std::vector<Mat>(blob_mats.size()));
+    }
+    else if (batch_blob_mats.size() != in.size())
+    {
+        fprintf(stderr, "batch size %d does not match the batch size %d fed before\n", (int)in.size(), (int)batch_blob_mats.size());
+        return -1;
+    }
+
+    for (size_t i=0; i<in.size(); i++)
+    {
+        batch_blob_mats[i][blob_index] = in[i];
+    }
+
+    return 0;
+}
+
+int Extractor::extract(int blob_index, std::vector<Mat>& feats)
+{
+    if (blob_index < 0 || blob_index >= (int)blob_mats.size())
+        return -1;
+
+    if (batch_blob_mats.empty())
+    {
+        fprintf(stderr, "extract batch without batched input\n");
+        return -1;
+    }
+
+    int ret = 0;
+
+    if (batch_blob_mats[0][blob_index].dims == 0)
+    {
+        ret = net->forward_blob_batch(blob_index, batch_blob_mats, opt);
+    }
+
+    const int batch = batch_blob_mats.size();
+
+    feats.resize(batch);
+    for (int i=0; i<batch; i++)
+    {
+        feats[i] = batch_blob_mats[i][blob_index];
+
+        if (opt.use_packing_layout)
+        {
+            Mat feat_unpacked;
+            convert_packing(feats[i], feat_unpacked, 1, opt);
+            feats[i] = feat_unpacked;
+        }
+    }
+
+    return ret;
+}
+
 int Extractor::input(int blob_index, const Mat& in)
 {
     if (blob_index < 0 || blob_index >= (int)blob_mats.size())
@@ -1896,8 +4428,6 @@ int Extractor::extract(int blob_index, Mat& feat)
 
     if (blob_mats[blob_index].dims == 0)
     {
-        int layer_index = net->blobs[blob_index].producer;
-
 #if NCNN_VULKAN
         if (opt.use_vulkan_compute)
         {
@@ -2001,10 +4531,10 @@ int Extractor::extract(int blob_index, Mat& feat)
         }
         else
         {
-            ret = net->forward_layer(layer_index, blob_mats, opt);
+            ret = forward_planned(blob_index);
         }
 #else
-        ret = net->forward_layer(layer_index, blob_mats, opt);
+        ret = forward_planned(blob_index);
 #endif // NCNN_VULKAN
 
     }
@@ -2018,6 +4548,12 @@ int Extractor::extract(int blob_index, Mat& feat)
         feat = bottom_blob_unpacked;
     }
 
+    if (blob_arena && (feat.allocator == blob_arena || blob_arena->contains(feat.data)))
+    {
+        // never hand out memory of the arena, it dies with the extractor
+        feat = feat.clone(opt.blob_allocator);
+    }
+
     return ret;
 }
 
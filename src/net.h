@@ -16,6 +16,8 @@
 #define NCNN_NET_H
 
 #include <stdio.h>
+#include <stdint.h>
+#include <string>
 #include <vector>
 #include "platform.h"
 #include "blob.h"
@@ -34,6 +36,55 @@ class VkCompute;
 #endif // NCNN_VULKAN
 class DataReader;
 class Extractor;
+class BranchSchedule;
+
+// plan for extracting one blob from a fixed set of input shapes
+// recorded on the first inference of those shapes and replayed by later ones
+// blobs whose lifetimes do not overlap share the same arena memory
+class BlobMemoryPlan
+{
+public:
+    // empty
+    BlobMemoryPlan();
+
+public:
+    // the blob to extract
+    int blob_index;
+    // light mode this plan was recorded with
+    bool lightmode;
+    // input blobs and their shapes this plan is valid for
+    std::vector<int> input_blob_indexes;
+    std::vector<Mat> input_blob_shapes;
+    // layer index in execution order
+    std::vector<int> layer_order;
+    // pending uses of each blob before the first layer runs
+    std::vector<int> blob_uses;
+    // kernel each layer picked by select_kernel, -1 lets the layer decide
+    std::vector<int> layer_kernels;
+    // the blob whose memory this blob shares, -1 means it owns its memory
+    std::vector<int> blob_alias;
+    // planned blob shape, empty shape means not placed in arena
+    std::vector<Mat> blob_shapes;
+    // byte offset of each planned blob in arena
+    std::vector<size_t> blob_offsets;
+    // arena size in bytes
+    size_t arena_size;
+    // hash of blob_index, lightmode and the input shapes
+    uint64_t key;
+    // references held by the net cache and the extractors using this plan
+    int refcount;
+};
+
+// kernel autotune measured fastest for one layer on one bottom blob shape
+struct TunedKernel
+{
+    int w;
+    int h;
+    int c;
+    int elempack;
+    int kernel;
+};
+
 class Net
 {
 public:
@@ -69,6 +120,8 @@ public:
 
     int load_param_bin(const DataReader& dr);
 
+    int load_param_graph(const DataReader& dr);
+
     int load_model(const DataReader& dr);
 
 #if NCNN_STDIO
@@ -84,10 +137,41 @@ public:
     int load_param_bin(FILE* fp);
     int load_param_bin(const char* protopath);
 
+    // load network structure from binary graph param file written by ncnn2mem
+    // names are kept and each layer type is resolved once
+    // return 0 if success
+    int load_param_graph(FILE* fp);
+    int load_param_graph(const char* graphpath);
+
     // load network weight data from model file
     // return 0 if success
     int load_model(FILE* fp);
     int load_model(const char* modelpath);
+
+    // map network weight data from model file
+    // raw float32 weight data is not copied but referenced from the mapping
+    // processes loading the same model file share its page cache
+    // the mapping is kept until clear()
+    // a failed load clears the net, load_param again before retrying
+    // return 0 if success
+    int load_model_mmap(const char* modelpath);
+
+    // keep transformed weight data of create_pipeline in cachedir
+    // the cache file is keyed by model hash, isa and option flags
+    // later loads map the cache file and skip the weight transforms
+    // set before load_model, empty path disables the cache
+    // return 0 if success
+    int set_weight_cache_dir(const char* cachedir);
+
+    // write the kernels picked by Extractor::autotune into a text table
+    // return 0 if success
+    int save_kernel_table(const char* tablepath) const;
+
+    // load a kernel table written on this cpu for the same model, options and thread count
+    // forward then runs the tuned kernel of each listed layer and shape
+    // set after load_model, never while extractors of this net are forwarding
+    // return 0 if success
+    int load_kernel_table(const char* tablepath);
 #endif // NCNN_STDIO
 
     // load network structure from external memory
@@ -95,6 +179,12 @@ public:
     // return bytes consumed
     int load_param(const unsigned char* mem);
 
+    // load network structure from binary graph param in external memory
+    // the graph is parsed in place without copying
+    // memory pointer must be 32-bit aligned
+    // return bytes consumed, 0 if failed
+    int load_param_graph(const unsigned char* mem);
+
     // reference network weight data from external memory
     // weight data is not copied but referenced
     // so external memory should be retained when used
@@ -120,7 +210,13 @@ public:
     // unload network structure and weight data
     void clear();
 
+    // layout conversions per inference saved by the packing layout plan of load_model
+    // zero unless use_packing_layout is set
+    int packing_conversions_eliminated() const;
+
     // construct an Extractor from network
+    // extractors of one net may run in parallel threads
+    // layer forward is const and keeps per-call scratch in workspace allocator
     Extractor create_extractor();
 
 protected:
@@ -146,7 +242,71 @@ protected:
     Layer* create_custom_layer(const char* type);
 #endif // NCNN_STRING
     Layer* create_custom_layer(int index);
-    int forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt);
+    // topologically sort layers into layer_schedule
+    // return 0 if success
+    int build_schedule();
+    // decide one layout per blob and insert Packing layers where consumers take the other one
+    // return 0 if success
+    int plan_packing_layout();
+    // run the layers required by blob_index in schedule order
+    // record blob lifetimes and layer kernels into record_plan if set
+    // or replay the layers and kernels of plan, placing planned top blobs into arena if set
+    int forward_blob(int blob_index, std::vector<Mat>& blob_mats, Option& opt, BlobMemoryPlan* record_plan = 0, const BlobMemoryPlan* plan = 0, ArenaAllocator* arena = 0);
+    // run one layer whose bottom blobs are all available
+    // bottom_blobs and top_blobs are scratch lists for multi-blob layers
+    // blob_lock guards taking bottom blobs when branches run concurrently
+    int forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt, std::vector<int>& blob_uses,
+                      std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, BlobMemoryPlan* record_plan, const BlobMemoryPlan* plan, ArenaAllocator* arena, Mutex* blob_lock = 0);
+    // run the required layers on opt.num_branch_workers workers
+    // a layer is dispatched as soon as all its bottom blobs are produced
+    int forward_branches(std::vector<Mat>& blob_mats, Option& opt, const std::vector<unsigned char>& required, int required_count, std::vector<int>& blob_uses);
+    // worker loop of forward_branches
+    void run_branch_worker(BranchSchedule* schedule);
+    static void* branch_worker(void* args);
+    // mark the layers required to produce blob_index and count the pending uses of each blob
+    // return 0 if success
+    int collect_required(int blob_index, const std::vector<Mat>& blob_mats, std::vector<unsigned char>& required, int& required_count, std::vector<int>& blob_uses) const;
+    // run the layers required by blob_index over a batch in schedule order
+    // batch_blob_mats[i] holds the blobs of sample i
+    int forward_blob_batch(int blob_index, std::vector< std::vector<Mat> >& batch_blob_mats, Option& opt);
+    // run one support_batch layer on all samples at once
+    // samples with a tuned kernel run one by one on that kernel
+    int forward_layer_batch(int layer_index, std::vector< std::vector<Mat> >& batch_blob_mats, Option& opt, std::vector< std::vector<int> >& batch_blob_uses);
+
+    // time the candidate kernels of the layers required by blob_index
+    // and keep the fastest per layer and bottom blob shape in tuned_kernels
+    // drops the memory plans, their kernels predate the tuning
+    int autotune_blob(int blob_index, const std::vector<Mat>& blob_mats, const Option& opt, int loop_count);
+    // tuned kernel of layer_index for bottom_blob, -1 if not tuned
+    int tuned_kernel(int layer_index, const Mat& bottom_blob) const;
+    void set_tuned_kernel(int layer_index, const Mat& bottom_blob, int kernel);
+
+    // mix layer type and loaded params into param_hash
+    void update_param_hash(int typeindex, const ParamDict& pd);
+
+#if NCNN_STDIO
+    // weight cache key from model hash, isa and option flags
+    uint64_t weight_cache_key(uint64_t weight_hash) const;
+    // fill in pipeline_weights of all layers from a matching cache file
+    // return 0 if success
+    int load_weight_cache(const char* cachepath, uint64_t key);
+    // write pipeline_weights of all layers into cache file
+    // return 0 if success
+    int save_weight_cache(const char* cachepath, uint64_t key);
+    // kernel table key from weight cache key and thread count
+    uint64_t kernel_table_key(int num_threads) const;
+#endif // NCNN_STDIO
+
+    // find the memory plan matching the current extractor state
+    // return null if not planned yet
+    const BlobMemoryPlan* find_memory_plan(int blob_index, const std::vector<Mat>& blob_mats, const Option& opt);
+    // assign arena offsets from recorded blob lifetimes and keep the plan
+    // the plan returned by find and add is referenced until released
+    const BlobMemoryPlan* add_memory_plan(BlobMemoryPlan* plan);
+    void retain_memory_plan(const BlobMemoryPlan* plan);
+    void release_memory_plan(const BlobMemoryPlan* plan);
+    // drop every cached plan, extractors holding one keep it until released
+    void clear_memory_plans();
 
 #if NCNN_VULKAN
     int forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector<VkMat>& blob_mats_gpu, VkCompute& cmd, Option& opt);
@@ -156,8 +316,38 @@ protected:
     std::vector<Blob> blobs;
     std::vector<Layer*> layers;
 
+    // layer indexes in topological order, built in load_param
+    std::vector<int> layer_schedule;
+
+    // layout each layer takes its bottom blobs in, planned in load_model
+    // 0 = pack1, 1 = packed, -1 = as is, empty when not planned
+    std::vector<int> layer_packing;
+    int packing_eliminated_count;
+
     std::vector<layer_registry_entry> custom_layer_registry;
 
+    // model file mapping referenced by weight data
+    void* model_mapping;
+    size_t model_mapping_size;
+
+    // hash of layer types and params, built in load_param
+    uint64_t param_hash;
+
+    // transformed weight cache directory and the cache file mapping
+    std::string weight_cache_dir;
+    void* weight_cache_mapping;
+    size_t weight_cache_mapping_size;
+
+    // kernels picked by autotune, per layer index
+    // and the thread count they were timed with
+    // read by forward without locking, only written while no extractor is forwarding
+    std::vector< std::vector<TunedKernel> > tuned_kernels;
+    int tuned_num_threads;
+
+    // plans per set of input shapes, least recently used first
+    Mutex memory_plans_lock;
+    std::vector<BlobMemoryPlan*> memory_plans;
+
 #if NCNN_VULKAN
     const VulkanDevice* vkdev;
 
@@ -174,6 +364,15 @@ protected:
 class Extractor
 {
 public:
+    // release blobs and arena
+    ~Extractor();
+
+    // copy
+    Extractor(const Extractor&);
+
+    // assign
+    Extractor& operator=(const Extractor&);
+
     // enable light mode
     // intermediate blob will be recycled when enabled
     // enabled by default
@@ -184,6 +383,11 @@ public:
     // default count is system depended
     void set_num_threads(int num_threads);
 
+    // set branch worker count for this extractor
+    // this will overwrite the global setting
+    // default count is 1
+    void set_num_branch_workers(int num_branch_workers);
+
     // set blob memory allocator
     void set_blob_allocator(Allocator* allocator);
 
@@ -208,6 +412,15 @@ public:
     // get result by blob name
     // return 0 if success
     int extract(const char* blob_name, Mat& feat);
+
+    // set a batch of inputs by blob name, one mat per sample
+    // all batched inputs of an extractor take the same sample count
+    // return 0 if success
+    int input(const char* blob_name, const std::vector<Mat>& in);
+
+    // get batched results by blob name, one mat per sample
+    // return 0 if success
+    int extract(const char* blob_name, std::vector<Mat>& feats);
 #endif // NCNN_STRING
 
     // set input by blob index
@@ -218,6 +431,33 @@ public:
     // return 0 if success
     int extract(int blob_index, Mat& feat);
 
+    // set a batch of inputs by blob index, one mat per sample
+    // return 0 if success
+    int input(int blob_index, const std::vector<Mat>& in);
+
+    // get batched results by blob index, one mat per sample
+    // layers with support_batch share their weights across the samples
+    // return 0 if success
+    int extract(int blob_index, std::vector<Mat>& feats);
+
+    // bytes of blob arena planned for this extractor
+    // return 0 if blob memory planning is disabled or not planned
+    size_t planned_arena_size() const;
+
+#if NCNN_STRING
+    // time every candidate kernel of the layers required by blob name on the current inputs
+    // the fastest of loop_count runs is kept per layer and shape in the net kernel table
+    // tune before creating the extractors for inference
+    // the table is written without locking, no other extractor of this net may forward meanwhile
+    // return 0 if success
+    int autotune(const char* blob_name, int loop_count = 4);
+#endif // NCNN_STRING
+
+    // time every candidate kernel of the layers required by blob index on the current inputs
+    // same restrictions as autotune by blob name
+    // return 0 if success
+    int autotune(int blob_index, int loop_count = 4);
+
 #if NCNN_VULKAN
 #if NCNN_STRING
     // set input by blob name
@@ -242,11 +482,24 @@ protected:
     friend Extractor Net::create_extractor();
     Extractor(Net* net, int blob_count);
 
+    // forward the producer of blob, through the shape plan if enabled
+    int forward_planned(int blob_index);
+    void copy_arena_blobs(const Extractor& rhs);
+    void create_local_allocator();
+
 private:
     Net* net;
     std::vector<Mat> blob_mats;
     Option opt;
 
+    // blobs of each sample of the batched inputs, empty until a batch is fed
+    std::vector< std::vector<Mat> > batch_blob_mats;
+
+    // planned blob arena, owned by this extractor
+    ArenaAllocator* blob_arena;
+    const BlobMemoryPlan* memory_plan;
+    Allocator* local_workspace_allocator;
+
 #if NCNN_VULKAN
     std::vector<VkMat> blob_mats_gpu;
 #endif // NCNN_VULKAN
@@ -21,8 +21,10 @@ Option::Option()
 {
     lightmode = true;
     num_threads = get_cpu_count();
+    num_branch_workers = 1;
     blob_allocator = 0;
     workspace_allocator = 0;
+    use_local_pool_allocator = false;
 
 #if NCNN_VULKAN
     blob_vkallocator = 0;
@@ -31,7 +33,11 @@ Option::Option()
 #endif // NCNN_VULKAN
 
     use_winograd_convolution = true;
+    use_winograd43_convolution = false;
+    use_winograd63_convolution = false;
     use_sgemm_convolution = true;
+    use_implicit_gemm_convolution = false;
+    use_pq_lookup_table = false;
     use_int8_inference = true;
     use_vulkan_compute = false;// TODO enable me
 
@@ -43,9 +49,17 @@ Option::Option()
 
     use_packing_layout = false;
 
+    use_blob_memory_plan = false;
+
+    use_shape_specialization = false;
+
+    use_weight_data_release = false;
+
     // sanitize
     if (num_threads <= 0)
         num_threads = 1;
+    if (num_branch_workers <= 0)
+        num_branch_workers = 1;
 }
 
 } // namespace ncnn
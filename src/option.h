@@ -40,12 +40,24 @@ public:
     // default value is the one returned by get_cpu_count()
     int num_threads;
 
+    // branch worker count
+    // independent branches of the graph run concurrently on this many workers
+    // the thread count is split evenly among the workers
+    // blob allocator must be thread-safe when more than one worker is used
+    // default value is 1, which runs layers one by one
+    int num_branch_workers;
+
     // blob memory allocator
     Allocator* blob_allocator;
 
     // workspace memory allocator
     Allocator* workspace_allocator;
 
+    // use a workspace pool owned by each extractor when workspace allocator is null
+    // scratch memory is then never shared between extractors running in parallel
+    // disabled by default
+    bool use_local_pool_allocator;
+
 #if NCNN_VULKAN
     // blob memory allocator
     VkAllocator* blob_vkallocator;
@@ -63,12 +75,33 @@ public:
     // enabled by default
     bool use_winograd_convolution;
 
+    // enable winograd F(4x4,3x3) and F(6x6,3x3) for convolution 3x3 stride1
+    // the larger output tile is picked per layer from the output size
+    // F(2x2,3x3) is used when both are disabled
+    // the larger tiles round to about 1e-4 relative error against sgemm
+    // changes should be applied before loading network structure and weight
+    // disabled by default
+    bool use_winograd43_convolution;
+    bool use_winograd63_convolution;
+
     // enable sgemm convolution optimization
     // improve convolution 1x1 stride1 performace, may consume more memory
     // changes should be applied before loading network structure and weight
     // enabled by default
     bool use_sgemm_convolution;
 
+    // pack im2col panels straight from the input in sgemm convolution
+    // instead of building the whole im2col matrix in workspace memory
+    // workspace then stays a few L2 sized blocks per thread for any kernel size
+    // disabled by default
+    bool use_implicit_gemm_convolution;
+
+    // run product-quantized Convolution and InnerProduct on codebook lookup tables
+    // instead of decoding the weights into float32 in create_pipeline
+    // keeps the weights small in memory but is slower than the decoded kernels on x86
+    // disabled by default
+    bool use_pq_lookup_table;
+
     // enable quantized int8 inference
     // use low-precision int8 path for quantized model
     // changes should be applied before loading network structure and weight
@@ -85,8 +118,29 @@ public:
     bool use_int8_storage;
     bool use_int8_arithmetic;
 
-    //
+    // keep blobs packed between layers supporting packing
+    // load_model plans one layout per blob and inserts Packing layers where consumers differ
     bool use_packing_layout;
+
+    // enable static blob memory planning
+    // intermediate blobs are placed into one preallocated arena per extractor
+    // at offsets planned from blob lifetimes on the first inference
+    // inputs with different shapes fallback to on-demand allocation
+    // disabled by default
+    bool use_blob_memory_plan;
+
+    // memoize per set of input shapes the layers to run and the kernel each layer picks
+    // later inferences of the same shapes replay them without re-deciding
+    // new shapes are recorded on their first inference
+    // the net keeps the 16 most recently used shape plans
+    // disabled by default
+    bool use_shape_specialization;
+
+    // release original weight data in create_pipeline
+    // once a layer has transformed it into the layout its forward uses
+    // pages of a mapped model are then no longer referenced after loading
+    // disabled by default
+    bool use_weight_data_release;
 };
 
 } // namespace ncnn
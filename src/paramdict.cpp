@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <ctype.h>
+#include <string.h>
 #include "paramdict.h"
 #include "datareader.h"
 #include "platform.h"
@@ -36,7 +37,6 @@ float ParamDict::get(int id, float def) const
 
 Mat ParamDict::get(int id, const Mat& def) const
 {
-    id = -id - 23300; // BISONAI
     return params[id].loaded ? params[id].v : def;
 }
 
@@ -250,4 +250,69 @@ int ParamDict::load_param_bin(const DataReader& dr)
     return 0;
 }
 
+int ParamDict::load_param_graph(const int*& mem, const int* end)
+{
+    clear();
+
+//     binary 2(count)
+//     binary 0
+//     binary 100
+//     binary 3 | array_bit
+//     binary 5
+//     binary 0.1 0.2 0.4 0.8 1.0
+
+    if (end - mem < 1)
+    {
+        fprintf(stderr, "ParamDict read param count failed\n");
+        return -1;
+    }
+
+    int count = *mem++;
+    for (int i=0; i<count; i++)
+    {
+        if (end - mem < 2)
+        {
+            fprintf(stderr, "ParamDict read param failed\n");
+            return -1;
+        }
+
+        int id = *mem++;
+
+        bool is_array = id <= -23300;
+        if (is_array)
+        {
+            id = -id - 23300;
+        }
+
+        if (id < 0 || id >= NCNN_MAX_PARAM_COUNT)
+        {
+            fprintf(stderr, "ParamDict param id %d out of range\n", id);
+            return -1;
+        }
+
+        if (is_array)
+        {
+            int len = *mem++;
+            if (len < 0 || end - mem < len)
+            {
+                fprintf(stderr, "ParamDict read array element failed\n");
+                return -1;
+            }
+
+            params[id].v.create(len);
+            if (len > 0)
+                memcpy(params[id].v.data, mem, len * sizeof(int));
+            mem += len;
+        }
+        else
+        {
+            params[id].i = *mem++;
+        }
+
+        params[id].loaded = 1;
+    }
+
+    return 0;
+}
+
 } // namespace ncnn
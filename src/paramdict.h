@@ -51,6 +51,8 @@ protected:
 
     int load_param(const DataReader& dr);
     int load_param_bin(const DataReader& dr);
+    // count prefixed params of a binary graph layer record, advance mem past them
+    int load_param_graph(const int*& mem, const int* end);
 
 protected:
     struct
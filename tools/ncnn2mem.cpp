@@ -16,6 +16,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <cstddef>
+#include <map>
 #include <string>
 #include <vector>
 #include "layer.h"
@@ -272,6 +273,247 @@ static int dump_param(const char* parampath, const char* parambinpath, const cha
     return 0;
 }
 
+static int intern_string(std::string& strings, std::map<std::string, int>& offsets, const char* str)
+{
+    std::map<std::string, int>::iterator it = offsets.find(str);
+    if (it != offsets.end())
+        return it->second;
+
+    int offset = strings.size();
+    strings.append(str);
+    strings.push_back('\0');
+
+    offsets[str] = offset;
+    return offset;
+}
+
+static int store_value(const char vstr[16])
+{
+    int v = 0;
+    if (vstr_is_float(vstr))
+    {
+        float vf = 0.f;
+        sscanf(vstr, "%f", &vf);
+        memcpy(&v, &vf, sizeof(float));
+    }
+    else
+    {
+        sscanf(vstr, "%d", &v);
+    }
+
+    return v;
+}
+
+// binary graph param read by Net::load_param_graph
+// header      magic version layer_count blob_count type_count string_bytes layer_words
+// strings     interned zero terminated names, padded to 4 bytes
+// type table  name offset and registry index per layer type
+// blob table  name offset per blob
+// layers      type name bottom_count top_count bottoms tops param_count params
+static int dump_param_graph(const char* parampath, const char* graphpath)
+{
+    FILE* fp = fopen(parampath, "rb");
+
+    if (!fp){
+        fprintf(stderr, "fopen %s failed\n", parampath);
+        return -1;
+    }
+
+    int nscan = 0;
+    int magic = 0;
+    nscan = fscanf(fp, "%d", &magic);
+    if (nscan != 1 || magic != 7767517)
+    {
+        fprintf(stderr, "read magic failed %d\n", nscan);
+        fclose(fp);
+        return -1;
+    }
+
+    int layer_count = 0;
+    int blob_count = 0;
+    nscan = fscanf(fp, "%d %d", &layer_count, &blob_count);
+    if (nscan != 2)
+    {
+        fprintf(stderr, "read layer_count and blob_count failed %d\n", nscan);
+        fclose(fp);
+        return -1;
+    }
+
+    std::string strings;
+    std::map<std::string, int> string_offsets;
+
+    std::vector<int> type_table;
+    std::map<std::string, int> type_ids;
+
+    std::vector<int> blob_table(blob_count, 0);
+    std::map<std::string, int> blob_ids;
+
+    std::vector<int> layer_words;
+
+    int blob_index = 0;
+    for (int i=0; i<layer_count; i++)
+    {
+        char layer_type[33];
+        char layer_name[257];
+        int bottom_count = 0;
+        int top_count = 0;
+        nscan = fscanf(fp, "%32s %256s %d %d", layer_type, layer_name, &bottom_count, &top_count);
+        if (nscan != 4)
+        {
+            fprintf(stderr, "read layer params failed %d\n", nscan);
+            fclose(fp);
+            return -1;
+        }
+
+        std::map<std::string, int>::iterator it = type_ids.find(layer_type);
+        if (it == type_ids.end())
+        {
+            it = type_ids.insert(std::make_pair(std::string(layer_type), (int)type_ids.size())).first;
+
+            type_table.push_back(intern_string(strings, string_offsets, layer_type));
+            type_table.push_back(ncnn::layer_to_index(layer_type));
+        }
+
+        layer_words.push_back(it->second);
+        layer_words.push_back(intern_string(strings, string_offsets, layer_name));
+        layer_words.push_back(bottom_count);
+        layer_words.push_back(top_count);
+
+        for (int j=0; j<bottom_count; j++)
+        {
+            char bottom_name[257];
+            nscan = fscanf(fp, "%256s", bottom_name);
+            if (nscan != 1)
+            {
+                fprintf(stderr, "read bottom_name failed %d\n", nscan);
+                fclose(fp);
+                return -1;
+            }
+
+            std::map<std::string, int>::iterator bit = blob_ids.find(bottom_name);
+            if (bit == blob_ids.end())
+            {
+                // bottom without producer takes a new blob as the text loader does
+                if (blob_index >= blob_count)
+                {
+                    fprintf(stderr, "blob_count %d too small\n", blob_count);
+                    fclose(fp);
+                    return -1;
+                }
+
+                blob_table[blob_index] = intern_string(strings, string_offsets, bottom_name);
+                bit = blob_ids.insert(std::make_pair(std::string(bottom_name), blob_index)).first;
+                blob_index++;
+            }
+
+            layer_words.push_back(bit->second);
+        }
+
+        for (int j=0; j<top_count; j++)
+        {
+            char blob_name[257];
+            nscan = fscanf(fp, "%256s", blob_name);
+            if (nscan != 1 || blob_index >= blob_count)
+            {
+                fprintf(stderr, "read blob_name failed %d\n", nscan);
+                fclose(fp);
+                return -1;
+            }
+
+            blob_table[blob_index] = intern_string(strings, string_offsets, blob_name);
+            blob_ids[blob_name] = blob_index;
+
+            layer_words.push_back(blob_index);
+
+            blob_index++;
+        }
+
+        // count prefixed key value pairs
+        const size_t param_count_pos = layer_words.size();
+        layer_words.push_back(0);
+
+        int id = 0;
+        while (fscanf(fp, "%d=", &id) == 1)
+        {
+            layer_words.push_back(id);
+
+            bool is_array = id <= -23300;
+
+            if (is_array)
+            {
+                int len = 0;
+                nscan = fscanf(fp, "%d", &len);
+                if (nscan != 1)
+                {
+                    fprintf(stderr, "read array length failed %d\n", nscan);
+                    fclose(fp);
+                    return -1;
+                }
+                layer_words.push_back(len);
+
+                for (int j = 0; j < len; j++)
+                {
+                    char vstr[16];
+                    nscan = fscanf(fp, ",%15[^,\n ]", vstr);
+                    if (nscan != 1)
+                    {
+                        fprintf(stderr, "read array element failed %d\n", nscan);
+                        fclose(fp);
+                        return -1;
+                    }
+
+                    layer_words.push_back(store_value(vstr));
+                }
+            }
+            else
+            {
+                char vstr[16];
+                nscan = fscanf(fp, "%15s", vstr);
+                if (nscan != 1)
+                {
+                    fprintf(stderr, "read value failed %d\n", nscan);
+                    fclose(fp);
+                    return -1;
+                }
+
+                layer_words.push_back(store_value(vstr));
+            }
+
+            layer_words[param_count_pos]++;
+        }
+    }
+
+    fclose(fp);
+
+    strings.resize((strings.size() + 3) / 4 * 4, '\0');
+
+    FILE* gp = fopen(graphpath, "wb");
+    if (!gp)
+    {
+        fprintf(stderr, "fopen %s failed\n", graphpath);
+        return -1;
+    }
+
+    int header[7];
+    header[0] = 0x6e636770;
+    header[1] = 1;
+    header[2] = layer_count;
+    header[3] = blob_count;
+    header[4] = type_ids.size();
+    header[5] = strings.size();
+    header[6] = layer_words.size();
+
+    fwrite(header, sizeof(int), 7, gp);
+    fwrite(strings.data(), 1, strings.size(), gp);
+    fwrite(type_table.data(), sizeof(int), type_table.size(), gp);
+    fwrite(blob_table.data(), sizeof(int), blob_table.size(), gp);
+    fwrite(layer_words.data(), sizeof(int), layer_words.size(), gp);
+
+    fclose(gp);
+
+    return 0;
+}
+
 static int write_memcpp(const char* parambinpath, const char* modelpath, const char* memcpppath)
 {
     FILE* cppfp = fopen(memcpppath, "wb");
@@ -369,9 +611,12 @@ int main(int argc, char** argv)
     const char* name = lastslash == NULL ? parampath : lastslash + 1;
 
     std::string parambinpath = std::string(name) + ".bin";
+    std::string paramgraphpath = std::string(name) + ".graph";
 
     dump_param(parampath, parambinpath.c_str(), idcpppath);
 
+    dump_param_graph(parampath, paramgraphpath.c_str());
+
     write_memcpp(parambinpath.c_str(), modelpath, memcpppath);
 
     return 0;
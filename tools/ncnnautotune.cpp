@@ -0,0 +1,100 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ncnn public header
+#include "benchmark.h"
+#include "cpu.h"
+#include "net.h"
+
+// time every convolution kernel of a model on this cpu and write the kernel table
+// run again with other input shapes to add them to the same table
+int main(int argc, char** argv)
+{
+    if (argc < 9 || argc > 11)
+    {
+        fprintf(stderr, "usage: %s [inparam] [inbin] [tablepath] [inblob] [w] [h] [c] [outblob] [num_threads=max] [loop_count=4]\n", argv[0]);
+        return -1;
+    }
+
+    const char* inparam = argv[1];
+    const char* inbin = argv[2];
+    const char* tablepath = argv[3];
+    const char* inblob = argv[4];
+    const int w = atoi(argv[5]);
+    const int h = atoi(argv[6]);
+    const int c = atoi(argv[7]);
+    const char* outblob = argv[8];
+    const int num_threads = argc > 9 ? atoi(argv[9]) : ncnn::get_cpu_count();
+    const int loop_count = argc > 10 ? atoi(argv[10]) : 4;
+
+    ncnn::Net net;
+    net.opt.num_threads = num_threads;
+
+    int ret = net.load_param(inparam);
+    if (ret != 0)
+    {
+        fprintf(stderr, "load_param %s failed\n", inparam);
+        return -1;
+    }
+
+    ret = net.load_model(inbin);
+    if (ret != 0)
+    {
+        fprintf(stderr, "load_model %s failed\n", inbin);
+        return -1;
+    }
+
+    // keep the shapes tuned by earlier runs
+    FILE* fp = fopen(tablepath, "rb");
+    if (fp)
+    {
+        fclose(fp);
+        net.load_kernel_table(tablepath);
+    }
+
+    ncnn::Mat in(w, h, c);
+    for (int q=0; q<c; q++)
+    {
+        float* ptr = in.channel(q);
+        for (int i=0; i<w * h; i++)
+        {
+            ptr[i] = (float)((q * 13 + i * 7) % 255) / 255.f - 0.5f;
+        }
+    }
+
+    double start = ncnn::get_current_time();
+
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input(inblob, in);
+    ret = ex.autotune(outblob, loop_count);
+    if (ret != 0)
+    {
+        fprintf(stderr, "autotune %s failed\n", outblob);
+        return -1;
+    }
+
+    double end = ncnn::get_current_time();
+
+    ret = net.save_kernel_table(tablepath);
+    if (ret != 0)
+        return -1;
+
+    fprintf(stderr, "autotune %.2f ms\n", end - start);
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ncnn public header
+#include "benchmark.h"
+#include "net.h"
+
+// prebuild the transformed weight cache of a model
+// option flags must match the ones the application loads the model with
+int main(int argc, char** argv)
+{
+    if (argc < 4 || argc > 10)
+    {
+        fprintf(stderr, "usage: %s [inparam] [inbin] [cachedir] [winograd=1] [sgemm=1] [int8=1] [packing=0] [winograd43=0] [winograd63=0]\n", argv[0]);
+        return -1;
+    }
+
+    const char* inparam = argv[1];
+    const char* inbin = argv[2];
+    const char* cachedir = argv[3];
+
+    ncnn::Net net;
+
+    net.opt.use_winograd_convolution = argc > 4 ? atoi(argv[4]) != 0 : true;
+    net.opt.use_sgemm_convolution = argc > 5 ? atoi(argv[5]) != 0 : true;
+    net.opt.use_int8_inference = argc > 6 ? atoi(argv[6]) != 0 : true;
+    net.opt.use_packing_layout = argc > 7 ? atoi(argv[7]) != 0 : false;
+    net.opt.use_winograd43_convolution = argc > 8 ? atoi(argv[8]) != 0 : false;
+    net.opt.use_winograd63_convolution = argc > 9 ? atoi(argv[9]) != 0 : false;
+
+    net.set_weight_cache_dir(cachedir);
+
+    int ret = net.load_param(inparam);
+    if (ret != 0)
+    {
+        fprintf(stderr, "load_param %s failed\n", inparam);
+        return -1;
+    }
+
+    // the first load writes the cache, the second one must hit it
+    double start = ncnn::get_current_time();
+
+    ret = net.load_model_mmap(inbin);
+    if (ret != 0)
+    {
+        fprintf(stderr, "load_model %s failed\n", inbin);
+        return -1;
+    }
+
+    double built = ncnn::get_current_time();
+
+    ncnn::Net net2;
+    net2.opt = net.opt;
+    net2.set_weight_cache_dir(cachedir);
+    net2.load_param(inparam);
+    ret = net2.load_model_mmap(inbin);
+    if (ret != 0)
+    {
+        fprintf(stderr, "reload %s from weight cache failed\n", inbin);
+        return -1;
+    }
+
+    double end = ncnn::get_current_time();
+
+    fprintf(stderr, "load %.2f ms, cached load %.2f ms\n", built - start, end - built);
+
+    return 0;
+}
@@ -82,10 +82,11 @@
 #include "layer/yolov3detectionoutput.h"
 
 
-static bool read_int8scale_table(const char* filepath, std::map<std::string, std::vector<float> >& blob_int8scale_table, std::map<std::string, std::vector<float> >& weight_int8scale_table)
+static bool read_int8scale_table(const char* filepath, std::map<std::string, std::vector<float> >& blob_int8scale_table, std::map<std::string, std::vector<float> >& weight_int8scale_table, std::map<std::string, int>& blob_int8zeropoint_table)
 {
     blob_int8scale_table.clear();
     weight_int8scale_table.clear();
+    blob_int8zeropoint_table.clear();
 
     FILE* fp = fopen(filepath, "rb");
     if (!fp)
@@ -136,6 +137,11 @@ static bool read_int8scale_table(const char* filepath, std::map<std::string, std
         {
             weight_int8scale_table[ keystr ] = scales;
         }
+        // XYZ_zero_point pattern
+        else if (keystr.size() > 11 && keystr.compare(keystr.size() - 11, 11, "_zero_point") == 0)
+        {
+            blob_int8zeropoint_table[ keystr.substr(0, keystr.size() - 11) ] = scales.empty() ? 0 : (int)scales[0];
+        }
         else
         {
             blob_int8scale_table[ keystr ] = scales;
@@ -156,8 +162,12 @@ public:
     int storage_type;
     std::map<std::string, std::vector<float> > blob_int8scale_table;
     std::map<std::string, std::vector<float> > weight_int8scale_table; 
+    std::map<std::string, int> blob_int8zeropoint_table;
 
 public:
+    // fold the bottom blob scales of a layer without per channel and zero point support into one
+    int symmetric_per_tensor_scale(const std::string& name);
+
     int quantize_convolution();
     int quantize_convolutiondepthwise();
     int quantize_innerproduct();
@@ -172,6 +182,34 @@ public:
     int save(const char* parampath, const char* binpath);
 };
 
+int NetQuantize::symmetric_per_tensor_scale(const std::string& name)
+{
+    std::vector<float>& scales = blob_int8scale_table[name];
+    if (scales.empty())
+        return -1;
+
+    int zero_point = 0;
+    std::map<std::string, int>::iterator iter = blob_int8zeropoint_table.find(name);
+    if (iter != blob_int8zeropoint_table.end())
+    {
+        zero_point = iter->second;
+        blob_int8zeropoint_table.erase(iter);
+    }
+
+    // the widest channel range
+    float scale = scales[0];
+    for (size_t i=1; i<scales.size(); i++)
+        scale = std::min(scale, scales[i]);
+
+    // the asymmetric range fits in the symmetric one of its larger end
+    scale = scale * 127 / (127 + abs(zero_point));
+
+    scales.resize(1);
+    scales[0] = scale;
+
+    return 0;
+}
+
 int NetQuantize::quantize_convolution()
 {
     const int layer_count = layers.size();
@@ -202,6 +240,55 @@ int NetQuantize::quantize_convolution()
 
         fprintf(stderr, "quantize_convolution %s\n", convolution->name.c_str());
 
+        std::map<std::string, int>::iterator iter_zero_point = blob_int8zeropoint_table.find(layers[i]->name);
+        if (iter_zero_point != blob_int8zeropoint_table.end())
+            convolution->bottom_blob_int8_zero_point = iter_zero_point->second;
+
+        const int maxk = convolution->kernel_w * convolution->kernel_h;
+        const int num_input = convolution->weight_data_size / maxk / convolution->num_output;
+
+        // per channel bottom blob scales, the int8 pad value is only exact for zero
+        const std::vector<float> bottom_blob_int8_scales = iter_data->second;
+        bool per_channel = (int)bottom_blob_int8_scales.size() == num_input && num_input > 1 && convolution->pad_value == 0.f;
+
+        if (per_channel)
+        {
+            // fold the bottom blob scales into the weight, keep the weight bit width of the table
+            ncnn::Mat weight_data_folded = convolution->weight_data.clone();
+            if (weight_data_folded.empty())
+                return -100;
+
+            for (int n=0; n<convolution->num_output; n++)
+            {
+                float* kptr = (float*)weight_data_folded + num_input * maxk * n;
+
+                float max_value = 0.f;
+                float max_value_folded = 0.f;
+                for (int q=0; q<num_input; q++)
+                {
+                    for (int k=0; k<maxk; k++)
+                    {
+                        max_value = std::max(max_value, (float)fabs(kptr[q * maxk + k]));
+                        kptr[q * maxk + k] /= bottom_blob_int8_scales[q];
+                        max_value_folded = std::max(max_value_folded, (float)fabs(kptr[q * maxk + k]));
+                    }
+                }
+
+                weight_data_int8_scales[n] = max_value_folded == 0.f ? 0.f : weight_data_int8_scales[n] * max_value / max_value_folded;
+            }
+
+            convolution->weight_data = weight_data_folded;
+            weight_int8scale_table[key] = weight_data_int8_scales;
+        }
+        else
+        {
+            // the widest channel range
+            std::vector<float>& scales = blob_int8scale_table[layers[i]->name];
+            for (size_t j=1; j<scales.size(); j++)
+                scales[0] = std::min(scales[0], scales[j]);
+            scales.resize(1);
+        }
+
         {
             ncnn::Mat int8_weight_data(convolution->weight_data_size, (size_t)1u);
             if (int8_weight_data.empty())
@@ -232,7 +319,7 @@ int NetQuantize::quantize_convolution()
             convolution->weight_data = int8_weight_data;
         }
 
-        convolution->int8_scale_term = 2;
+        convolution->int8_scale_term = per_channel ? 3 : 2;
     }
 
     return 0;
@@ -268,6 +355,14 @@ int NetQuantize::quantize_convolutiondepthwise()
 
         fprintf(stderr, "quantize_convolution %s\n", convdw->name.c_str());
 
+        // one bottom blob scale per group, no zero point
+        const int num_input = convdw->weight_data_size / (convdw->kernel_w * convdw->kernel_h) / (convdw->num_output / convdw->group);
+        bool per_channel = (int)iter_data->second.size() == convdw->group && convdw->group == num_input && convdw->group > 1
+                           && convdw->pad_value == 0.f && blob_int8zeropoint_table.find(layers[i]->name) == blob_int8zeropoint_table.end();
+
+        if (!per_channel)
+            symmetric_per_tensor_scale(layers[i]->name);
+
         {
             ncnn::Mat int8_weight_data(convdw->weight_data_size, (size_t)1u);
             if (int8_weight_data.empty())
@@ -298,7 +393,7 @@ int NetQuantize::quantize_convolutiondepthwise()
             convdw->weight_data = int8_weight_data;
         }
 
-        convdw->int8_scale_term = 1;
+        convdw->int8_scale_term = per_channel ? 3 : 1;
     }
 
     return 0;
@@ -334,6 +429,8 @@ int NetQuantize::quantize_innerproduct()
 
         fprintf(stderr, "quantize_convolution %s\n", fc->name.c_str());
 
+        symmetric_per_tensor_scale(layers[i]->name);
+
         {
             ncnn::Mat int8_weight_data(fc->weight_data_size, (size_t)1u);
             if (int8_weight_data.empty())
@@ -575,6 +672,7 @@ int NetQuantize::save(const char* parampath, const char* binpath)
             fprintf_param_value(" 8=%d", int8_scale_term)
             fprintf_param_value(" 9=%d", activation_type)
             { if (!op->activation_params.empty()) fprintf_param_float_array(10, op->activation_params, pp); }
+            fprintf_param_value(" 23=%d", bottom_blob_int8_zero_point)
 
             fwrite_weight_tag_data(0, op->weight_data, bp);
             fwrite_weight_data(op->bias_data, bp);
@@ -1158,7 +1256,7 @@ int main(int argc, char** argv)
     // parse the calibration scale table
     if (int8scale_table_path)
     {
-        bool s2 = read_int8scale_table(int8scale_table_path, quantizer.blob_int8scale_table, quantizer.weight_int8scale_table);
+        bool s2 = read_int8scale_table(int8scale_table_path, quantizer.blob_int8scale_table, quantizer.weight_int8scale_table, quantizer.blob_int8zeropoint_table);
         if (!s2)
         {
             fprintf(stderr, "read_int8scale_table failed\n");
@@ -0,0 +1,674 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <dirent.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+// ncnn public header
+#include "platform.h"
+#include "net.h"
+#include "cpu.h"
+#include "benchmark.h"
+#include "datareader.h"
+
+// ncnn private header
+#include "layer/convolution.h"
+#include "layer/convolutiondepthwise.h"
+#include "layer/innerproduct.h"
+
+#include "quantize_common.h"
+
+static ncnn::Option g_default_option;
+static ncnn::UnlockedPoolAllocator g_blob_pool_allocator;
+static ncnn::PoolAllocator g_workspace_pool_allocator;
+
+// cosine similarity and max absolute error of a blob accumulated over the calibration set
+class BlobError
+{
+public:
+    BlobError() : dot(0), norm_ref(0), norm_int8(0), max_error(0), count(0) {}
+
+    void update(const ncnn::Mat& ref, const ncnn::Mat& int8);
+
+    double cosine() const
+    {
+        if (norm_ref == 0 || norm_int8 == 0)
+            return norm_ref == norm_int8 ? 1.0 : 0.0;
+
+        return dot / sqrt(norm_ref * norm_int8);
+    }
+
+public:
+    double dot;
+    double norm_ref;
+    double norm_int8;
+    float max_error;
+    int count;
+};
+
+void BlobError::update(const ncnn::Mat& ref, const ncnn::Mat& int8)
+{
+    // blobs kept in int8 between layers are not comparable
+    if (ref.empty() || int8.empty() || ref.elemsize != 4 || int8.elemsize != 4)
+        return;
+
+    if (ref.w != int8.w || ref.h != int8.h || ref.c != int8.c)
+        return;
+
+    const int size = ref.w * ref.h;
+    for (int q=0; q<ref.c; q++)
+    {
+        const float* ptr = ref.channel(q);
+        const float* ptr_int8 = int8.channel(q);
+        for (int k=0; k<size; k++)
+        {
+            dot += ptr[k] * ptr_int8[k];
+            norm_ref += ptr[k] * ptr[k];
+            norm_int8 += ptr_int8[k] * ptr_int8[k];
+            max_error = std::max(max_error, fabsf(ptr[k] - ptr_int8[k]));
+        }
+    }
+
+    count++;
+}
+
+// one int8 layer against its float32 twin
+struct MixedLayer
+{
+    int layer_index;
+
+    // standalone ops, both fed with the float32 bottom blob
+    ncnn::Layer* op_fp32;
+    ncnn::Layer* op_int8;
+
+    // int8 op alone and the whole int8 network up to this layer
+    BlobError isolated;
+    BlobError cumulative;
+
+    double time_fp32;
+    double time_int8;
+
+    bool use_int8;
+};
+
+static double forward_time(const ncnn::Layer* op, const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, int loop, const ncnn::Option& opt)
+{
+    double time_min = DBL_MAX;
+    for (int i=0; i<loop; i++)
+    {
+        double start = ncnn::get_current_time();
+
+        op->forward(bottom_blob, top_blob, opt);
+
+        double end = ncnn::get_current_time();
+        time_min = std::min(time_min, end - start);
+    }
+
+    return time_min;
+}
+
+static void read_param_lines(const char* param_path, std::vector<std::string>& lines)
+{
+    FILE* ip = fopen(param_path, "rb");
+    if (!ip)
+        return;
+
+    char line[65536];
+    while (fgets(line, sizeof(line), ip))
+    {
+        std::string s(line);
+        while (!s.empty() && (s[s.size() - 1] == '\n' || s[s.size() - 1] == '\r'))
+            s.erase(s.size() - 1);
+
+        if (s.empty())
+            continue;
+
+        lines.push_back(s);
+    }
+
+    fclose(ip);
+}
+
+// take each layer line from the int8 param when the layer stays int8, otherwise from the float32 param
+static int save_param(const char* fp32param, const char* int8param, const char* outparam, const std::vector<bool>& layer_use_int8)
+{
+    std::vector<std::string> lines_fp32;
+    std::vector<std::string> lines_int8;
+    read_param_lines(fp32param, lines_fp32);
+    read_param_lines(int8param, lines_int8);
+
+    // magic and layer count lines, then one line per layer
+    if (lines_fp32.size() != layer_use_int8.size() + 2 || lines_int8.size() != lines_fp32.size())
+    {
+        fprintf(stderr, "param layer lines mismatch\n");
+        return -1;
+    }
+
+    FILE* pp = fopen(outparam, "wb");
+    if (!pp)
+    {
+        fprintf(stderr, "fopen %s failed\n", outparam);
+        return -1;
+    }
+
+    for (size_t i=0; i<lines_int8.size(); i++)
+    {
+        const bool use_int8 = i < 2 || layer_use_int8[i - 2];
+        fprintf(pp, "%s\n", use_int8 ? lines_int8[i].c_str() : lines_fp32[i].c_str());
+    }
+
+    fclose(pp);
+
+    return 0;
+}
+
+static int save_bin(const ModelBinRecording& mb_fp32, const ModelBinRecording& mb_int8, const char* outbin, const std::vector<bool>& layer_use_int8)
+{
+    FILE* bp = fopen(outbin, "wb");
+    if (!bp)
+    {
+        fprintf(stderr, "fopen %s failed\n", outbin);
+        return -1;
+    }
+
+    // both recordings are in layer order
+    size_t i_fp32 = 0;
+    size_t i_int8 = 0;
+    for (size_t layer_index=0; layer_index<layer_use_int8.size(); layer_index++)
+    {
+        std::vector<const ModelBinRecording::Record*> records;
+        for (; i_fp32 < mb_fp32.records.size() && mb_fp32.records[i_fp32].layer_index == (int)layer_index; i_fp32++)
+        {
+            if (!layer_use_int8[layer_index])
+                records.push_back(&mb_fp32.records[i_fp32]);
+        }
+        for (; i_int8 < mb_int8.records.size() && mb_int8.records[i_int8].layer_index == (int)layer_index; i_int8++)
+        {
+            if (layer_use_int8[layer_index])
+                records.push_back(&mb_int8.records[i_int8]);
+        }
+
+        for (size_t j=0; j<records.size(); j++)
+        {
+            const ModelBinRecording::Record& r = *records[j];
+
+            if (r.type == 0)
+                fwrite_weight(r.data.elemsize == 1 ? 0x000D4B38 : 0, r.data, bp);
+            else
+                fwrite_weight(-1, r.data, bp);
+        }
+    }
+
+    fclose(bp);
+
+    return 0;
+}
+
+// whole network output against the float32 one, and the time spent on it
+static int evaluate_net(const std::vector<std::string>& filenames, QuantNet& net_fp32, ncnn::Net& net, const struct PreParam& pre_param, int loop, BlobError& error, double& time)
+{
+    const std::string output_name = net_fp32.output_blob_name();
+
+    time = 0;
+    for (size_t i=0; i<filenames.size(); i++)
+    {
+        ncnn::Mat in;
+        if (load_image(filenames[i], pre_param, in) != 0)
+            return -1;
+
+        ncnn::Mat out_fp32;
+        {
+            ncnn::Extractor ex = net_fp32.create_extractor();
+            ex.input("data", in);
+            ex.extract(output_name.c_str(), out_fp32);
+        }
+
+        ncnn::Mat out;
+        double time_min = DBL_MAX;
+        for (int j=0; j<loop; j++)
+        {
+            double start = ncnn::get_current_time();
+
+            ncnn::Extractor ex = net.create_extractor();
+            ex.input("data", in);
+            ex.extract(output_name.c_str(), out);
+
+            double end = ncnn::get_current_time();
+            time_min = std::min(time_min, end - start);
+        }
+
+        time += time_min;
+        error.update(out_fp32, out);
+    }
+
+    time /= std::max((int)filenames.size(), 1);
+
+    return 0;
+}
+
+static int mixed_precision(const std::vector<std::string>& filenames, const char* fp32param, const char* fp32bin, const char* int8param, const char* int8bin,
+                           const char* outparam, const char* outbin, float cosine_threshold, int loop, const struct PreParam& pre_param)
+{
+    // networks for the blob comparison
+    QuantNet net_fp32;
+    net_fp32.opt = g_default_option;
+    net_fp32.opt.use_int8_inference = false;
+    if (net_fp32.load_param(fp32param) != 0 || net_fp32.load_model(fp32bin) != 0)
+        return -1;
+
+    QuantNet net_int8;
+    net_int8.opt = g_default_option;
+    if (net_int8.load_param(int8param) != 0 || net_int8.load_model(int8bin) != 0)
+        return -1;
+
+    // reload the weights in file order, the recorded layers serve as the standalone ops
+    QuantNet recording_fp32;
+    QuantNet recording_int8;
+    recording_fp32.opt = net_fp32.opt;
+    recording_int8.opt = net_int8.opt;
+
+    FILE* fp_fp32 = fopen(fp32bin, "rb");
+    FILE* fp_int8 = fopen(int8bin, "rb");
+    if (!fp_fp32 || !fp_int8)
+    {
+        fprintf(stderr, "fopen %s %s failed\n", fp32bin, int8bin);
+        if (fp_fp32)
+            fclose(fp_fp32);
+        if (fp_int8)
+            fclose(fp_int8);
+        return -1;
+    }
+
+    ncnn::DataReaderFromStdio dr_fp32(fp_fp32);
+    ncnn::DataReaderFromStdio dr_int8(fp_int8);
+    ModelBinRecording mb_fp32(dr_fp32);
+    ModelBinRecording mb_int8(dr_int8);
+
+    int ret = 0;
+    if (recording_fp32.load_param(fp32param) != 0 || recording_fp32.load_model_recording(mb_fp32) != 0
+        || recording_int8.load_param(int8param) != 0 || recording_int8.load_model_recording(mb_int8) != 0)
+        ret = -1;
+
+    fclose(fp_fp32);
+    fclose(fp_int8);
+
+    if (ret == 0 && recording_fp32.layer_count() != recording_int8.layer_count())
+    {
+        fprintf(stderr, "float32 and int8 models have different layer count\n");
+        ret = -1;
+    }
+
+    for (int i=0; ret == 0 && i<recording_fp32.layer_count(); i++)
+    {
+        if (recording_fp32.layer(i)->name != recording_int8.layer(i)->name || recording_fp32.layer(i)->type != recording_int8.layer(i)->type)
+        {
+            fprintf(stderr, "layer %d %s does not match %s\n", i, recording_fp32.layer(i)->name.c_str(), recording_int8.layer(i)->name.c_str());
+            ret = -1;
+        }
+    }
+
+    std::vector<MixedLayer> mixed_layers;
+    if (ret == 0)
+    {
+        std::vector<int> int8_layers;
+        recording_int8.get_int8_layers(int8_layers);
+
+        for (size_t j=0; j<int8_layers.size(); j++)
+        {
+            MixedLayer ml;
+            ml.layer_index = int8_layers[j];
+            ml.op_fp32 = recording_fp32.layer(ml.layer_index);
+            ml.op_int8 = recording_int8.layer(ml.layer_index);
+            ml.time_fp32 = 0;
+            ml.time_int8 = 0;
+            ml.use_int8 = false;
+
+            if (ml.op_fp32->create_pipeline(recording_fp32.opt) != 0 || ml.op_int8->create_pipeline(recording_int8.opt) != 0)
+            {
+                fprintf(stderr, "create_pipeline %s failed\n", ml.op_int8->name.c_str());
+                ret = -1;
+                break;
+            }
+
+            mixed_layers.push_back(ml);
+        }
+    }
+
+    if (ret != 0)
+        return -1;
+
+    // step 1 per blob and per layer error, per layer time
+    printf("====> step 1 : compare float32 and int8 layers.\n");
+    std::vector<BlobError> blob_errors(net_fp32.blob_count());
+    for (size_t i=0; i<filenames.size(); i++)
+    {
+        if ((i+1)%100 == 0)
+            fprintf(stderr, "          %d/%d\n", (int)(i+1), (int)filenames.size());
+
+        ncnn::Mat in;
+        if (load_image(filenames[i], pre_param, in) != 0)
+            return -1;
+
+        ncnn::Extractor ex_fp32 = net_fp32.create_extractor();
+        ncnn::Extractor ex_int8 = net_int8.create_extractor();
+        ex_fp32.input("data", in);
+        ex_int8.input("data", in);
+
+        for (int b=0; b<net_fp32.blob_count(); b++)
+        {
+            const std::string name = net_fp32.blob_name(b);
+
+            ncnn::Mat blob_fp32;
+            ncnn::Mat blob_int8;
+            if (ex_fp32.extract(name.c_str(), blob_fp32) != 0 || ex_int8.extract(name.c_str(), blob_int8) != 0)
+                continue;
+
+            blob_errors[b].update(blob_fp32, blob_int8);
+        }
+
+        for (size_t j=0; j<mixed_layers.size(); j++)
+        {
+            MixedLayer& ml = mixed_layers[j];
+
+            ncnn::Mat bottom_blob;
+            ncnn::Mat top_blob;
+            ncnn::Mat top_blob_int8;
+            ex_fp32.extract(net_fp32.bottom_blob_name(ml.layer_index).c_str(), bottom_blob);
+            ex_fp32.extract(net_fp32.top_blob_name(ml.layer_index).c_str(), top_blob);
+
+            // warm up on the first image
+            if (i == 0)
+            {
+                ncnn::Mat top_blob_warmup;
+                ml.op_fp32->forward(bottom_blob, top_blob_warmup, recording_fp32.opt);
+                ml.op_int8->forward(bottom_blob, top_blob_warmup, recording_int8.opt);
+            }
+
+            ncnn::Mat top_blob_fp32;
+            ml.time_fp32 += forward_time(ml.op_fp32, bottom_blob, top_blob_fp32, loop, recording_fp32.opt);
+            ml.time_int8 += forward_time(ml.op_int8, bottom_blob, top_blob_int8, loop, recording_int8.opt);
+
+            ml.isolated.update(top_blob, top_blob_int8);
+        }
+    }
+
+    // step 2 keep the int8 layers that are accurate and faster
+    printf("====> step 2 : select the int8 layers.\n");
+    std::vector<bool> layer_use_int8(recording_int8.layer_count(), true);
+    for (size_t j=0; j<mixed_layers.size(); j++)
+    {
+        MixedLayer& ml = mixed_layers[j];
+
+        ml.time_fp32 /= std::max((int)filenames.size(), 1);
+        ml.time_int8 /= std::max((int)filenames.size(), 1);
+        ml.cumulative = blob_errors[ net_fp32.layer(ml.layer_index)->tops[0] ];
+
+        ml.use_int8 = ml.isolated.cosine() >= cosine_threshold && ml.time_int8 < ml.time_fp32;
+        layer_use_int8[ml.layer_index] = ml.use_int8;
+    }
+
+    ret = save_param(fp32param, int8param, outparam, layer_use_int8);
+    if (ret == 0)
+        ret = save_bin(mb_fp32, mb_int8, outbin, layer_use_int8);
+
+    if (ret != 0)
+        return -1;
+
+    // step 3 whole network
+    printf("====> step 3 : evaluate the mixed precision model.\n");
+    ncnn::Net net_mixed;
+    net_mixed.opt = g_default_option;
+    if (net_mixed.load_param(outparam) != 0 || net_mixed.load_model(outbin) != 0)
+        return -1;
+
+    BlobError output_error_fp32;
+    BlobError output_error_int8;
+    BlobError output_error_mixed;
+    double time_fp32 = 0;
+    double time_int8 = 0;
+    double time_mixed = 0;
+    if (evaluate_net(filenames, net_fp32, net_fp32, pre_param, loop, output_error_fp32, time_fp32) != 0
+        || evaluate_net(filenames, net_fp32, net_int8, pre_param, loop, output_error_int8, time_int8) != 0
+        || evaluate_net(filenames, net_fp32, net_mixed, pre_param, loop, output_error_mixed, time_mixed) != 0)
+        return -1;
+
+    // report
+    fprintf(stderr, "%-24s %12s %12s\n", "blob", "cosine", "max error");
+    for (int b=0; b<net_fp32.blob_count(); b++)
+    {
+        const BlobError& e = blob_errors[b];
+        if (e.count == 0)
+            continue;
+
+        fprintf(stderr, "%-24s %12f %12f\n", net_fp32.blob_name(b).c_str(), e.cosine(), e.max_error);
+    }
+
+    fprintf(stderr, "\n%-24s %12s %12s %12s %10s %10s %6s\n", "layer", "cosine", "max error", "net cosine", "fp32 ms", "int8 ms", "mixed");
+    for (size_t j=0; j<mixed_layers.size(); j++)
+    {
+        const MixedLayer& ml = mixed_layers[j];
+
+        // the top blob stays int8 when requantize is fused
+        char net_cosine[32] = "-";
+        if (ml.cumulative.count > 0)
+            sprintf(net_cosine, "%f", ml.cumulative.cosine());
+
+        fprintf(stderr, "%-24s %12f %12f %12s %10.3f %10.3f %6s\n", net_fp32.layer(ml.layer_index)->name.c_str(),
+                ml.isolated.cosine(), ml.isolated.max_error, net_cosine, ml.time_fp32, ml.time_int8, ml.use_int8 ? "int8" : "fp32");
+    }
+
+    fprintf(stderr, "\n%-24s %12s %12s %10s\n", "network", "cosine", "max error", "ms");
+    fprintf(stderr, "%-24s %12f %12f %10.3f\n", "fp32", output_error_fp32.cosine(), output_error_fp32.max_error, time_fp32);
+    fprintf(stderr, "%-24s %12f %12f %10.3f\n", "int8", output_error_int8.cosine(), output_error_int8.max_error, time_int8);
+    fprintf(stderr, "%-24s %12f %12f %10.3f\n", "mixed", output_error_mixed.cosine(), output_error_mixed.max_error, time_mixed);
+
+    return 0;
+}
+
+// usage
+void showUsage()
+{
+    std::cout << "usage: ncnn2mixed [-h] [-p] [-b] [-q] [-x] [-i] [-o] [-w] [-m] [-n] [-s] [-c] [-e] [-l] [-t]" << std::endl;
+    std::cout << " -h, --help       show this help message and exit" << std::endl;
+    std::cout << " -p, --param      path to float32 ncnn.param file" << std::endl;
+    std::cout << " -b, --bin        path to float32 ncnn.bin file" << std::endl;
+    std::cout << " -q, --int8param  path to int8 ncnn.param file written by ncnn2int8" << std::endl;
+    std::cout << " -x, --int8bin    path to int8 ncnn.bin file written by ncnn2int8" << std::endl;
+    std::cout << " -i, --images     path to calibration images" << std::endl;
+    std::cout << " -o, --outparam   path to output mixed precision ncnn.param file" << std::endl;
+    std::cout << " -w, --outbin     path to output mixed precision ncnn.bin file" << std::endl;
+    std::cout << " -m, --mean       value of mean" << std::endl;
+    std::cout << " -n, --norm       value of normalize(scale value,defualt is 1)" << std::endl;
+    std::cout << " -s, --size       the size of input image(using the resize the original image,default is w=224,h=224)" << std::endl;
+    std::cout << " -c  --swapRB     flag which indicates that swap first and last channels in 3-channel image is necessary" << std::endl;
+    std::cout << " -e, --cosine     int8 layers with lower output cosine similarity are kept float32(default is 0.99)" << std::endl;
+    std::cout << " -l, --loop       timing runs per image, the fastest one counts(default is 4)" << std::endl;
+    std::cout << " -t, --thread     number of threads(defalut is 1)" << std::endl;
+    std::cout << "example: ./ncnn2mixed --param squeezenet-fp32.param --bin squeezenet-fp32.bin --int8param squeezenet-int8.param --int8bin squeezenet-int8.bin --images images/ --outparam squeezenet-mixed.param --outbin squeezenet-mixed.bin --mean 104,117,123 --norm 1,1,1 --size 227,227 --cosine 0.99 --thread 2" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    char* imagepath = NULL;
+    char* parampath = NULL;
+    char* binpath = NULL;
+    char* int8parampath = NULL;
+    char* int8binpath = NULL;
+    char* outparampath = NULL;
+    char* outbinpath = NULL;
+    float cosine_threshold = 0.99f;
+    int loop = 4;
+    int num_threads = 1;
+
+    struct PreParam pre_param = {
+        .mean = {104.f, 117.f, 103.f},
+        .norm = {1.f, 1.f, 1.f},
+        .weith = 224,
+        .height =224,
+        .swapRB = false
+    };
+
+    int c;
+
+    while (1)
+    {
+        int option_index = 0;
+        static struct option long_options[] =
+        {
+            {"param",     required_argument, 0,  'p' },
+            {"bin",       required_argument, 0,  'b' },
+            {"int8param", required_argument, 0,  'q' },
+            {"int8bin",   required_argument, 0,  'x' },
+            {"images",    required_argument, 0,  'i' },
+            {"outparam",  required_argument, 0,  'o' },
+            {"outbin",    required_argument, 0,  'w' },
+            {"mean",      required_argument, 0,  'm' },
+            {"norm",      required_argument, 0,  'n' },
+            {"size",      required_argument, 0,  's' },
+            {"swapRB",    no_argument,       0,  'c' },
+            {"cosine",    required_argument, 0,  'e' },
+            {"loop",      required_argument, 0,  'l' },
+            {"thread",    required_argument, 0,  't' },
+            {"help",      no_argument,       0,  'h' },
+            {0,           0,                 0,  0 }
+        };
+
+        c = getopt_long(argc, argv, "p:b:q:x:i:o:w:m:n:s:ce:l:t:h", long_options, &option_index);
+        if (c == -1)
+            break;
+
+        switch (c)
+        {
+        case 'p':
+            parampath = optarg;
+            break;
+
+        case 'b':
+            binpath = optarg;
+            break;
+
+        case 'q':
+            int8parampath = optarg;
+            break;
+
+        case 'x':
+            int8binpath = optarg;
+            break;
+
+        case 'i':
+            imagepath = optarg;
+            break;
+
+        case 'o':
+            outparampath = optarg;
+            break;
+
+        case 'w':
+            outbinpath = optarg;
+            break;
+
+        case 'm':
+        {
+            std::vector<std::string> array = split(std::string(optarg), ",");
+            pre_param.mean[0] = atof(array[0].c_str());
+            pre_param.mean[1] = atof(array[1].c_str());
+            pre_param.mean[2] = atof(array[2].c_str());
+        }
+            break;
+
+        case 'n':
+        {
+            std::vector<std::string> array = split(std::string(optarg), ",");
+            pre_param.norm[0] = atof(array[0].c_str());
+            pre_param.norm[1] = atof(array[1].c_str());
+            pre_param.norm[2] = atof(array[2].c_str());
+        }
+            break;
+
+        case 's':
+        {
+            std::vector<std::string> array = split(std::string(optarg), ",");
+            pre_param.weith = atoi(array[0].c_str());
+            pre_param.height = atoi(array[1].c_str());
+        }
+            break;
+
+        case 'c':
+            pre_param.swapRB = true;
+            break;
+
+        case 'e':
+            cosine_threshold = atof(optarg);
+            break;
+
+        case 'l':
+            loop = atoi(optarg);
+            break;
+
+        case 't':
+            num_threads = atoi(optarg);
+            break;
+
+        case 'h':
+        case '?':
+            showUsage();
+            return 0;
+
+        default:
+            showUsage();
+        }
+    }
+
+    // check the input param
+    if (imagepath == NULL || parampath == NULL || binpath == NULL || int8parampath == NULL || int8binpath == NULL || outparampath == NULL || outbinpath == NULL)
+    {
+        fprintf(stderr, "someone path maybe empty,please check it and try again.\n");
+        return 0;
+    }
+
+    if (loop < 1)
+        loop = 1;
+
+    g_blob_pool_allocator.set_size_compare_ratio(0.0f);
+    g_workspace_pool_allocator.set_size_compare_ratio(0.5f);
+
+    // default option, keep every blob for the per blob comparison
+    g_default_option.lightmode = false;
+    g_default_option.num_threads = num_threads;
+    g_default_option.blob_allocator = &g_blob_pool_allocator;
+    g_default_option.workspace_allocator = &g_workspace_pool_allocator;
+
+    ncnn::set_cpu_powersave(2);
+    ncnn::set_omp_dynamic(0);
+    ncnn::set_omp_num_threads(num_threads);
+
+    std::vector<std::string> filenames;
+
+    // parse the image file.
+    parse_images_dir(imagepath, filenames);
+
+    return mixed_precision(filenames, parampath, binpath, int8parampath, int8binpath, outparampath, outbinpath, cosine_threshold, loop, pre_param);
+}
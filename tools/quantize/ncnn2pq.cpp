@@ -0,0 +1,393 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+// ncnn public header
+#include "net.h"
+#include "layer.h"
+#include "layer_type.h"
+#include "datareader.h"
+
+// ncnn private header
+#include "layer/convolution.h"
+#include "layer/innerproduct.h"
+
+// remember every weight a layer loads so that the bin can be written back in order
+class ModelBinRecording : public ncnn::ModelBin
+{
+public:
+    ModelBinRecording(const ncnn::DataReader& dr) : mb(dr), layer_index(0) {}
+
+    virtual ncnn::Mat load(int w, int type) const
+    {
+        ncnn::Mat m = mb.load(w, type);
+
+        Record r;
+        r.layer_index = layer_index;
+        r.type = type;
+        r.data = m.clone();
+        records.push_back(r);
+
+        return m;
+    }
+
+public:
+    struct Record
+    {
+        int layer_index;
+        int type;
+        ncnn::Mat data;
+    };
+
+    ncnn::ModelBinFromDataReader mb;
+    int layer_index;
+    mutable std::vector<Record> records;
+};
+
+class NetPQ : public ncnn::Net
+{
+public:
+    // codewords per layer, at most 256 for byte codes
+    int num_codeword;
+    // subvector size of innerproduct weight
+    int innerproduct_subvector;
+    // lloyd iterations
+    int iterations;
+
+public:
+    int load_model_recording(ModelBinRecording& mb);
+
+    int subvector_size(int layer_index, int weight_data_size) const;
+
+    int save(const ModelBinRecording& mb, const char* binpath);
+};
+
+static inline size_t alignSize(size_t sz, int n)
+{
+    return (sz + n-1) & -n;
+}
+
+static void fwrite_padding(FILE* bp, long p0)
+{
+    int nwrite = ftell(bp) - p0;
+    int nalign = alignSize(nwrite, 4);
+    unsigned char padding[4] = {0x00, 0x00, 0x00, 0x00};
+    fwrite(padding, sizeof(unsigned char), nalign - nwrite, bp);
+}
+
+// k-means on n subvectors of size d
+// centroids are trained on a strided sample and every subvector gets its nearest codeword
+static void kmeans(const float* data, int n, int d, int k, int iterations, std::vector<float>& codebook, std::vector<unsigned char>& codes)
+{
+    const int max_train = 65536;
+    const int train_step = n > max_train ? n / max_train : 1;
+    const int num_train = n / train_step;
+
+    k = std::min(k, num_train);
+
+    codebook.resize(k * d);
+    for (int i=0; i<k; i++)
+    {
+        const float* ptr = data + (size_t)(i * (num_train / k) * train_step) * d;
+        memcpy(&codebook[i * d], ptr, d * sizeof(float));
+    }
+
+    std::vector<int> assign(num_train);
+
+    for (int it=0; it<iterations; it++)
+    {
+        #pragma omp parallel for
+        for (int i=0; i<num_train; i++)
+        {
+            const float* ptr = data + (size_t)i * train_step * d;
+
+            float best = FLT_MAX;
+            int best_index = 0;
+            for (int j=0; j<k; j++)
+            {
+                const float* cw = &codebook[j * d];
+                float dist = 0.f;
+                for (int l=0; l<d; l++)
+                {
+                    float v = ptr[l] - cw[l];
+                    dist += v * v;
+                }
+                if (dist < best)
+                {
+                    best = dist;
+                    best_index = j;
+                }
+            }
+
+            assign[i] = best_index;
+        }
+
+        std::vector<double> sum(k * d, 0.0);
+        std::vector<int> count(k, 0);
+        for (int i=0; i<num_train; i++)
+        {
+            const float* ptr = data + (size_t)i * train_step * d;
+            double* sptr = &sum[assign[i] * d];
+            for (int l=0; l<d; l++)
+            {
+                sptr[l] += ptr[l];
+            }
+            count[assign[i]]++;
+        }
+
+        for (int j=0; j<k; j++)
+        {
+            // empty cluster keeps its centroid
+            if (count[j] == 0)
+                continue;
+
+            for (int l=0; l<d; l++)
+            {
+                codebook[j * d + l] = (float)(sum[j * d + l] / count[j]);
+            }
+        }
+    }
+
+    codes.resize(n);
+
+    #pragma omp parallel for
+    for (int i=0; i<n; i++)
+    {
+        const float* ptr = data + (size_t)i * d;
+
+        float best = FLT_MAX;
+        int best_index = 0;
+        for (int j=0; j<k; j++)
+        {
+            const float* cw = &codebook[j * d];
+            float dist = 0.f;
+            for (int l=0; l<d; l++)
+            {
+                float v = ptr[l] - cw[l];
+                dist += v * v;
+            }
+            if (dist < best)
+            {
+                best = dist;
+                best_index = j;
+            }
+        }
+
+        codes[i] = (unsigned char)best_index;
+    }
+}
+
+int NetPQ::load_model_recording(ModelBinRecording& mb)
+{
+    const int layer_count = layers.size();
+    for (int i=0; i<layer_count; i++)
+    {
+        mb.layer_index = i;
+
+        int ret = layers[i]->load_model(mb);
+        if (ret != 0)
+        {
+            fprintf(stderr, "layer load_model %d %s failed\n", i, layers[i]->name.c_str());
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// 0 keeps the weight in float32
+int NetPQ::subvector_size(int layer_index, int weight_data_size) const
+{
+    const ncnn::Layer* layer = layers[layer_index];
+
+    int d = 0;
+    int num_input = 0;
+    if (layer->type == "Convolution")
+    {
+        const ncnn::Convolution* op = (const ncnn::Convolution*)layer;
+        if (op->int8_scale_term)
+            return 0;
+
+        // one codeword per kernel, 1x1 kernels gain nothing from lookup
+        d = op->kernel_w * op->kernel_h;
+        num_input = weight_data_size / op->num_output;
+        if (d == 1)
+            return 0;
+    }
+    else if (layer->type == "InnerProduct")
+    {
+        const ncnn::InnerProduct* op = (const ncnn::InnerProduct*)layer;
+        if (op->int8_scale_term)
+            return 0;
+
+        d = innerproduct_subvector;
+        num_input = weight_data_size / op->num_output;
+    }
+    else
+    {
+        return 0;
+    }
+
+    if (num_input % d != 0)
+        return 0;
+
+    // codebook would outweigh the codes
+    if (weight_data_size / d < num_codeword * 4)
+        return 0;
+
+    return d;
+}
+
+int NetPQ::save(const ModelBinRecording& mb, const char* binpath)
+{
+    FILE* bp = fopen(binpath, "wb");
+    if (!bp)
+    {
+        fprintf(stderr, "fopen %s failed\n", binpath);
+        return -1;
+    }
+
+    size_t size_fp32 = 0;
+    size_t size_pq = 0;
+
+    int last_layer_index = -1;
+    for (size_t i=0; i<mb.records.size(); i++)
+    {
+        const ModelBinRecording::Record& r = mb.records[i];
+
+        // weight_data is the first load of convolution and innerproduct
+        const bool first_load = r.layer_index != last_layer_index;
+        last_layer_index = r.layer_index;
+
+        const ncnn::Mat data = r.data.reshape(r.data.w * r.data.h * r.data.c);
+        const int w = data.w;
+
+        long p0 = ftell(bp);
+
+        int d = 0;
+        if (first_load && r.type == 0 && data.elemsize == 4)
+            d = subvector_size(r.layer_index, w);
+
+        if (d > 0)
+        {
+            const int n = w / d;
+
+            std::vector<float> codebook;
+            std::vector<unsigned char> codes;
+            kmeans(data, n, d, num_codeword, iterations, codebook, codes);
+
+            const int k = codebook.size() / d;
+
+            double err = 0.0;
+            double norm = 0.0;
+            for (int j=0; j<n; j++)
+            {
+                const float* ptr = (const float*)data + (size_t)j * d;
+                const float* cw = &codebook[codes[j] * d];
+                for (int l=0; l<d; l++)
+                {
+                    err += (ptr[l] - cw[l]) * (ptr[l] - cw[l]);
+                    norm += ptr[l] * ptr[l];
+                }
+            }
+
+            unsigned int tag = 0x0051500D; // pq magic
+            int pq_header[2] = {d, k};
+            fwrite(&tag, sizeof(unsigned int), 1, bp);
+            fwrite(pq_header, sizeof(int), 2, bp);
+            fwrite(&codebook[0], sizeof(float), k * d, bp);
+            fwrite(&codes[0], sizeof(unsigned char), n, bp);
+            fwrite_padding(bp, p0);
+
+            fprintf(stderr, "%-24s d=%d k=%d  %d -> %ld bytes  relative error %f\n", layers[r.layer_index]->name.c_str(), d, k, w * 4, ftell(bp) - p0, norm > 0 ? sqrt(err / norm) : 0.0);
+
+            size_fp32 += w * 4;
+            size_pq += ftell(bp) - p0;
+            continue;
+        }
+
+        if (r.type == 0)
+        {
+            unsigned int tag = data.elemsize == 1 ? 0x000D4B38 : 0; // int8 magic or raw float32
+            fwrite(&tag, sizeof(unsigned int), 1, bp);
+        }
+
+        fwrite(data.data, data.elemsize, w, bp);
+        fwrite_padding(bp, p0);
+
+        size_fp32 += ftell(bp) - p0;
+        size_pq += ftell(bp) - p0;
+    }
+
+    fclose(bp);
+
+    fprintf(stderr, "model size %lu -> %lu bytes\n", (unsigned long)size_fp32, (unsigned long)size_pq);
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        fprintf(stderr, "usage: %s [inparam] [inbin] [outbin] [codeword=256] [fcsubvector=8] [iterations=16]\n", argv[0]);
+        return -1;
+    }
+
+    const char* inparam = argv[1];
+    const char* inbin = argv[2];
+    const char* outbin = argv[3];
+    int num_codeword = argc >= 5 ? atoi(argv[4]) : 256;
+    int innerproduct_subvector = argc >= 6 ? atoi(argv[5]) : 8;
+    int iterations = argc >= 7 ? atoi(argv[6]) : 16;
+
+    if (num_codeword < 1 || num_codeword > 256 || innerproduct_subvector < 1 || iterations < 0)
+    {
+        fprintf(stderr, "invalid codeword %d fcsubvector %d iterations %d\n", num_codeword, innerproduct_subvector, iterations);
+        return -1;
+    }
+
+    NetPQ pq;
+    pq.num_codeword = num_codeword;
+    pq.innerproduct_subvector = innerproduct_subvector;
+    pq.iterations = iterations;
+
+    if (pq.load_param(inparam) != 0)
+        return -1;
+
+    FILE* fp = fopen(inbin, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", inbin);
+        return -1;
+    }
+
+    ncnn::DataReaderFromStdio dr(fp);
+    ModelBinRecording mb(dr);
+
+    int ret = pq.load_model_recording(mb);
+    fclose(fp);
+    if (ret != 0)
+        return -1;
+
+    return pq.save(mb, outbin);
+}
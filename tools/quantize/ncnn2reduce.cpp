@@ -0,0 +1,901 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdio.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <dirent.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+// ncnn public header
+#include "platform.h"
+#include "net.h"
+#include "cpu.h"
+#include "datareader.h"
+#include "layer_type.h"
+
+// ncnn private header
+#include "layer/convolution.h"
+
+#include "quantize_common.h"
+
+static ncnn::Option g_default_option;
+static ncnn::UnlockedPoolAllocator g_blob_pool_allocator;
+static ncnn::PoolAllocator g_workspace_pool_allocator;
+
+// input channel statistics of one convolution over the calibration set
+class ChannelReduceData
+{
+public:
+    ChannelReduceData(int layer_index, const std::string& name, int channels);
+
+    int update_statistics(const ncnn::Mat& data);
+
+    // agglomerative clustering of correlated channels into reduced_channels groups
+    // all-zero channels are dropped
+    int cluster_channels(int reduced_channels);
+
+    // least squares kernel of each group for the summed input
+    ncnn::Mat reduce_weight(const ncnn::Convolution* op) const;
+
+public:
+    int layer_index;
+    std::string name;
+    int channels;
+    int feature_size;
+    int reduced_channels;
+
+    // sum over all pixels of x_i and x_i * x_j
+    double count;
+    std::vector<double> sum;
+    std::vector<double> cross;
+
+    // group of each channel, -1 for dropped
+    std::vector<int> channel_group;
+
+    ncnn::Layer* reduced_op;
+    double error_sum;
+    double reference_sum;
+};
+
+ChannelReduceData::ChannelReduceData(int _layer_index, const std::string& _name, int _channels)
+{
+    layer_index = _layer_index;
+    name = _name;
+    channels = _channels;
+    feature_size = 0;
+    reduced_channels = 0;
+
+    count = 0;
+    sum.resize(channels, 0.0);
+    cross.resize(channels * channels, 0.0);
+
+    reduced_op = 0;
+    error_sum = 0;
+    reference_sum = 0;
+}
+
+int ChannelReduceData::update_statistics(const ncnn::Mat& data)
+{
+    const int size = data.w * data.h;
+    feature_size = size;
+
+    #pragma omp parallel for
+    for (int i=0; i<channels; i++)
+    {
+        const float* ptr_i = data.channel(i);
+
+        double s = 0.0;
+        for (int k=0; k<size; k++)
+        {
+            s += ptr_i[k];
+        }
+        sum[i] += s;
+
+        for (int j=i; j<channels; j++)
+        {
+            const float* ptr_j = data.channel(j);
+
+            double c = 0.0;
+            for (int k=0; k<size; k++)
+            {
+                c += ptr_i[k] * ptr_j[k];
+            }
+            cross[i * channels + j] += c;
+        }
+    }
+
+    count += size;
+
+    return 0;
+}
+
+int ChannelReduceData::cluster_channels(int _reduced_channels)
+{
+    // symmetric second moment
+    for (int i=0; i<channels; i++)
+    {
+        for (int j=0; j<i; j++)
+        {
+            cross[i * channels + j] = cross[j * channels + i];
+        }
+    }
+
+    std::vector<double> stddev(channels);
+    for (int i=0; i<channels; i++)
+    {
+        double mean = sum[i] / count;
+        double var = cross[i * channels + i] / count - mean * mean;
+        stddev[i] = var > 0 ? sqrt(var) : 0.0;
+    }
+
+    // each live channel starts as its own cluster
+    std::vector<std::vector<int> > clusters;
+    channel_group.assign(channels, -1);
+    for (int i=0; i<channels; i++)
+    {
+        if (cross[i * channels + i] == 0.0)
+            continue;
+
+        clusters.push_back(std::vector<int>(1, i));
+    }
+
+    const int n = clusters.size();
+    std::vector<double> similarity(n * n, -DBL_MAX);
+    for (int a=0; a<n; a++)
+    {
+        int i = clusters[a][0];
+        for (int b=0; b<n; b++)
+        {
+            int j = clusters[b][0];
+            if (a == b)
+                continue;
+
+            double cov = cross[i * channels + j] / count - (sum[i] / count) * (sum[j] / count);
+            double denom = stddev[i] * stddev[j];
+            similarity[a * n + b] = denom > 0 ? cov / denom : 0.0;
+        }
+    }
+
+    std::vector<bool> alive(n, true);
+    int num_clusters = n;
+    while (num_clusters > _reduced_channels && num_clusters > 1)
+    {
+        int best_a = -1;
+        int best_b = -1;
+        double best = -DBL_MAX;
+        for (int a=0; a<n; a++)
+        {
+            if (!alive[a])
+                continue;
+
+            for (int b=a+1; b<n; b++)
+            {
+                if (!alive[b])
+                    continue;
+
+                if (similarity[a * n + b] > best)
+                {
+                    best = similarity[a * n + b];
+                    best_a = a;
+                    best_b = b;
+                }
+            }
+        }
+
+        // average linkage
+        const double size_a = clusters[best_a].size();
+        const double size_b = clusters[best_b].size();
+        for (int k=0; k<n; k++)
+        {
+            if (!alive[k] || k == best_a || k == best_b)
+                continue;
+
+            double s = (similarity[best_a * n + k] * size_a + similarity[best_b * n + k] * size_b) / (size_a + size_b);
+            similarity[best_a * n + k] = s;
+            similarity[k * n + best_a] = s;
+        }
+
+        clusters[best_a].insert(clusters[best_a].end(), clusters[best_b].begin(), clusters[best_b].end());
+        clusters[best_b].clear();
+        alive[best_b] = false;
+        num_clusters--;
+    }
+
+    reduced_channels = 0;
+    for (int a=0; a<n; a++)
+    {
+        if (!alive[a])
+            continue;
+
+        for (size_t k=0; k<clusters[a].size(); k++)
+        {
+            channel_group[ clusters[a][k] ] = reduced_channels;
+        }
+        reduced_channels++;
+    }
+
+    return 0;
+}
+
+ncnn::Mat ChannelReduceData::reduce_weight(const ncnn::Convolution* op) const
+{
+    const int maxk = op->kernel_w * op->kernel_h;
+    const int num_output = op->num_output;
+
+    // x_i of a group contributes E[x_i S] / E[S S] of the summed input S
+    std::vector<double> coeff(channels, 0.0);
+    std::vector<double> group_energy(reduced_channels, 0.0);
+    for (int i=0; i<channels; i++)
+    {
+        int g = channel_group[i];
+        if (g < 0)
+            continue;
+
+        for (int j=0; j<channels; j++)
+        {
+            if (channel_group[j] == g)
+                coeff[i] += cross[i * channels + j];
+        }
+
+        group_energy[g] += coeff[i];
+    }
+
+    for (int i=0; i<channels; i++)
+    {
+        int g = channel_group[i];
+        if (g >= 0 && group_energy[g] > 0)
+            coeff[i] /= group_energy[g];
+    }
+
+    ncnn::Mat weight_data_reduced(maxk * reduced_channels * num_output);
+    weight_data_reduced.fill(0.f);
+
+    for (int p=0; p<num_output; p++)
+    {
+        const float* kptr = (const float*)op->weight_data + maxk * channels * p;
+        float* outptr = (float*)weight_data_reduced + maxk * reduced_channels * p;
+
+        for (int i=0; i<channels; i++)
+        {
+            int g = channel_group[i];
+            if (g < 0)
+                continue;
+
+            for (int k=0; k<maxk; k++)
+            {
+                outptr[maxk * g + k] += (float)(coeff[i] * kptr[maxk * i + k]);
+            }
+        }
+    }
+
+    return weight_data_reduced;
+}
+
+class ReduceNet : public QuantNet
+{
+public:
+    // convolutions with at least min_channels float32 input channels
+    int get_reduce_layers(int min_channels, std::vector<ChannelReduceData>& reduce_datas);
+};
+
+int ReduceNet::get_reduce_layers(int min_channels, std::vector<ChannelReduceData>& reduce_datas)
+{
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        const ncnn::Layer* layer = layers[i];
+        if (layer->type != "Convolution")
+            continue;
+
+        const ncnn::Convolution* op = (const ncnn::Convolution*)layer;
+        if (op->int8_scale_term || op->weight_data.elemsize != 4 || op->weight_codebook.w != 0)
+            continue;
+
+        const int maxk = op->kernel_w * op->kernel_h;
+        const int channels = op->weight_data_size / maxk / op->num_output;
+        if (channels < min_channels)
+            continue;
+
+        reduce_datas.push_back(ChannelReduceData(i, layer->name, channels));
+    }
+
+    return 0;
+}
+
+static int save_param(const char* inparam, const char* outparam, const std::vector<ChannelReduceData>& reduce_datas, const ReduceNet& net)
+{
+    FILE* ip = fopen(inparam, "rb");
+    if (!ip)
+    {
+        fprintf(stderr, "fopen %s failed\n", inparam);
+        return -1;
+    }
+
+    FILE* pp = fopen(outparam, "wb");
+    if (!pp)
+    {
+        fprintf(stderr, "fopen %s failed\n", outparam);
+        fclose(ip);
+        return -1;
+    }
+
+    // magic and layer count lines, then one line per layer
+    int line_index = 0;
+    char line[65536];
+    while (fgets(line, sizeof(line), ip))
+    {
+        std::string s(line);
+        while (!s.empty() && (s[s.size() - 1] == '\n' || s[s.size() - 1] == '\r'))
+            s.erase(s.size() - 1);
+
+        if (s.empty())
+            continue;
+
+        const int layer_index = line_index - 2;
+        line_index++;
+
+        const ChannelReduceData* rd = 0;
+        for (size_t i=0; i<reduce_datas.size(); i++)
+        {
+            if (reduce_datas[i].layer_index == layer_index && reduce_datas[i].reduced_channels < reduce_datas[i].channels)
+                rd = &reduce_datas[i];
+        }
+
+        if (!rd)
+        {
+            fprintf(pp, "%s\n", s.c_str());
+            continue;
+        }
+
+        const ncnn::Convolution* op = (const ncnn::Convolution*)net.layer(layer_index);
+        const int maxk = op->kernel_w * op->kernel_h;
+
+        // replace weight_data_size and channel reduction params
+        std::vector<std::string> tokens;
+        {
+            char* strc = new char[s.size() + 1];
+            strcpy(strc, s.c_str());
+            char* tmpStr = strtok(strc, " \t");
+            while (tmpStr != NULL)
+            {
+                tokens.push_back(std::string(tmpStr));
+                tmpStr = strtok(NULL, " \t");
+            }
+            delete[] strc;
+        }
+
+        std::string out;
+        for (size_t i=0; i<tokens.size(); i++)
+        {
+            const std::string& t = tokens[i];
+            if (t.compare(0, 2, "6=") == 0 || t.compare(0, 3, "19=") == 0 || t.compare(0, 3, "20=") == 0 || t.compare(0, 3, "21=") == 0 || t.compare(0, 7, "-23322=") == 0)
+                continue;
+
+            if (!out.empty())
+                out += " ";
+            out += t;
+        }
+
+        char buf[64];
+        sprintf(buf, " 6=%d", maxk * rd->reduced_channels * op->num_output);
+        out += buf;
+        sprintf(buf, " 19=%d 20=%d 21=%d", rd->channels, rd->reduced_channels, rd->feature_size);
+        out += buf;
+        sprintf(buf, " -23322=%d", rd->channels);
+        out += buf;
+        for (int i=0; i<rd->channels; i++)
+        {
+            sprintf(buf, ",%d", rd->channel_group[i]);
+            out += buf;
+        }
+
+        fprintf(pp, "%s\n", out.c_str());
+    }
+
+    fclose(ip);
+    fclose(pp);
+
+    return 0;
+}
+
+static int save_bin(const ModelBinRecording& mb, const char* outbin, const std::vector<ChannelReduceData>& reduce_datas, const ReduceNet& net)
+{
+    FILE* bp = fopen(outbin, "wb");
+    if (!bp)
+    {
+        fprintf(stderr, "fopen %s failed\n", outbin);
+        return -1;
+    }
+
+    int last_layer_index = -1;
+    for (size_t i=0; i<mb.records.size(); i++)
+    {
+        const ModelBinRecording::Record& r = mb.records[i];
+
+        // weight_data is the first load of convolution
+        const bool first_load = r.layer_index != last_layer_index;
+        last_layer_index = r.layer_index;
+
+        const ChannelReduceData* rd = 0;
+        for (size_t j=0; j<reduce_datas.size(); j++)
+        {
+            if (reduce_datas[j].layer_index == r.layer_index && reduce_datas[j].reduced_channels < reduce_datas[j].channels)
+                rd = &reduce_datas[j];
+        }
+
+        if (first_load && rd)
+        {
+            fwrite_weight(0, rd->reduce_weight((const ncnn::Convolution*)net.layer(r.layer_index)), bp);
+            continue;
+        }
+
+        if (r.type == 0)
+            fwrite_weight(r.data.elemsize == 1 ? 0x000D4B38 : 0, r.data, bp);
+        else
+            fwrite_weight(-1, r.data, bp);
+    }
+
+    fclose(bp);
+
+    return 0;
+}
+
+static ncnn::Layer* create_reduced_convolution(const ncnn::Convolution* op, const ChannelReduceData& rd, const ncnn::Option& opt)
+{
+    ncnn::Layer* reduced_op = ncnn::create_layer(ncnn::LayerType::Convolution);
+
+    const int maxk = op->kernel_w * op->kernel_h;
+
+    ncnn::ParamDict pd;
+    pd.set(0, op->num_output);
+    pd.set(1, op->kernel_w);
+    pd.set(11, op->kernel_h);
+    pd.set(2, op->dilation_w);
+    pd.set(12, op->dilation_h);
+    pd.set(3, op->stride_w);
+    pd.set(13, op->stride_h);
+    pd.set(4, op->pad_left);
+    pd.set(15, op->pad_right);
+    pd.set(14, op->pad_top);
+    pd.set(16, op->pad_bottom);
+    pd.set(18, op->pad_value);
+    pd.set(5, op->bias_term);
+    pd.set(6, maxk * rd.reduced_channels * op->num_output);
+    pd.set(9, op->activation_type);
+    pd.set(10, op->activation_params);
+
+    reduced_op->load_param(pd);
+
+    ncnn::Mat weights[2];
+    weights[0] = rd.reduce_weight(op);
+    weights[1] = op->bias_data;
+
+    reduced_op->load_model(ncnn::ModelBinFromMatArray(weights));
+
+    reduced_op->create_pipeline(opt);
+
+    return reduced_op;
+}
+
+// sum the input channels of each group
+static ncnn::Mat reduce_input(const ncnn::Mat& bottom_blob, const ChannelReduceData& rd)
+{
+    ncnn::Mat bottom_blob_reduced(bottom_blob.w, bottom_blob.h, rd.reduced_channels);
+    bottom_blob_reduced.fill(0.f);
+
+    const int size = bottom_blob.w * bottom_blob.h;
+    for (int i=0; i<rd.channels; i++)
+    {
+        int g = rd.channel_group[i];
+        if (g < 0)
+            continue;
+
+        const float* ptr = bottom_blob.channel(i);
+        float* outptr = bottom_blob_reduced.channel(g);
+        for (int k=0; k<size; k++)
+        {
+            outptr[k] += ptr[k];
+        }
+    }
+
+    return bottom_blob_reduced;
+}
+
+static double convolution_flops(const ncnn::Convolution* op, int channels, const ncnn::Mat& top_blob)
+{
+    return 2.0 * op->kernel_w * op->kernel_h * channels * op->num_output * top_blob.w * top_blob.h;
+}
+
+static int channel_reduce(const std::vector<std::string>& filenames, const char* param_path, const char* bin_path, const char* outparam_path, const char* outbin_path, float ratio, int min_channels, const struct PreParam& pre_param)
+{
+    ReduceNet net;
+    net.opt = g_default_option;
+
+    if (net.load_param(param_path) != 0 || net.load_model(bin_path) != 0)
+        return -1;
+
+    std::vector<ChannelReduceData> reduce_datas;
+    net.get_reduce_layers(min_channels, reduce_datas);
+
+    // step 1 input channel statistics
+    printf("====> step 1 : collect input channel statistics.\n");
+    for (size_t i=0; i<filenames.size(); i++)
+    {
+        if ((i+1)%100 == 0)
+            fprintf(stderr, "          %d/%d\n", (int)(i+1), (int)filenames.size());
+
+        ncnn::Mat in;
+        if (load_image(filenames[i], pre_param, in) != 0)
+            return -1;
+
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", in);
+
+        for (size_t j=0; j<reduce_datas.size(); j++)
+        {
+            ncnn::Mat bottom_blob;
+            ex.extract(net.bottom_blob_name(reduce_datas[j].layer_index).c_str(), bottom_blob);
+
+            if (bottom_blob.dims != 3 || bottom_blob.c != reduce_datas[j].channels)
+                continue;
+
+            reduce_datas[j].update_statistics(bottom_blob);
+        }
+    }
+
+    // step 2 grouping
+    printf("====> step 2 : cluster correlated input channels.\n");
+    for (size_t j=0; j<reduce_datas.size(); j++)
+    {
+        ChannelReduceData& rd = reduce_datas[j];
+        if (rd.count == 0)
+        {
+            rd.reduced_channels = rd.channels;
+            continue;
+        }
+
+        int target = (int)(rd.channels * ratio + 0.5f);
+        rd.cluster_channels(std::max(target, 1));
+
+        if (rd.reduced_channels < rd.channels)
+            rd.reduced_op = create_reduced_convolution((const ncnn::Convolution*)net.layer(rd.layer_index), rd, net.opt);
+    }
+
+    if (save_param(param_path, outparam_path, reduce_datas, net) != 0)
+        return -1;
+
+    // reload the weights in file order and write them back with the reduced ones
+    {
+        ReduceNet recording_net;
+        recording_net.load_param(param_path);
+
+        FILE* fp = fopen(bin_path, "rb");
+        if (!fp)
+            return -1;
+
+        ncnn::DataReaderFromStdio dr(fp);
+        ModelBinRecording mb(dr);
+        int ret = recording_net.load_model_recording(mb);
+        fclose(fp);
+        if (ret != 0)
+            return -1;
+
+        if (save_bin(mb, outbin_path, reduce_datas, net) != 0)
+            return -1;
+    }
+
+    // step 3 per layer error and flops
+    printf("====> step 3 : evaluate the reduced convolutions.\n");
+    std::vector<double> flops(reduce_datas.size(), 0.0);
+
+#if BISONAI_KILL_THE_BITS
+    double output_error_sum = 0;
+    double output_reference_sum = 0;
+    int top1_match = 0;
+    int top1_count = 0;
+
+    ncnn::Net reduced_net;
+    reduced_net.opt = g_default_option;
+    if (reduced_net.load_param(outparam_path) != 0 || reduced_net.load_model(outbin_path) != 0)
+        return -1;
+#endif
+
+    for (size_t i=0; i<filenames.size(); i++)
+    {
+        ncnn::Mat in;
+        if (load_image(filenames[i], pre_param, in) != 0)
+            return -1;
+
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", in);
+
+        for (size_t j=0; j<reduce_datas.size(); j++)
+        {
+            ChannelReduceData& rd = reduce_datas[j];
+            if (!rd.reduced_op)
+                continue;
+
+            ncnn::Mat bottom_blob;
+            ncnn::Mat top_blob;
+            ex.extract(net.bottom_blob_name(rd.layer_index).c_str(), bottom_blob);
+            ex.extract(net.top_blob_name(rd.layer_index).c_str(), top_blob);
+
+            flops[j] = convolution_flops((const ncnn::Convolution*)net.layer(rd.layer_index), 1, top_blob);
+
+            ncnn::Mat top_blob_reduced;
+            rd.reduced_op->forward(reduce_input(bottom_blob, rd), top_blob_reduced, net.opt);
+
+            for (int q=0; q<top_blob.c; q++)
+            {
+                const float* ptr = top_blob.channel(q);
+                const float* ptr_reduced = top_blob_reduced.channel(q);
+                for (int k=0; k<top_blob.w * top_blob.h; k++)
+                {
+                    rd.error_sum += (ptr[k] - ptr_reduced[k]) * (ptr[k] - ptr_reduced[k]);
+                    rd.reference_sum += ptr[k] * ptr[k];
+                }
+            }
+        }
+
+#if BISONAI_KILL_THE_BITS
+        // whole network output of the reduced model
+        ncnn::Mat out;
+        ncnn::Mat out_reduced;
+        ex.extract(net.output_blob_name().c_str(), out);
+
+        ncnn::Extractor ex_reduced = reduced_net.create_extractor();
+        ex_reduced.input("data", in);
+        ex_reduced.extract(net.output_blob_name().c_str(), out_reduced);
+
+        const float* ptr = out;
+        const float* ptr_reduced = out_reduced;
+        const int total = (int)std::min(out.total(), out_reduced.total());
+        for (int k=0; k<total; k++)
+        {
+            output_error_sum += (ptr[k] - ptr_reduced[k]) * (ptr[k] - ptr_reduced[k]);
+            output_reference_sum += ptr[k] * ptr[k];
+        }
+
+        if (out.dims == 1 && total > 0)
+        {
+            top1_match += std::max_element(ptr, ptr + total) - ptr == std::max_element(ptr_reduced, ptr_reduced + total) - ptr_reduced;
+            top1_count++;
+        }
+#endif // BISONAI_KILL_THE_BITS
+    }
+
+    // report
+    double total_flops = 0;
+    double total_flops_reduced = 0;
+    fprintf(stderr, "%-24s %9s %12s %12s %12s\n", "layer", "channels", "mflops", "reduced", "rel error");
+    for (size_t j=0; j<reduce_datas.size(); j++)
+    {
+        const ChannelReduceData& rd = reduce_datas[j];
+        if (!rd.reduced_op)
+            continue;
+
+        const double f = flops[j] * rd.channels;
+        const double f_reduced = flops[j] * rd.reduced_channels;
+        total_flops += f;
+        total_flops_reduced += f_reduced;
+
+        fprintf(stderr, "%-24s %4d->%-4d %12.2f %12.2f %12f\n", rd.name.c_str(), rd.channels, rd.reduced_channels, f / 1e6, f_reduced / 1e6,
+                rd.reference_sum > 0 ? sqrt(rd.error_sum / rd.reference_sum) : 0.0);
+    }
+
+    fprintf(stderr, "reduced convolution mflops %.2f -> %.2f (%.1f%%)\n", total_flops / 1e6, total_flops_reduced / 1e6, total_flops > 0 ? 100.0 * (1.0 - total_flops_reduced / total_flops) : 0.0);
+
+#if BISONAI_KILL_THE_BITS
+    fprintf(stderr, "network output rel error %f", output_reference_sum > 0 ? sqrt(output_error_sum / output_reference_sum) : 0.0);
+    if (top1_count > 0)
+        fprintf(stderr, "  top1 agreement %.2f%%", 100.0 * top1_match / top1_count);
+    fprintf(stderr, "\n");
+#else
+    fprintf(stderr, "build with BISONAI_KILL_THE_BITS to measure the whole network output\n");
+#endif
+
+    for (size_t j=0; j<reduce_datas.size(); j++)
+    {
+        if (reduce_datas[j].reduced_op)
+        {
+            reduce_datas[j].reduced_op->destroy_pipeline(net.opt);
+            delete reduce_datas[j].reduced_op;
+        }
+    }
+
+    return 0;
+}
+
+// usage
+void showUsage()
+{
+    std::cout << "usage: ncnn2reduce [-h] [-p] [-b] [-i] [-o] [-w] [-m] [-n] [-s] [-c] [-r] [-l] [-t]" << std::endl;
+    std::cout << " -h, --help       show this help message and exit" << std::endl;
+    std::cout << " -p, --param      path to ncnn.param file" << std::endl;
+    std::cout << " -b, --bin        path to ncnn.bin file" << std::endl;
+    std::cout << " -i, --images     path to calibration images" << std::endl;
+    std::cout << " -o, --outparam   path to output reduced ncnn.param file" << std::endl;
+    std::cout << " -w, --outbin     path to output reduced ncnn.bin file" << std::endl;
+    std::cout << " -m, --mean       value of mean" << std::endl;
+    std::cout << " -n, --norm       value of normalize(scale value,defualt is 1)" << std::endl;
+    std::cout << " -s, --size       the size of input image(using the resize the original image,default is w=224,h=224)" << std::endl;
+    std::cout << " -c  --swapRB     flag which indicates that swap first and last channels in 3-channel image is necessary" << std::endl;
+    std::cout << " -r, --ratio      reduced input channels over input channels(default is 0.5)" << std::endl;
+    std::cout << " -l, --min        convolutions with fewer input channels are kept(default is 16)" << std::endl;
+    std::cout << " -t, --thread     number of threads(defalut is 1)" << std::endl;
+    std::cout << "example: ./ncnn2reduce --param squeezenet-fp32.param --bin squeezenet-fp32.bin --images images/ --outparam squeezenet-reduced.param --outbin squeezenet-reduced.bin --mean 104,117,123 --norm 1,1,1 --size 227,227 --ratio 0.5 --thread 2" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    char* imagepath = NULL;
+    char* parampath = NULL;
+    char* binpath = NULL;
+    char* outparampath = NULL;
+    char* outbinpath = NULL;
+    float ratio = 0.5f;
+    int min_channels = 16;
+    int num_threads = 1;
+
+    struct PreParam pre_param = {
+        .mean = {104.f, 117.f, 103.f},
+        .norm = {1.f, 1.f, 1.f},
+        .weith = 224,
+        .height =224,
+        .swapRB = false
+    };
+
+    int c;
+
+    while (1)
+    {
+        int option_index = 0;
+        static struct option long_options[] =
+        {
+            {"param",    required_argument, 0,  'p' },
+            {"bin",      required_argument, 0,  'b' },
+            {"images",   required_argument, 0,  'i' },
+            {"outparam", required_argument, 0,  'o' },
+            {"outbin",   required_argument, 0,  'w' },
+            {"mean",     required_argument, 0,  'm' },
+            {"norm",     required_argument, 0,  'n' },
+            {"size",     required_argument, 0,  's' },
+            {"swapRB",   no_argument,       0,  'c' },
+            {"ratio",    required_argument, 0,  'r' },
+            {"min",      required_argument, 0,  'l' },
+            {"thread",   required_argument, 0,  't' },
+            {"help",     no_argument,       0,  'h' },
+            {0,          0,                 0,  0 }
+        };
+
+        c = getopt_long(argc, argv, "p:b:i:o:w:m:n:s:cr:l:t:h", long_options, &option_index);
+        if (c == -1)
+            break;
+
+        switch (c)
+        {
+        case 'p':
+            parampath = optarg;
+            break;
+
+        case 'b':
+            binpath = optarg;
+            break;
+
+        case 'i':
+            imagepath = optarg;
+            break;
+
+        case 'o':
+            outparampath = optarg;
+            break;
+
+        case 'w':
+            outbinpath = optarg;
+            break;
+
+        case 'm':
+        {
+            std::vector<std::string> array = split(std::string(optarg), ",");
+            pre_param.mean[0] = atof(array[0].c_str());
+            pre_param.mean[1] = atof(array[1].c_str());
+            pre_param.mean[2] = atof(array[2].c_str());
+        }
+            break;
+
+        case 'n':
+        {
+            std::vector<std::string> array = split(std::string(optarg), ",");
+            pre_param.norm[0] = atof(array[0].c_str());
+            pre_param.norm[1] = atof(array[1].c_str());
+            pre_param.norm[2] = atof(array[2].c_str());
+        }
+            break;
+
+        case 's':
+        {
+            std::vector<std::string> array = split(std::string(optarg), ",");
+            pre_param.weith = atoi(array[0].c_str());
+            pre_param.height = atoi(array[1].c_str());
+        }
+            break;
+
+        case 'c':
+            pre_param.swapRB = true;
+            break;
+
+        case 'r':
+            ratio = atof(optarg);
+            break;
+
+        case 'l':
+            min_channels = atoi(optarg);
+            break;
+
+        case 't':
+            num_threads = atoi(optarg);
+            break;
+
+        case 'h':
+        case '?':
+            showUsage();
+            return 0;
+
+        default:
+            showUsage();
+        }
+    }
+
+    // check the input param
+    if (imagepath == NULL || parampath == NULL || binpath == NULL || outparampath == NULL || outbinpath == NULL)
+    {
+        fprintf(stderr, "someone path maybe empty,please check it and try again.\n");
+        return 0;
+    }
+
+    if (ratio <= 0.f || ratio > 1.f)
+    {
+        fprintf(stderr, "ratio %f out of range (0, 1]\n", ratio);
+        return -1;
+    }
+
+    g_blob_pool_allocator.set_size_compare_ratio(0.0f);
+    g_workspace_pool_allocator.set_size_compare_ratio(0.5f);
+
+    // default option, keep every blob for the per layer comparison
+    g_default_option.lightmode = false;
+    g_default_option.num_threads = num_threads;
+    g_default_option.blob_allocator = &g_blob_pool_allocator;
+    g_default_option.workspace_allocator = &g_workspace_pool_allocator;
+
+    ncnn::set_cpu_powersave(2);
+    ncnn::set_omp_dynamic(0);
+    ncnn::set_omp_num_threads(num_threads);
+
+    std::vector<std::string> filenames;
+
+    // parse the image file.
+    parse_images_dir(imagepath, filenames);
+
+    return channel_reduce(filenames, parampath, binpath, outparampath, outbinpath, ratio, min_channels, pre_param);
+}
@@ -40,172 +40,12 @@
 #include "layer/convolutiondepthwise.h"
 #include "layer/innerproduct.h"
 
+#include "quantize_common.h"
+
 static ncnn::Option g_default_option;
 static ncnn::UnlockedPoolAllocator g_blob_pool_allocator;
 static ncnn::PoolAllocator g_workspace_pool_allocator;
 
-// Get the filenames from direct path
-int parse_images_dir(const char *base_path, std::vector<std::string>& file_path)
-{
-    DIR *dir;
-    struct dirent *ptr;
-
-    if ((dir=opendir(base_path)) == NULL)
-    {
-        perror("Open dir error...");
-        exit(1);
-    }
-
-    while ((ptr=readdir(dir)) != NULL)
-    {
-        if(strcmp(ptr->d_name,".")==0 || strcmp(ptr->d_name,"..")==0)    ///current dir OR parrent dir
-        {
-            continue;
-        } 
-
-        std::string path = base_path;
-        file_path.push_back(path + ptr->d_name);
-    }
-    closedir(dir);
-
-    return 0;
-}
-
-class QuantNet : public ncnn::Net
-{
-public:
-    int get_conv_names();
-    int get_conv_bottom_blob_names();
-    int get_conv_weight_blob_scales();
-
-public:
-    std::vector<std::string> conv_names;
-    std::map<std::string,std::string> conv_bottom_blob_names;
-    std::map<std::string,std::vector<float> > weight_scales;
-};
-
-int QuantNet::get_conv_names()
-{
-    for (size_t i=0; i<layers.size(); i++)
-    {
-        ncnn::Layer* layer = layers[i];
-        
-        if (layer->type == "Convolution" || layer->type == "ConvolutionDepthWise" || layer->type == "InnerProduct")
-        {
-            std::string name = layer->name;
-            conv_names.push_back(name);
-        }
-    }        
-
-    return 0;
-}
-
-int QuantNet::get_conv_bottom_blob_names()
-{
-    // find conv bottom name or index
-    for (size_t i=0; i<layers.size(); i++)
-    {
-        ncnn::Layer* layer = layers[i];
-        
-        if (layer->type == "Convolution" || layer->type == "ConvolutionDepthWise" || layer->type == "InnerProduct")
-        {
-            std::string name = layer->name;
-            std::string bottom_blob_name = blobs[layer->bottoms[0]].name;
-            conv_bottom_blob_names[name] = bottom_blob_name;
-        }
-    }
-
-    return 0;
-}
-
-int QuantNet::get_conv_weight_blob_scales()
-{
-    for (size_t i=0; i<layers.size(); i++)
-    {
-        ncnn::Layer* layer = layers[i];
-        
-        if (layer->type == "Convolution")
-        {
-            std::string name = layer->name;
-            const int weight_data_size_output = ((ncnn::Convolution*)layer)->weight_data_size / ((ncnn::Convolution*)layer)->num_output;
-            std::vector<float> scales;
-
-            // int8 winograd F43 needs weight data to use 6bit quantization
-            bool quant_6bit = false;
-            int kernel_w = ((ncnn::Convolution*)layer)->kernel_w;
-            int kernel_h = ((ncnn::Convolution*)layer)->kernel_h;
-            int dilation_w = ((ncnn::Convolution*)layer)->dilation_w;
-            int dilation_h = ((ncnn::Convolution*)layer)->dilation_h;
-            int stride_w = ((ncnn::Convolution*)layer)->stride_w;
-            int stride_h = ((ncnn::Convolution*)layer)->stride_h;
-
-            if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
-                quant_6bit = true;
-
-            for (int n=0; n<((ncnn::Convolution*)layer)->num_output; n++)
-            {
-                const ncnn::Mat weight_data_n = ((ncnn::Convolution*)layer)->weight_data.range(weight_data_size_output * n, weight_data_size_output);
-                const float *data_n = weight_data_n;
-                float max_value = std::numeric_limits<float>::min();
-
-                for (int i = 0; i < weight_data_size_output; i++)
-                    max_value = std::max(max_value, std::fabs(data_n[i]));
-
-                if (quant_6bit)
-                    scales.push_back(31 / max_value);
-                else
-                    scales.push_back(127 / max_value);
-            }
-
-            weight_scales[name] = scales;
-        }
-        
-        if (layer->type == "ConvolutionDepthWise")
-        {
-            std::string name = layer->name;
-            const int weight_data_size_output = ((ncnn::ConvolutionDepthWise*)layer)->weight_data_size / ((ncnn::ConvolutionDepthWise*)layer)->group;
-            std::vector<float> scales;
-
-            for (int n=0; n<((ncnn::ConvolutionDepthWise*)layer)->group; n++)
-            {
-                const ncnn::Mat weight_data_n = ((ncnn::ConvolutionDepthWise*)layer)->weight_data.range(weight_data_size_output * n, weight_data_size_output);
-                const float *data_n = weight_data_n;
-                float max_value = std::numeric_limits<float>::min();
-
-                for (int i = 0; i < weight_data_size_output; i++)
-                    max_value = std::max(max_value, std::fabs(data_n[i]));
-
-                scales.push_back(127 / max_value); 
-            }
-
-            weight_scales[name] = scales;                
-        }
-
-        if (layer->type == "InnerProduct")
-        {
-            std::string name = layer->name;
-            const int weight_data_size_output = ((ncnn::InnerProduct*)layer)->weight_data_size / ((ncnn::InnerProduct*)layer)->num_output;
-            std::vector<float> scales;
-
-            for (int n=0; n<((ncnn::InnerProduct*)layer)->num_output; n++)
-            {
-                const ncnn::Mat weight_data_n = ((ncnn::InnerProduct*)layer)->weight_data.range(weight_data_size_output * n, weight_data_size_output);
-                const float *data_n = weight_data_n;
-                float max_value = std::numeric_limits<float>::min();
-
-                for (int i = 0; i < weight_data_size_output; i++)
-                    max_value = std::max(max_value, std::fabs(data_n[i]));
-
-                scales.push_back(127 / max_value);
-            }
-
-            weight_scales[name] = scales;            
-        }
-    }              
-
-    return 0;
-}
-
 class QuantizeData
 {
 public:
@@ -218,9 +58,14 @@ public:
     int normalize_histogram(); 
     int update_histogram(ncnn::Mat data);
 
+    // fold the statistics another calibration thread collected into this one
+    int merge_blob_max(const QuantizeData& data);
+    int merge_histogram(const QuantizeData& data);
+
     float compute_kl_divergence(const std::vector<float> &dist_a, const std::vector<float> &dist_b);
     int threshold_distribution(const std::vector<float> &distribution, const int target_bin=128);
     float get_data_blob_scale();
+    int get_data_blob_scales(bool per_channel, bool asymmetric);
 
 public:
     std::string name;
@@ -229,10 +74,18 @@ public:
     int num_bins;
     float histogram_interval;
     std::vector<float> histogram;
+
+    // signed range of each channel, always covers zero
+    std::vector<float> channel_min;
+    std::vector<float> channel_max;
     
     float threshold;
     int threshold_bin;
     float scale;
+
+    // one scale per tensor or per channel, zero point of the asymmetric range
+    std::vector<float> scales;
+    int zero_point;
 };
 
 QuantizeData::QuantizeData(std::string layer_name, int num)
@@ -243,6 +96,7 @@ QuantizeData::QuantizeData(std::string layer_name, int num)
     histogram_interval = 0.0;
     histogram.resize(num_bins);
     initial_histogram_value();
+    zero_point = 0;
 }
 
 int QuantizeData::initial_blob_max(ncnn::Mat data)
@@ -250,18 +104,55 @@ int QuantizeData::initial_blob_max(ncnn::Mat data)
     int channel_num = data.c;
     int size = data.w * data.h;
 
+    if ((int)channel_max.size() != channel_num)
+    {
+        channel_min.resize(channel_num, 0.f);
+        channel_max.resize(channel_num, 0.f);
+    }
+
     for (int q=0; q<channel_num; q++)
     {
         const float *data_n = data.channel(q);
         for(int i=0; i<size; i++)
         {
             max_value = std::max(max_value, std::fabs(data_n[i]));
+            channel_min[q] = std::min(channel_min[q], data_n[i]);
+            channel_max[q] = std::max(channel_max[q], data_n[i]);
         }
     }
 
     return 0;
 }
 
+int QuantizeData::merge_blob_max(const QuantizeData& data)
+{
+    max_value = std::max(max_value, data.max_value);
+
+    if (channel_max.size() < data.channel_max.size())
+    {
+        channel_min.resize(data.channel_min.size(), 0.f);
+        channel_max.resize(data.channel_max.size(), 0.f);
+    }
+
+    for (size_t q=0; q<data.channel_max.size(); q++)
+    {
+        channel_min[q] = std::min(channel_min[q], data.channel_min[q]);
+        channel_max[q] = std::max(channel_max[q], data.channel_max[q]);
+    }
+
+    return 0;
+}
+
+int QuantizeData::merge_histogram(const QuantizeData& data)
+{
+    for (size_t i=0; i<histogram.size(); i++)
+    {
+        histogram[i] += data.histogram[i];
+    }
+
+    return 0;
+}
+
 int QuantizeData::initial_histogram_interval()
 {
     histogram_interval = max_value / num_bins;
@@ -481,38 +372,154 @@ float QuantizeData::get_data_blob_scale()
     return scale;
 }
 
-struct PreParam
+int QuantizeData::get_data_blob_scales(bool per_channel, bool asymmetric)
 {
-    float mean[3];
-    float norm[3];
-    int weith;
-    int height;
-    bool swapRB;
-};
+    get_data_blob_scale();
+
+    scales.clear();
+    zero_point = 0;
+
+    if (!per_channel && !asymmetric)
+    {
+        scales.push_back(scale);
+        return 0;
+    }
+
+    // the kl threshold clips the range of the tensor and of every channel
+    float lo = 0.f;
+    float hi = 0.f;
+    for (size_t q=0; q<channel_max.size(); q++)
+    {
+        lo = std::min(lo, channel_min[q]);
+        hi = std::max(hi, channel_max[q]);
+    }
+    lo = std::max(lo, -threshold);
+    hi = std::min(hi, threshold);
 
-static int post_training_quantize(const std::vector<std::string> filenames, const char* param_path, const char* bin_path, const char* table_path, struct PreParam per_param)
+    // map lo..hi onto -127..127, shared by all channels
+    if (asymmetric && hi > lo)
+        zero_point = static_cast<int>(round(-127 - lo * 254 / (hi - lo)));
+
+    const int channel_num = per_channel ? channel_max.size() : 1;
+    for (int q=0; q<channel_num; q++)
+    {
+        float channel_lo = per_channel ? std::max(channel_min[q], -threshold) : lo;
+        float channel_hi = per_channel ? std::min(channel_max[q], threshold) : hi;
+
+        if (!asymmetric)
+        {
+            channel_hi = std::max(channel_hi, -channel_lo);
+            channel_lo = -channel_hi;
+        }
+
+        // the largest scale keeping both ends within -127..127 around the zero point
+        float channel_scale = 0.f;
+        if (channel_hi > 0)
+            channel_scale = (127 - zero_point) / channel_hi;
+        if (channel_lo < 0)
+        {
+            float lo_scale = (127 + zero_point) / -channel_lo;
+            channel_scale = channel_scale == 0.f ? lo_scale : std::min(channel_scale, lo_scale);
+        }
+
+        // channel never activated
+        if (channel_scale == 0.f)
+            channel_scale = scale;
+
+        scales.push_back(channel_scale);
+    }
+
+    return 0;
+}
+
+// run the calibration images through the net on num_threads images at once
+// step 1 collects the max values, step 3 the histograms, merged over the threads at the end
+static int calibrate_images(QuantNet& net, const std::vector<std::string>& filenames, const struct PreParam& pre_param, int num_threads, int step, std::vector<QuantizeData>& quantize_datas)
 {
-    int size = filenames.size();
+    const int size = filenames.size();
 
+    std::vector<std::string> blob_names(quantize_datas.size());
+    for (size_t j=0; j<quantize_datas.size(); j++)
+        blob_names[j] = net.conv_bottom_blob_names[quantize_datas[j].name];
+
+    std::vector<std::vector<QuantizeData> > thread_quantize_datas(num_threads, quantize_datas);
+    for (int t=0; t<num_threads; t++)
+    {
+        for (size_t j=0; j<thread_quantize_datas[t].size(); j++)
+        {
+            std::vector<float>& histogram = thread_quantize_datas[t][j].histogram;
+            std::fill(histogram.begin(), histogram.end(), 0.f);
+        }
+    }
+
+    int ret = 0;
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        // the pool allocators are not thread safe
+        ncnn::UnlockedPoolAllocator blob_pool_allocator;
+        ncnn::UnlockedPoolAllocator workspace_pool_allocator;
+        blob_pool_allocator.set_size_compare_ratio(0.0f);
+        workspace_pool_allocator.set_size_compare_ratio(0.5f);
+
+        std::vector<QuantizeData>& datas = thread_quantize_datas[ncnn::get_omp_thread_num()];
+
+        #pragma omp for schedule(dynamic)
+        for (int i=0; i<size; i++)
+        {
+            std::string img_name = filenames[i];
+
+            if ((i+1)%100 == 0)
+                fprintf(stderr, "          %d/%d\n", (int)(i+1), (int)size);
+
+            ncnn::Mat in;
+            if (load_image(img_name, pre_param, in) != 0)
+            {
+                ret = -1;
+                continue;
+            }
+
+            ncnn::Extractor ex = net.create_extractor();
+            ex.set_num_threads(1);
+            ex.set_blob_allocator(&blob_pool_allocator);
+            ex.set_workspace_allocator(&workspace_pool_allocator);
+            ex.input("data", in);
+
+            for (size_t j=0; j<datas.size(); j++)
+            {
+                ncnn::Mat out;
+                ex.extract(blob_names[j].c_str(), out);
+
+                if (step == 1)
+                    datas[j].initial_blob_max(out);
+                else
+                    datas[j].update_histogram(out);
+            }
+        }
+    }
+
+    for (int t=0; t<num_threads; t++)
+    {
+        for (size_t j=0; j<quantize_datas.size(); j++)
+        {
+            if (step == 1)
+                quantize_datas[j].merge_blob_max(thread_quantize_datas[t][j]);
+            else
+                quantize_datas[j].merge_histogram(thread_quantize_datas[t][j]);
+        }
+    }
+
+    return ret;
+}
+
+static int post_training_quantize(const std::vector<std::string> filenames, const char* param_path, const char* bin_path, const char* table_path, struct PreParam per_param, int num_threads, bool per_channel, bool asymmetric)
+{
     QuantNet net;
     net.opt = g_default_option;
 
     net.load_param(param_path);
     net.load_model(bin_path);
 
-    float mean_vals[3], norm_vals[3];
-    int weith = per_param.weith;
-    int height = per_param.height;
-    bool swapRB = per_param.swapRB;
-
-    mean_vals[0] = per_param.mean[0];
-    mean_vals[1] = per_param.mean[1];
-    mean_vals[2] = per_param.mean[2];
-
-    norm_vals[0] = per_param.norm[0];
-    norm_vals[1] = per_param.norm[1];
-    norm_vals[2] = per_param.norm[2];
-
     g_blob_pool_allocator.clear();
     g_workspace_pool_allocator.clear();
 
@@ -551,135 +558,53 @@ static int post_training_quantize(const std::vector<std::string> filenames, cons
     printf("====> Quantize the activation.\n"); 
     printf("    ====> step 1 : find the max value.\n");
 
-    for (size_t i=0; i<filenames.size(); i++)
+    if (calibrate_images(net, filenames, per_param, num_threads, 1, quantize_datas) != 0)
     {
-        std::string img_name = filenames[i];
-
-        if ((i+1)%100 == 0)
-            fprintf(stderr, "          %d/%d\n", (int)(i+1), (int)size);
-
-#if OpenCV_VERSION_MAJOR > 2
-        cv::Mat bgr = cv::imread(img_name, cv::IMREAD_COLOR);
-#else
-        cv::Mat bgr = cv::imread(img_name, CV_LOAD_IMAGE_COLOR);
-#endif
-        if (bgr.empty())
-        {
-            fprintf(stderr, "cv::imread %s failed\n", img_name.c_str());
-            return -1;
-        }
-
-        ncnn::Mat in = ncnn::Mat::from_pixels_resize(bgr.data, swapRB ? ncnn::Mat::PIXEL_BGR2RGB : ncnn::Mat::PIXEL_BGR, bgr.cols, bgr.rows, weith, height);
-        in.substract_mean_normalize(mean_vals, norm_vals);
-
-        ncnn::Extractor ex = net.create_extractor();
-        ex.input("data", in);
-
-        for (size_t i=0; i<net.conv_names.size(); i++)
-        {
-            std::string layer_name = net.conv_names[i];
-            std::string blob_name = net.conv_bottom_blob_names[layer_name];
-
-            ncnn::Mat out;
-            ex.extract(blob_name.c_str(), out);  
-
-            for (size_t j=0; j<quantize_datas.size(); j++)
-            {
-                if (quantize_datas[j].name == layer_name)
-                {
-                    quantize_datas[j].initial_blob_max(out);
-                    break;
-                }
-            }
-        }         
+        fclose(fp);
+        return -1;
     }
 
     // step 2 histogram_interval
     printf("    ====> step 2 : generatue the histogram_interval.\n");
-    for (size_t i=0; i<net.conv_names.size(); i++)
+    for (size_t j=0; j<quantize_datas.size(); j++)
     {
-        std::string layer_name = net.conv_names[i];
+        quantize_datas[j].initial_histogram_interval();
 
-        for (size_t j=0; j<quantize_datas.size(); j++)
-        {
-            if (quantize_datas[j].name == layer_name)
-            {
-                quantize_datas[j].initial_histogram_interval();
-
-                fprintf(stderr, "%-20s : max = %-15f interval = %-10f\n", quantize_datas[j].name.c_str(), quantize_datas[j].max_value, quantize_datas[j].histogram_interval);
-                break;
-            }
-        }
+        fprintf(stderr, "%-20s : max = %-15f interval = %-10f\n", quantize_datas[j].name.c_str(), quantize_datas[j].max_value, quantize_datas[j].histogram_interval);
     }    
 
     // step 3 histogram
     printf("    ====> step 3 : generatue the histogram.\n");
-    for (size_t i=0; i<filenames.size(); i++)
-    {
-        std::string img_name = filenames[i];
-
-        if ((i+1)%100 == 0)
-            fprintf(stderr, "          %d/%d\n", (int)(i+1), (int)size);
-#if OpenCV_VERSION_MAJOR > 2
-        cv::Mat bgr = cv::imread(img_name, cv::IMREAD_COLOR);
-#else
-        cv::Mat bgr = cv::imread(img_name, CV_LOAD_IMAGE_COLOR);
-#endif
-        if (bgr.empty())
-        {
-            fprintf(stderr, "cv::imread %s failed\n", img_name.c_str());
-            return -1;
-        }  
-
-        ncnn::Mat in = ncnn::Mat::from_pixels_resize(bgr.data, swapRB ? ncnn::Mat::PIXEL_BGR2RGB : ncnn::Mat::PIXEL_BGR, bgr.cols, bgr.rows, weith, height);
-        in.substract_mean_normalize(mean_vals, norm_vals);
-      
-        ncnn::Extractor ex = net.create_extractor();
-        ex.input("data", in);
-
-        for (size_t i=0; i<net.conv_names.size(); i++)
-        {
-            std::string layer_name = net.conv_names[i];
-            std::string blob_name = net.conv_bottom_blob_names[layer_name];
 
-            ncnn::Mat out;
-            ex.extract(blob_name.c_str(), out);  
-
-            for (size_t j=0; j<quantize_datas.size(); j++)
-            {
-                if (quantize_datas[j].name == layer_name)
-                {
-                    quantize_datas[j].update_histogram(out);
-                    break;
-                }
-            }
-        }     
+    if (calibrate_images(net, filenames, per_param, num_threads, 3, quantize_datas) != 0)
+    {
+        fclose(fp);
+        return -1;
     }
 
     // step4 kld
     printf("    ====> step 4 : using kld to find the best threshold value.\n");
-    for (size_t i=0; i<net.conv_names.size(); i++)
+    for (size_t j=0; j<quantize_datas.size(); j++)
     {
-        std::string layer_name = net.conv_names[i];
-        std::string blob_name = net.conv_bottom_blob_names[layer_name];
-        fprintf(stderr, "%-20s ", layer_name.c_str());
+        QuantizeData& quantize_data = quantize_datas[j];
 
-        for (size_t j=0; j<quantize_datas.size(); j++)
-        {
-            if (quantize_datas[j].name == layer_name)
-            {
-                quantize_datas[j].get_data_blob_scale();
-                fprintf(stderr, "bin : %-8d threshold : %-15f interval : %-10f scale : %-10f\n", \
-                                                                quantize_datas[j].threshold_bin, \
-                                                                quantize_datas[j].threshold, \
-                                                                quantize_datas[j].histogram_interval, \
-                                                                quantize_datas[j].scale);
+        fprintf(stderr, "%-20s ", quantize_data.name.c_str());
 
-                fprintf(fp, "%s %f\n", layer_name.c_str(), quantize_datas[j].scale);
+        quantize_data.get_data_blob_scales(per_channel, asymmetric);
+        fprintf(stderr, "bin : %-8d threshold : %-15f interval : %-10f scale : %-10f zero_point : %d\n", \
+                                                        quantize_data.threshold_bin, \
+                                                        quantize_data.threshold, \
+                                                        quantize_data.histogram_interval, \
+                                                        quantize_data.scales[0], \
+                                                        quantize_data.zero_point);
 
-                break;
-            }
-        }
+        fprintf(fp, "%s", quantize_data.name.c_str());
+        for (size_t k=0; k<quantize_data.scales.size(); k++)
+            fprintf(fp, " %f", quantize_data.scales[k]);
+        fprintf(fp, "\n");
+
+        if (asymmetric)
+            fprintf(fp, "%s_zero_point %d\n", quantize_data.name.c_str(), quantize_data.zero_point);
     }
 
     fclose(fp);
@@ -691,7 +616,7 @@ static int post_training_quantize(const std::vector<std::string> filenames, cons
 // usage
 void showUsage() 
 {
-    std::cout << "usage: ncnn2table [-h] [-p] [-b] [-o] [-m] [-n] [-s] [-t]" << std::endl;
+    std::cout << "usage: ncnn2table [-h] [-p] [-b] [-o] [-m] [-n] [-s] [-t] [-r] [-a]" << std::endl;
     std::cout << " -h, --help       show this help message and exit" << std::endl;
     std::cout << " -p, --param      path to ncnn.param file" << std::endl;
     std::cout << " -b, --bin        path to ncnn.bin file" << std::endl;
@@ -702,28 +627,11 @@ void showUsage()
     std::cout << " -s, --size       the size of input image(using the resize the original image,default is w=224,h=224)" << std::endl;
     std::cout << " -c  --swapRB     flag which indicates that swap first and last channels in 3-channel image is necessary" << std::endl;
     std::cout << " -t, --thread     number of threads(defalut is 1)" << std::endl;    
+    std::cout << " -r, --per-channel  one activation scale per channel" << std::endl;
+    std::cout << " -a, --asymmetric   asymmetric activation range with a zero point" << std::endl;
     std::cout << "example: ./ncnn2table --param squeezenet-fp32.param --bin squeezenet-fp32.bin --images images/ --output squeezenet.table --mean 104,117,123 --norm 1,1,1 --size 227,227 --swapRB --thread 2" << std::endl;
 }
 
-// string.split('x')
-std::vector<std::string> split(const std::string &str,const std::string &pattern)
-{
-    //const char* convert to char*
-    char * strc = new char[strlen(str.c_str())+1];
-    strcpy(strc, str.c_str());
-    std::vector<std::string> resultVec;
-    char* tmpStr = strtok(strc, pattern.c_str());
-    while (tmpStr != NULL)
-    {
-        resultVec.push_back(std::string(tmpStr));
-        tmpStr = strtok(NULL, pattern.c_str());
-    }
-
-    delete[] strc;
-
-    return resultVec;
-}
-
 int main(int argc, char** argv)
 {
     std::cout << "--- ncnn post training quantization tool --- " << __TIME__ << " " << __DATE__ << std::endl;
@@ -733,6 +641,8 @@ int main(int argc, char** argv)
     char* binpath = NULL;
     char* tablepath = NULL;
     int num_threads = 1;
+    bool per_channel = false;
+    bool asymmetric = false;
 
     struct PreParam pre_param = {
         .mean = {104.f, 117.f, 103.f}, 
@@ -758,11 +668,13 @@ int main(int argc, char** argv)
             {"size",    required_argument, 0,  's' },
             {"swapRB",  no_argument,       0,  'c' },
             {"thread",  required_argument, 0,  't' },
+            {"per-channel", no_argument,   0,  'r' },
+            {"asymmetric",  no_argument,   0,  'a' },
             {"help",    no_argument,       0,  'h' },
             {0,         0,                 0,  0 }
         };
 
-        c = getopt_long(argc, argv, "p:b:i:o:m:n:s:ct:h", long_options, &option_index);
+        c = getopt_long(argc, argv, "p:b:i:o:m:n:s:ct:rah", long_options, &option_index);
         if (c == -1)
             break;
 
@@ -831,6 +743,16 @@ int main(int argc, char** argv)
             num_threads = atoi(optarg);
             break;            
 
+        case 'r':
+            printf("per-channel = '%s'\n", "true");
+            per_channel = true;
+            break;
+
+        case 'a':
+            printf("asymmetric = '%s'\n", "true");
+            asymmetric = true;
+            break;
+
         case 'h':
         case '?':
             showUsage();
@@ -876,7 +798,7 @@ int main(int argc, char** argv)
     parse_images_dir(imagepath, filenames);
 
     // get the calibration table file, and save it.
-    int ret = post_training_quantize(filenames, parampath, binpath, tablepath, pre_param);
+    int ret = post_training_quantize(filenames, parampath, binpath, tablepath, pre_param, num_threads, per_channel, asymmetric);
     if (!ret)
         fprintf(stderr, "\nNCNN Int8 Calibration table create success, best wish for your INT8 inference has a low accuracy loss...\\(^▽^)/...233...\n");
 
@@ -0,0 +1,361 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// helpers shared by ncnn2table, ncnn2reduce and ncnn2mixed
+
+#ifndef NCNN_QUANTIZE_COMMON_H
+#define NCNN_QUANTIZE_COMMON_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <dirent.h>
+#include <vector>
+#include <string>
+#include <map>
+#include <limits>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+// ncnn public header
+#include "net.h"
+#include "datareader.h"
+#include "modelbin.h"
+
+// ncnn private header
+#include "layer/convolution.h"
+#include "layer/convolutiondepthwise.h"
+#include "layer/innerproduct.h"
+
+// Get the filenames from direct path
+static inline int parse_images_dir(const char *base_path, std::vector<std::string>& file_path)
+{
+    DIR *dir;
+    struct dirent *ptr;
+
+    if ((dir=opendir(base_path)) == NULL)
+    {
+        perror("Open dir error...");
+        exit(1);
+    }
+
+    while ((ptr=readdir(dir)) != NULL)
+    {
+        if(strcmp(ptr->d_name,".")==0 || strcmp(ptr->d_name,"..")==0)    ///current dir OR parrent dir
+        {
+            continue;
+        }
+
+        std::string path = base_path;
+        file_path.push_back(path + ptr->d_name);
+    }
+    closedir(dir);
+
+    std::sort(file_path.begin(), file_path.end());
+
+    return 0;
+}
+
+// string.split('x')
+static inline std::vector<std::string> split(const std::string &str,const std::string &pattern)
+{
+    //const char* convert to char*
+    char * strc = new char[strlen(str.c_str())+1];
+    strcpy(strc, str.c_str());
+    std::vector<std::string> resultVec;
+    char* tmpStr = strtok(strc, pattern.c_str());
+    while (tmpStr != NULL)
+    {
+        resultVec.push_back(std::string(tmpStr));
+        tmpStr = strtok(NULL, pattern.c_str());
+    }
+
+    delete[] strc;
+
+    return resultVec;
+}
+
+struct PreParam
+{
+    float mean[3];
+    float norm[3];
+    int weith;
+    int height;
+    bool swapRB;
+};
+
+static inline int load_image(const std::string& img_name, const struct PreParam& pre_param, ncnn::Mat& in)
+{
+#if OpenCV_VERSION_MAJOR > 2
+    cv::Mat bgr = cv::imread(img_name, cv::IMREAD_COLOR);
+#else
+    cv::Mat bgr = cv::imread(img_name, CV_LOAD_IMAGE_COLOR);
+#endif
+    if (bgr.empty())
+    {
+        fprintf(stderr, "cv::imread %s failed\n", img_name.c_str());
+        return -1;
+    }
+
+    in = ncnn::Mat::from_pixels_resize(bgr.data, pre_param.swapRB ? ncnn::Mat::PIXEL_BGR2RGB : ncnn::Mat::PIXEL_BGR, bgr.cols, bgr.rows, pre_param.weith, pre_param.height);
+    in.substract_mean_normalize(pre_param.mean, pre_param.norm);
+
+    return 0;
+}
+
+// remember every weight a layer loads so that the bin can be written back in order
+class ModelBinRecording : public ncnn::ModelBin
+{
+public:
+    ModelBinRecording(const ncnn::DataReader& dr) : mb(dr), layer_index(0) {}
+
+    virtual ncnn::Mat load(int w, int type) const
+    {
+        ncnn::Mat m = mb.load(w, type);
+
+        Record r;
+        r.layer_index = layer_index;
+        r.type = type;
+        r.data = m.clone();
+        records.push_back(r);
+
+        return m;
+    }
+
+public:
+    struct Record
+    {
+        int layer_index;
+        int type;
+        ncnn::Mat data;
+    };
+
+    ncnn::ModelBinFromDataReader mb;
+    int layer_index;
+    mutable std::vector<Record> records;
+};
+
+static inline size_t alignSize(size_t sz, int n)
+{
+    return (sz + n-1) & -n;
+}
+
+static inline void fwrite_weight(int tag, const ncnn::Mat& data, FILE* bp)
+{
+    long p0 = ftell(bp);
+
+    ncnn::Mat data_flattened = data.reshape(data.w * data.h * data.c);
+
+    if (tag != -1)
+        fwrite(&tag, sizeof(int), 1, bp);
+
+    fwrite(data_flattened.data, data_flattened.elemsize, data_flattened.w, bp);
+
+    // padding to 32bit align
+    int nwrite = ftell(bp) - p0;
+    int nalign = alignSize(nwrite, 4);
+    unsigned char padding[4] = {0x00, 0x00, 0x00, 0x00};
+    fwrite(padding, sizeof(unsigned char), nalign - nwrite, bp);
+}
+
+class QuantNet : public ncnn::Net
+{
+public:
+    int get_conv_names();
+    int get_conv_bottom_blob_names();
+    int get_conv_weight_blob_scales();
+
+    // indexes of the convolution and innerproduct layers quantized by ncnn2int8
+    int get_int8_layers(std::vector<int>& int8_layers) const;
+
+    int load_model_recording(ModelBinRecording& mb);
+
+    int layer_count() const { return layers.size(); }
+    int blob_count() const { return blobs.size(); }
+    std::string blob_name(int blob_index) const { return blobs[blob_index].name; }
+    std::string bottom_blob_name(int layer_index) const { return blobs[layers[layer_index]->bottoms[0]].name; }
+    std::string top_blob_name(int layer_index) const { return blobs[layers[layer_index]->tops[0]].name; }
+    std::string output_blob_name() const { return blobs[layers.back()->tops[0]].name; }
+
+    ncnn::Layer* layer(int layer_index) const { return layers[layer_index]; }
+
+public:
+    std::vector<std::string> conv_names;
+    std::map<std::string,std::string> conv_bottom_blob_names;
+    std::map<std::string,std::vector<float> > weight_scales;
+};
+
+inline int QuantNet::get_conv_names()
+{
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        ncnn::Layer* layer = layers[i];
+
+        if (layer->type == "Convolution" || layer->type == "ConvolutionDepthWise" || layer->type == "InnerProduct")
+        {
+            std::string name = layer->name;
+            conv_names.push_back(name);
+        }
+    }
+
+    return 0;
+}
+
+inline int QuantNet::get_conv_bottom_blob_names()
+{
+    // find conv bottom name or index
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        ncnn::Layer* layer = layers[i];
+
+        if (layer->type == "Convolution" || layer->type == "ConvolutionDepthWise" || layer->type == "InnerProduct")
+        {
+            std::string name = layer->name;
+            std::string bottom_blob_name = blobs[layer->bottoms[0]].name;
+            conv_bottom_blob_names[name] = bottom_blob_name;
+        }
+    }
+
+    return 0;
+}
+
+inline int QuantNet::get_conv_weight_blob_scales()
+{
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        ncnn::Layer* layer = layers[i];
+
+        if (layer->type == "Convolution")
+        {
+            std::string name = layer->name;
+            const int weight_data_size_output = ((ncnn::Convolution*)layer)->weight_data_size / ((ncnn::Convolution*)layer)->num_output;
+            std::vector<float> scales;
+
+            // int8 winograd F43 needs weight data to use 6bit quantization
+            bool quant_6bit = false;
+            int kernel_w = ((ncnn::Convolution*)layer)->kernel_w;
+            int kernel_h = ((ncnn::Convolution*)layer)->kernel_h;
+            int dilation_w = ((ncnn::Convolution*)layer)->dilation_w;
+            int dilation_h = ((ncnn::Convolution*)layer)->dilation_h;
+            int stride_w = ((ncnn::Convolution*)layer)->stride_w;
+            int stride_h = ((ncnn::Convolution*)layer)->stride_h;
+
+            if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
+                quant_6bit = true;
+
+            for (int n=0; n<((ncnn::Convolution*)layer)->num_output; n++)
+            {
+                const ncnn::Mat weight_data_n = ((ncnn::Convolution*)layer)->weight_data.range(weight_data_size_output * n, weight_data_size_output);
+                const float *data_n = weight_data_n;
+                float max_value = std::numeric_limits<float>::min();
+
+                for (int i = 0; i < weight_data_size_output; i++)
+                    max_value = std::max(max_value, std::fabs(data_n[i]));
+
+                if (quant_6bit)
+                    scales.push_back(31 / max_value);
+                else
+                    scales.push_back(127 / max_value);
+            }
+
+            weight_scales[name] = scales;
+        }
+
+        if (layer->type == "ConvolutionDepthWise")
+        {
+            std::string name = layer->name;
+            const int weight_data_size_output = ((ncnn::ConvolutionDepthWise*)layer)->weight_data_size / ((ncnn::ConvolutionDepthWise*)layer)->group;
+            std::vector<float> scales;
+
+            for (int n=0; n<((ncnn::ConvolutionDepthWise*)layer)->group; n++)
+            {
+                const ncnn::Mat weight_data_n = ((ncnn::ConvolutionDepthWise*)layer)->weight_data.range(weight_data_size_output * n, weight_data_size_output);
+                const float *data_n = weight_data_n;
+                float max_value = std::numeric_limits<float>::min();
+
+                for (int i = 0; i < weight_data_size_output; i++)
+                    max_value = std::max(max_value, std::fabs(data_n[i]));
+
+                scales.push_back(127 / max_value);
+            }
+
+            weight_scales[name] = scales;
+        }
+
+        if (layer->type == "InnerProduct")
+        {
+            std::string name = layer->name;
+            const int weight_data_size_output = ((ncnn::InnerProduct*)layer)->weight_data_size / ((ncnn::InnerProduct*)layer)->num_output;
+            std::vector<float> scales;
+
+            for (int n=0; n<((ncnn::InnerProduct*)layer)->num_output; n++)
+            {
+                const ncnn::Mat weight_data_n = ((ncnn::InnerProduct*)layer)->weight_data.range(weight_data_size_output * n, weight_data_size_output);
+                const float *data_n = weight_data_n;
+                float max_value = std::numeric_limits<float>::min();
+
+                for (int i = 0; i < weight_data_size_output; i++)
+                    max_value = std::max(max_value, std::fabs(data_n[i]));
+
+                scales.push_back(127 / max_value);
+            }
+
+            weight_scales[name] = scales;
+        }
+    }
+
+    return 0;
+}
+
+inline int QuantNet::get_int8_layers(std::vector<int>& int8_layers) const
+{
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        const ncnn::Layer* layer = layers[i];
+
+        int int8_scale_term = 0;
+        if (layer->type == "Convolution")
+            int8_scale_term = ((const ncnn::Convolution*)layer)->int8_scale_term;
+        else if (layer->type == "ConvolutionDepthWise")
+            int8_scale_term = ((const ncnn::ConvolutionDepthWise*)layer)->int8_scale_term;
+        else if (layer->type == "InnerProduct")
+            int8_scale_term = ((const ncnn::InnerProduct*)layer)->int8_scale_term;
+
+        if (int8_scale_term)
+            int8_layers.push_back(i);
+    }
+
+    return 0;
+}
+
+inline int QuantNet::load_model_recording(ModelBinRecording& mb)
+{
+    for (size_t i=0; i<layers.size(); i++)
+    {
+        mb.layer_index = i;
+
+        int ret = layers[i]->load_model(mb);
+        if (ret != 0)
+        {
+            fprintf(stderr, "layer load_model %d %s failed\n", (int)i, layers[i]->name.c_str());
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+#endif // NCNN_QUANTIZE_COMMON_H